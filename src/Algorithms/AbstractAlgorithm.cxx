@@ -20,11 +20,20 @@
 
 #include "AbstractAlgorithm.h"
 
+#include "CaretProfiler.h"
+
+#include <typeinfo>
+
 using namespace std;
 using namespace caret;
 
 AbstractAlgorithm::AbstractAlgorithm(ProgressObject* myProgressObject)
 {
+    m_profiled = CaretProfiler::isEnabled();
+    if (m_profiled)
+    {//the derived type isn't available yet, LevelProgress asks for the name from inside the derived constructor
+        CaretProfiler::startSection([this]() { return CaretProfiler::demangle(typeid(*this).name()); });
+    }
     m_progObj = myProgressObject;
     m_finish = true;
     if (m_progObj == NULL)
@@ -60,4 +69,8 @@ AbstractAlgorithm::~AbstractAlgorithm()
     {
         m_progObj->forceFinish();
     }
+    if (m_profiled)
+    {
+        CaretProfiler::stopSection();
+    }
 }
@@ -34,6 +34,7 @@ namespace caret {
     {
         ProgressObject* m_progObj;//so that the destructor can make sure the bar finishes
         bool m_finish;
+        bool m_profiled;//so that the destructor stops the profiler section only if the constructor started one
         AbstractAlgorithm();//prevent default construction
     protected:
         ///override this with the weights of the algorithms this algorithm will call
@@ -34,6 +34,7 @@
 #include <fstream>
 #include <utility>
 #include <algorithm>
+#include <cstdlib>
 
 using namespace caret;
 using namespace std;
@@ -216,6 +217,7 @@ AlgorithmCiftiCorrelation::AlgorithmCiftiCorrelation(ProgressObject* myProgObj,
         CaretLogInfo("computing " + AString::number(numCacheRows) + " rows at a time, reading rows as needed during processing");
     }
     vector<CaretArray<float> > outRows;
+    allocateCache(cacheFullInput ? numRows : numCacheRows);
     if (cacheFullInput)
     {
         for (int i = 0; i < numRows; ++i)
@@ -402,6 +404,7 @@ AlgorithmCiftiCorrelation::AlgorithmCiftiCorrelation(ProgressObject* myProgObj,
         CaretLogInfo("computing " + AString::number(numCacheRows) + " rows at a time, reading rows as needed during processing");
     }
     vector<CaretArray<float> > outRows;
+    allocateCache(cacheFullInput ? numRows : numCacheRows);
     if (cacheFullInput)
     {
         for (int i = 0; i < numRows; ++i)
@@ -607,6 +610,26 @@ void AlgorithmCiftiCorrelation::init(const CiftiFile* input, const vector<float>
     }
 }
 
+void AlgorithmCiftiCorrelation::allocateCache(const int& numCacheRows)
+{//every thread reads every cache row, so touch the memory from all threads to spread its pages over the memory of every socket, rather than filling one socket's memory from the reading thread
+    int oldSize = (int)m_rowCache.size();
+    if (numCacheRows <= oldSize) return;
+#ifdef CARET_OMP
+    static bool hinted = false;//once per process, batch mode can run many correlations
+    if (!hinted && omp_get_max_threads() > 1 && getenv("OMP_PROC_BIND") == NULL)
+    {//unbound threads can migrate after touching the pages, so the spread isn't guaranteed
+        hinted = true;
+        CaretLogInfo("OMP_PROC_BIND is not set, so the correlation row cache may not be spread across sockets, see 'wb_command -parallel-help'");
+    }
+#endif
+    m_rowCache.resize(numCacheRows);
+#pragma omp CARET_PARFOR schedule(static)
+    for (int i = oldSize; i < numCacheRows; ++i)
+    {
+        m_rowCache[i].m_row.resize(m_numCols);
+    }
+}
+
 void AlgorithmCiftiCorrelation::cacheRow(const int& ciftiIndex)
 {
     CaretAssertVectorIndex(m_rowInfo, ciftiIndex);
@@ -614,6 +637,9 @@ void AlgorithmCiftiCorrelation::cacheRow(const int& ciftiIndex)
     if (m_cacheUsed >= (int)m_rowCache.size())
     {
         m_rowCache.push_back(CacheRow());
+    }
+    if ((int)m_rowCache[m_cacheUsed].m_row.size() != m_numCols)
+    {
         m_rowCache[m_cacheUsed].m_row.resize(m_numCols);
     }
     m_rowCache[m_cacheUsed].m_ciftiIndex = ciftiIndex;
@@ -26,7 +26,9 @@
 #include "AlgorithmLabelDilate.h"
 #include "AlgorithmMetricDilate.h"
 #include "AlgorithmVolumeDilate.h"
+#include "CaretPointer.h"
 #include "CiftiFile.h"
+#include "CiftiStructureScheduler.h"
 #include "LabelFile.h"
 #include "MetricFile.h"
 #include "SurfaceFile.h"
@@ -206,6 +208,8 @@ AlgorithmCiftiDilate::AlgorithmCiftiDilate(ProgressObject* myProgObj, const Cift
         }
     }
     myCiftiOut->setCiftiXML(myXML);
+    bool isLabel = (myXML.getMappingType(1 - myDir) == CIFTI_INDEX_TYPE_LABELS);
+    CiftiStructureScheduler myScheduler;//structures are independent, so dilate them concurrently
     for (int whichStruct = 0; whichStruct < (int)surfaceList.size(); ++whichStruct)
     {
         const SurfaceFile* mySurf = NULL;
@@ -227,70 +231,85 @@ AlgorithmCiftiDilate::AlgorithmCiftiDilate(ProgressObject* myProgObj, const Cift
             default:
                 break;
         }
-        MetricFile badRoiMetric, dataRoiMetric;
-        MetricFile* badRoiPtr = NULL;
-        if (myBadRoi != NULL)
+        StructureEnum::Enum myStruct = surfaceList[whichStruct];
+        myScheduler.addTask(myXML.getSurfaceNumberOfNodes(myDir, myStruct), [=]() -> CiftiStructureScheduler::StoreFunction
         {
-            AlgorithmCiftiSeparate(NULL, myBadRoi, CiftiXMLOld::ALONG_COLUMN, surfaceList[whichStruct], &badRoiMetric);
-            badRoiPtr = &badRoiMetric;
-        }
-        if (myXML.getMappingType(1 - myDir) == CIFTI_INDEX_TYPE_LABELS)
-        {
-            LabelFile myLabel, myLabelOut;
-            AlgorithmCiftiSeparate(NULL, myCifti, myDir, surfaceList[whichStruct], &myLabel);
-            AlgorithmLabelDilate(NULL, &myLabel, mySurf, surfDist, &myLabelOut, badRoiPtr, -1, myCorrAreas);
-            AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, surfaceList[whichStruct], &myLabelOut);
-        } else {
-            MetricFile myMetric, myMetricOut;
-            AlgorithmMetricDilate::Method myMethod = AlgorithmMetricDilate::WEIGHTED;
-            if (nearest) myMethod = AlgorithmMetricDilate::NEAREST;
-            AlgorithmCiftiSeparate(NULL, myCifti, myDir, surfaceList[whichStruct], &myMetric, &dataRoiMetric);
-            AlgorithmMetricDilate(NULL, &myMetric, mySurf, surfDist, &myMetricOut, badRoiPtr, &dataRoiMetric, -1, myMethod, 2.0f, myCorrAreas);
-            AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, surfaceList[whichStruct], &myMetricOut);
-        }
+            MetricFile badRoiMetric, dataRoiMetric;
+            MetricFile* badRoiPtr = NULL;
+            if (myBadRoi != NULL)
+            {
+                AlgorithmCiftiSeparate(NULL, myBadRoi, CiftiXMLOld::ALONG_COLUMN, myStruct, &badRoiMetric);
+                badRoiPtr = &badRoiMetric;
+            }
+            if (isLabel)
+            {
+                LabelFile myLabel;
+                CaretPointer<LabelFile> myLabelOut(new LabelFile());
+                AlgorithmCiftiSeparate(NULL, myCifti, myDir, myStruct, &myLabel);
+                AlgorithmLabelDilate(NULL, &myLabel, mySurf, surfDist, myLabelOut, badRoiPtr, -1, myCorrAreas);
+                return [=]() { AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, myStruct, myLabelOut); };
+            } else {
+                MetricFile myMetric;
+                CaretPointer<MetricFile> myMetricOut(new MetricFile());
+                AlgorithmMetricDilate::Method myMethod = AlgorithmMetricDilate::WEIGHTED;
+                if (nearest) myMethod = AlgorithmMetricDilate::NEAREST;
+                AlgorithmCiftiSeparate(NULL, myCifti, myDir, myStruct, &myMetric, &dataRoiMetric);
+                AlgorithmMetricDilate(NULL, &myMetric, mySurf, surfDist, myMetricOut, badRoiPtr, &dataRoiMetric, -1, myMethod, 2.0f, myCorrAreas);
+                return [=]() { AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, myStruct, myMetricOut); };
+            }
+        });
+    }
+    AlgorithmVolumeDilate::Method myVolMethod = AlgorithmVolumeDilate::WEIGHTED;
+    if (nearest)
+    {
+        myVolMethod = AlgorithmVolumeDilate::NEAREST;
     }
     if (mergedVolume)
     {
         if (myXML.hasVolumeData(myDir))
         {
-            VolumeFile myVol, roiVol, myVolOut;
-            VolumeFile* roiPtr = NULL;
-            int64_t offset[3];
-            AlgorithmVolumeDilate::Method myMethod = AlgorithmVolumeDilate::WEIGHTED;
-            if (nearest)
+            vector<CiftiVolumeMap> myVolMap;
+            myXML.getVolumeMap(myDir, myVolMap);
+            myScheduler.addTask(myVolMap.size(), [=]() -> CiftiStructureScheduler::StoreFunction
             {
-                myMethod = AlgorithmVolumeDilate::NEAREST;
-            }
-            if (myBadRoi != NULL)
-            {
-                AlgorithmCiftiSeparate(NULL, myBadRoi, CiftiXMLOld::ALONG_COLUMN, &roiVol, offset, NULL, true);
-                roiPtr = &roiVol;
-            }
-            AlgorithmCiftiSeparate(NULL, myCifti, myDir, &myVol, offset, NULL, true);
-            AlgorithmVolumeDilate(NULL, &myVol, volDist, myMethod, &myVolOut, roiPtr);
-            AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, &myVolOut, true);
+                VolumeFile myVol, roiVol;
+                CaretPointer<VolumeFile> myVolOut(new VolumeFile());
+                VolumeFile* roiPtr = NULL;
+                int64_t offset[3];
+                if (myBadRoi != NULL)
+                {
+                    AlgorithmCiftiSeparate(NULL, myBadRoi, CiftiXMLOld::ALONG_COLUMN, &roiVol, offset, NULL, true);
+                    roiPtr = &roiVol;
+                }
+                AlgorithmCiftiSeparate(NULL, myCifti, myDir, &myVol, offset, NULL, true);
+                AlgorithmVolumeDilate(NULL, &myVol, volDist, myVolMethod, myVolOut, roiPtr);
+                return [=]() { AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, myVolOut, true); };
+            });
         }
     } else {
-        AlgorithmVolumeDilate::Method myMethod = AlgorithmVolumeDilate::WEIGHTED;
-        if (nearest)
-        {
-            myMethod = AlgorithmVolumeDilate::NEAREST;
-        }
         for (int whichStruct = 0; whichStruct < (int)volumeList.size(); ++whichStruct)
         {
-            VolumeFile myVol, badRoiVol, myVolOut, dataRoiVol;
-            VolumeFile* roiPtr = NULL;
-            int64_t offset[3];
-            if (myBadRoi != NULL)
+            StructureEnum::Enum myStruct = volumeList[whichStruct];
+            vector<CiftiVolumeMap> myVolMap;
+            myXML.getVolumeStructureMap(myDir, myVolMap, myStruct);
+            myScheduler.addTask(myVolMap.size(), [=]() -> CiftiStructureScheduler::StoreFunction
             {
-                AlgorithmCiftiSeparate(NULL, myBadRoi, CiftiXMLOld::ALONG_COLUMN, volumeList[whichStruct], &badRoiVol, offset, NULL, true);
-                roiPtr = &badRoiVol;
-            }
-            AlgorithmCiftiSeparate(NULL, myCifti, myDir, volumeList[whichStruct], &myVol, offset, &dataRoiVol, true);
-            AlgorithmVolumeDilate(NULL, &myVol, volDist, myMethod, &myVolOut, roiPtr, &dataRoiVol);
-            AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, volumeList[whichStruct], &myVolOut, true);
+                VolumeFile myVol, badRoiVol, dataRoiVol;
+                CaretPointer<VolumeFile> myVolOut(new VolumeFile());
+                VolumeFile* roiPtr = NULL;
+                int64_t offset[3];
+                if (myBadRoi != NULL)
+                {
+                    AlgorithmCiftiSeparate(NULL, myBadRoi, CiftiXMLOld::ALONG_COLUMN, myStruct, &badRoiVol, offset, NULL, true);
+                    roiPtr = &badRoiVol;
+                }
+                AlgorithmCiftiSeparate(NULL, myCifti, myDir, myStruct, &myVol, offset, &dataRoiVol, true);
+                AlgorithmVolumeDilate(NULL, &myVol, volDist, myVolMethod, myVolOut, roiPtr, &dataRoiVol);
+                return [=]() { AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, myStruct, myVolOut, true); };
+            });
         }
     }
+    myScheduler.run();
 }
 
 float AlgorithmCiftiDilate::getAlgorithmInternalWeight()
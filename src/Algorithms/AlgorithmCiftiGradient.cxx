@@ -28,6 +28,8 @@
 #include "SurfaceFile.h"
 #include "AlgorithmCiftiSeparate.h"
 #include "AlgorithmCiftiReplaceStructure.h"
+#include "CaretPointer.h"
+#include "CiftiStructureScheduler.h"
 
 #include <vector>
 
@@ -250,98 +252,127 @@ AlgorithmCiftiGradient::AlgorithmCiftiGradient(ProgressObject* myProgObj, const
     {
         ciftiVectorsOut->setCiftiXML(myVecXML);
     }
+    vector<SurfaceFile*> structSurfs(surfaceList.size(), NULL);
+    vector<const MetricFile*> structAreas(surfaceList.size(), NULL);
     for (int whichStruct = 0; whichStruct < (int)surfaceList.size(); ++whichStruct)
     {
-        SurfaceFile* mySurf = NULL;
-        const MetricFile* myAreas = NULL;
         switch (surfaceList[whichStruct])
         {
             case StructureEnum::CORTEX_LEFT:
-                mySurf = myLeftSurf;
-                myAreas = myLeftAreas;
+                structSurfs[whichStruct] = myLeftSurf;
+                structAreas[whichStruct] = myLeftAreas;
                 break;
             case StructureEnum::CORTEX_RIGHT:
-                mySurf = myRightSurf;
-                myAreas = myRightAreas;
+                structSurfs[whichStruct] = myRightSurf;
+                structAreas[whichStruct] = myRightAreas;
                 break;
             case StructureEnum::CEREBELLUM:
-                mySurf = myCerebSurf;
-                myAreas = myCerebAreas;
+                structSurfs[whichStruct] = myCerebSurf;
+                structAreas[whichStruct] = myCerebAreas;
                 break;
             default:
                 break;
         }
-        MetricFile myMetric, myRoi, myMetricOut, vectorsOut, *vectorPtr = NULL;
-        if (ciftiVectorsOut != NULL) vectorPtr = &vectorsOut;
-        AlgorithmCiftiSeparate(NULL, myCifti, myDir, surfaceList[whichStruct], &myMetric, &myRoi);
-        AlgorithmMetricGradient(NULL, mySurf, &myMetric, &myMetricOut, vectorPtr, surfKern, &myRoi, false, -1, myAreas);
-        if (outputAverage)
+    }
+    bool sharedSurface = false;//metric gradient computes normals on the surface, so structures given the same surface object can't run at the same time
+    for (int i = 0; i < (int)structSurfs.size(); ++i)
+    {
+        for (int j = i + 1; j < (int)structSurfs.size(); ++j)
+        {
+            if (structSurfs[i] == structSurfs[j]) sharedSurface = true;
+        }
+    }
+    CiftiStructureScheduler myScheduler(!sharedSurface);//structures are independent, so process them concurrently
+    for (int whichStruct = 0; whichStruct < (int)surfaceList.size(); ++whichStruct)
+    {
+        SurfaceFile* mySurf = structSurfs[whichStruct];
+        const MetricFile* myAreas = structAreas[whichStruct];
+        StructureEnum::Enum myStruct = surfaceList[whichStruct];
+        myScheduler.addTask(myDenseMap.getSurfaceNumberOfNodes(myStruct), [=]() -> CiftiStructureScheduler::StoreFunction
         {
-            int numNodes = myMetricOut.getNumberOfNodes(), numCols = myMetricOut.getNumberOfColumns();
-            vector<double> accum(numNodes, 0.0);//use double for numerical stability
-            for (int i = 0; i < numCols; ++i)
+            MetricFile myMetric, myRoi;
+            CaretPointer<MetricFile> myMetricOut(new MetricFile()), vectorsOut;
+            if (ciftiVectorsOut != NULL) vectorsOut.grabNew(new MetricFile());
+            AlgorithmCiftiSeparate(NULL, myCifti, myDir, myStruct, &myMetric, &myRoi);
+            AlgorithmMetricGradient(NULL, mySurf, &myMetric, myMetricOut, vectorsOut, surfKern, &myRoi, false, -1, myAreas);
+            if (outputAverage)
             {
-                const float* column = myMetricOut.getValuePointerForColumn(i);
-                for (int j = 0; j < numNodes; ++j)
+                int numNodes = myMetricOut->getNumberOfNodes(), numCols = myMetricOut->getNumberOfColumns();
+                vector<double> accum(numNodes, 0.0);//use double for numerical stability
+                for (int i = 0; i < numCols; ++i)
                 {
-                    accum[j] += column[j];
+                    const float* column = myMetricOut->getValuePointerForColumn(i);
+                    for (int j = 0; j < numNodes; ++j)
+                    {
+                        accum[j] += column[j];
+                    }
                 }
+                vector<float> temparray(numNodes);//copy result into float array so it can be put into a metric, and then into cifti (yes, really)
+                for (int i = 0; i < numNodes; ++i)
+                {
+                    temparray[i] = (float)(accum[i] / numCols);
+                }
+                myMetricOut->setNumberOfNodesAndColumns(numNodes, 1);
+                myMetricOut->setValuesForColumn(0, temparray.data());
+                return [=]() { AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, CiftiXML::ALONG_COLUMN, myStruct, myMetricOut); };//average always outputs a dscalar, so always along column
             }
-            vector<float> temparray(numNodes);//copy result into float array so it can be put into a metric, and then into cifti (yes, really)
-            for (int i = 0; i < numNodes; ++i)
+            return [=]()
             {
-                temparray[i] = (float)(accum[i] / numCols);
-            }
-            myMetricOut.setNumberOfNodesAndColumns(numNodes, 1);
-            myMetricOut.setValuesForColumn(0, temparray.data());
-            AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, CiftiXML::ALONG_COLUMN, surfaceList[whichStruct], &myMetricOut);//average always outputs a dscalar, so always along column
-        } else {
-            AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, surfaceList[whichStruct], &myMetricOut);
-            if (ciftiVectorsOut != NULL)
-            {//is always a dscalar, so always use column
-                AlgorithmCiftiReplaceStructure(NULL, ciftiVectorsOut, CiftiXML::ALONG_COLUMN, surfaceList[whichStruct], &vectorsOut);
-            }
-        }
+                AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, myStruct, myMetricOut);
+                if (ciftiVectorsOut != NULL)
+                {//is always a dscalar, so always use column
+                    AlgorithmCiftiReplaceStructure(NULL, ciftiVectorsOut, CiftiXML::ALONG_COLUMN, myStruct, vectorsOut);
+                }
+            };
+        });
     }
     for (int whichStruct = 0; whichStruct < (int)volumeList.size(); ++whichStruct)
     {
-        VolumeFile myVol, myRoi, myVolOut, vecVolOut, *vecVolPtr = NULL;
-        if (ciftiVectorsOut != NULL) vecVolPtr = &vecVolOut;
-        int64_t offset[3];
-        AlgorithmCiftiSeparate(NULL, myCifti, myDir, volumeList[whichStruct], &myVol, offset, &myRoi, true);
-        AlgorithmVolumeGradient(NULL, &myVol, &myVolOut, volKern, &myRoi, vecVolPtr);
-        if (outputAverage)
+        StructureEnum::Enum myStruct = volumeList[whichStruct];
+        myScheduler.addTask(myDenseMap.getVolumeStructureMap(myStruct).size(), [=]() -> CiftiStructureScheduler::StoreFunction
         {
-            vector<int64_t> myDims;
-            myVolOut.getDimensions(myDims);
-            int64_t frameSize = myDims[0] * myDims[1] * myDims[2];
-            vector<double> accum(frameSize, 0.0);
-            for (int64_t i = 0; i < myDims[3]; ++i)
+            VolumeFile myVol, myRoi;
+            CaretPointer<VolumeFile> myVolOut(new VolumeFile()), vecVolOut;
+            if (ciftiVectorsOut != NULL) vecVolOut.grabNew(new VolumeFile());
+            int64_t offset[3];
+            AlgorithmCiftiSeparate(NULL, myCifti, myDir, myStruct, &myVol, offset, &myRoi, true);
+            AlgorithmVolumeGradient(NULL, &myVol, myVolOut, volKern, &myRoi, vecVolOut);
+            if (outputAverage)
             {
-                const float* myFrame = myVolOut.getFrame(i);
-                for (int64_t j = 0; j < frameSize; ++j)
+                vector<int64_t> myDims;
+                myVolOut->getDimensions(myDims);
+                int64_t frameSize = myDims[0] * myDims[1] * myDims[2];
+                vector<double> accum(frameSize, 0.0);
+                for (int64_t i = 0; i < myDims[3]; ++i)
                 {
-                    accum[j] += myFrame[j];
+                    const float* myFrame = myVolOut->getFrame(i);
+                    for (int64_t j = 0; j < frameSize; ++j)
+                    {
+                        accum[j] += myFrame[j];
+                    }
                 }
+                vector<float> temparray(frameSize);
+                for (int64_t i = 0; i < frameSize; ++i)
+                {
+                    temparray[i] = (float)(accum[i] / myDims[3]);
+                }
+                vector<int64_t> newDims = myDims;
+                newDims.resize(3);
+                myVolOut->reinitialize(newDims, myVol.getSform());
+                myVolOut->setFrame(temparray.data());
+                return [=]() { AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, CiftiXML::ALONG_COLUMN, myStruct, myVolOut, true); };
             }
-            vector<float> temparray(frameSize);
-            for (int64_t i = 0; i < frameSize; ++i)
-            {
-                temparray[i] = (float)(accum[i] / myDims[3]);
-            }
-            vector<int64_t> newDims = myDims;
-            newDims.resize(3);
-            myVolOut.reinitialize(newDims, myVol.getSform());
-            myVolOut.setFrame(temparray.data());
-            AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, CiftiXML::ALONG_COLUMN, volumeList[whichStruct], &myVolOut, true);
-        } else {
-            AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, volumeList[whichStruct], &myVolOut, true);
-            if (ciftiVectorsOut != NULL)
+            return [=]()
             {
-                AlgorithmCiftiReplaceStructure(NULL, ciftiVectorsOut, CiftiXML::ALONG_COLUMN, volumeList[whichStruct], &vecVolOut, true);
-            }
-        }
+                AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, myStruct, myVolOut, true);
+                if (ciftiVectorsOut != NULL)
+                {
+                    AlgorithmCiftiReplaceStructure(NULL, ciftiVectorsOut, CiftiXML::ALONG_COLUMN, myStruct, vecVolOut, true);
+                }
+            };
+        });
     }
+    myScheduler.run();
 }
 
 float AlgorithmCiftiGradient::getAlgorithmInternalWeight()
@@ -22,9 +22,9 @@
 #include "AlgorithmException.h"
 
 #include "CiftiFile.h"
+#include "LabelProbabilityAccumulator.h"
 
-#include <cmath>
-#include <map>
+#include <algorithm>
 #include <vector>
 
 using namespace caret;
@@ -76,67 +76,44 @@ AlgorithmCiftiLabelProbability::AlgorithmCiftiLabelProbability(ProgressObject* m
         throw AlgorithmException("input cifti file does not have the mapping types of a dlabel file");
     }
     const CiftiLabelsMap& inputLabelMap = inputXML.getLabelsMap(CiftiXML::ALONG_ROW);
-    int64_t numInMaps = inputLabelMap.getLength();
-    vector<map<int, int> > keyToOutMapLookup(numInMaps);//we match labels by name, not by key - since cifti files are more memory efficient than volume files, do it the fast way
-    map<AString, int> nameToOutMap;
+    int64_t numInMaps = inputLabelMap.getLength(), colSize = inputXML.getDimensionLength(CiftiXML::ALONG_COLUMN);
+    LabelProbabilityAccumulator myAccum(colSize, excludeUnlabeled);//we match labels by name, not by key
+    vector<int> tableHandles(numInMaps);
     for (int64_t m = 0; m < numInMaps; ++m)
     {
-        const GiftiLabelTable* mapTable = inputLabelMap.getMapLabelTable(m);
-        set<int32_t> mapKeys = mapTable->getKeys();
-        int32_t unlabeledKey = -1;//don't request it from the table if we aren't going to skip it, because requesting it can add it to the table
-        if (excludeUnlabeled)
-        {
-            unlabeledKey = mapTable->getUnassignedLabelKey();
-        }
-        for (set<int32_t>::iterator iter = mapKeys.begin(); iter != mapKeys.end(); ++iter)//order by key value
-        {
-            if (excludeUnlabeled && *iter == unlabeledKey) continue;//skip to next key
-            const AString thisName = mapTable->getLabelName(*iter);
-            map<AString, int>::iterator search = nameToOutMap.find(thisName);
-            int outMap = -1;
-            if (search == nameToOutMap.end())
-            {
-                outMap = nameToOutMap.size();//sequential integers starting from 0
-                nameToOutMap[thisName] = outMap;
-            } else {
-                outMap = search->second;
-            }
-            keyToOutMapLookup[m][*iter] = outMap;
-        }
-    }//for simplicity, do the actual processing in a second loop
-    int64_t numOutMaps = nameToOutMap.size(), colSize = inputXML.getDimensionLength(CiftiXML::ALONG_COLUMN);
-    vector<vector<int> > counts(numOutMaps, vector<int>(colSize, 0));
-    for (int64_t row = 0; row < colSize; ++row)
+        tableHandles[m] = myAccum.addLabelTable(inputLabelMap.getMapLabelTable(m));
+    }
+    myAccum.startRowMajorMaps(tableHandles);
+    const int64_t BLOCK_ROWS = 4096;//read serially, count in parallel
+    vector<float> scratchBlock(min(BLOCK_ROWS, colSize) * numInMaps);
+    for (int64_t firstRow = 0; firstRow < colSize; firstRow += BLOCK_ROWS)
     {
-        vector<float> scratchRow(numInMaps);
-        inputLabel->getRow(scratchRow.data(), row);
-        for (int64_t m = 0; m < numInMaps; ++m)
+        int64_t numRows = min(BLOCK_ROWS, colSize - firstRow);
+        for (int64_t r = 0; r < numRows; ++r)
         {
-            int thiskey = (int)floor(scratchRow[m] + 0.5f);
-            map<int, int>::iterator search = keyToOutMapLookup[m].find(thiskey);
-            if (search != keyToOutMapLookup[m].end())
-            {
-                ++counts[search->second][row];
-            }
+            inputLabel->getRow(scratchBlock.data() + r * numInMaps, firstRow + r);
         }
+        myAccum.addRows(firstRow, numRows, scratchBlock.data());
     }
+    int64_t numOutMaps = myAccum.getNumberOfLabels();
     CiftiXML outXML;
     outXML.setNumberOfDimensions(2);
     outXML.setMap(CiftiXML::ALONG_COLUMN, inputXML.getBrainModelsMap(CiftiXML::ALONG_COLUMN));
     CiftiScalarsMap outRowMap;
     outRowMap.setLength(numOutMaps);
-    for (map<AString, int>::iterator iter = nameToOutMap.begin(); iter != nameToOutMap.end(); ++iter)
+    for (int64_t m = 0; m < numOutMaps; ++m)
     {
-        outRowMap.setMapName(iter->second, iter->first);
+        outRowMap.setMapName(m, myAccum.getLabelName(m));
     }
     outXML.setMap(CiftiXML::ALONG_ROW, outRowMap);
     outputCifti->setCiftiXML(outXML);
+    const float divisor = (float)numInMaps;
+    vector<float> scratchRow(numOutMaps);
     for (int64_t row = 0; row < colSize; ++row)
     {
-        vector<float> scratchRow(numOutMaps);
         for (int64_t m = 0; m < numOutMaps; ++m)
         {
-            scratchRow[m] = ((float)counts[m][row]) / numInMaps;
+            scratchRow[m] = ((float)myAccum.getCounts(m)[row]) / divisor;
         }
         outputCifti->setRow(scratchRow.data(), row);
     }
@@ -24,6 +24,7 @@
 #include "CiftiFile.h"
 #include "GiftiLabel.h"
 #include "GiftiLabelTable.h"
+#include "GiftiLabelTableLookup.h"
 #include "MetricFile.h"
 #include "MultiDimIterator.h"
 #include "ReductionOperation.h"
@@ -868,17 +869,18 @@ CiftiParcelsMap AlgorithmCiftiParcellate::parcellateMapping(const CiftiFile* myC
     if (includeEmpty)
     {//if we include empty, then the dlabel file by itself determines the entire parcel map, ignoring the data map
         const vector<StructureEnum::Enum> labelSurfList = labelDenseMap.getSurfaceStructureList();
-        const set<int32_t> allLabelKeys = myLabelTable->getKeys();
-        map<int32_t, int32_t> keyToParcel;
+        const CaretPointer<const GiftiLabelTableLookup> labelLookup = myLabelTable->getLookup();
+        const int32_t numLabels = labelLookup->getNumberOfLabels();
+        vector<int32_t> labelToParcel(numLabels, -1);
         int32_t count = 0;
         vector<CiftiParcelsMap::Parcel> parcelList;
-        for (set<int32_t>::const_iterator iter = allLabelKeys.begin(); iter != allLabelKeys.end(); ++iter)
+        for (int32_t label = 0; label < numLabels; ++label)//label indices are in key order
         {
-            if (*iter != unusedKey)
+            if (labelLookup->getKey(label) != unusedKey)
             {
-                keyToParcel[*iter] = count;
+                labelToParcel[label] = count;
                 parcelList.push_back(CiftiParcelsMap::Parcel());
-                parcelList.back().m_name = myLabelTable->getLabelName(*iter);
+                parcelList.back().m_name = labelLookup->getLabel(label)->getName();
                 ++count;
             }
         }
@@ -897,10 +899,10 @@ CiftiParcelsMap AlgorithmCiftiParcellate::parcellateMapping(const CiftiFile* myC
             for (int64_t j = 0; j < (int64_t)labelSurfMap.size(); ++j)
             {
                 int labelKey = (int)floor(labelData[labelSurfMap[j].m_ciftiIndex] + 0.5f);
-                map<int32_t, int32_t>::iterator found = keyToParcel.find(labelKey);//could be unlabeled, or wild key value
-                if (found != keyToParcel.end())
+                int32_t label = labelLookup->find(labelKey);//could be unlabeled, or wild key value
+                if (label != -1 && labelToParcel[label] != -1)
                 {
-                    int32_t whichParcel = found->second;
+                    int32_t whichParcel = labelToParcel[label];
                     parcelList[whichParcel].m_surfaceNodes[myStruct].insert(labelSurfMap[j].m_surfaceNode);
                     int64_t dataIndex = toParcellate.getIndexForNode(labelSurfMap[j].m_surfaceNode, myStruct);
                     if (dataIndex != -1)
@@ -914,10 +916,10 @@ CiftiParcelsMap AlgorithmCiftiParcellate::parcellateMapping(const CiftiFile* myC
         for (int64_t i = 0; i < (int64_t)labelVolMap.size(); ++i)
         {
             int labelKey = (int)floor(labelData[labelVolMap[i].m_ciftiIndex] + 0.5f);
-            map<int32_t, int32_t>::iterator found = keyToParcel.find(labelKey);//could be unlabeled, or wild key value
-            if (found != keyToParcel.end())
+            int32_t label = labelLookup->find(labelKey);//could be unlabeled, or wild key value
+            if (label != -1 && labelToParcel[label] != -1)
             {
-                int32_t whichParcel = found->second;
+                int32_t whichParcel = labelToParcel[label];
                 parcelList[whichParcel].m_voxelIndices.insert(labelVolMap[i].m_ijk);
                 int64_t dataIndex = toParcellate.getIndexForVoxel(labelVolMap[i].m_ijk);
                 if (dataIndex != -1)
@@ -931,7 +933,9 @@ CiftiParcelsMap AlgorithmCiftiParcellate::parcellateMapping(const CiftiFile* myC
             ret.addParcel(parcelList[i]);
         }
     } else {
-        map<int, pair<CiftiParcelsMap::Parcel, int> > usedKeys;//the keys from the label table that actually overlap with data in the input file
+        const CaretPointer<const GiftiLabelTableLookup> labelLookup = myLabelTable->getLookup();
+        vector<int> labelToTemp(labelLookup->getNumberOfLabels(), -1);//the labels from the label table that actually overlap with data in the input file
+        vector<CiftiParcelsMap::Parcel> tempParcels;
         for (int i = 0; i < (int)surfList.size(); ++i)
         {
             StructureEnum::Enum myStruct = surfList[i];
@@ -953,22 +957,17 @@ CiftiParcelsMap AlgorithmCiftiParcellate::parcellateMapping(const CiftiFile* myC
                         if (labelKey != unusedKey)
                         {
                             int tempVal = -1;
-                            map<int, pair<CiftiParcelsMap::Parcel, int> >::iterator iter = usedKeys.find(labelKey);
-                            if (iter == usedKeys.end())
+                            int32_t label = labelLookup->find(labelKey);
+                            if (label != -1)//ignore values that aren't in the label table
                             {
-                                const GiftiLabel* myLabel = myLabelTable->getLabel(labelKey);
-                                if (myLabel != NULL)//ignore values that aren't in the label table
+                                if (labelToTemp[label] == -1)
                                 {
-                                    tempVal = usedKeys.size();
-                                    CiftiParcelsMap::Parcel tempParcel;
-                                    tempParcel.m_name = myLabel->getName();
-                                    tempParcel.m_surfaceNodes[myStruct].insert(surfMap[j].m_surfaceNode);
-                                    usedKeys[labelKey] = pair<CiftiParcelsMap::Parcel, int>(tempParcel, tempVal);
+                                    labelToTemp[label] = (int)tempParcels.size();
+                                    tempParcels.push_back(CiftiParcelsMap::Parcel());
+                                    tempParcels.back().m_name = labelLookup->getLabel(label)->getName();
                                 }
-                            } else {
-                                tempVal = iter->second.second;
-                                CiftiParcelsMap::Parcel& tempParcel = iter->second.first;
-                                tempParcel.m_surfaceNodes[myStruct].insert(surfMap[j].m_surfaceNode);
+                                tempVal = labelToTemp[label];
+                                tempParcels[tempVal].m_surfaceNodes[myStruct].insert(surfMap[j].m_surfaceNode);
                             }
                             indexToParcelOut[surfMap[j].m_ciftiIndex] = tempVal;//we will remap these to be in order of label keys later
                         }
@@ -986,35 +985,33 @@ CiftiParcelsMap AlgorithmCiftiParcellate::parcellateMapping(const CiftiFile* myC
                 if (labelKey != unusedKey)
                 {
                     int tempVal = -1;
-                    map<int, pair<CiftiParcelsMap::Parcel, int> >::iterator iter = usedKeys.find(labelKey);
-                    if (iter == usedKeys.end())
+                    int32_t label = labelLookup->find(labelKey);
+                    if (label != -1)//ignore values that aren't in the label table
                     {
-                        const GiftiLabel* myLabel = myLabelTable->getLabel(labelKey);
-                        if (myLabel != NULL)//ignore values that aren't in the label table
+                        if (labelToTemp[label] == -1)
                         {
-                            tempVal = usedKeys.size();
-                            CiftiParcelsMap::Parcel tempParcel;
-                            tempParcel.m_name = myLabel->getName();
-                            tempParcel.m_voxelIndices.insert(VoxelIJK(volMap[i].m_ijk));
-                            usedKeys[labelKey] = pair<CiftiParcelsMap::Parcel, int>(tempParcel, tempVal);
+                            labelToTemp[label] = (int)tempParcels.size();
+                            tempParcels.push_back(CiftiParcelsMap::Parcel());
+                            tempParcels.back().m_name = labelLookup->getLabel(label)->getName();
                         }
-                    } else {
-                        tempVal = iter->second.second;
-                        CiftiParcelsMap::Parcel& tempParcel = iter->second.first;
-                        tempParcel.m_voxelIndices.insert(VoxelIJK(volMap[i].m_ijk));
+                        tempVal = labelToTemp[label];
+                        tempParcels[tempVal].m_voxelIndices.insert(VoxelIJK(volMap[i].m_ijk));
                     }
                     indexToParcelOut[volMap[i].m_ciftiIndex] = tempVal;//we will remap these to be in order of label keys later
                 }
             }
         }
-        int numParcels = (int)usedKeys.size();
+        int numParcels = (int)tempParcels.size();
         vector<int> valRemap(numParcels, -1);
         int count = 0;
-        for (map<int, pair<CiftiParcelsMap::Parcel, int> >::const_iterator iter = usedKeys.begin(); iter != usedKeys.end(); ++iter)
+        for (int label = 0; label < (int)labelToTemp.size(); ++label)//label indices are in key order
         {
-            valRemap[iter->second.second] = count;//build a lookup from temp values to label key rank
-            ret.addParcel(iter->second.first);
-            ++count;
+            if (labelToTemp[label] != -1)
+            {
+                valRemap[labelToTemp[label]] = count;//build a lookup from temp values to label key rank
+                ret.addParcel(tempParcels[labelToTemp[label]]);
+                ++count;
+            }
         }
         int64_t lookupSize = (int64_t)indexToParcelOut.size();
         for (int64_t i = 0; i < lookupSize; ++i)//finally, remap the temporary values to the key order of the labels
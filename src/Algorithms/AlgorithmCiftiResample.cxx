@@ -29,6 +29,7 @@
 #include "AlgorithmMetricResample.h"
 #include "AlgorithmVolumeAffineResample.h"
 #include "AlgorithmVolumeWarpfieldResample.h"
+#include "CaretPointer.h"
 #include "CiftiFile.h"
 #include "LabelFile.h"
 #include "MetricFile.h"
@@ -729,6 +730,7 @@ AlgorithmCiftiResample::AlgorithmCiftiResample(ProgressObject* myProgObj, const
     myCiftiOut->setCiftiXML(myOutXML);
     if (direction == CiftiXML::ALONG_COLUMN)
     {
+        CiftiStructureScheduler myScheduler;//structures are independent, so resample them concurrently
         for (int i = 0; i < (int)surfList.size(); ++i)//and now, resampling
         {
             const SurfaceFile* curSphere = NULL, *newSphere = NULL;
@@ -757,12 +759,21 @@ AlgorithmCiftiResample::AlgorithmCiftiResample(ProgressObject* myProgObj, const
                     throw AlgorithmException("unsupported surface structure: " + StructureEnum::toGuiName(surfList[i]));
                     break;
             }
-            processSurfaceComponent(myCiftiIn, direction, surfList[i], mySurfMethod, myCiftiOut, surfLargest, surfdilatemm, curSphere, newSphere, curAreas, newAreas, surfDilateMethod, surfDilateExponent);
+            StructureEnum::Enum myStruct = surfList[i];
+            myScheduler.addTask(outModels.getSurfaceNumberOfNodes(myStruct), [=]()
+            {
+                return processSurfaceComponent(myCiftiIn, direction, myStruct, mySurfMethod, myCiftiOut, surfLargest, surfdilatemm, curSphere, newSphere, curAreas, newAreas, surfDilateMethod, surfDilateExponent);
+            });
         }
         for (int i = 0; i < (int)volList.size(); ++i)
         {
-            processVolumeWarpfield(myCiftiIn, direction, volList[i], myVolMethod, myCiftiOut, voldilatemm, warpfield, volDilateMethod, volDilateExponent);
+            StructureEnum::Enum myStruct = volList[i];
+            myScheduler.addTask(outModels.getVolumeStructureMap(myStruct).size(), [=]()
+            {
+                return processVolumeWarpfield(myCiftiIn, direction, myStruct, myVolMethod, myCiftiOut, voldilatemm, warpfield, volDilateMethod, volDilateExponent);
+            });
         }
+        myScheduler.run();
     } else {//avoid cifti separate/replace with ALONG_ROW
         vector<StructureEnum::Enum> surfList = outModels.getSurfaceStructureList(), volList = outModels.getVolumeStructureList();
         int numSurfStructs = (int)surfList.size(), numVolStructs = (int)volList.size();
@@ -852,6 +863,7 @@ AlgorithmCiftiResample::AlgorithmCiftiResample(ProgressObject* myProgObj, const
     myCiftiOut->setCiftiXML(myOutXML);
     if (direction == CiftiXML::ALONG_COLUMN)
     {
+        CiftiStructureScheduler myScheduler;//structures are independent, so resample them concurrently
         for (int i = 0; i < (int)surfList.size(); ++i)//and now, resampling
         {
             const SurfaceFile* curSphere = NULL, *newSphere = NULL;
@@ -880,12 +892,21 @@ AlgorithmCiftiResample::AlgorithmCiftiResample(ProgressObject* myProgObj, const
                     throw AlgorithmException("unsupported surface structure: " + StructureEnum::toGuiName(surfList[i]));
                     break;
             }
-            processSurfaceComponent(myCiftiIn, direction, surfList[i], mySurfMethod, myCiftiOut, surfLargest, surfdilatemm, curSphere, newSphere, curAreas, newAreas, surfDilateMethod, surfDilateExponent);
+            StructureEnum::Enum myStruct = surfList[i];
+            myScheduler.addTask(outModels.getSurfaceNumberOfNodes(myStruct), [=]()
+            {
+                return processSurfaceComponent(myCiftiIn, direction, myStruct, mySurfMethod, myCiftiOut, surfLargest, surfdilatemm, curSphere, newSphere, curAreas, newAreas, surfDilateMethod, surfDilateExponent);
+            });
         }
         for (int i = 0; i < (int)volList.size(); ++i)
         {
-            processVolumeAffine(myCiftiIn, direction, volList[i], myVolMethod, myCiftiOut, voldilatemm, affine, volDilateMethod, volDilateExponent);
+            StructureEnum::Enum myStruct = volList[i];
+            myScheduler.addTask(outModels.getVolumeStructureMap(myStruct).size(), [=]()
+            {
+                return processVolumeAffine(myCiftiIn, direction, myStruct, myVolMethod, myCiftiOut, voldilatemm, affine, volDilateMethod, volDilateExponent);
+            });
         }
+        myScheduler.run();
     } else {//avoid cifti separate/replace with ALONG_ROW
         vector<StructureEnum::Enum> surfList = outModels.getSurfaceStructureList(), volList = outModels.getVolumeStructureList();
         int numSurfStructs = (int)surfList.size(), numVolStructs = (int)volList.size();
@@ -947,7 +968,7 @@ AlgorithmCiftiResample::AlgorithmCiftiResample(ProgressObject* myProgObj, const
     }
 }
 
-void AlgorithmCiftiResample::processSurfaceComponent(const CiftiFile* myCiftiIn, const int& direction, const StructureEnum::Enum& myStruct, const SurfaceResamplingMethodEnum::Enum& mySurfMethod,
+CiftiStructureScheduler::StoreFunction AlgorithmCiftiResample::processSurfaceComponent(const CiftiFile* myCiftiIn, const int& direction, const StructureEnum::Enum& myStruct, const SurfaceResamplingMethodEnum::Enum& mySurfMethod,
                                                      CiftiFile* myCiftiOut, const bool& surfLargest, const float& surfdilatemm, const SurfaceFile* curSphere, const SurfaceFile* newSphere,
                                                      const MetricFile* curAreas, const MetricFile* newAreas,
                                                      const AlgorithmMetricDilate::Method& surfDilateMethod, const float& surfDilateExponent)
@@ -955,14 +976,14 @@ void AlgorithmCiftiResample::processSurfaceComponent(const CiftiFile* myCiftiIn,
     const CiftiXML& myInputXML = myCiftiIn->getCiftiXML();
     if (myInputXML.getMappingType(1 - direction) == CiftiMappingType::LABELS)
     {
-        LabelFile origLabel;
+        CaretPointer<LabelFile> origLabel(new LabelFile());
         MetricFile origRoi, resampleROI;
-        AlgorithmCiftiSeparate(NULL, myCiftiIn, direction, myStruct, &origLabel, &origRoi);
-        LabelFile newLabel, newDilate, *newUse = &newLabel;
+        AlgorithmCiftiSeparate(NULL, myCiftiIn, direction, myStruct, origLabel, &origRoi);
+        CaretPointer<LabelFile> newLabel(new LabelFile()), newUse = newLabel;
         if (curSphere != NULL)
         {
-            AlgorithmLabelResample(NULL, &origLabel, curSphere, newSphere, mySurfMethod, &newLabel, curAreas, newAreas, &origRoi, &resampleROI, surfLargest);
-            origLabel.clear();//delete the data we no longer need to keep memory use down
+            AlgorithmLabelResample(NULL, origLabel, curSphere, newSphere, mySurfMethod, newLabel, curAreas, newAreas, &origRoi, &resampleROI, surfLargest);
+            origLabel.grabNew(NULL);//delete the data we no longer need to keep memory use down
             if (surfdilatemm > 0.0f)
             {
                 MetricFile invertResampleROI;
@@ -972,22 +993,24 @@ void AlgorithmCiftiResample::processSurfaceComponent(const CiftiFile* myCiftiIn,
                     float tempf = (resampleROI.getValue(j, 0) > 0.0f) ? 0.0f : 1.0f;//make an inverse ROI
                     invertResampleROI.setValue(j, 0, tempf);
                 }
-                AlgorithmLabelDilate(NULL, &newLabel, newSphere, surfdilatemm, &newDilate, &invertResampleROI);
-                newLabel.clear();//ditto
-                newUse = &newDilate;
+                newUse.grabNew(new LabelFile());
+                AlgorithmLabelDilate(NULL, newLabel, newSphere, surfdilatemm, newUse, &invertResampleROI);
+                newLabel.grabNew(NULL);//ditto
             }
         } else {
-            newUse = &origLabel;
+            newUse = origLabel;
         }
-        AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, direction, myStruct, newUse);
+        return [=]() { AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, direction, myStruct, newUse); };
     } else {
-        MetricFile origMetric, origROI;
-        AlgorithmCiftiSeparate(NULL, myCiftiIn, direction, myStruct, &origMetric, &origROI);
-        MetricFile newMetric, newDilate, resampleROI, *newUse = &newMetric;
+        CaretPointer<MetricFile> origMetric(new MetricFile());
+        MetricFile origROI;
+        AlgorithmCiftiSeparate(NULL, myCiftiIn, direction, myStruct, origMetric, &origROI);
+        MetricFile resampleROI;
+        CaretPointer<MetricFile> newMetric(new MetricFile()), newUse = newMetric;
         if (curSphere != NULL)
         {
-            AlgorithmMetricResample(NULL, &origMetric, curSphere, newSphere, mySurfMethod, &newMetric, curAreas, newAreas, &origROI, &resampleROI, surfLargest);
-            origMetric.clear();//ditto
+            AlgorithmMetricResample(NULL, origMetric, curSphere, newSphere, mySurfMethod, newMetric, curAreas, newAreas, &origROI, &resampleROI, surfLargest);
+            origMetric.grabNew(NULL);//ditto
             if (surfdilatemm > 0.0f)
             {
                 MetricFile invertResampleROI;
@@ -997,18 +1020,18 @@ void AlgorithmCiftiResample::processSurfaceComponent(const CiftiFile* myCiftiIn,
                     float tempf = (resampleROI.getValue(j, 0) > 0.0f) ? 0.0f : 1.0f;//make an inverse ROI
                     invertResampleROI.setValue(j, 0, tempf);
                 }
-                AlgorithmMetricDilate(NULL, &newMetric, newSphere, surfdilatemm, &newDilate, &invertResampleROI, NULL, -1, surfDilateMethod, surfDilateExponent);//we could get the data roi from the template cifti and use it here
-                newMetric.clear();
-                newUse = &newDilate;
+                newUse.grabNew(new MetricFile());
+                AlgorithmMetricDilate(NULL, newMetric, newSphere, surfdilatemm, newUse, &invertResampleROI, NULL, -1, surfDilateMethod, surfDilateExponent);//we could get the data roi from the template cifti and use it here
+                newMetric.grabNew(NULL);
             }
         } else {
-            newUse = &origMetric;
+            newUse = origMetric;
         }
-        AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, direction, myStruct, newUse);
+        return [=]() { AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, direction, myStruct, newUse); };
     }
 }
 
-void AlgorithmCiftiResample::processVolumeWarpfield(const CiftiFile* myCiftiIn, const int& direction, const StructureEnum::Enum& myStruct, const VolumeFile::InterpType& myVolMethod,
+CiftiStructureScheduler::StoreFunction AlgorithmCiftiResample::processVolumeWarpfield(const CiftiFile* myCiftiIn, const int& direction, const StructureEnum::Enum& myStruct, const VolumeFile::InterpType& myVolMethod,
                                                     CiftiFile* myCiftiOut, const float& voldilatemm, const VolumeFile* warpfield,
                                                     const AlgorithmVolumeDilate::Method& volDilateMethod, const float& volDilateExponent)
 {
@@ -1039,16 +1062,16 @@ void AlgorithmCiftiResample::processVolumeWarpfield(const CiftiFile* myCiftiIn,
         origPad.clear();//ditto
         origProcess = &origDilate;
     }
-    VolumeFile newVolume;
+    CaretPointer<VolumeFile> newVolume(new VolumeFile());
     int64_t refdims[3], refoffset[3];
     vector<vector<float> > refsform;
     AlgorithmCiftiSeparate::getCroppedVolSpace(myCiftiOut, direction, myStruct, refdims, refsform, refoffset);
-    AlgorithmVolumeWarpfieldResample(NULL, origProcess, warpfield, refdims, refsform, myVolMethod, &newVolume);
+    AlgorithmVolumeWarpfieldResample(NULL, origProcess, warpfield, refdims, refsform, myVolMethod, newVolume);
     origProcess->clear();//ditto
-    AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, direction, myStruct, &newVolume, true);
+    return [=]() { AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, direction, myStruct, newVolume, true); };
 }
 
-void AlgorithmCiftiResample::processVolumeAffine(const CiftiFile* myCiftiIn, const int& direction, const StructureEnum::Enum& myStruct, const VolumeFile::InterpType& myVolMethod,
+CiftiStructureScheduler::StoreFunction AlgorithmCiftiResample::processVolumeAffine(const CiftiFile* myCiftiIn, const int& direction, const StructureEnum::Enum& myStruct, const VolumeFile::InterpType& myVolMethod,
                                                  CiftiFile* myCiftiOut, const float& voldilatemm, const FloatMatrix& affine,
                                                  const AlgorithmVolumeDilate::Method& volDilateMethod, const float& volDilateExponent)
 {
@@ -1079,13 +1102,13 @@ void AlgorithmCiftiResample::processVolumeAffine(const CiftiFile* myCiftiIn, con
         origPad.clear();//ditto
         origProcess = &origDilate;
     }
-    VolumeFile newVolume;
+    CaretPointer<VolumeFile> newVolume(new VolumeFile());
     int64_t refdims[3], refoffset[3];
     vector<vector<float> > refsform;
     AlgorithmCiftiSeparate::getCroppedVolSpace(myCiftiOut, direction, myStruct, refdims, refsform, refoffset);
-    AlgorithmVolumeAffineResample(NULL, origProcess, affine, refdims, refsform, myVolMethod, &newVolume);
+    AlgorithmVolumeAffineResample(NULL, origProcess, affine, refdims, refsform, myVolMethod, newVolume);
     origProcess->clear();//ditto
-    AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, direction, myStruct, &newVolume, true);
+    return [=]() { AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, direction, myStruct, newVolume, true); };
 }
 
 float AlgorithmCiftiResample::getAlgorithmInternalWeight()
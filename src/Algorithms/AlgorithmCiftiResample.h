@@ -24,6 +24,7 @@
 #include "AbstractAlgorithm.h"
 #include "AlgorithmMetricDilate.h" //for dilate method enums
 #include "AlgorithmVolumeDilate.h"
+#include "CiftiStructureScheduler.h"
 #include "FloatMatrix.h"
 #include "StructureEnum.h"
 #include "SurfaceResamplingMethodEnum.h"
@@ -36,13 +37,13 @@ namespace caret {
     class AlgorithmCiftiResample : public AbstractAlgorithm
     {
         AlgorithmCiftiResample();
-        void processSurfaceComponent(const CiftiFile* myCiftiIn, const int& direction, const StructureEnum::Enum& myStruct, const SurfaceResamplingMethodEnum::Enum& mySurfMethod,
+        CiftiStructureScheduler::StoreFunction processSurfaceComponent(const CiftiFile* myCiftiIn, const int& direction, const StructureEnum::Enum& myStruct, const SurfaceResamplingMethodEnum::Enum& mySurfMethod,
                                      CiftiFile* myCiftiOut, const bool& surfLargest, const float& surfdilatemm, const SurfaceFile* curSphere, const SurfaceFile* newSphere,
                                      const MetricFile* curAreas, const MetricFile* newAreas, const AlgorithmMetricDilate::Method& surfDilateMethod, const float& surfDilateExponent);
-        void processVolumeWarpfield(const CiftiFile* myCiftiIn, const int& direction, const StructureEnum::Enum& myStruct, const VolumeFile::InterpType& myVolMethod,
+        CiftiStructureScheduler::StoreFunction processVolumeWarpfield(const CiftiFile* myCiftiIn, const int& direction, const StructureEnum::Enum& myStruct, const VolumeFile::InterpType& myVolMethod,
                                     CiftiFile* myCiftiOut, const float& voldilatemm, const VolumeFile* warpfield,
                                     const AlgorithmVolumeDilate::Method& volDilateMethod, const float& volDilateExponent);
-        void processVolumeAffine(const CiftiFile* myCiftiIn, const int& direction, const StructureEnum::Enum& myStruct, const VolumeFile::InterpType& myVolMethod,
+        CiftiStructureScheduler::StoreFunction processVolumeAffine(const CiftiFile* myCiftiIn, const int& direction, const StructureEnum::Enum& myStruct, const VolumeFile::InterpType& myVolMethod,
                                  CiftiFile* myCiftiOut, const float& voldilatemm, const FloatMatrix& affine,
                                  const AlgorithmVolumeDilate::Method& volDilateMethod, const float& volDilateExponent);
     protected:
@@ -28,6 +28,8 @@
 #include "SurfaceFile.h"
 #include "AlgorithmCiftiSeparate.h"
 #include "AlgorithmCiftiReplaceStructure.h"
+#include "CaretPointer.h"
+#include "CiftiStructureScheduler.h"
 
 using namespace caret;
 using namespace std;
@@ -226,6 +228,7 @@ AlgorithmCiftiSmoothing::AlgorithmCiftiSmoothing(ProgressObject* myProgObj, cons
         }
     }
     myCiftiOut->setCiftiXML(myXML);
+    CiftiStructureScheduler myScheduler;//structures are independent, so smooth them concurrently
     for (int whichStruct = 0; whichStruct < (int)surfaceList.size(); ++whichStruct)
     {
         const SurfaceFile* mySurf = NULL;
@@ -247,55 +250,77 @@ AlgorithmCiftiSmoothing::AlgorithmCiftiSmoothing(ProgressObject* myProgObj, cons
             default:
                 break;
         }
-        MetricFile myMetric, myRoi, myMetricOut;
-        AlgorithmCiftiSeparate(NULL, myCifti, myDir, surfaceList[whichStruct], &myMetric, &myRoi);
-        if (surfKern > 0.0f)
+        StructureEnum::Enum myStruct = surfaceList[whichStruct];
+        myScheduler.addTask(myXML.getSurfaceNumberOfNodes(myDir, myStruct), [=]() -> CiftiStructureScheduler::StoreFunction
         {
-            if (roiCifti != NULL)
-            {//due to above testing, we know the structure mask is the same, so just overwrite the ROI from the mask
-                AlgorithmCiftiSeparate(NULL, roiCifti, CiftiXMLOld::ALONG_COLUMN, surfaceList[whichStruct], &myRoi);
+            CaretPointer<MetricFile> myMetric(new MetricFile()), myMetricOut(new MetricFile());
+            MetricFile myRoi;
+            AlgorithmCiftiSeparate(NULL, myCifti, myDir, myStruct, myMetric, &myRoi);
+            if (surfKern > 0.0f)
+            {
+                if (roiCifti != NULL)
+                {//due to above testing, we know the structure mask is the same, so just overwrite the ROI from the mask
+                    AlgorithmCiftiSeparate(NULL, roiCifti, CiftiXMLOld::ALONG_COLUMN, myStruct, &myRoi);
+                }
+                AlgorithmMetricSmoothing(NULL, mySurf, myMetric, surfKern, myMetricOut, &myRoi, false, fixZerosSurf, -1, myAreas);
+                myMetric.grabNew(NULL);//delete the data we no longer need to keep memory use down
+            } else {
+                myMetricOut = myMetric;
             }
-            AlgorithmMetricSmoothing(NULL, mySurf, &myMetric, surfKern, &myMetricOut, &myRoi, false, fixZerosSurf, -1, myAreas);
-            AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, surfaceList[whichStruct], &myMetricOut);
-        } else {
-            AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, surfaceList[whichStruct], &myMetric);
-        }
+            return [=]() { AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, myStruct, myMetricOut); };
+        });
     }
     if (mergedVolume)
     {
-        VolumeFile myVol, myRoi, myVolOut;
-        int64_t offset[3];
-        AlgorithmCiftiSeparate(NULL, myCifti, myDir, &myVol, offset, &myRoi, true);
-        if (volKern > 0.0f)
-        {
-            if (roiCifti != NULL)
-            {//due to above testing, we know the structure mask is the same, so just overwrite the ROI from the mask
-                AlgorithmCiftiSeparate(NULL, roiCifti, CiftiXMLOld::ALONG_COLUMN, &myRoi, offset, NULL, true);
-            }
-            AlgorithmVolumeSmoothing(NULL, &myVol, volKern, &myVolOut, &myRoi, fixZerosVol);
-            AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, &myVolOut, true);
-        } else {
-            AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, &myVol, true);
-        }
-    } else {
-        for (int whichStruct = 0; whichStruct < (int)volumeList.size(); ++whichStruct)
+        vector<CiftiVolumeMap> myVolMap;
+        myXML.getVolumeMap(myDir, myVolMap);
+        myScheduler.addTask(myVolMap.size(), [=]() -> CiftiStructureScheduler::StoreFunction
         {
-            VolumeFile myVol, myRoi, myVolOut;
+            CaretPointer<VolumeFile> myVol(new VolumeFile()), myVolOut(new VolumeFile());
+            VolumeFile myRoi;
             int64_t offset[3];
-            AlgorithmCiftiSeparate(NULL, myCifti, myDir, volumeList[whichStruct], &myVol, offset, &myRoi, true);
+            AlgorithmCiftiSeparate(NULL, myCifti, myDir, myVol, offset, &myRoi, true);
             if (volKern > 0.0f)
             {
                 if (roiCifti != NULL)
                 {//due to above testing, we know the structure mask is the same, so just overwrite the ROI from the mask
-                    AlgorithmCiftiSeparate(NULL, roiCifti, CiftiXMLOld::ALONG_COLUMN, volumeList[whichStruct], &myRoi, offset, NULL, true);
+                    AlgorithmCiftiSeparate(NULL, roiCifti, CiftiXMLOld::ALONG_COLUMN, &myRoi, offset, NULL, true);
                 }
-                AlgorithmVolumeSmoothing(NULL, &myVol, volKern, &myVolOut, &myRoi, fixZerosVol);
-                AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, volumeList[whichStruct], &myVolOut, true);
+                AlgorithmVolumeSmoothing(NULL, myVol, volKern, myVolOut, &myRoi, fixZerosVol);
+                myVol.grabNew(NULL);
             } else {
-                AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, volumeList[whichStruct], &myVol, true);
+                myVolOut = myVol;
             }
+            return [=]() { AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, myVolOut, true); };
+        });
+    } else {
+        for (int whichStruct = 0; whichStruct < (int)volumeList.size(); ++whichStruct)
+        {
+            StructureEnum::Enum myStruct = volumeList[whichStruct];
+            vector<CiftiVolumeMap> myVolMap;
+            myXML.getVolumeStructureMap(myDir, myVolMap, myStruct);
+            myScheduler.addTask(myVolMap.size(), [=]() -> CiftiStructureScheduler::StoreFunction
+            {
+                CaretPointer<VolumeFile> myVol(new VolumeFile()), myVolOut(new VolumeFile());
+                VolumeFile myRoi;
+                int64_t offset[3];
+                AlgorithmCiftiSeparate(NULL, myCifti, myDir, myStruct, myVol, offset, &myRoi, true);
+                if (volKern > 0.0f)
+                {
+                    if (roiCifti != NULL)
+                    {//due to above testing, we know the structure mask is the same, so just overwrite the ROI from the mask
+                        AlgorithmCiftiSeparate(NULL, roiCifti, CiftiXMLOld::ALONG_COLUMN, myStruct, &myRoi, offset, NULL, true);
+                    }
+                    AlgorithmVolumeSmoothing(NULL, myVol, volKern, myVolOut, &myRoi, fixZerosVol);
+                    myVol.grabNew(NULL);
+                } else {
+                    myVolOut = myVol;
+                }
+                return [=]() { AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, myStruct, myVolOut, true); };
+            });
         }
     }
+    myScheduler.run();
 }
 
 float AlgorithmCiftiSmoothing::getAlgorithmInternalWeight()
@@ -0,0 +1,319 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AlgorithmCiftiTFCE.h"
+#include "AlgorithmException.h"
+
+#include "AlgorithmCiftiSmoothing.h"
+#include "CaretAssert.h"
+#include "CaretOMP.h"
+#include "CiftiFile.h"
+#include "MetricFile.h"
+#include "SurfaceFile.h"
+#include "TfceHelper.h"
+#include "Vector3D.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+AString AlgorithmCiftiTFCE::getCommandSwitch()
+{
+    return "-cifti-tfce";
+}
+
+AString AlgorithmCiftiTFCE::getShortDescription()
+{
+    return "DO TFCE ON A CIFTI FILE";
+}
+
+OperationParameters* AlgorithmCiftiTFCE::getParameters()
+{
+    OperationParameters* ret = new OperationParameters();
+    ret->addCiftiParameter(1, "cifti-in", "the input cifti");
+    
+    ret->addCiftiOutputParameter(2, "cifti-out", "the output cifti");
+    
+    OptionalParameter* presmoothOpt = ret->createOptionalParameter(3, "-presmooth", "smooth the data before running TFCE");
+    presmoothOpt->addDoubleParameter(1, "surface-kernel", "the sigma for the gaussian surface smoothing kernel, in mm");
+    presmoothOpt->addDoubleParameter(2, "volume-kernel", "the sigma for the gaussian volume smoothing kernel, in mm");
+    
+    OptionalParameter* roiOpt = ret->createOptionalParameter(4, "-roi", "select a region of interest to run TFCE on");
+    roiOpt->addCiftiParameter(1, "roi-cifti", "the area to run TFCE on, as a cifti file");
+    
+    OptionalParameter* paramsOpt = ret->createOptionalParameter(5, "-parameters", "set parameters for TFCE integral");
+    paramsOpt->addDoubleParameter(1, "surface-E", "exponent for cluster area on surfaces (default 1.0)");
+    paramsOpt->addDoubleParameter(2, "volume-E", "exponent for cluster volume in mm^3 (default 0.5)");
+    paramsOpt->addDoubleParameter(3, "H", "exponent for threshold value (default 2.0)");
+    
+    OptionalParameter* leftSurfOpt = ret->createOptionalParameter(6, "-left-surface", "specify the left surface to use");
+    leftSurfOpt->addSurfaceParameter(1, "surface", "the left surface file");
+    OptionalParameter* leftCorrAreasOpt = leftSurfOpt->createOptionalParameter(2, "-left-corrected-areas", "vertex areas to use instead of computing them from the left surface");
+    leftCorrAreasOpt->addMetricParameter(1, "area-metric", "the corrected vertex areas, as a metric");
+    
+    OptionalParameter* rightSurfOpt = ret->createOptionalParameter(7, "-right-surface", "specify the right surface to use");
+    rightSurfOpt->addSurfaceParameter(1, "surface", "the right surface file");
+    OptionalParameter* rightCorrAreasOpt = rightSurfOpt->createOptionalParameter(2, "-right-corrected-areas", "vertex areas to use instead of computing them from the right surface");
+    rightCorrAreasOpt->addMetricParameter(1, "area-metric", "the corrected vertex areas, as a metric");
+    
+    OptionalParameter* cerebSurfOpt = ret->createOptionalParameter(8, "-cerebellum-surface", "specify the cerebellum surface to use");
+    cerebSurfOpt->addSurfaceParameter(1, "surface", "the cerebellum surface file");
+    OptionalParameter* cerebCorrAreasOpt = cerebSurfOpt->createOptionalParameter(2, "-cerebellum-corrected-areas", "vertex areas to use instead of computing them from the cerebellum surface");
+    cerebCorrAreasOpt->addMetricParameter(1, "area-metric", "the corrected vertex areas, as a metric");
+    
+    ret->setHelpText(
+        AString("Does the same computation as -metric-tfce and -volume-tfce on every map of a cifti file with a brain models mapping along columns, such as .dscalar.nii.  ") +
+        "Clusters do not extend across structure boundaries, including between volume structures.  " +
+        "The neighbor information is computed once, and the maps are processed in parallel, so a large set of permutations can be done in a single command.  " +
+        "Each map is read into memory before processing.\n\n" +
+        "A surface must be specified for each surface structure in the cifti file.  " +
+        "The ROI should have a brain models mapping along columns, exactly matching the input mapping, data outside the ROI is ignored and set to zero in the output.  " +
+        "For details on the method and the -*-corrected-areas options, see -metric-tfce."
+    );
+    return ret;
+}
+
+void AlgorithmCiftiTFCE::useParameters(OperationParameters* myParams, ProgressObject* myProgObj)
+{
+    CiftiFile* myCifti = myParams->getCifti(1);
+    CiftiFile* myCiftiOut = myParams->getOutputCifti(2);
+    float surfPresmooth = 0.0f, volPresmooth = 0.0f;
+    OptionalParameter* presmoothOpt = myParams->getOptionalParameter(3);
+    if (presmoothOpt->m_present)
+    {
+        surfPresmooth = (float)presmoothOpt->getDouble(1);
+        volPresmooth = (float)presmoothOpt->getDouble(2);
+        if (surfPresmooth < 0.0f || volPresmooth < 0.0f) throw AlgorithmException("presmooth kernel sizes must not be negative");
+    }
+    CiftiFile* roiCifti = NULL;
+    OptionalParameter* roiOpt = myParams->getOptionalParameter(4);
+    if (roiOpt->m_present)
+    {
+        roiCifti = roiOpt->getCifti(1);
+    }
+    float surf_param_e = 1.0f, vol_param_e = 0.5f, param_h = 2.0f;
+    OptionalParameter* paramsOpt = myParams->getOptionalParameter(5);
+    if (paramsOpt->m_present)
+    {
+        surf_param_e = (float)paramsOpt->getDouble(1);
+        vol_param_e = (float)paramsOpt->getDouble(2);
+        param_h = (float)paramsOpt->getDouble(3);
+    }
+    SurfaceFile* myLeftSurf = NULL, *myRightSurf = NULL, *myCerebSurf = NULL;
+    MetricFile* myLeftAreas = NULL, *myRightAreas = NULL, *myCerebAreas = NULL;
+    OptionalParameter* leftSurfOpt = myParams->getOptionalParameter(6);
+    if (leftSurfOpt->m_present)
+    {
+        myLeftSurf = leftSurfOpt->getSurface(1);
+        OptionalParameter* leftCorrAreasOpt = leftSurfOpt->getOptionalParameter(2);
+        if (leftCorrAreasOpt->m_present)
+        {
+            myLeftAreas = leftCorrAreasOpt->getMetric(1);
+        }
+    }
+    OptionalParameter* rightSurfOpt = myParams->getOptionalParameter(7);
+    if (rightSurfOpt->m_present)
+    {
+        myRightSurf = rightSurfOpt->getSurface(1);
+        OptionalParameter* rightCorrAreasOpt = rightSurfOpt->getOptionalParameter(2);
+        if (rightCorrAreasOpt->m_present)
+        {
+            myRightAreas = rightCorrAreasOpt->getMetric(1);
+        }
+    }
+    OptionalParameter* cerebSurfOpt = myParams->getOptionalParameter(8);
+    if (cerebSurfOpt->m_present)
+    {
+        myCerebSurf = cerebSurfOpt->getSurface(1);
+        OptionalParameter* cerebCorrAreasOpt = cerebSurfOpt->getOptionalParameter(2);
+        if (cerebCorrAreasOpt->m_present)
+        {
+            myCerebAreas = cerebCorrAreasOpt->getMetric(1);
+        }
+    }
+    AlgorithmCiftiTFCE(myProgObj, myCifti, myCiftiOut, surfPresmooth, volPresmooth, roiCifti, surf_param_e, vol_param_e, param_h,
+                       myLeftSurf, myRightSurf, myCerebSurf, myLeftAreas, myRightAreas, myCerebAreas);
+}
+
+AlgorithmCiftiTFCE::AlgorithmCiftiTFCE(ProgressObject* myProgObj, const CiftiFile* myCifti, CiftiFile* myCiftiOut, const float& surfPresmooth, const float& volPresmooth,
+                                       const CiftiFile* roiCifti, const float& surf_param_e, const float& vol_param_e, const float& param_h,
+                                       const SurfaceFile* myLeftSurf, const SurfaceFile* myRightSurf, const SurfaceFile* myCerebSurf,
+                                       const MetricFile* myLeftAreas, const MetricFile* myRightAreas, const MetricFile* myCerebAreas) : AbstractAlgorithm(myProgObj)
+{
+    LevelProgress myProgress(myProgObj);
+    const CiftiXML& myXML = myCifti->getCiftiXML();
+    if (myXML.getNumberOfDimensions() != 2) throw AlgorithmException("cifti tfce only supports 2D cifti");
+    if (myXML.getMappingType(CiftiXML::ALONG_COLUMN) != CiftiMappingType::BRAIN_MODELS) throw AlgorithmException("input cifti does not have a brain models mapping along columns");
+    const CiftiBrainModelsMap& myDenseMap = myXML.getBrainModelsMap(CiftiXML::ALONG_COLUMN);
+    int64_t numBrainordinates = myXML.getDimensionLength(CiftiXML::ALONG_COLUMN);
+    int64_t numMaps = myXML.getDimensionLength(CiftiXML::ALONG_ROW);
+    vector<float> roiData;
+    if (roiCifti != NULL)
+    {
+        const CiftiXML& roiXML = roiCifti->getCiftiXML();
+        if (roiXML.getMappingType(CiftiXML::ALONG_COLUMN) != CiftiMappingType::BRAIN_MODELS ||
+            roiXML.getBrainModelsMap(CiftiXML::ALONG_COLUMN) != myDenseMap)
+        {
+            throw AlgorithmException("roi cifti brain models mapping does not match the input cifti");
+        }
+        roiData.resize(numBrainordinates);
+        vector<float> scratchRow(roiXML.getDimensionLength(CiftiXML::ALONG_ROW));
+        for (int64_t i = 0; i < numBrainordinates; ++i)
+        {
+            roiCifti->getRow(scratchRow.data(), i);
+            roiData[i] = scratchRow[0];
+        }
+    }
+    TfceHelper surfTfce(numBrainordinates), volTfce(numBrainordinates);//surface and volume use different extent exponents, so keep them separate
+    vector<StructureEnum::Enum> surfList = myDenseMap.getSurfaceStructureList();
+    for (int whichStruct = 0; whichStruct < (int)surfList.size(); ++whichStruct)
+    {
+        const SurfaceFile* mySurf = NULL;
+        const MetricFile* myAreas = NULL;
+        AString surfType;
+        switch (surfList[whichStruct])
+        {
+            case StructureEnum::CORTEX_LEFT:
+                mySurf = myLeftSurf;
+                myAreas = myLeftAreas;
+                surfType = "left";
+                break;
+            case StructureEnum::CORTEX_RIGHT:
+                mySurf = myRightSurf;
+                myAreas = myRightAreas;
+                surfType = "right";
+                break;
+            case StructureEnum::CEREBELLUM:
+                mySurf = myCerebSurf;
+                myAreas = myCerebAreas;
+                surfType = "cerebellum";
+                break;
+            default:
+                throw AlgorithmException("found surface model with incorrect type: " + StructureEnum::toName(surfList[whichStruct]));
+        }
+        if (mySurf == NULL)
+        {
+            throw AlgorithmException(surfType + " surface required but not provided");
+        }
+        int64_t numNodes = mySurf->getNumberOfNodes();
+        if (numNodes != myDenseMap.getSurfaceNumberOfNodes(surfList[whichStruct]))
+        {
+            throw AlgorithmException(surfType + " surface has the wrong number of vertices");
+        }
+        if (myAreas != NULL && myAreas->getNumberOfNodes() != numNodes)
+        {
+            throw AlgorithmException(surfType + " surface and vertex area metric have different number of vertices");
+        }
+        vector<float> surfAreaData;
+        const float* areaData = NULL;
+        if (myAreas == NULL)
+        {
+            mySurf->computeNodeAreas(surfAreaData);
+            areaData = surfAreaData.data();
+        } else {
+            areaData = myAreas->getValuePointerForColumn(0);
+        }
+        vector<int64_t> nodeToData(numNodes, -1);
+        vector<CiftiBrainModelsMap::SurfaceMap> myMap = myDenseMap.getSurfaceMap(surfList[whichStruct]);
+        for (int64_t i = 0; i < (int64_t)myMap.size(); ++i)
+        {
+            if (roiCifti == NULL || roiData[myMap[i].m_ciftiIndex] > 0.0f)
+            {
+                nodeToData[myMap[i].m_surfaceNode] = myMap[i].m_ciftiIndex;
+            }
+        }
+        surfTfce.addSurface(mySurf, areaData, nodeToData);
+    }
+    if (myDenseMap.hasVolumeData())
+    {
+        Vector3D ivec, jvec, kvec, origin;
+        myDenseMap.getVolumeSpace().getSpacingVectors(ivec, jvec, kvec, origin);
+        float voxelVolume = abs(ivec.dot(jvec.cross(kvec)));
+        vector<StructureEnum::Enum> volList = myDenseMap.getVolumeStructureList();
+        for (int whichStruct = 0; whichStruct < (int)volList.size(); ++whichStruct)
+        {
+            vector<CiftiBrainModelsMap::VolumeMap> myMap = myDenseMap.getVolumeStructureMap(volList[whichStruct]);
+            vector<int64_t> voxelIJK, voxelIndices;
+            for (int64_t i = 0; i < (int64_t)myMap.size(); ++i)
+            {
+                if (roiCifti == NULL || roiData[myMap[i].m_ciftiIndex] > 0.0f)
+                {
+                    voxelIJK.insert(voxelIJK.end(), myMap[i].m_ijk, myMap[i].m_ijk + 3);
+                    voxelIndices.push_back(myMap[i].m_ciftiIndex);
+                }
+            }
+            volTfce.addVoxels(voxelIJK, voxelIndices, voxelVolume);
+        }
+    }
+    const CiftiFile* toUse = myCifti;
+    CiftiFile smoothed;
+    if (surfPresmooth > 0.0f || volPresmooth > 0.0f)
+    {
+        AlgorithmCiftiSmoothing(NULL, myCifti, surfPresmooth, volPresmooth, CiftiXMLOld::ALONG_COLUMN, &smoothed, myLeftSurf, myRightSurf, myCerebSurf,
+                                roiCifti, false, false, myLeftAreas, myRightAreas, myCerebAreas);
+        toUse = &smoothed;
+    }
+    vector<vector<float> > mapData(numMaps, vector<float>(numBrainordinates));//maps are columns, transpose so each map is contiguous
+    vector<float> scratchRow(numMaps);
+    for (int64_t i = 0; i < numBrainordinates; ++i)
+    {
+        toUse->getRow(scratchRow.data(), i);
+        for (int64_t j = 0; j < numMaps; ++j)
+        {
+            mapData[j][i] = scratchRow[j];
+        }
+    }
+#pragma omp CARET_PAR
+    {
+        vector<float> surfOut(numBrainordinates), volOut(numBrainordinates);
+        TfceHelper::Workspace myScratch;
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int64_t j = 0; j < numMaps; ++j)
+        {
+            surfTfce.compute(mapData[j].data(), surfOut.data(), surf_param_e, param_h, myScratch);
+            volTfce.compute(mapData[j].data(), volOut.data(), vol_param_e, param_h, myScratch);
+            for (int64_t i = 0; i < numBrainordinates; ++i)
+            {
+                mapData[j][i] = surfOut[i] + volOut[i];//each brainordinate is in only one of them, the other output is zero
+            }
+        }
+    }
+    myCiftiOut->setCiftiXML(myXML);
+    for (int64_t i = 0; i < numBrainordinates; ++i)
+    {
+        for (int64_t j = 0; j < numMaps; ++j)
+        {
+            scratchRow[j] = mapData[j][i];
+        }
+        myCiftiOut->setRow(scratchRow.data(), i);
+    }
+}
+
+float AlgorithmCiftiTFCE::getAlgorithmInternalWeight()
+{
+    return 1.0f;//override this if needed, if the progress bar isn't smooth
+}
+
+float AlgorithmCiftiTFCE::getSubAlgorithmWeight()
+{
+    return AlgorithmCiftiSmoothing::getAlgorithmWeight();
+}
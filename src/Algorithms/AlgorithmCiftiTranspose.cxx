@@ -20,11 +20,47 @@
 
 #include "AlgorithmCiftiTranspose.h"
 #include "AlgorithmException.h"
+
+#include "CaretLogger.h"
+#include "CaretOMP.h"
 #include "CiftiFile.h"
 
+#include <QDir>
+#include <QTemporaryFile>
+
+#include <algorithm>
+#include <vector>
+
 using namespace caret;
 using namespace std;
 
+namespace
+{
+    const int64_t TILE_SIZE = 32;//32x32 floats is 4KB, small enough for both tiles to stay in L1
+    
+    //out[c * outStride + r] = in[r * inStride + c]
+    void transposeBlock(const float* in, const int64_t& numRows, const int64_t& numCols, const int64_t& inStride, float* out, const int64_t& outStride)
+    {
+#pragma omp CARET_PARFOR schedule(dynamic)
+        for (int64_t colTile = 0; colTile < numCols; colTile += TILE_SIZE)
+        {
+            int64_t colEnd = min(colTile + TILE_SIZE, numCols);
+            for (int64_t rowTile = 0; rowTile < numRows; rowTile += TILE_SIZE)
+            {
+                int64_t rowEnd = min(rowTile + TILE_SIZE, numRows);
+                for (int64_t c = colTile; c < colEnd; ++c)
+                {
+                    float* outRow = out + c * outStride;
+                    for (int64_t r = rowTile; r < rowEnd; ++r)
+                    {
+                        outRow[r] = in[r * inStride + c];
+                    }
+                }
+            }
+        }
+    }
+}
+
 AString AlgorithmCiftiTranspose::getCommandSwitch()
 {
     return "-cifti-transpose";
@@ -47,7 +83,9 @@ OperationParameters* AlgorithmCiftiTranspose::getParameters()
     
     ret->setHelpText(
         AString("The input must be a 2-dimensional cifti file.  ") +
-        "The output is a cifti file where every row in the input is a column in the output."
+        "The output is a cifti file where every row in the input is a column in the output.\n\n" +
+        "If the input does not fit within the memory limit, it is transposed in blocks using a temporary file of the same size as the input, " +
+        "so the input is read only once regardless of the limit."
     );
     return ret;
 }
@@ -82,32 +120,88 @@ AlgorithmCiftiTranspose::AlgorithmCiftiTranspose(ProgressObject* myProgObj, cons
     outXML.setMap(0, *(inXML.getMap(1)));
     outXML.setMap(1, *(inXML.getMap(0)));
     ciftiOut->setCiftiXML(outXML);
-    int rowSize = outXML.getDimensionLength(CiftiXML::ALONG_ROW), colSize = outXML.getDimensionLength(CiftiXML::ALONG_COLUMN);
-    int64_t outRowBytes = rowSize * sizeof(float);
-    int numCacheRows = colSize;
+    int64_t inRows = inXML.getDimensionLength(CiftiXML::ALONG_COLUMN), inCols = inXML.getDimensionLength(CiftiXML::ALONG_ROW);//output has inCols rows of length inRows
+    int64_t totalFloats = inRows * inCols;
+    int64_t limitFloats = totalFloats + TILE_SIZE * inRows;//everything in memory, plus a panel of output rows
     if (memLimitGB >= 0.0f)
     {
-        numCacheRows = memLimitGB * 1024 * 1024 * 1024 / outRowBytes;
-        if (numCacheRows < 1) numCacheRows = 1;
-        if (numCacheRows > colSize) numCacheRows = colSize;
+        limitFloats = (int64_t)(memLimitGB * 1024 * 1024 * 1024) / (int64_t)sizeof(float);
+    }
+    if (limitFloats >= totalFloats + TILE_SIZE * inRows)
+    {//whole input in memory, transpose a panel of output rows at a time
+        vector<float> inData(totalFloats);
+        for (int64_t i = 0; i < inRows; ++i)
+        {
+            ciftiIn->getRow(inData.data() + i * inCols, i);
+        }
+        int64_t panelRows = TILE_SIZE;
+        vector<float> panel(panelRows * inRows);
+        for (int64_t panelStart = 0; panelStart < inCols; panelStart += panelRows)
+        {
+            int64_t panelEnd = min(panelStart + panelRows, inCols);
+            transposeBlock(inData.data() + panelStart, inRows, panelEnd - panelStart, inCols, panel.data(), inRows);
+            for (int64_t k = panelStart; k < panelEnd; ++k)
+            {
+                ciftiOut->setRow(panel.data() + (k - panelStart) * inRows, k);
+            }
+        }
+        return;
+    }
+    //out of core: read blocks of input rows once, transpose each block, and scatter the pieces into the temporary file so that
+    //every panel of output rows is contiguous, then read the panels back in order and write the output sequentially
+    //first pass holds a block and its transpose, second pass holds a panel and one output row
+    int64_t blockRows = max((int64_t)1, min(inRows, limitFloats / 2 / inCols));
+    int64_t panelRows = max((int64_t)1, min(inCols, (limitFloats - inRows) / inRows));
+    AString tempPath = QDir::tempPath();
+    if (!tempPath.endsWith('/')) tempPath += '/';
+    QTemporaryFile transposeFile(tempPath + "wb_cifti_transpose.XXXXXX");
+    if (!transposeFile.open())
+    {
+        throw AlgorithmException("failed to create temporary file in '" + tempPath + "', check permissions");
     }
-    vector<vector<float> > cacheRows(numCacheRows, vector<float>(rowSize));
-    vector<float> scratchInRow(colSize);
-    for (int i = 0; i < colSize; i += numCacheRows)//loop through cache chunks
+    CaretLogInfo("cifti file exceeds memory limit, transposing in blocks using temporary file '" + transposeFile.fileName() + "'");
     {
-        int end = i + numCacheRows;
-        if (end > colSize) end = colSize;
-        for (int j = 0; j < rowSize; ++j)//loop through all input rows
+        vector<float> block(blockRows * inCols), transposed(blockRows * inCols);
+        for (int64_t blockStart = 0; blockStart < inRows; blockStart += blockRows)
         {
-            ciftiIn->getRow(scratchInRow.data(), j);
-            for (int k = i; k < end; ++k)
+            int64_t blockEnd = min(blockStart + blockRows, inRows), thisBlockRows = blockEnd - blockStart;
+            for (int64_t i = blockStart; i < blockEnd; ++i)
             {
-                cacheRows[k - i][j] = scratchInRow[k];
+                ciftiIn->getRow(block.data() + (i - blockStart) * inCols, i);
+            }
+            transposeBlock(block.data(), thisBlockRows, inCols, inCols, transposed.data(), thisBlockRows);
+            for (int64_t panelStart = 0; panelStart < inCols; panelStart += panelRows)
+            {//output rows of a panel are adjacent in the transposed block, so each panel gets one contiguous write
+                int64_t thisPanelRows = min(panelStart + panelRows, inCols) - panelStart;
+                int64_t fileOffset = panelStart * inRows + thisPanelRows * blockStart;
+                qint64 writeBytes = thisPanelRows * thisBlockRows * sizeof(float);
+                if (!transposeFile.seek(fileOffset * sizeof(float)) ||
+                    transposeFile.write((const char*)(transposed.data() + panelStart * thisBlockRows), writeBytes) != writeBytes)
+                {
+                    throw AlgorithmException("failed to write to temporary file '" + transposeFile.fileName() + "', check free disk space");
+                }
             }
         }
-        for (int k = i; k < end; ++k)
+    }
+    vector<float> panel(panelRows * inRows), outRow(inRows);
+    for (int64_t panelStart = 0; panelStart < inCols; panelStart += panelRows)
+    {
+        int64_t thisPanelRows = min(panelStart + panelRows, inCols) - panelStart;
+        qint64 readBytes = thisPanelRows * inRows * sizeof(float);
+        if (!transposeFile.seek(panelStart * inRows * sizeof(float)) ||
+            transposeFile.read((char*)panel.data(), readBytes) != readBytes)
         {
-            ciftiOut->setRow(cacheRows[k - i].data(), k);
+            throw AlgorithmException("failed to read transposed data back from temporary file '" + transposeFile.fileName() + "'");
+        }
+        for (int64_t k = 0; k < thisPanelRows; ++k)
+        {//panel is a sequence of (thisPanelRows x thisBlockRows) tiles, one per input block
+            for (int64_t blockStart = 0; blockStart < inRows; blockStart += blockRows)
+            {
+                int64_t thisBlockRows = min(blockStart + blockRows, inRows) - blockStart;
+                const float* tileRow = panel.data() + thisPanelRows * blockStart + k * thisBlockRows;
+                copy(tileRow, tileRow + thisBlockRows, outRow.data() + blockStart);
+            }
+            ciftiOut->setRow(outRow.data(), panelStart + k);
         }
     }
 }
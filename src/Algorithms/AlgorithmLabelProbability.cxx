@@ -21,11 +21,10 @@
 #include "AlgorithmLabelProbability.h"
 #include "AlgorithmException.h"
 
-#include "GiftiLabelTable.h"
 #include "LabelFile.h"
+#include "LabelProbabilityAccumulator.h"
 #include "MetricFile.h"
 
-#include <map>
 #include <vector>
 
 using namespace caret;
@@ -71,46 +70,20 @@ AlgorithmLabelProbability::AlgorithmLabelProbability(ProgressObject* myProgObj,
     LevelProgress myProgress(myProgObj);
     int numNodes = inputLabel->getNumberOfNodes();
     int numInMaps = inputLabel->getNumberOfMaps();//note: label files have only one label table that covers the entire file, and should never have duplicate names
-    map<int, int> keyToOutMapLookup;
-    vector<AString> outMapNames;
-    const GiftiLabelTable* fileTable = inputLabel->getLabelTable();
-    set<int32_t> keys = fileTable->getKeys();
-    int32_t unlabeledKey = -1;//don't request it from label table if we aren't going to exclude it, as that could create the unassigned key
-    if (excludeUnlabeled)
-    {
-        unlabeledKey = fileTable->getUnassignedLabelKey();
-    }
-    for (set<int32_t>::iterator iter = keys.begin(); iter != keys.end(); ++iter)
-    {
-        if (excludeUnlabeled && *iter == unlabeledKey) continue;
-        int newOutMap = (int)keyToOutMapLookup.size();//get size before [] allocates a new member
-        keyToOutMapLookup[*iter] = newOutMap;
-        outMapNames.push_back(fileTable->getLabelName(*iter));
-    }
-    int numOutMaps = keyToOutMapLookup.size();
-    vector<vector<int32_t> > counts(numOutMaps, vector<int32_t>(numNodes, 0));
+    LabelProbabilityAccumulator myAccum(numNodes, excludeUnlabeled);
+    int tableHandle = myAccum.addLabelTable(inputLabel->getLabelTable());
     for (int m = 0; m < numInMaps; ++m)
     {
-        const int32_t* data = inputLabel->getLabelKeyPointerForColumn(m);
-        for (int i = 0; i < numNodes; ++i)
-        {
-            map<int, int>::iterator search = keyToOutMapLookup.find(data[i]);
-            if (search != keyToOutMapLookup.end())
-            {
-                ++counts[search->second][i];
-            }
-        }
+        myAccum.addMap(tableHandle, inputLabel->getLabelKeyPointerForColumn(m));
     }
+    int numOutMaps = myAccum.getNumberOfLabels();
     vector<float> scratch(numNodes);
     outputMetric->setNumberOfNodesAndColumns(numNodes, numOutMaps);
     outputMetric->setStructure(inputLabel->getStructure());
     for (int m = 0; m < numOutMaps; ++m)
     {
-        outputMetric->setMapName(m, outMapNames[m]);
-        for (int i = 0; i < numNodes; ++i)
-        {
-            scratch[i] = ((float)counts[m][i]) / numInMaps;
-        }
+        outputMetric->setMapName(m, myAccum.getLabelName(m));
+        myAccum.getProbabilities(m, scratch.data());
         outputMetric->setValuesForColumn(m, scratch.data());
     }
 }
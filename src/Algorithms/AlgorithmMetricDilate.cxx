@@ -177,8 +177,6 @@ AlgorithmMetricDilate::AlgorithmMetricDilate(ProgressObject* myProgObj, const Me
         throw AlgorithmException("distance cannot be negative");
     }
     myMetricOut->setStructure(mySurf->getStructure());
-    vector<pair<int, StencilElem> > myStencils;//because we need to iterate over it in parallel
-    vector<pair<int, int> > myNearest;
     vector<float> colScratch(numNodes);
     vector<float> myAreasData;
     const float* myAreas = NULL;
@@ -189,70 +187,141 @@ AlgorithmMetricDilate::AlgorithmMetricDilate(ProgressObject* myProgObj, const Me
     } else {
         myAreas = corrAreas->getValuePointerForColumn(0);
     }
-    bool linear = (myMethod == LINEAR), nearest = (myMethod == NEAREST);
-    if (!linear && badNodeRoi != NULL)//if we know which nodes need to have their values replaced, then we can do the same thing at each vertex for each column
+    CaretPointer<GeodesicHelperBase> correctedBase;
+    if (corrAreas != NULL)
     {
-        if (nearest)
-        {
-            precomputeNearest(myNearest, mySurf, badNodeRoi, dataRoi, corrAreas, distance);
-        } else {
-            precomputeStencils(myStencils, mySurf, myAreas, badNodeRoi, dataRoi, corrAreas, distance, exponent);
-        }
+        correctedBase.grabNew(new GeodesicHelperBase(mySurf, corrAreas->getValuePointerForColumn(0)));//NOTE: myAreas also points to this when applicable
     }
+    const float* badRoiData = NULL;
+    if (badNodeRoi != NULL) badRoiData = badNodeRoi->getValuePointerForColumn(0);
+    const float* dataRoiVals = NULL;
+    if (dataRoi != NULL) dataRoiVals = dataRoi->getValuePointerForColumn(0);
+    int startCol = 0, endCol = myMetric->getNumberOfColumns();
     if (columnNum == -1)
     {
         myMetricOut->setNumberOfNodesAndColumns(numNodes, myMetric->getNumberOfColumns());
-        for (int thisCol = 0; thisCol < myMetric->getNumberOfColumns(); ++thisCol)
+    } else {
+        startCol = columnNum;
+        endCol = columnNum + 1;
+        myMetricOut->setNumberOfNodesAndColumns(numNodes, 1);
+    }
+    vector<pair<int, StencilElem> > myStencils;//because we need to iterate over it in parallel
+    vector<pair<int, int> > myNearest;
+    vector<char> charRoi, stencilRoi;//without a bad vertex roi, the bad vertices come from the data, but columns often share the same pattern
+    vector<int32_t> badNodes;
+    bool haveStencils = false;
+    for (int thisCol = startCol; thisCol < endCol; ++thisCol)
+    {
+        int outCol = thisCol - startCol;
+        *(myMetricOut->getMapPaletteColorMapping(outCol)) = *(myMetric->getMapPaletteColorMapping(thisCol));
+        const float* myInputData = myMetric->getValuePointerForColumn(thisCol);
+        myMetricOut->setColumnName(outCol, myMetric->getColumnName(thisCol));
+        if (myMethod == LINEAR)
         {
-            *(myMetricOut->getMapPaletteColorMapping(thisCol)) = *(myMetric->getMapPaletteColorMapping(thisCol));
-            const float* myInputData = myMetric->getValuePointerForColumn(thisCol);
-            myMetricOut->setColumnName(thisCol, myMetric->getColumnName(thisCol));
-            if (badNodeRoi == NULL)
+            processColumnLinear(colScratch.data(), myInputData, mySurf, badRoiData, dataRoiVals, correctedBase, distance);
+        } else {
+            if (!haveStencils || badRoiData == NULL)
             {
-                processColumn(colScratch.data(), myInputData, mySurf, myAreas, badNodeRoi, dataRoi, corrAreas, distance, nearest, linear, exponent);
-            } else {
-                switch (myMethod)
+                makeRois(charRoi, badNodes, numNodes, badRoiData, dataRoiVals, myInputData);
+                if (!haveStencils || charRoi != stencilRoi)
                 {
-                    case NEAREST:
-                        processColumn(colScratch.data(), numNodes, myInputData, myNearest);
-                        break;
-                    case WEIGHTED:
-                        processColumn(colScratch.data(), numNodes, myInputData, myStencils);
-                        break;
-                    case LINEAR:
-                        processColumn(colScratch.data(), myInputData, mySurf, myAreas, badNodeRoi, dataRoi, corrAreas, distance, nearest, linear, exponent);
-                        break;
+                    vector<pair<int32_t, float> > closest;
+                    findClosest(closest, badNodes, charRoi, mySurf, correctedBase, distance);
+                    if (myMethod == NEAREST)
+                    {
+                        precomputeNearest(myNearest, badNodes, closest);
+                    } else {
+                        precomputeStencils(myStencils, badNodes, closest, charRoi, mySurf, myAreas, correctedBase, exponent);
+                    }
+                    stencilRoi.swap(charRoi);
+                    haveStencils = true;
                 }
             }
-            myMetricOut->setValuesForColumn(thisCol, colScratch.data());
+            if (myMethod == NEAREST)
+            {
+                processColumn(colScratch.data(), numNodes, myInputData, myNearest);
+            } else {
+                processColumn(colScratch.data(), numNodes, myInputData, myStencils);
+            }
         }
-    } else {
-        myMetricOut->setNumberOfNodesAndColumns(numNodes, 1);
-        *(myMetricOut->getMapPaletteColorMapping(0)) = *(myMetric->getMapPaletteColorMapping(columnNum));
-        const float* myInputData = myMetric->getValuePointerForColumn(columnNum);
-        myMetricOut->setColumnName(0, myMetric->getColumnName(columnNum));
-        if (badNodeRoi == NULL)
+        myMetricOut->setValuesForColumn(outCol, colScratch.data());
+    }
+}
+
+namespace
+{
+    CaretPointer<GeodesicHelper> getGeoHelper(const SurfaceFile* mySurf, const CaretPointer<GeodesicHelperBase>& correctedBase)
+    {
+        if (correctedBase == NULL) return mySurf->getGeodesicHelper();
+        CaretPointer<GeodesicHelper> ret(new GeodesicHelper(correctedBase));
+        return ret;
+    }
+}
+
+void AlgorithmMetricDilate::makeRois(vector<char>& charRoi, vector<int32_t>& badNodes, const int& numNodes, const float* badRoiData, const float* dataRoiVals, const float* myInputData)
+{
+    charRoi.resize(numNodes);
+    badNodes.clear();
+    for (int i = 0; i < numNodes; ++i)
+    {
+        bool inData = (dataRoiVals == NULL || dataRoiVals[i] > 0.0f);
+        bool badNode;
+        if (badRoiData != NULL)
+        {
+            badNode = (badRoiData[i] > 0.0f);//"not greater than" is good, to trap NaNs
+        } else {
+            badNode = (myInputData[i] == 0.0f);
+        }
+        if (inData && !badNode)
         {
-            processColumn(colScratch.data(), myInputData, mySurf, myAreas, badNodeRoi, dataRoi, corrAreas, distance, nearest, linear, exponent);
+            charRoi[i] = 1;
         } else {
-            switch (myMethod)
+            charRoi[i] = 0;
+            if (inData) badNodes.push_back(i);
+        }
+    }
+}
+
+void AlgorithmMetricDilate::findClosest(vector<pair<int32_t, float> >& closestOut, const vector<int32_t>& badNodes, const vector<char>& charRoi,
+                                        const SurfaceFile* mySurf, const CaretPointer<GeodesicHelperBase>& correctedBase, const float& distance)
+{
+    vector<int32_t> closestNodes;
+    vector<float> closestDists;
+    getGeoHelper(mySurf, correctedBase)->getClosestNodesInRoi(charRoi.data(), distance, closestNodes, closestDists);//one search from all valid vertices, rather than one per bad vertex
+    int numBad = (int)badNodes.size();
+    closestOut.resize(numBad);
+#pragma omp CARET_PAR
+    {
+        CaretPointer<TopologyHelper> myTopoHelp = mySurf->getTopologyHelper();
+        CaretPointer<GeodesicHelper> myGeoHelp;
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int b = 0; b < numBad; ++b)
+        {
+            const int i = badNodes[b];
+            int closestNode = closestNodes[i];
+            float closestDist = closestDists[i];
+            if (closestNode == -1)//check neighbors, to ensure we dilate by at least one node everywhere
             {
-                case NEAREST:
-                    processColumn(colScratch.data(), numNodes, myInputData, myNearest);
-                    break;
-                case WEIGHTED:
-                    processColumn(colScratch.data(), numNodes, myInputData, myStencils);
-                    break;
-                case LINEAR:
-                    processColumn(colScratch.data(), myInputData, mySurf, myAreas, badNodeRoi, dataRoi, corrAreas, distance, nearest, linear, exponent);
-                    break;
+                if (myGeoHelp == NULL) myGeoHelp = getGeoHelper(mySurf, correctedBase);
+                const vector<int32_t>& nodeList = myTopoHelp->getNodeNeighbors(i);
+                vector<float> distList;
+                myGeoHelp->getGeoToTheseNodes(i, nodeList, distList);//ok, its a little silly to do this
+                const int numInRange = (int)nodeList.size();
+                for (int j = 0; j < numInRange; ++j)
+                {
+                    if (charRoi[nodeList[j]] != 0 && (closestNode == -1 || distList[j] < closestDist))
+                    {
+                        closestNode = nodeList[j];
+                        closestDist = distList[j];
+                    }
+                }
             }
+            closestOut[b] = pair<int32_t, float>(closestNode, closestDist);
         }
-        myMetricOut->setValuesForColumn(0, colScratch.data());
     }
 }
 
-void AlgorithmMetricDilate::processColumn(float* colScratch, const int& numNodes, const float* myInputData, vector<pair<int, int> > myNearest)
+void AlgorithmMetricDilate::processColumn(float* colScratch, const int& numNodes, const float* myInputData, const vector<pair<int, int> >& myNearest)
 {
     for (int i = 0; i < numNodes; ++i)
     {
@@ -273,7 +342,7 @@ void AlgorithmMetricDilate::processColumn(float* colScratch, const int& numNodes
     }
 }
 
-void AlgorithmMetricDilate::processColumn(float* colScratch, const int& numNodes, const float* myInputData, vector<pair<int, StencilElem> > myStencils)
+void AlgorithmMetricDilate::processColumn(float* colScratch, const int& numNodes, const float* myInputData, const vector<pair<int, StencilElem> >& myStencils)
 {
     for (int i = 0; i < numNodes; ++i)
     {
@@ -300,245 +369,97 @@ void AlgorithmMetricDilate::processColumn(float* colScratch, const int& numNodes
     }
 }
 
-void AlgorithmMetricDilate::processColumn(float* colScratch, const float* myInputData, const SurfaceFile* mySurf, const float* myAreas,
-                                          const MetricFile* badNodeRoi, const MetricFile* dataRoi, const MetricFile* corrAreas,
-                                          const float& distance, const bool& nearest, const bool& linear, const float& exponent)
+void AlgorithmMetricDilate::processColumnLinear(float* colScratch, const float* myInputData, const SurfaceFile* mySurf, const float* badRoiData, const float* dataRoiVals,
+                                                const CaretPointer<GeodesicHelperBase>& correctedBase, const float& distance)
 {
-    float cutoffRatio = 1.5f, test = pow(10.0f, 1.0f / exponent);//find what cutoff ratio corresponds to a tenth of weight, but don't use more than a 1.5 * nearest cutoff
-    if (test > 1.0f && test < cutoffRatio)//if it is less than 1, the exponent is weird, so simply ignore it and use default
-    {
-        if (test > 1.1f)
-        {
-            cutoffRatio = test;
-        } else {
-            cutoffRatio = 1.1f;
-        }
-    }
     int numNodes = mySurf->getNumberOfNodes();
-    vector<char> charRoi(numNodes);
-    const float* badRoiData = NULL;
-    if (badNodeRoi != NULL) badRoiData = badNodeRoi->getValuePointerForColumn(0);
-    const float* dataRoiVals = NULL;
-    if (dataRoi != NULL)
-    {
-        dataRoiVals = dataRoi->getValuePointerForColumn(0);
-        if (badRoiData != NULL)
-        {
-            for (int i = 0; i < numNodes; ++i)
-            {
-                if (dataRoiVals[i] > 0.0f && !(badRoiData[i] > 0.0f))//"not greater than" to trap NaNs
-                {
-                    charRoi[i] = 1;
-                } else {
-                    charRoi[i] = 0;
-                }
-            }
-        } else {
-            for (int i = 0; i < numNodes; ++i)
-            {
-                if (dataRoiVals[i] > 0.0f && myInputData[i] != 0.0f)
-                {
-                    charRoi[i] = 1;
-                } else {
-                    charRoi[i] = 0;
-                }
-            }
-        }
-    } else {
-        if (badRoiData != NULL)
-        {
-            for (int i = 0; i < numNodes; ++i)
-            {
-                if (!(badRoiData[i] > 0.0f))//ditto
-                {
-                    charRoi[i] = 1;
-                } else {
-                    charRoi[i] = 0;
-                }
-            }
-        } else {
-            for (int i = 0; i < numNodes; ++i)
-            {
-                if (myInputData[i] != 0.0f)
-                {
-                    charRoi[i] = 1;
-                } else {
-                    charRoi[i] = 0;
-                }
-            }
-        }
-    }
-    CaretPointer<GeodesicHelperBase> correctedBase;
-    if (corrAreas != NULL)
+    vector<char> charRoi;
+    vector<int32_t> badNodes;
+    makeRois(charRoi, badNodes, numNodes, badRoiData, dataRoiVals, myInputData);
+    vector<pair<int32_t, float> > closest;
+    findClosest(closest, badNodes, charRoi, mySurf, correctedBase, distance);
+    for (int i = 0; i < numNodes; ++i)
     {
-        correctedBase.grabNew(new GeodesicHelperBase(mySurf, corrAreas->getValuePointerForColumn(0)));//NOTE: myAreas also points to this when applicable
+        colScratch[i] = myInputData[i];
     }
+    int numBad = (int)badNodes.size();
 #pragma omp CARET_PAR
     {
-        CaretPointer<TopologyHelper> myTopoHelp = mySurf->getTopologyHelper();
-        CaretPointer<GeodesicHelper> myGeoHelp;
-        if (corrAreas == NULL)
-        {
-            myGeoHelp = mySurf->getGeodesicHelper();
-        } else {
-            myGeoHelp.grabNew(new GeodesicHelper(correctedBase));
-        }
+        CaretPointer<GeodesicHelper> myGeoHelp = getGeoHelper(mySurf, correctedBase);
 #pragma omp CARET_FOR schedule(dynamic)
-        for (int i = 0; i < numNodes; ++i)
+        for (int b = 0; b < numBad; ++b)
         {
-            bool badNode;
-            if (badRoiData != NULL)
+            const int i = badNodes[b];
+            const int closestNode = closest[b].first;
+            if (closestNode == -1)
             {
-                badNode = (badRoiData[i] > 0.0f);
-            } else {
-                badNode = (myInputData[i] == 0.0f);
+                colScratch[i] = 0.0f;
+                continue;
             }
-            if ((dataRoiVals == NULL || dataRoiVals[i] > 0.0f) && badNode)
+            vector<int32_t> nodeList;
+            vector<float> distList;
+            myGeoHelp->getNodesToGeoDist(i, distance, nodeList, distList);
+            int numInRange = (int)nodeList.size();
+            Vector3D center = mySurf->getCoordinate(i);
+            vector<float> blockDists;
+            vector<int32_t> blockPath;
+            vector<int32_t> usableNodes;
+            vector<float> usableDists;
+            for (int j = 0; j < numInRange; ++j)//prescan what is usable, and also exclude things that are through a valid node
             {
-                float closestDist;//NOTE: the only time this function is called with a badRoi is when using linear, which doesn't use the closest distance
-                int closestNode = myGeoHelp->getClosestNodeInRoi(i, charRoi.data(), distance, closestDist);
-                if (closestNode == -1)//check neighbors, to ensure we dilate by at least one node everywhere
+                if (charRoi[nodeList[j]] != 0)
                 {
-                    const vector<int32_t>& nodeList = myTopoHelp->getNodeNeighbors(i);
-                    vector<float> distList;
-                    myGeoHelp->getGeoToTheseNodes(i, nodeList, distList);//ok, its a little silly to do this
-                    const int numInRange = (int)nodeList.size();
-                    for (int j = 0; j < numInRange; ++j)
+                    myGeoHelp->getPathAlongLineSegment(i, nodeList[j], center, mySurf->getCoordinate(nodeList[j]), blockPath, blockDists);
+                    CaretAssert(blockPath.size() > 0 && blockPath[0] == i);//we already know that i is "bad", skip it
+                    bool usable = true;
+                    for (int k = 1; k < (int)blockPath.size() - 1; ++k)//and don't test the endpoint
                     {
-                        if (charRoi[nodeList[j]] != 0 && (closestNode == -1 || distList[j] < closestDist))
+                        if (charRoi[blockPath[k]] != 0)
                         {
-                            closestNode = nodeList[j];
-                            closestDist = distList[j];
+                            usable = false;
+                            break;
                         }
                     }
+                    if (usable)
+                    {
+                        usableNodes.push_back(nodeList[j]);
+                        usableDists.push_back(distList[j]);
+                    }
                 }
-                if (closestNode == -1)
+            }
+            int numUsable = (int)usableNodes.size();
+            float bestGradient = -1.0f;
+            int bestj = -1, bestk = -1;
+            for (int j = 0; j < numUsable; ++j)
+            {
+                int node1 = usableNodes[j];
+                for (int k = j + 1; k < numUsable; ++k)
                 {
-                    colScratch[i] = 0.0f;
-                } else {
-                    if (nearest)
+                    int node2 = usableNodes[k];
+                    float grad = abs(myInputData[node1] - myInputData[node2]) / (usableDists[j] + usableDists[k]);
+                    if (grad > bestGradient)
                     {
-                        colScratch[i] = myInputData[closestNode];
-                    } else {
-                        vector<int32_t> nodeList;
-                        vector<float> distList;
-                        if (linear)
-                        {
-                            myGeoHelp->getNodesToGeoDist(i, distance, nodeList, distList);
-                            int numInRange = (int)nodeList.size();
-                            Vector3D center = mySurf->getCoordinate(i);
-                            vector<float> blockDists;
-                            vector<int32_t> blockPath;
-                            vector<int32_t> usableNodes;
-                            vector<float> usableDists;
-                            for (int j = 0; j < numInRange; ++j)//prescan what is usable, and also exclude things that are through a valid node
-                            {
-                                if (badRoiData != NULL)
-                                {
-                                    badNode = (badRoiData[nodeList[j]] > 0.0f);
-                                } else {
-                                    badNode = (myInputData[nodeList[j]] == 0.0f);
-                                }
-                                if ((dataRoiVals == NULL || dataRoiVals[nodeList[j]] > 0.0f) && !badNode)
-                                {
-                                    myGeoHelp->getPathAlongLineSegment(i, nodeList[j], center, mySurf->getCoordinate(nodeList[j]), blockPath, blockDists);
-                                    CaretAssert(blockPath.size() > 0 && blockPath[0] == i);//we already know that i is "bad", skip it
-                                    bool usable = true;
-                                    for (int k = 1; k < (int)blockPath.size() - 1; ++k)//and don't test the endpoint
-                                    {
-                                        if (dataRoiVals == NULL || dataRoiVals[blockPath[k]] > 0.0f)
-                                        {
-                                            if (badRoiData != NULL)
-                                            {
-                                                if (!(badRoiData[blockPath[k]] > 0.0f))//"not greater than" to trap NaNs
-                                                {
-                                                    usable = false;
-                                                    break;
-                                                }
-                                            } else {
-                                                if (myInputData[blockPath[k]] != 0.0f)
-                                                {
-                                                    usable = false;
-                                                    break;
-                                                }
-                                            }
-                                        }
-                                    }
-                                    if (usable)
-                                    {
-                                        usableNodes.push_back(nodeList[j]);
-                                        usableDists.push_back(distList[j]);
-                                    }
-                                }
-                            }
-                            int numUsable = (int)usableNodes.size();
-                            float bestGradient = -1.0f;
-                            int bestj = -1, bestk = -1;
-                            for (int j = 0; j < numUsable; ++j)
-                            {
-                                int node1 = usableNodes[j];
-                                for (int k = j + 1; k < numUsable; ++k)
-                                {
-                                    int node2 = usableNodes[k];
-                                    float grad = abs(myInputData[node1] - myInputData[node2]) / (usableDists[j] + usableDists[k]);
-                                    if (grad > bestGradient)
-                                    {
-                                        bestGradient = grad;
-                                        bestj = j;
-                                        bestk = k;
-                                    }
-                                }
-                            }
-                            if (bestj == -1)
-                            {
-                                colScratch[i] = myInputData[closestNode];
-                            } else {
-                                int node1 = usableNodes[bestj], node2 = usableNodes[bestk];
-                                colScratch[i] = myInputData[node1] + (myInputData[node2] - myInputData[node1]) * usableDists[bestj] / (usableDists[bestj] + usableDists[bestk]);
-                            }
-                        } else {
-                            myGeoHelp->getNodesToGeoDist(i, closestDist * cutoffRatio, nodeList, distList);//NOTE: guaranteed to find at least the closest node
-                            int numInRange = (int)nodeList.size();
-                            float totalWeight = 0.0f, weightedSum = 0.0f;
-                            for (int j = 0; j < numInRange; ++j)
-                            {
-                                if (charRoi[nodeList[j]] != 0)
-                                {
-                                    float weight;
-                                    const float tolerance = 0.9f;//distances should NEVER be less than closestDist, for obvious reasons
-                                    float divdist = distList[j] / closestDist;
-                                    if (divdist > tolerance)//tricky: if closestDist is zero, this filters between NaN and inf, resulting in a straight average between nodes with 0 distance
-                                    {
-                                        weight = myAreas[nodeList[j]] / pow(divdist, exponent);//NOTE: myAreas has already been pointed to the right data with -corrected-areas
-                                    } else {
-                                        weight = myAreas[nodeList[j]] / pow(tolerance, exponent);
-                                    }
-                                    totalWeight += weight;
-                                    weightedSum += myInputData[nodeList[j]] * weight;
-                                }
-                            }
-                            if (totalWeight != 0.0f)
-                            {
-                                colScratch[i] = weightedSum / totalWeight;
-                            } else {
-                                colScratch[i] = 0.0f;
-                            }
-                        }
+                        bestGradient = grad;
+                        bestj = j;
+                        bestk = k;
                     }
                 }
+            }
+            if (bestj == -1)
+            {
+                colScratch[i] = myInputData[closestNode];
             } else {
-                colScratch[i] = myInputData[i];
+                int node1 = usableNodes[bestj], node2 = usableNodes[bestk];
+                colScratch[i] = myInputData[node1] + (myInputData[node2] - myInputData[node1]) * usableDists[bestj] / (usableDists[bestj] + usableDists[bestk]);
             }
         }
     }
 }
 
-void AlgorithmMetricDilate::precomputeStencils(vector<pair<int, StencilElem> >& myStencils, const SurfaceFile* mySurf, const float* myAreas,
-                                               const MetricFile* badNodeRoi, const MetricFile* dataRoi, const MetricFile* corrAreas,
-                                               const float& distance, const float& exponent)
+void AlgorithmMetricDilate::precomputeStencils(vector<pair<int, StencilElem> >& myStencils, const vector<int32_t>& badNodes, const vector<pair<int32_t, float> >& closest,
+                                               const vector<char>& charRoi, const SurfaceFile* mySurf, const float* myAreas,
+                                               const CaretPointer<GeodesicHelperBase>& correctedBase, const float& exponent)
 {
-    CaretAssert(badNodeRoi != NULL);//because it should never be called if we don't know exactly what nodes we are replacing
-    const float* badNodeData = badNodeRoi->getValuePointerForColumn(0);
     float cutoffRatio = 1.5f, test = pow(10.0f, 1.0f / exponent);//find what cutoff ratio corresponds to a tenth of weight, but don't use more than a 1.5 * nearest cutoff
     if (test > 1.0f && test < cutoffRatio)//if it is less than 1, the exponent is weird, so simply ignore it and use default
     {
@@ -549,215 +470,60 @@ void AlgorithmMetricDilate::precomputeStencils(vector<pair<int, StencilElem> >&
             cutoffRatio = 1.1f;
         }
     }
-    int numNodes = mySurf->getNumberOfNodes();
-    vector<char> charRoi(numNodes);
-    const float* dataRoiVals = NULL;
-    int badCount = 0;
-    if (dataRoi != NULL)
-    {
-        dataRoiVals = dataRoi->getValuePointerForColumn(0);
-        for (int i = 0; i < numNodes; ++i)
-        {
-            if (!(badNodeData[i] > 0.0f))//in case some clown uses NaN in the ROI instead of 0
-            {
-                if (dataRoiVals[i] > 0.0f)
-                {
-                    charRoi[i] = 1;
-                } else {
-                    charRoi[i] = 0;
-                }
-            } else {
-                if (dataRoiVals[i] > 0.0f)
-                {
-                    ++badCount;
-                }
-                charRoi[i] = 0;
-            }
-        }
-    } else {
-        for (int i = 0; i < numNodes; ++i)
-        {
-            if (!(badNodeData[i] > 0.0f))
-            {
-                charRoi[i] = 1;
-            } else {
-                ++badCount;
-                charRoi[i] = 0;
-            }
-        }
-    }
-    myStencils.resize(badCount);//initializes all stencils to have empty lists
-    badCount = 0;
-    CaretPointer<GeodesicHelperBase> correctedBase;
-    if (corrAreas != NULL)
-    {
-        correctedBase.grabNew(new GeodesicHelperBase(mySurf, corrAreas->getValuePointerForColumn(0)));//NOTE: myAreas also points to this when applicable
-    }
+    int numBad = (int)badNodes.size();
+    myStencils.clear();//in case of reuse with a different pattern
+    myStencils.resize(numBad);//initializes all stencils to have empty lists
 #pragma omp CARET_PAR
     {
-        CaretPointer<TopologyHelper> myTopoHelp = mySurf->getTopologyHelper();
-        CaretPointer<GeodesicHelper> myGeoHelp;
-        if (corrAreas == NULL)
-        {
-            myGeoHelp = mySurf->getGeodesicHelper();
-        } else {
-            myGeoHelp.grabNew(new GeodesicHelper(correctedBase));
-        }
+        CaretPointer<GeodesicHelper> myGeoHelp = getGeoHelper(mySurf, correctedBase);
 #pragma omp CARET_FOR schedule(dynamic)
-        for (int i = 0; i < numNodes; ++i)
+        for (int b = 0; b < numBad; ++b)
         {
-            if (badNodeData[i] > 0.0f && (dataRoiVals == NULL || dataRoiVals[i] > 0.0f))
+            const int i = badNodes[b];
+            myStencils[b].first = i;
+            StencilElem& myElem = myStencils[b].second;
+            myElem.m_weightsum = 0.0f;
+            const int closestNode = closest[b].first;
+            const float closestDist = closest[b].second;
+            if (closestNode != -1)
             {
-                int myIndex;
-#pragma omp critical
+                vector<int32_t> nodeList;
+                vector<float> distList;
+                myGeoHelp->getNodesToGeoDist(i, closestDist * cutoffRatio, nodeList, distList);//NOTE: guaranteed to find at least the closest node
+                int numInRange = (int)nodeList.size();
+                for (int j = 0; j < numInRange; ++j)
                 {
-                    myIndex = badCount;
-                    ++badCount;
-                }
-                myStencils[myIndex].first = i;
-                StencilElem& myElem = myStencils[myIndex].second;
-                float closestDist;
-                int closestNode = myGeoHelp->getClosestNodeInRoi(i, charRoi.data(), distance, closestDist);
-                if (closestNode == -1)//check neighbors, to ensure we dilate by at least one node everywhere
-                {
-                    const vector<int32_t>& nodeList = myTopoHelp->getNodeNeighbors(i);
-                    vector<float> distList;
-                    myGeoHelp->getGeoToTheseNodes(i, nodeList, distList);//ok, its a little silly to do this
-                    const int numInRange = (int)nodeList.size();
-                    for (int j = 0; j < numInRange; ++j)
+                    if (charRoi[nodeList[j]] != 0)
                     {
-                        if (charRoi[nodeList[j]] != 0 && (closestNode == -1 || distList[j] < closestDist))
+                        float weight;
+                        const float tolerance = 0.9f;//distances should NEVER be less than closestDist, for obvious reasons
+                        float divdist = distList[j] / closestDist;
+                        if (divdist > tolerance)//tricky: if closestDist is zero, this filters between NaN and inf, resulting in a straight average between nodes with 0 distance
                         {
-                            closestNode = nodeList[j];
-                            closestDist = distList[j];
+                            weight = myAreas[nodeList[j]] / pow(divdist, exponent);//NOTE: myAreas has already been pointed to the right data with -corrected-areas
+                        } else {
+                            weight = myAreas[nodeList[j]] / pow(tolerance, exponent);
                         }
+                        myElem.m_weightsum += weight;
+                        myElem.m_weightlist.push_back(pair<int, float>(nodeList[j], weight));
                     }
                 }
-                if (closestNode != -1)
+                if (myElem.m_weightsum == 0.0f)//set list to empty instead of making NaNs
                 {
-                    vector<int32_t> nodeList;
-                    vector<float> distList;
-                    myGeoHelp->getNodesToGeoDist(i, closestDist * cutoffRatio, nodeList, distList);
-                    int numInRange = (int)nodeList.size();
-                    myElem.m_weightsum = 0.0f;
-                    for (int j = 0; j < numInRange; ++j)
-                    {
-                        if (charRoi[nodeList[j]] != 0)
-                        {
-                            float weight;
-                            const float tolerance = 0.9f;//distances should NEVER be less than closestDist, for obvious reasons
-                            float divdist = distList[j] / closestDist;
-                            if (divdist > tolerance)//tricky: if closestDist is zero, this filters between NaN and inf, resulting in a straight average between nodes with 0 distance
-                            {
-                                weight = myAreas[nodeList[j]] / pow(divdist, exponent);//NOTE: myAreas has already been pointed to the right data with -corrected-areas
-                            } else {
-                                weight = myAreas[nodeList[j]] / pow(tolerance, exponent);
-                            }
-                            myElem.m_weightsum += weight;
-                            myElem.m_weightlist.push_back(pair<int, float>(nodeList[j], weight));
-                        }
-                    }
-                    if (myElem.m_weightsum == 0.0f)//set list to empty instead of making NaNs
-                    {
-                        myElem.m_weightlist.clear();
-                    }
+                    myElem.m_weightlist.clear();
                 }
             }
         }
     }
 }
 
-void AlgorithmMetricDilate::precomputeNearest(vector<pair<int, int> >& myNearest, const SurfaceFile* mySurf,
-                                              const MetricFile* badNodeRoi, const MetricFile* dataRoi, const MetricFile* corrAreas, const float& distance)
+void AlgorithmMetricDilate::precomputeNearest(vector<pair<int, int> >& myNearest, const vector<int32_t>& badNodes, const vector<pair<int32_t, float> >& closest)
 {
-    CaretAssert(badNodeRoi != NULL);//because it should never be called if we don't know exactly what nodes we are replacing
-    const float* badNodeData = badNodeRoi->getValuePointerForColumn(0);
-    int numNodes = mySurf->getNumberOfNodes();
-    vector<char> charRoi(numNodes);
-    const float* dataRoiVals = NULL;
-    int badCount = 0;
-    if (dataRoi != NULL)
+    int numBad = (int)badNodes.size();
+    myNearest.resize(numBad);
+    for (int b = 0; b < numBad; ++b)
     {
-        dataRoiVals = dataRoi->getValuePointerForColumn(0);
-        for (int i = 0; i < numNodes; ++i)
-        {
-            if (!(badNodeData[i] > 0.0f))//in case some clown uses NaN as "bad" in the ROI
-            {
-                if (dataRoiVals[i] > 0.0f)
-                {
-                    charRoi[i] = 1;
-                } else {
-                    charRoi[i] = 0;
-                }
-            } else {
-                if (dataRoiVals[i] > 0.0f)
-                {
-                    ++badCount;
-                }
-                charRoi[i] = 0;
-            }
-        }
-    } else {
-        for (int i = 0; i < numNodes; ++i)
-        {
-            if (!(badNodeData[i] > 0.0f))
-            {
-                charRoi[i] = 1;
-            } else {
-                ++badCount;
-                charRoi[i] = 0;
-            }
-        }
-    }
-    myNearest.resize(badCount);
-    badCount = 0;
-    CaretPointer<GeodesicHelperBase> correctedBase;
-    if (corrAreas != NULL)
-    {
-        correctedBase.grabNew(new GeodesicHelperBase(mySurf, corrAreas->getValuePointerForColumn(0)));//NOTE: myAreas also points to this when applicable
-    }
-#pragma omp CARET_PAR
-    {
-        CaretPointer<TopologyHelper> myTopoHelp = mySurf->getTopologyHelper();
-        CaretPointer<GeodesicHelper> myGeoHelp;
-        if (corrAreas == NULL)
-        {
-            myGeoHelp = mySurf->getGeodesicHelper();
-        } else {
-            myGeoHelp.grabNew(new GeodesicHelper(correctedBase));
-        }
-#pragma omp CARET_FOR schedule(dynamic)
-        for (int i = 0; i < numNodes; ++i)
-        {
-            if (badNodeData[i] > 0.0f && (dataRoiVals == NULL || dataRoiVals[i] > 0.0f))
-            {
-                int myIndex;
-#pragma omp critical
-                {
-                    myIndex = badCount;
-                    ++badCount;
-                }
-                myNearest[myIndex].first = i;
-                float closestDist;
-                int closestNode = myGeoHelp->getClosestNodeInRoi(i, charRoi.data(), distance, closestDist);
-                if (closestNode == -1)//check neighbors, to ensure we dilate by at least one node everywhere
-                {
-                    const vector<int32_t>& nodeList = myTopoHelp->getNodeNeighbors(i);
-                    vector<float> distList;
-                    myGeoHelp->getGeoToTheseNodes(i, nodeList, distList);//ok, its a little silly to do this
-                    const int numInRange = (int)nodeList.size();
-                    for (int j = 0; j < numInRange; ++j)
-                    {
-                        if (charRoi[nodeList[j]] != 0 && (closestNode == -1 || distList[j] < closestDist))
-                        {
-                            closestNode = nodeList[j];
-                            closestDist = distList[j];
-                        }
-                    }
-                }
-                myNearest[myIndex].second = closestNode;
-            }
-        }
+        myNearest[b] = pair<int, int>(badNodes[b], closest[b].first);
     }
 }
 
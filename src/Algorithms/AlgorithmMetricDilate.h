@@ -22,9 +22,14 @@
 /*LICENSE_END*/
 
 #include "AbstractAlgorithm.h"
+#include "CaretPointer.h"
+
+#include <vector>
 
 namespace caret {
     
+    class GeodesicHelperBase;
+    
     class AlgorithmMetricDilate : public AbstractAlgorithm
     {
         struct StencilElem
@@ -33,16 +38,17 @@ namespace caret {
             float m_weightsum;
         };
         AlgorithmMetricDilate();
-        void precomputeStencils(std::vector<std::pair<int, StencilElem> >& myStencils, const SurfaceFile* mySurf, const float* myAreas,
-                                const MetricFile* badNodeRoi, const MetricFile* dataRoi, const MetricFile* corrAreas,
-                                const float& distance, const float& exponent);
-        void precomputeNearest(std::vector<std::pair<int, int> >& myNearest, const SurfaceFile* mySurf,
-                               const MetricFile* badNodeRoi, const MetricFile* dataRoi, const MetricFile* corrAreas, const float& distance);
-        void processColumn(float* colScratch, const int& numNodes, const float* myInputData, std::vector<std::pair<int, int> > myNearest);
-        void processColumn(float* colScratch, const int& numNodes, const float* myInputData, std::vector<std::pair<int, StencilElem> > myStencils);
-        void processColumn(float* colScratch, const float* myInputData, const SurfaceFile* mySurf, const float* myAreas,
-                           const MetricFile* badNodeRoi, const MetricFile* dataRoi, const MetricFile* corrAreas,
-                           const float& distance, const bool& nearest, const bool& linear, const float& exponent);
+        void makeRois(std::vector<char>& charRoi, std::vector<int32_t>& badNodes, const int& numNodes, const float* badRoiData, const float* dataRoiVals, const float* myInputData);
+        void findClosest(std::vector<std::pair<int32_t, float> >& closestOut, const std::vector<int32_t>& badNodes, const std::vector<char>& charRoi,
+                         const SurfaceFile* mySurf, const CaretPointer<GeodesicHelperBase>& correctedBase, const float& distance);
+        void precomputeStencils(std::vector<std::pair<int, StencilElem> >& myStencils, const std::vector<int32_t>& badNodes, const std::vector<std::pair<int32_t, float> >& closest,
+                                const std::vector<char>& charRoi, const SurfaceFile* mySurf, const float* myAreas,
+                                const CaretPointer<GeodesicHelperBase>& correctedBase, const float& exponent);
+        void precomputeNearest(std::vector<std::pair<int, int> >& myNearest, const std::vector<int32_t>& badNodes, const std::vector<std::pair<int32_t, float> >& closest);
+        void processColumn(float* colScratch, const int& numNodes, const float* myInputData, const std::vector<std::pair<int, int> >& myNearest);
+        void processColumn(float* colScratch, const int& numNodes, const float* myInputData, const std::vector<std::pair<int, StencilElem> >& myStencils);
+        void processColumnLinear(float* colScratch, const float* myInputData, const SurfaceFile* mySurf, const float* badRoiData, const float* dataRoiVals,
+                                 const CaretPointer<GeodesicHelperBase>& correctedBase, const float& distance);
     protected:
         static float getSubAlgorithmWeight();
         static float getAlgorithmInternalWeight();
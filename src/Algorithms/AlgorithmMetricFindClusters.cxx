@@ -21,12 +21,15 @@
 #include "AlgorithmMetricFindClusters.h"
 #include "AlgorithmException.h"
 
+#include "CaretAssert.h"
 #include "CaretLogger.h"
+#include "CaretOMP.h"
+#include "ClusterHelper.h"
 #include "GeodesicHelper.h"
 #include "MetricFile.h"
 #include "SurfaceFile.h"
-#include "TopologyHelper.h"
 
+#include <algorithm>
 #include <vector>
 
 using namespace caret;
@@ -145,19 +148,20 @@ void AlgorithmMetricFindClusters::useParameters(OperationParameters* myParams, P
 
 namespace
 {
-    struct Cluster
+    struct ColumnClusters
     {
-        Cluster() { area = 0.0; }
-        vector<int32_t> members;
-        double area;
+        ColumnClusters() { numClusters = 0; }
+        vector<int32_t> labels;//cluster of each vertex, from ClusterHelper
+        vector<int32_t> kept;//clusters that pass all tests, in output order
+        int32_t numClusters;
     };
     
-    void processColumn(const float* data, const float* roiData, const float* nodeAreas, TopologyHelper* myTopoHelp, GeodesicHelper* myGeoHelp,
+    void processColumn(const float* data, const float* roiData, const float* nodeAreas, const ClusterHelper* myClusterHelp, GeodesicHelper* myGeoHelp,
                        const float& threshVal, const float& minArea, const bool& lessThan, const float& areaRatio, const float& distanceCutoff,
-                       float* outData, int& markVal)
+                       ColumnClusters& clustersOut)
     {
-        int numNodes = myTopoHelp->getNumberOfNodes();
-        vector<int> marked(numNodes, 0);
+        int numNodes = (int)myClusterHelp->getNumberOfElements();
+        vector<char> marked(numNodes, 0);
         if (lessThan)
         {
             for (int i = 0; i < numNodes; ++i)
@@ -176,48 +180,37 @@ namespace
                 }
             }
         }
-        vector<Cluster> clusters;
+        vector<double> areas;
+        myClusterHelp->findClusters(marked.data(), clustersOut.labels, areas, nodeAreas);
+        clustersOut.numClusters = (int32_t)areas.size();
+        vector<int32_t>& clusters = clustersOut.kept;
+        clusters.clear();
         float biggestSize = 0.0f;
         int biggestCluster = -1;
-        for (int i = 0; i < numNodes; ++i)
+        for (int32_t i = 0; i < (int32_t)areas.size(); ++i)
         {
-            if (marked[i])
+            if (areas[i] > minArea)
             {
-                Cluster newCluster;
-                newCluster.members.push_back(i);
-                marked[i] = 0;//unmark it when added to list to prevent multiples
-                for (int index = 0; index < (int)newCluster.members.size(); ++index)//NOTE: vector grows inside loop
+                if (areas[i] > biggestSize)
                 {
-                    int node = newCluster.members[index];//keep list around so we can put it into the output immediately if it is large enough
-                    newCluster.area += nodeAreas[node];
-                    const vector<int32_t>& neighbors = myTopoHelp->getNodeNeighbors(node);
-                    int numNeigh = (int)neighbors.size();
-                    for (int n = 0; n < numNeigh; ++n)
-                    {
-                        const int32_t& neighbor = neighbors[n];
-                        if (marked[neighbor])
-                        {
-                            newCluster.members.push_back(neighbor);
-                            marked[neighbor] = 0;
-                        }
-                    }
-                }
-                if (newCluster.area > minArea)
-                {
-                    if (newCluster.area > biggestSize)
-                    {
-                        biggestSize = newCluster.area;
-                        biggestCluster = (int)clusters.size();
-                    }
-                    clusters.push_back(newCluster);
+                    biggestSize = areas[i];
+                    biggestCluster = (int)clusters.size();
                 }
+                clusters.push_back(i);
             }
         }
-        vector<int32_t> pathScratch;
-        vector<float> distScratch;
         if (!clusters.empty() && biggestCluster == -1) CaretLogWarning("clusters found, but none have positive area, check your vertex areas for negatives");
         if (biggestCluster != -1 && (distanceCutoff > 0.0f || areaRatio > 0.0f))
         {
+            vector<vector<int64_t> > members;
+            vector<int32_t> biggestMembers, thisMembers, pathScratch;
+            vector<float> distScratch;
+            if (distanceCutoff > 0.0f)
+            {
+                ClusterHelper::getClusterMembers(clustersOut.labels, (int32_t)areas.size(), members);
+                const vector<int64_t>& biggestList = members[clusters[biggestCluster]];
+                biggestMembers.assign(biggestList.begin(), biggestList.end());
+            }
             for (size_t i = 0; i < clusters.size(); ++i)
             {
                 if ((int)i != biggestCluster)
@@ -225,7 +218,7 @@ namespace
                     bool erase = false;
                     if (areaRatio > 0.0f)
                     {
-                        if ((clusters[i].area / biggestSize) < areaRatio)
+                        if ((areas[clusters[i]] / biggestSize) < areaRatio)
                         {
                             erase = true;
                         }
@@ -233,7 +226,9 @@ namespace
                     if (!erase && distanceCutoff > 0.0f)
                     {
                         CaretAssert(myGeoHelp != NULL);
-                        myGeoHelp->getPathBetweenNodeLists(clusters[i].members, clusters[biggestCluster].members, distanceCutoff, pathScratch, distScratch, true);
+                        const vector<int64_t>& thisList = members[clusters[i]];
+                        thisMembers.assign(thisList.begin(), thisList.end());
+                        myGeoHelp->getPathBetweenNodeLists(thisMembers, biggestMembers, distanceCutoff, pathScratch, distScratch, true);
                         if (pathScratch.empty())//empty path means no path found
                         {
                             erase = true;
@@ -248,7 +243,12 @@ namespace
                 }
             }
         }
-        for (size_t i = 0; i < clusters.size(); ++i)
+    }
+    
+    void markColumn(const ColumnClusters& clusters, float* outData, int& markVal)
+    {
+        vector<float> clusterMarks(clusters.numClusters, 0.0f);
+        for (size_t i = 0; i < clusters.kept.size(); ++i)
         {
             if (markVal == 0)
             {
@@ -257,13 +257,15 @@ namespace
             }
             float tempVal = markVal;
             if ((int)tempVal != markVal) throw AlgorithmException("too many clusters, unable to mark them uniquely");
-            int numMembers = (int)clusters[i].members.size();
-            for (int index = 0; index < numMembers; ++index)
-            {
-                outData[clusters[i].members[index]] = tempVal;
-            }
+            clusterMarks[clusters.kept[i]] = tempVal;
             ++markVal;
         }
+        int64_t numNodes = (int64_t)clusters.labels.size();
+        for (int64_t i = 0; i < numNodes; ++i)
+        {
+            int32_t label = clusters.labels[i];
+            outData[i] = (label < 0 ? 0.0f : clusterMarks[label]);
+        }
     }
 }
 
@@ -302,41 +304,62 @@ AlgorithmMetricFindClusters::AlgorithmMetricFindClusters(ProgressObject* myProgO
     } else {
         nodeAreas = myAreas->getValuePointerForColumn(0);
     }
-    CaretPointer<TopologyHelper> myTopoHelp = mySurf->getTopologyHelper();
-    CaretPointer<GeodesicHelper> myGeoHelp;
+    ClusterHelper myClusterHelp(mySurf);
     CaretPointer<GeodesicHelperBase> myGeoBase;
-    if (distanceCutoff > 0.0f)//geodesic is only needed for distance cutoff
+    if (distanceCutoff > 0.0f && myAreas != NULL)//geodesic is only needed for distance cutoff
     {
-        if (myAreas == NULL)
-        {
-            myGeoHelp = mySurf->getGeodesicHelper();
-        } else {
-            myGeoBase.grabNew(new GeodesicHelperBase(mySurf, myAreas->getValuePointerForColumn(0)));
-            myGeoHelp.grabNew(new GeodesicHelper(myGeoBase));
-        }
+        myGeoBase.grabNew(new GeodesicHelperBase(mySurf, myAreas->getValuePointerForColumn(0)));
     }
-    vector<int> toSearch;
-    int markVal = startVal;//give each cluster a different value, including across maps
+    vector<int> columnList;
     if (columnNum == -1)
     {
         myMetricOut->setNumberOfNodesAndColumns(numNodes, numCols);
-        myMetricOut->setStructure(mySurf->getStructure());
         for (int c = 0; c < numCols; ++c)
         {
-            myMetricOut->setColumnName(c, myMetric->getColumnName(c));
-            vector<float> outData(numNodes, 0.0f);
-            const float* data = myMetric->getValuePointerForColumn(c);
-            processColumn(data, roiData, nodeAreas, myTopoHelp, myGeoHelp, threshVal, minArea, lessThan, areaRatio, distanceCutoff, outData.data(), markVal);
-            myMetricOut->setValuesForColumn(c, outData.data());
+            columnList.push_back(c);
         }
     } else {
         myMetricOut->setNumberOfNodesAndColumns(numNodes, 1);
-        myMetricOut->setStructure(mySurf->getStructure());
-        myMetricOut->setColumnName(0, myMetric->getColumnName(columnNum));
-        vector<float> outData(numNodes, 0.0f);
-        const float* data = myMetric->getValuePointerForColumn(columnNum);
-        processColumn(data, roiData, nodeAreas, myTopoHelp, myGeoHelp, threshVal, minArea, lessThan, areaRatio, distanceCutoff, outData.data(), markVal);
-        myMetricOut->setValuesForColumn(0, outData.data());
+        columnList.push_back(columnNum);
+    }
+    myMetricOut->setStructure(mySurf->getStructure());
+    int numOutCols = (int)columnList.size();
+#ifdef CARET_OMP
+    const int batchSize = 2 * omp_get_max_threads();//keeping a label per vertex for every column at once could take more memory than the input
+#else
+    const int batchSize = 1;
+#endif
+    vector<ColumnClusters> columnClusters(min(batchSize, numOutCols));
+    int markVal = startVal;//give each cluster a different value, including across maps
+    vector<float> outData(numNodes);
+    for (int batchStart = 0; batchStart < numOutCols; batchStart += batchSize)
+    {
+        int batchEnd = min(batchStart + batchSize, numOutCols);
+#pragma omp CARET_PAR
+        {
+            CaretPointer<GeodesicHelper> myGeoHelp;
+            if (distanceCutoff > 0.0f)
+            {
+                if (myAreas == NULL)
+                {
+                    myGeoHelp = mySurf->getGeodesicHelper();
+                } else {
+                    myGeoHelp.grabNew(new GeodesicHelper(myGeoBase));
+                }
+            }
+#pragma omp CARET_FOR schedule(dynamic)
+            for (int c = batchStart; c < batchEnd; ++c)
+            {
+                const float* data = myMetric->getValuePointerForColumn(columnList[c]);
+                processColumn(data, roiData, nodeAreas, &myClusterHelp, myGeoHelp, threshVal, minArea, lessThan, areaRatio, distanceCutoff, columnClusters[c - batchStart]);
+            }
+        }
+        for (int c = batchStart; c < batchEnd; ++c)
+        {//mark values depend on the clusters in previous columns, so do this part in order
+            myMetricOut->setColumnName(c, myMetric->getColumnName(columnList[c]));
+            markColumn(columnClusters[c - batchStart], outData.data(), markVal);
+            myMetricOut->setValuesForColumn(c, outData.data());
+        }
     }
     if (endVal != NULL) *endVal = markVal;
 }
@@ -28,6 +28,7 @@
 #include "CaretAssert.h"
 #include "CaretLogger.h"
 #include "SurfaceFile.h"
+#include "SurfaceSmoothingObject.h"
 
 using namespace caret;
 
@@ -138,12 +139,15 @@ AlgorithmSurfaceInflation::AlgorithmSurfaceInflation(ProgressObject* myProgObj,
                                                      const float inflationFactorIn)
    : AbstractAlgorithm(myProgObj)
 {
-    std::vector<ProgressObject*> subAlgProgress;
-    if (myProgObj != NULL) {
-        subAlgProgress.resize(cycles);
-        for (int32_t i = 0; i < cycles; ++i)
-        {
-            subAlgProgress[i] = myProgObj->addAlgorithm(AlgorithmSurfaceSmoothing::getAlgorithmWeight());
+    if (cycles > 0) {
+        if ((strength < 0.0)
+            || (strength > 1.0)) {
+            throw AlgorithmException("Invalid smoothing strength outside [0.0, 1.0]: "
+                                     + QString::number(strength, 'f', 5));
+        }
+        if (iterations <= 0) {
+            throw AlgorithmException("Invalid iterations value [1, infinity]: "
+                                     + QString::number(iterations));
         }
     }
     
@@ -151,7 +155,7 @@ AlgorithmSurfaceInflation::AlgorithmSurfaceInflation(ProgressObject* myProgObj,
      * Sets the algorithm up to use the progress object, and will
      * finish the progress object automatically when the algorithm terminates
      */
-    LevelProgress myProgress(myProgObj, 1.0f, 0.1f);//lower the internal weight
+    LevelProgress myProgress(myProgObj);
     
     const float inflationFactor = inflationFactorIn - 1.0;
     
@@ -163,49 +167,31 @@ AlgorithmSurfaceInflation::AlgorithmSurfaceInflation(ProgressObject* myProgObj,
     const float anatomicalRangeY = anatomicalBoundingBox->getDifferenceY();
     const float anatomicalRangeZ = anatomicalBoundingBox->getDifferenceZ();
     
-    const int32_t numberOfNodes = outputSurfaceFile->getNumberOfNodes();
+    /*
+     * The neighbor lists and coordinates are kept between cycles, rather than
+     * going through the surface file for each smoothing
+     */
+    SurfaceSmoothingObject mySmoother(outputSurfaceFile);
     
     for (int iCycle = 0; iCycle < cycles; iCycle++) {
         /*
          * Smooth
          */
-        ProgressObject* subProgress = NULL;
-        if (myProgObj != NULL)
-        {
-            subProgress = subAlgProgress[iCycle];
-        }
-        AlgorithmSurfaceSmoothing(subProgress,
-                                  outputSurfaceFile,
-                                  outputSurfaceFile,
-                                  strength,
-                                  iterations);
+        mySmoother.smooth(strength,
+                          iterations,
+                          &myProgress,
+                          static_cast<float>(iCycle) / static_cast<float>(cycles),
+                          static_cast<float>(iCycle + 1) / static_cast<float>(cycles));
         
         /*
          * Inflate
          */
-        float xyz[3];
-        for (int32_t iNode = 0; iNode < numberOfNodes; iNode++) {
-            outputSurfaceFile->getCoordinate(iNode,
-                                             xyz);
-            
-            const float x = xyz[0] / anatomicalRangeX;
-            const float y = xyz[1] / anatomicalRangeY;
-            const float z = xyz[2] / anatomicalRangeZ;
-            
-            const float radius = std::sqrt(x*x + y*y + z*z);
-            const float scale  = 1.0 + inflationFactor * (1.0 - radius);
-            
-            xyz[0] *= scale;
-            xyz[1] *= scale;
-            xyz[2] *= scale;
-            
-            outputSurfaceFile->setCoordinate(iNode,
-                                             xyz);
-        }
-        
-        myProgress.reportProgress(static_cast<float>(iCycle +1)
-                                  / static_cast<float>(cycles));
+        mySmoother.inflate(anatomicalRangeX,
+                           anatomicalRangeY,
+                           anatomicalRangeZ,
+                           inflationFactor);
     }
+    mySmoother.copyCoordinatesTo(outputSurfaceFile);
     
     outputSurfaceFile->computeNormals();
 }
@@ -219,7 +205,7 @@ AlgorithmSurfaceInflation::getAlgorithmInternalWeight()
     /*
      * override this if needed, if the progress bar isn't smooth
      */
-    return 0.1f;//all this does internally is rescale the coordinates, lower the internal weight
+    return AlgorithmSurfaceSmoothing::getAlgorithmWeight();//smoothing is done internally, rescaling the coordinates is cheap
 }
 
 /**
@@ -231,6 +217,6 @@ AlgorithmSurfaceInflation::getSubAlgorithmWeight()
     /*
      * If you use a subalgorithm
      */
-    return AlgorithmSurfaceSmoothing::getAlgorithmWeight();
+    return 0.0f;
 }
 
@@ -24,10 +24,12 @@
 #include "CaretAssert.h"
 #include "CaretLogger.h"
 #include "CaretPointer.h"
+#include "CaretOMP.h"
 #include "CaretPointLocator.h"
+#include "ClusterHelper.h"
 #include "VolumeFile.h"
-#include "VoxelIJK.h"
 
+#include <algorithm>
 #include <cmath>
 #include <vector>
 
@@ -135,23 +137,32 @@ void AlgorithmVolumeFindClusters::useParameters(OperationParameters* myParams, P
 
 namespace
 {
-    void processSubvol(const float* inFrame, VolumeFile* volOut, const int64_t& outSubvol, const int64_t& outComponent, const float& threshValue, const float& minVolume,
-                       const bool& lessThan, const float* roiFrame, const float& sizeRatio, const float& distanceCutoff, int& markVal)
+    struct FrameClusters
     {
-        vector<int64_t> dims = volOut->getDimensions();
+        FrameClusters() { numClusters = 0; }
+        vector<int32_t> labels;//cluster of each voxel, from ClusterHelper
+        vector<int32_t> kept;//clusters that pass all tests, in output order
+        int32_t numClusters;
+    };
+    
+    void indexToIJK(const int64_t& index, const vector<int64_t>& dims, int64_t ijkOut[3])
+    {
+        ijkOut[0] = index % dims[0];
+        int64_t temp = index / dims[0];
+        ijkOut[1] = temp % dims[1];
+        ijkOut[2] = temp / dims[1];
+    }
+    
+    void processSubvol(const float* inFrame, const VolumeSpace& mySpace, const ClusterHelper* myClusterHelp, const float& threshValue, const float& minVolume,
+                       const bool& lessThan, const float* roiFrame, const float& sizeRatio, const float& distanceCutoff, FrameClusters& clustersOut)
+    {
+        const int64_t* dimsPtr = mySpace.getDims();
+        vector<int64_t> dims(dimsPtr, dimsPtr + 3);
         int64_t frameSize = dims[0] * dims[1] * dims[2];
-        const VolumeSpace& mySpace = volOut->getVolumeSpace();
         Vector3D ivec, jvec, kvec, origin;
         mySpace.getSpacingVectors(ivec, jvec, kvec, origin);
         float voxelVolume = abs(ivec.dot(jvec.cross(kvec)));
         int64_t minVoxels = (int64_t)ceil(minVolume / voxelVolume);
-        vector<VoxelIJK> neighbors;
-        neighbors.push_back(VoxelIJK(1, 0, 0));
-        neighbors.push_back(VoxelIJK(-1, 0, 0));
-        neighbors.push_back(VoxelIJK(0, 1, 0));
-        neighbors.push_back(VoxelIJK(0, -1, 0));
-        neighbors.push_back(VoxelIJK(0, 0, 1));
-        neighbors.push_back(VoxelIJK(0, 0, -1));
         vector<char> marked(frameSize, 0);
         if (lessThan)
         {
@@ -171,65 +182,43 @@ namespace
                 }
             }
         }
-        vector<vector<VoxelIJK> > clusters;
-        size_t biggestCount = 0;
+        vector<double> counts;
+        myClusterHelp->findClusters(marked.data(), clustersOut.labels, counts);
+        clustersOut.numClusters = (int32_t)counts.size();
+        vector<int32_t>& clusters = clustersOut.kept;
+        clusters.clear();
+        int64_t biggestCount = 0;
         int64_t biggestCluster = -1;
-        for (int64_t k = 0; k < dims[2]; ++k)
+        for (int32_t i = 0; i < (int32_t)counts.size(); ++i)
         {
-            for (int64_t j = 0; j < dims[1]; ++j)
+            int64_t thisCount = (int64_t)counts[i];
+            if (thisCount >= minVoxels)
             {
-                for (int64_t i = 0; i < dims[0]; ++i)
+                if (thisCount > biggestCount)
                 {
-                    int64_t myIndex = mySpace.getIndex(i, j, k);
-                    if (marked[myIndex])
-                    {
-                        vector<VoxelIJK> voxelList;
-                        voxelList.push_back(VoxelIJK(i, j, k));
-                        marked[myIndex] = 0;//don't let voxels get duplicated in the list
-                        for (int64_t index = 0; index < (int64_t)voxelList.size(); ++index)//NOTE: vector grows inside loop
-                        {
-                            const VoxelIJK& thisVoxel = voxelList[index];
-                            for (int n = 0; n < (int)neighbors.size(); ++n)
-                            {
-                                VoxelIJK neighVox(thisVoxel.m_ijk[0] + neighbors[n].m_ijk[0],
-                                                    thisVoxel.m_ijk[1] + neighbors[n].m_ijk[1],
-                                                    thisVoxel.m_ijk[2] + neighbors[n].m_ijk[2]);
-                                if (mySpace.indexValid(neighVox.m_ijk))
-                                {
-                                    int64_t neighIndex = mySpace.getIndex(neighVox.m_ijk);
-                                    if (marked[neighIndex])
-                                    {
-                                        voxelList.push_back(neighVox);
-                                        marked[neighIndex] = 0;
-                                    }
-                                }
-                            }
-                        }
-                        if ((int64_t)voxelList.size() >= minVoxels)
-                        {
-                            if (voxelList.size() > biggestCount)
-                            {
-                                biggestCount = voxelList.size();
-                                biggestCluster = (int64_t)clusters.size();
-                            }
-                            clusters.push_back(voxelList);
-                        }
-                    }
+                    biggestCount = thisCount;
+                    biggestCluster = (int64_t)clusters.size();
                 }
+                clusters.push_back(i);
             }
         }
         if (!clusters.empty()) CaretAssert(biggestCluster != -1);
         if (biggestCluster != -1 && (distanceCutoff > 0.0f || sizeRatio > 0.0f))
         {
             CaretPointer<CaretPointLocator> myLocator;
+            vector<vector<int64_t> > members;
             if (distanceCutoff > 0.0f)
             {
+                ClusterHelper::getClusterMembers(clustersOut.labels, clustersOut.numClusters, members);
+                const vector<int64_t>& biggestList = members[clusters[biggestCluster]];
                 vector<float> biggestCoords;//gather coordinates of biggest cluster voxels
                 biggestCoords.reserve(biggestCount * 3);
-                for (size_t i = 0; i < clusters[biggestCluster].size(); ++i)
+                for (size_t i = 0; i < biggestList.size(); ++i)
                 {
+                    int64_t ijk[3];
                     float thisCoord[3];
-                    mySpace.indexToSpace(clusters[biggestCluster][i].m_ijk, thisCoord);
+                    indexToIJK(biggestList[i], dims, ijk);
+                    mySpace.indexToSpace(ijk, thisCoord);
                     biggestCoords.push_back(thisCoord[0]);
                     biggestCoords.push_back(thisCoord[1]);
                     biggestCoords.push_back(thisCoord[2]);
@@ -241,17 +230,20 @@ namespace
                 if ((int64_t)i != biggestCluster)
                 {
                     bool erase = false;
-                    if (sizeRatio > 0.0f && ((float)clusters[i].size()) / biggestCount < sizeRatio)
+                    if (sizeRatio > 0.0f && ((float)counts[clusters[i]]) / biggestCount < sizeRatio)
                     {
                         erase = true;
                     }
                     if (!erase && distanceCutoff > 0.0f)
                     {
                         erase = true;//erase unless we find a point close enough to the biggest cluster
-                        for (size_t j = 0; j < clusters[i].size(); ++j)
+                        const vector<int64_t>& thisList = members[clusters[i]];
+                        for (size_t j = 0; j < thisList.size(); ++j)
                         {
+                            int64_t ijk[3];
                             float thisCoord[3];
-                            mySpace.indexToSpace(clusters[i][j].m_ijk, thisCoord);
+                            indexToIJK(thisList[j], dims, ijk);
+                            mySpace.indexToSpace(ijk, thisCoord);
                             int32_t ret = myLocator->closestPointLimited(thisCoord, distanceCutoff);
                             if (ret == -1)
                             {
@@ -269,7 +261,12 @@ namespace
                 }
             }
         }
-        for (size_t i = 0; i < clusters.size(); ++i)
+    }
+    
+    void markFrame(const FrameClusters& clusters, float* outFrame, int& markVal)
+    {
+        vector<float> clusterMarks(clusters.numClusters, 0.0f);
+        for (size_t i = 0; i < clusters.kept.size(); ++i)
         {
             if (markVal == 0)
             {
@@ -278,12 +275,15 @@ namespace
             }
             float tempVal = markVal;
             if ((int)tempVal != markVal) throw AlgorithmException("too many clusters, unable to mark them uniquely");
-            for (size_t index = 0; index < clusters[i].size(); ++index)
-            {
-                volOut->setValue(tempVal, clusters[i][index].m_ijk, outSubvol, outComponent);
-            }
+            clusterMarks[clusters.kept[i]] = tempVal;
             ++markVal;
         }
+        int64_t frameSize = (int64_t)clusters.labels.size();
+        for (int64_t i = 0; i < frameSize; ++i)
+        {
+            int32_t label = clusters.labels[i];
+            outFrame[i] = (label < 0 ? 0.0f : clusterMarks[label]);
+        }
     }
 }
 
@@ -304,28 +304,53 @@ AlgorithmVolumeFindClusters::AlgorithmVolumeFindClusters(ProgressObject* myProgO
         roiFrame = myRoi->getFrame();
     }
     vector<int64_t> dims = volIn->getDimensions();
-    int markVal = startVal;
+    vector<int64_t> inSubvols, outSubvols, components;//flattened list of frames to process, in output order
     if (subvolNum == -1)
     {
         volOut->reinitialize(volIn->getOriginalDimensions(), volIn->getSform(), dims[4]);
-        volOut->setValueAllVoxels(0.0f);
         for (int64_t c = 0; c < dims[4]; ++c)
         {
             for (int64_t s = 0; s < dims[3]; ++s)
             {
-                const float* inFrame = volIn->getFrame(s, c);
-                processSubvol(inFrame, volOut, s, c, threshValue, minVolume, lessThan, roiFrame, sizeRatio, distanceCutoff, markVal);
+                inSubvols.push_back(s);
+                outSubvols.push_back(s);
+                components.push_back(c);
             }
         }
     } else {
         vector<int64_t> outDims = volIn->getOriginalDimensions();
         outDims.resize(3);
         volOut->reinitialize(outDims, volIn->getSform(), dims[4]);
-        volOut->setValueAllVoxels(0.0f);
         for (int64_t c = 0; c < dims[4]; ++c)
         {
-            const float* inFrame = volIn->getFrame(subvolNum, c);
-            processSubvol(inFrame, volOut, 0, c, threshValue, minVolume, lessThan, roiFrame, sizeRatio, distanceCutoff, markVal);
+            inSubvols.push_back(subvolNum);
+            outSubvols.push_back(0);
+            components.push_back(c);
+        }
+    }
+    ClusterHelper myClusterHelp(dims);
+    int64_t numFrames = (int64_t)inSubvols.size();
+#ifdef CARET_OMP
+    const int64_t batchSize = 2 * omp_get_max_threads();//keeping a label per voxel for every frame at once could take more memory than the input
+#else
+    const int64_t batchSize = 1;
+#endif
+    vector<FrameClusters> frameClusters(min(batchSize, numFrames));
+    int markVal = startVal;
+    vector<float> outFrame(dims[0] * dims[1] * dims[2]);
+    for (int64_t batchStart = 0; batchStart < numFrames; batchStart += batchSize)
+    {
+        int64_t batchEnd = min(batchStart + batchSize, numFrames);
+#pragma omp CARET_PARFOR schedule(dynamic)
+        for (int64_t f = batchStart; f < batchEnd; ++f)
+        {
+            const float* inFrame = volIn->getFrame(inSubvols[f], components[f]);
+            processSubvol(inFrame, mySpace, &myClusterHelp, threshValue, minVolume, lessThan, roiFrame, sizeRatio, distanceCutoff, frameClusters[f - batchStart]);
+        }
+        for (int64_t f = batchStart; f < batchEnd; ++f)
+        {//mark values depend on the clusters in previous frames, so do this part in order
+            markFrame(frameClusters[f - batchStart], outFrame.data(), markVal);
+            volOut->setFrame(outFrame.data(), outSubvols[f], components[f]);
         }
     }
     if (endVal != NULL) *endVal = markVal;
@@ -0,0 +1,141 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CiftiStructureScheduler.h"
+
+#include "CaretMutex.h"
+#include "CaretOMP.h"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    struct CostOrder
+    {
+        const vector<int64_t>& m_costs;
+        CostOrder(const vector<int64_t>& costs) : m_costs(costs) { }
+        bool operator()(const int& left, const int& right) const { return m_costs[left] > m_costs[right]; }
+    };
+}
+
+void CiftiStructureScheduler::addTask(const int64_t& cost, const ComputeFunction& compute)
+{
+    Task newTask;
+    newTask.m_cost = max(cost, (int64_t)1);
+    newTask.m_compute = compute;
+    m_tasks.push_back(newTask);
+}
+
+void CiftiStructureScheduler::run()
+{
+    const int numTasks = (int)m_tasks.size();
+    if (numTasks == 0) return;
+    vector<StoreFunction> stores(numTasks);
+    vector<exception_ptr> errors(numTasks);
+    vector<bool> finished(numTasks, false);
+    int nextStore = 0;
+    bool failed = false;
+    CaretMutex storeMutex;
+    auto runTask = [&](const int& task)
+    {
+        bool skip;
+        {
+            CaretMutexLocker locked(&storeMutex);
+            skip = failed;//the whole output is useless once anything has failed
+        }
+        if (!skip)
+        {
+            try
+            {
+                stores[task] = m_tasks[task].m_compute();
+            } catch (...) {//exceptions can't leave an openmp region
+                errors[task] = current_exception();
+            }
+        }
+        m_tasks[task].m_compute = ComputeFunction();//release anything the compute function captured
+        CaretMutexLocker locked(&storeMutex);
+        if (errors[task]) failed = true;
+        finished[task] = true;
+        while (nextStore < numTasks && finished[nextStore])
+        {//whoever finishes the next task in order does the stores that were waiting on it, so no thread blocks waiting for another task
+            if (!failed && stores[nextStore])
+            {
+                try
+                {
+                    stores[nextStore]();
+                } catch (...) {
+                    errors[nextStore] = current_exception();
+                    failed = true;
+                }
+            }
+            stores[nextStore] = StoreFunction();//free the structure's result as soon as it is in the output
+            ++nextStore;
+        }
+    };
+    bool ranParallel = false;
+#ifdef CARET_OMP
+    const int totalThreads = omp_get_max_threads();
+    if (m_parallel && numTasks > 1 && totalThreads > 1 && omp_get_level() == 0)
+    {//with one structure, or when already inside a parallel region, the structure's own loops use the threads better
+        vector<int64_t> costs(numTasks);
+        int64_t totalCost = 0;
+        for (int i = 0; i < numTasks; ++i)
+        {
+            costs[i] = m_tasks[i].m_cost;
+            totalCost += costs[i];
+        }
+        vector<int> order(numTasks);
+        for (int i = 0; i < numTasks; ++i) order[i] = i;
+        stable_sort(order.begin(), order.end(), CostOrder(costs));//start the big structures first, so a small one finishes the schedule
+        vector<int> budget(numTasks);
+        for (int i = 0; i < numTasks; ++i)
+        {//threads proportional to cost, the rounding can oversubscribe slightly, which is harmless
+            budget[i] = max(1, min(totalThreads, (int)floor(((double)totalThreads) * costs[i] / totalCost + 0.5)));
+        }
+        const int oldMaxLevels = omp_get_max_active_levels();
+        if (oldMaxLevels < 2) omp_set_max_active_levels(2);
+#pragma omp CARET_PARFOR schedule(dynamic) num_threads(min(numTasks, totalThreads))
+        for (int i = 0; i < numTasks; ++i)
+        {
+            omp_set_num_threads(budget[order[i]]);//only affects parallel regions started by this thread
+            runTask(order[i]);
+        }
+        omp_set_max_active_levels(oldMaxLevels);
+        ranParallel = true;
+    }
+#endif
+    if (!ranParallel)
+    {
+        for (int i = 0; i < numTasks; ++i)
+        {
+            runTask(i);
+        }
+    }
+    m_tasks.clear();
+    for (int i = 0; i < numTasks; ++i)
+    {
+        if (errors[i]) rethrow_exception(errors[i]);
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef __CIFTI_STRUCTURE_SCHEDULER_H__
+#define __CIFTI_STRUCTURE_SCHEDULER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <functional>
+#include <stdint.h>
+#include <vector>
+
+namespace caret
+{
+
+    ///runs the per-structure steps of a dense cifti algorithm (separate, process, replace structure) for several structures at once
+    ///each task's compute function runs on its own share of the openmp threads, largest first, and returns a store function that puts
+    ///its result into the output cifti - store functions run one at a time and in the order the tasks were added, so the output
+    ///(including label table keys) doesn't depend on which structure finished first
+    ///compute functions run concurrently, so they must not modify anything shared, including non-const surfaces used by more than one task
+    class CiftiStructureScheduler
+    {
+    public:
+        typedef std::function<void()> StoreFunction;
+        typedef std::function<StoreFunction()> ComputeFunction;
+
+        ///parallel = false runs everything in the calling thread, in order
+        explicit CiftiStructureScheduler(const bool& parallel = true) : m_parallel(parallel) { }
+
+        ///cost should be proportional to the work, the number of vertices or voxels in the structure is usually good enough
+        void addTask(const int64_t& cost, const ComputeFunction& compute);
+
+        ///rethrows the first exception in task order, after all running tasks finish
+        void run();
+    private:
+        struct Task
+        {
+            int64_t m_cost;
+            ComputeFunction m_compute;
+        };
+        bool m_parallel;
+        std::vector<Task> m_tasks;
+    };
+
+}
+
+#endif //__CIFTI_STRUCTURE_SCHEDULER_H__
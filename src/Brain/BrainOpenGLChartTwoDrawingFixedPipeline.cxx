@@ -1243,9 +1243,54 @@ BrainOpenGLChartTwoDrawingFixedPipeline::drawMatrixChartContent(const ChartableT
                                                                 const float /*zooming*/,
                                                                 std::vector<MatrixRowColumnHighight*>& rowColumnHighlightingOut)
 {
-    GraphicsPrimitiveV3fC4f* matrixPrimitive = matrixChart->getMatrixChartingGraphicsPrimitive(chartViewingType,
-                                                                                               CiftiMappableDataFile::MatrixGridMode::FILLED);
+    glPushMatrix();
+    glScalef(cellWidth, cellHeight, 1.0);
+    
+    /*
+     * Large matrices are drawn with only the part that is in view
+     * at a level of detail that fits the viewport.
+     */
+    const bool levelOfDetailFlag = matrixChart->isMatrixChartingLevelOfDetailUsed();
+    float viewBounds[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    float cellsPerPixel = 1.0f;
+    if (levelOfDetailFlag) {
+        GLfloat modelviewMatrix[16];
+        glGetFloatv(GL_MODELVIEW_MATRIX, modelviewMatrix);
+        GLfloat projectionMatrix[16];
+        glGetFloatv(GL_PROJECTION_MATRIX, projectionMatrix);
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        
+        /*
+         * Scaling from matrix cells to pixels with orthographic projection
+         */
+        const float pixelsPerCellX = (modelviewMatrix[0] * projectionMatrix[0] * viewport[2]) / 2.0f;
+        const float pixelsPerCellY = (modelviewMatrix[5] * projectionMatrix[5] * viewport[3]) / 2.0f;
+        if ((pixelsPerCellX > 0.0f)
+            && (pixelsPerCellY > 0.0f)) {
+            const float cellsAtLeftX   = (((-1.0f - projectionMatrix[12]) / projectionMatrix[0]) - modelviewMatrix[12]) / modelviewMatrix[0];
+            const float cellsAtBottomY = (((-1.0f - projectionMatrix[13]) / projectionMatrix[5]) - modelviewMatrix[13]) / modelviewMatrix[5];
+            viewBounds[0] = cellsAtLeftX;
+            viewBounds[1] = cellsAtLeftX + (viewport[2] / pixelsPerCellX);
+            viewBounds[2] = cellsAtBottomY;
+            viewBounds[3] = cellsAtBottomY + (viewport[3] / pixelsPerCellY);
+            
+            /*
+             * Pooled cells are at least two pixels so that they are distinguishable
+             */
+            cellsPerPixel = 2.0f / std::min(pixelsPerCellX, pixelsPerCellY);
+        }
+    }
+    
+    GraphicsPrimitiveV3fC4f* matrixPrimitive = (levelOfDetailFlag
+                                                ? matrixChart->getMatrixChartingGraphicsPrimitiveForView(chartViewingType,
+                                                                                                         CiftiMappableDataFile::MatrixGridMode::FILLED,
+                                                                                                         viewBounds,
+                                                                                                         cellsPerPixel)
+                                                : matrixChart->getMatrixChartingGraphicsPrimitive(chartViewingType,
+                                                                                                  CiftiMappableDataFile::MatrixGridMode::FILLED));
     if (matrixPrimitive == NULL) {
+        glPopMatrix();
         return;
     }
     
@@ -1253,8 +1298,6 @@ BrainOpenGLChartTwoDrawingFixedPipeline::drawMatrixChartContent(const ChartableT
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     }
     
-    glPushMatrix();
-    glScalef(cellWidth, cellHeight, 1.0);
     /*
      * Enable alpha blending so voxels that are not drawn from higher layers
      * allow voxels from lower layers to be seen.
@@ -1277,15 +1320,26 @@ BrainOpenGLChartTwoDrawingFixedPipeline::drawMatrixChartContent(const ChartableT
             CaretAssert(matrixPrimitive->getPrimitiveType() == GraphicsPrimitive::PrimitiveType::OPENGL_TRIANGLES);
             primitiveIndex /= 2;
             
-            int32_t numberOfRows = 0;
-            int32_t numberOfColumns = 0;
-            matrixChart->getMatrixDimensions(numberOfRows,
-                                             numberOfColumns);
-            
-            const int32_t rowIndex = primitiveIndex / numberOfColumns;
-            const int32_t colIndex = primitiveIndex % numberOfColumns;
+            int32_t rowIndex = -1;
+            int32_t colIndex = -1;
+            if (levelOfDetailFlag) {
+                matrixChart->getMatrixChartingForViewRowAndColumn(primitiveIndex,
+                                                                  rowIndex,
+                                                                  colIndex);
+            }
+            else {
+                int32_t numberOfRows = 0;
+                int32_t numberOfColumns = 0;
+                matrixChart->getMatrixDimensions(numberOfRows,
+                                                 numberOfColumns);
+                
+                rowIndex = primitiveIndex / numberOfColumns;
+                colIndex = primitiveIndex % numberOfColumns;
+            }
             
-            if (m_selectionItemMatrix->isOtherScreenDepthCloserToViewer(primitiveDepth)) {
+            if ((rowIndex >= 0)
+                && (colIndex >= 0)
+                && m_selectionItemMatrix->isOtherScreenDepthCloserToViewer(primitiveDepth)) {
                 m_selectionItemMatrix->setMatrixChart(const_cast<ChartableTwoFileMatrixChart*>(matrixChart),
                                                       rowIndex,
                                                       colIndex);
@@ -1299,8 +1353,13 @@ BrainOpenGLChartTwoDrawingFixedPipeline::drawMatrixChartContent(const ChartableT
         CaretAssert(matrixProperties);
         
         if (matrixProperties->isGridLinesDisplayed()) {
-            GraphicsPrimitiveV3fC4f* matrixGridPrimitive = matrixChart->getMatrixChartingGraphicsPrimitive(chartViewingType,
-                                                                                                           CiftiMappableDataFile::MatrixGridMode::OUTLINE);
+            GraphicsPrimitiveV3fC4f* matrixGridPrimitive = (levelOfDetailFlag
+                                                            ? matrixChart->getMatrixChartingGraphicsPrimitiveForView(chartViewingType,
+                                                                                                                     CiftiMappableDataFile::MatrixGridMode::OUTLINE,
+                                                                                                                     viewBounds,
+                                                                                                                     cellsPerPixel)
+                                                            : matrixChart->getMatrixChartingGraphicsPrimitive(chartViewingType,
+                                                                                                              CiftiMappableDataFile::MatrixGridMode::OUTLINE));
             drawPrimitivePrivate(matrixGridPrimitive);
         }
         
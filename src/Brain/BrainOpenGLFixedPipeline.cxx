@@ -102,6 +102,7 @@
 #include "GiftiLabel.h"
 #include "GiftiLabelTable.h"
 #include "GraphicsEngineDataOpenGL.h"
+#include "GraphicsPrimitiveV3fC4f.h"
 #include "GraphicsPrimitiveV3fC4ub.h"
 #include "GraphicsPrimitiveV3f.h"
 #include "GraphicsShape.h"
@@ -124,6 +125,7 @@
 #include "SurfaceMontageConfigurationFlatMaps.h"
 #include "IdentificationWithColor.h"
 #include "SelectionManager.h"
+#include "SelectionRayCaster.h"
 #include "MathFunctions.h"
 #include "ModelChart.h"
 #include "ModelChartTwo.h"
@@ -2005,30 +2007,14 @@ BrainOpenGLFixedPipeline::drawSurfaceTriangles(Surface* surface,
             break;
     }
     
-    if (isSelect) {
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    }
-    
-    uint8_t rgba[4];
-    
-    glBegin(GL_TRIANGLES);
-    for (int32_t i = 0; i < numTriangles; i++) {
-        const int32_t i3 = i * 3;
-        const int32_t n1 = triangles[i3];
-        const int32_t n2 = triangles[i3+1];
-        const int32_t n3 = triangles[i3+2];
-        
-        if (isSelect) {
-            this->colorIdentification->addItem(rgba, SelectionItemDataTypeEnum::SURFACE_TRIANGLE, i);
-            glColor3ubv(rgba);
-            glNormal3fv(&normals[n1*3]);
-            glVertex3fv(&coordinates[n1*3]);
-            glNormal3fv(&normals[n2*3]);
-            glVertex3fv(&coordinates[n2*3]);
-            glNormal3fv(&normals[n3*3]);
-            glVertex3fv(&coordinates[n3*3]);
-        }
-        else {
+    if ( ! isSelect) {
+        glBegin(GL_TRIANGLES);
+        for (int32_t i = 0; i < numTriangles; i++) {
+            const int32_t i3 = i * 3;
+            const int32_t n1 = triangles[i3];
+            const int32_t n2 = triangles[i3+1];
+            const int32_t n3 = triangles[i3+2];
+            
             glColor4fv(&nodeColoringRGBA[n1*4]);
             glNormal3fv(&normals[n1*3]);
             glVertex3fv(&coordinates[n1*3]);
@@ -2039,17 +2025,24 @@ BrainOpenGLFixedPipeline::drawSurfaceTriangles(Surface* surface,
             glNormal3fv(&normals[n3*3]);
             glVertex3fv(&coordinates[n3*3]);
         }
+        glEnd();
     }
-    glEnd();
     
     if (isSelect) {
+        /*
+         * Cast a ray into the surface instead of drawing the
+         * triangles in identification colors and reading pixels
+         */
         int32_t triangleIndex = -1;
         float depth = -1.0;
-        this->getIndexFromColorSelection(SelectionItemDataTypeEnum::SURFACE_TRIANGLE, 
-                                         this->mouseX, 
-                                         this->mouseY,
-                                         triangleIndex,
-                                         depth);
+        const SelectionRayCaster rayCaster = createSelectionRayCaster();
+        float hitXYZ[3];
+        if (getSurfaceRayHit(rayCaster,
+                             surface,
+                             triangleIndex,
+                             hitXYZ)) {
+            depth = rayCaster.getWindowDepth(hitXYZ);
+        }
         
         
         if (triangleIndex >= 0) {
@@ -2337,7 +2330,6 @@ BrainOpenGLFixedPipeline::drawSurfaceNodes(Surface* surface,
         case MODE_IDENTIFICATION:
             if (nodeID->isEnabledForSelection()) {
                 isSelect = true;
-                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);            
             }
             else {
                 return;
@@ -2347,42 +2339,57 @@ BrainOpenGLFixedPipeline::drawSurfaceNodes(Surface* surface,
             break;
     }
     
-    uint8_t rgba[4];
-
-    float pointSize = dps->getNodeSize();
-    if (isSelect) {
-        if (pointSize < 2.0) {
-            pointSize = 2.0;
-        }
-    }
-    setPointSize(pointSize);
-    
-    glBegin(GL_POINTS);
-    for (int32_t i = 0; i < numNodes; i++) {
-        const int32_t i3 = i * 3;
+    if ( ! isSelect) {
+        setPointSize(dps->getNodeSize());
         
-        if (isSelect) {
-            this->colorIdentification->addItem(rgba, SelectionItemDataTypeEnum::SURFACE_NODE, i);
-            glColor3ubv(rgba);
-            glNormal3fv(&normals[i3]);
-            glVertex3fv(&coordinates[i3]);
-        }
-        else {
+        glBegin(GL_POINTS);
+        for (int32_t i = 0; i < numNodes; i++) {
+            const int32_t i3 = i * 3;
             glColor4fv(&nodeColoringRGBA[i*4]);
             glNormal3fv(&normals[i3]);
             glVertex3fv(&coordinates[i3]);
         }
+        glEnd();
     }
-    glEnd();
     
     if (isSelect) {
+        /*
+         * Cast a ray into the surface and use the vertex of the
+         * hit triangle that is closest to the mouse on the screen.
+         * Unlike picking the drawn vertex points by color, this only
+         * finds vertices on the visible front surface, and it finds
+         * one anywhere on the surface, not only within a point's size
+         * of the mouse.
+         */
         int nodeIndex = -1;
         float depth = -1.0;
-        this->getIndexFromColorSelection(SelectionItemDataTypeEnum::SURFACE_NODE, 
-                                         this->mouseX, 
-                                         this->mouseY,
-                                         nodeIndex,
-                                         depth);
+        const SelectionRayCaster rayCaster = createSelectionRayCaster();
+        int32_t triangleIndex = -1;
+        float hitXYZ[3];
+        if (getSurfaceRayHit(rayCaster,
+                             surface,
+                             triangleIndex,
+                             hitXYZ)) {
+            const int32_t* triangleNodes = surface->getTriangle(triangleIndex);
+            double nearestDistance = std::numeric_limits<double>::max();
+            for (int32_t iNode = 0; iNode < 3; iNode++) {
+                const float* xyz = &coordinates[triangleNodes[iNode] * 3];
+                const double nodeXYZ[3] = { xyz[0], xyz[1], xyz[2] };
+                double windowXYZ[3];
+                if (rayCaster.getWindowXYZ(nodeXYZ,
+                                           windowXYZ)) {
+                    const double dist = MathFunctions::distanceSquared2D(windowXYZ[0],
+                                                                         windowXYZ[1],
+                                                                         this->mouseX,
+                                                                         this->mouseY);
+                    if (dist < nearestDistance) {
+                        nearestDistance = dist;
+                        nodeIndex = triangleNodes[iNode];
+                    }
+                }
+            }
+            depth = rayCaster.getWindowDepth(hitXYZ);
+        }
         if (nodeIndex >= 0) {
             if (nodeID->isOtherScreenDepthCloserToViewer(depth)) {
                 nodeID->setBrain(surface->getBrainStructure()->getBrain());
@@ -3731,7 +3738,6 @@ BrainOpenGLFixedPipeline::drawVolumeVoxelsAsCubesWholeBrain(std::vector<VolumeDr
         case MODE_IDENTIFICATION:
             if (voxelID->isEnabledForSelection()) {
                 isSelect = true;
-                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
             }
             else {
                 return;
@@ -3773,8 +3779,17 @@ BrainOpenGLFixedPipeline::drawVolumeVoxelsAsCubesWholeBrain(std::vector<VolumeDr
      */
     const int32_t idPerVoxelCount = 5;
     std::vector<int32_t> identificationIndices;
+    
+    /*
+     * Voxels are identified by casting a ray through the
+     * cubes instead of drawing them in identification colors
+     */
+    CaretPointer<SelectionRayCaster> rayCaster;
+    int32_t nearestVoxelIndex = -1;
+    float nearestVoxelDistance = std::numeric_limits<float>::max();
     if (isSelect) {
         identificationIndices.reserve(10000 * idPerVoxelCount);
+        rayCaster.grabNew(new SelectionRayCaster(createSelectionRayCaster()));
     }
     
     PaletteFile* paletteFile = m_brain->getPaletteFile();
@@ -3855,18 +3870,6 @@ BrainOpenGLFixedPipeline::drawVolumeVoxelsAsCubesWholeBrain(std::vector<VolumeDr
                             rgba[3] *= volInfo.opacity;
                         }
                         if (rgba[3] > 0) {
-                            if (isSelect) {
-                                const int32_t idIndex = identificationIndices.size() / idPerVoxelCount;
-                                this->colorIdentification->addItem(rgba,
-                                                                   SelectionItemDataTypeEnum::VOXEL,
-                                                                   idIndex);
-                                identificationIndices.push_back(iVol);
-                                identificationIndices.push_back(volInfo.mapIndex);
-                                identificationIndices.push_back(iVoxel);
-                                identificationIndices.push_back(jVoxel);
-                                identificationIndices.push_back(kVoxel);
-                            }
-                            
                             float x = 0, y = 0.0, z = 0.0;
                             volumeFile->indexToSpace(iVoxel, jVoxel, kVoxel, x, y, z);
                             
@@ -3879,6 +3882,27 @@ BrainOpenGLFixedPipeline::drawVolumeVoxelsAsCubesWholeBrain(std::vector<VolumeDr
                                 }
                             }
                             
+                            if (drawIt
+                                && isSelect) {
+                                const float xyz[3] = { x, y, z };
+                                const float cubeSize[3] = { cubeSizeDX, cubeSizeDY, cubeSizeDZ };
+                                float distance = 0.0;
+                                if (rayCaster->getBoxIntersection(xyz,
+                                                                  cubeSize,
+                                                                  distance)) {
+                                    if (distance < nearestVoxelDistance) {
+                                        nearestVoxelDistance = distance;
+                                        nearestVoxelIndex = identificationIndices.size() / idPerVoxelCount;
+                                        identificationIndices.push_back(iVol);
+                                        identificationIndices.push_back(volInfo.mapIndex);
+                                        identificationIndices.push_back(iVoxel);
+                                        identificationIndices.push_back(jVoxel);
+                                        identificationIndices.push_back(kVoxel);
+                                    }
+                                }
+                                drawIt = false;
+                            }
+                            
                             if (drawIt) {
                                 glPushMatrix();
                                 glTranslatef(x, y, z);
@@ -3902,14 +3926,19 @@ BrainOpenGLFixedPipeline::drawVolumeVoxelsAsCubesWholeBrain(std::vector<VolumeDr
     }
     
     if (isSelect) {
-        int32_t identifiedItemIndex;
+        const int32_t identifiedItemIndex = nearestVoxelIndex;
         float depth = -1.0;
-        this->getIndexFromColorSelection(SelectionItemDataTypeEnum::VOXEL,
-                                         this->mouseX,
-                                         this->mouseY,
-                                         identifiedItemIndex,
-                                         depth);
         if (identifiedItemIndex >= 0) {
+            float rayOrigin[3], rayDirection[3];
+            rayCaster->getRay(rayOrigin,
+                              rayDirection);
+            const float hitXYZ[3] = {
+                rayOrigin[0] + nearestVoxelDistance * rayDirection[0],
+                rayOrigin[1] + nearestVoxelDistance * rayDirection[1],
+                rayOrigin[2] + nearestVoxelDistance * rayDirection[2]
+            };
+            depth = rayCaster->getWindowDepth(hitXYZ);
+
             const int32_t idIndex = identifiedItemIndex * idPerVoxelCount;
             const int32_t volDrawInfoIndex = identificationIndices[idIndex];
             CaretAssertVectorIndex(volumeDrawInfo, volDrawInfoIndex);
@@ -4118,8 +4147,8 @@ BrainOpenGLFixedPipeline::addFiberOrientationForDrawing(const FiberOrientationDi
  * For comparison when sorting that results in furthest fibers drawn first.
  */
 static bool
-fiberDepthCompare(FiberOrientation* &f1,
-                              FiberOrientation* &f2)
+fiberDepthCompare(const FiberOrientation* f1,
+                  const FiberOrientation* f2)
 {
     return (f1->m_drawingDepth > f2->m_drawingDepth);
 }
@@ -4157,7 +4186,7 @@ BrainOpenGLFixedPipeline::sortFiberOrientationsByDepth()
     const float m2 = modelToScreenMatrix.getMatrixElement(2, 2);
     const float m3 = modelToScreenMatrix.getMatrixElement(2, 3);
     
-    for (std::list<FiberOrientation*>::const_iterator iter = m_fiberOrientationsForDrawing.begin();
+    for (std::vector<FiberOrientation*>::const_iterator iter = m_fiberOrientationsForDrawing.begin();
          iter != m_fiberOrientationsForDrawing.end();
          iter++) {
         const FiberOrientation* fiberOrientation = *iter;
@@ -4172,7 +4201,12 @@ BrainOpenGLFixedPipeline::sortFiberOrientationsByDepth()
         
     }
     
-    m_fiberOrientationsForDrawing.sort(fiberDepthCompare);
+    /*
+     * Stable sort keeps the same order for equal depths as the list sort that was used before
+     */
+    std::stable_sort(m_fiberOrientationsForDrawing.begin(),
+                     m_fiberOrientationsForDrawing.end(),
+                     fiberDepthCompare);
 }
 
 /**
@@ -4189,7 +4223,21 @@ BrainOpenGLFixedPipeline::drawAllFiberOrientations(const FiberOrientationDisplay
         sortFiberOrientationsByDepth();
     }
     
-    for (std::list<FiberOrientation*>::const_iterator iter = m_fiberOrientationsForDrawing.begin();
+    /*
+     * All lines go into one primitive, in the sorted order, so that they are
+     * drawn with one call instead of a glBegin/glEnd for each fiber
+     */
+    std::unique_ptr<GraphicsPrimitiveV3fC4f> linesPrimitive;
+    switch (fodi->symbolType) {
+        case FiberOrientationSymbolTypeEnum::FIBER_SYMBOL_FANS:
+            break;
+        case FiberOrientationSymbolTypeEnum::FIBER_SYMBOL_LINES:
+            linesPrimitive.reset(GraphicsPrimitive::newPrimitiveV3fC4f(GraphicsPrimitive::PrimitiveType::OPENGL_LINES));
+            linesPrimitive->reserveForNumberOfVertices(m_fiberOrientationsForDrawing.size() * 2 * 3);
+            break;
+    }
+    
+    for (std::vector<FiberOrientation*>::const_iterator iter = m_fiberOrientationsForDrawing.begin();
          iter != m_fiberOrientationsForDrawing.end();
          iter++) {
         const FiberOrientation* fiberOrientation = *iter;
@@ -4306,30 +4354,18 @@ BrainOpenGLFixedPipeline::drawAllFiberOrientations(const FiberOrientationDisplay
                                 const int32_t indx = j % 3;
                                 switch (indx) {
                                     case 0: /* use RED */
-                                        glColor4f(BrainOpenGLFixedPipeline::COLOR_RED[0],
-                                                  BrainOpenGLFixedPipeline::COLOR_RED[1],
-                                                  BrainOpenGLFixedPipeline::COLOR_RED[2],
-                                                  alpha);
                                         fiberRGBA[0] = BrainOpenGLFixedPipeline::COLOR_RED[0];
                                         fiberRGBA[1] = BrainOpenGLFixedPipeline::COLOR_RED[1];
                                         fiberRGBA[2] = BrainOpenGLFixedPipeline::COLOR_RED[2];
                                         fiberRGBA[3] = alpha;
                                         break;
                                     case 1: /* use BLUE */
-                                        glColor4f(BrainOpenGLFixedPipeline::COLOR_BLUE[0],
-                                                  BrainOpenGLFixedPipeline::COLOR_BLUE[1],
-                                                  BrainOpenGLFixedPipeline::COLOR_BLUE[2],
-                                                  alpha);
                                         fiberRGBA[0] = BrainOpenGLFixedPipeline::COLOR_BLUE[0];
                                         fiberRGBA[1] = BrainOpenGLFixedPipeline::COLOR_BLUE[1];
                                         fiberRGBA[2] = BrainOpenGLFixedPipeline::COLOR_BLUE[2];
                                         fiberRGBA[3] = alpha;
                                         break;
                                     case 2: /* use GREEN */
-                                        glColor4f(BrainOpenGLFixedPipeline::COLOR_GREEN[0],
-                                                  BrainOpenGLFixedPipeline::COLOR_GREEN[1],
-                                                  BrainOpenGLFixedPipeline::COLOR_GREEN[2],
-                                                  alpha);
                                         fiberRGBA[0] = BrainOpenGLFixedPipeline::COLOR_GREEN[0];
                                         fiberRGBA[1] = BrainOpenGLFixedPipeline::COLOR_GREEN[1];
                                         fiberRGBA[2] = BrainOpenGLFixedPipeline::COLOR_GREEN[2];
@@ -4343,10 +4379,6 @@ BrainOpenGLFixedPipeline::drawAllFiberOrientations(const FiberOrientationDisplay
                                 CaretAssert((fiber->m_directionUnitVectorRGB[1] >= 0.0) && (fiber->m_directionUnitVectorRGB[1] <= 1.0));
                                 CaretAssert((fiber->m_directionUnitVectorRGB[2] >= 0.0) && (fiber->m_directionUnitVectorRGB[2] <= 1.0));
                                 CaretAssert((alpha >= 0.0) && (alpha <= 1.0));
-                                glColor4f(fiber->m_directionUnitVectorRGB[0],
-                                          fiber->m_directionUnitVectorRGB[1],
-                                          fiber->m_directionUnitVectorRGB[2],
-                                          alpha);
                                 fiberRGBA[0] = fiber->m_directionUnitVectorRGB[0];
                                 fiberRGBA[1] = fiber->m_directionUnitVectorRGB[1];
                                 fiberRGBA[2] = fiber->m_directionUnitVectorRGB[2];
@@ -4358,10 +4390,6 @@ BrainOpenGLFixedPipeline::drawAllFiberOrientations(const FiberOrientationDisplay
                     {
                         const CaretColorEnum::Enum caretColor = fodi->colorSource->getCaretColor();
                         const float* rgb = CaretColorEnum::toRGB(caretColor);
-                        glColor4f(rgb[0],
-                                  rgb[1],
-                                  rgb[2],
-                                  alpha);
                         fiberRGBA[0] = rgb[0];
                         fiberRGBA[1] = rgb[1];
                         fiberRGBA[2] = rgb[2];
@@ -4421,12 +4449,8 @@ BrainOpenGLFixedPipeline::drawAllFiberOrientations(const FiberOrientationDisplay
                         break;
                     case FiberOrientationSymbolTypeEnum::FIBER_SYMBOL_LINES:
                     {
-                        const float radius = 2.0;
-                        setLineWidth(radius);
-                        glBegin(GL_LINES);
-                        glVertex3fv(startXYZ);
-                        glVertex3fv(endXYZ);
-                        glEnd();
+                        linesPrimitive->addVertex(startXYZ, fiberRGBA);
+                        linesPrimitive->addVertex(endXYZ, fiberRGBA);
                     }
                         break;
                 }
@@ -4434,8 +4458,18 @@ BrainOpenGLFixedPipeline::drawAllFiberOrientations(const FiberOrientationDisplay
         }
     }
     
+    if (linesPrimitive) {
+        if (linesPrimitive->isValid()) {
+            const float lineWidth = 2.0;
+            linesPrimitive->setLineWidth(GraphicsPrimitive::LineWidthType::PIXELS,
+                                         lineWidth);
+            GraphicsEngineDataOpenGL::draw(linesPrimitive.get());
+        }
+    }
+    
     /*
-     * Now clear the list of fiber orientations for drawing.
+     * Now clear the list of fiber orientations for drawing, keeping its
+     * memory for the next time fibers are drawn.
      */
     m_fiberOrientationsForDrawing.clear();
 }
@@ -6043,6 +6077,82 @@ BrainOpenGLFixedPipeline::setSelectedItemScreenXYZ(SelectionItem* item,
     }
 }
 
+/**
+ * @return A ray caster for identification at the mouse position
+ * using the current modelview and projection matrices and viewport.
+ */
+SelectionRayCaster
+BrainOpenGLFixedPipeline::createSelectionRayCaster() const
+{
+    GLdouble selectionModelviewMatrix[16];
+    glGetDoublev(GL_MODELVIEW_MATRIX, selectionModelviewMatrix);
+    
+    GLdouble selectionProjectionMatrix[16];
+    glGetDoublev(GL_PROJECTION_MATRIX, selectionProjectionMatrix);
+    
+    GLint selectionViewport[4];
+    glGetIntegerv(GL_VIEWPORT, selectionViewport);
+    const int32_t viewport[4] = {
+        selectionViewport[0],
+        selectionViewport[1],
+        selectionViewport[2],
+        selectionViewport[3]
+    };
+    
+    return SelectionRayCaster(selectionModelviewMatrix,
+                              selectionProjectionMatrix,
+                              viewport,
+                              this->mouseX,
+                              this->mouseY);
+}
+
+/**
+ * Find the surface triangle nearest the viewer that is under the mouse
+ * and is not removed by the surface clipping planes.
+ *
+ * @param rayCaster
+ *    Ray caster for the mouse position.
+ * @param surface
+ *    The surface.
+ * @param triangleIndexOut
+ *    Output with index of triangle that was hit.
+ * @param hitXYZOut
+ *    Output with coordinate where the triangle was hit.
+ * @return True if a triangle was hit.
+ */
+bool
+BrainOpenGLFixedPipeline::getSurfaceRayHit(const SelectionRayCaster& rayCaster,
+                                           const Surface* surface,
+                                           int32_t& triangleIndexOut,
+                                           float hitXYZOut[3])
+{
+    triangleIndexOut = -1;
+    
+    std::vector<SurfaceTriangleBVH::Hit> hits;
+    rayCaster.getSurfaceIntersections(surface,
+                                      hits);
+    
+    const bool doClipping = ((m_clippingPlaneGroup != NULL)
+                             && m_clippingPlaneGroup->isSurfaceSelected());
+    for (std::vector<SurfaceTriangleBVH::Hit>::const_iterator iter = hits.begin();
+         iter != hits.end();
+         iter++) {
+        if (doClipping) {
+            if ( ! isCoordinateInsideClippingPlanesForStructure(surface->getStructure(),
+                                                                iter->m_xyz)) {
+                continue;
+            }
+        }
+        triangleIndexOut = iter->m_triangle;
+        hitXYZOut[0] = iter->m_xyz[0];
+        hitXYZOut[1] = iter->m_xyz[1];
+        hitXYZOut[2] = iter->m_xyz[2];
+        return true;
+    }
+    
+    return false;
+}
+
 /**
  * Draw sphere.
  *
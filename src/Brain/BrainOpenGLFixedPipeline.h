@@ -75,6 +75,7 @@ namespace caret {
     class Palette;
     class PaletteColorMapping;
     class PaletteFile;
+    class SelectionRayCaster;
     class SurfaceFile;
     class SurfaceMontageConfigurationCerebellar;
     class SurfaceMontageConfigurationCerebral;
@@ -368,6 +369,13 @@ namespace caret {
         
         void setSelectedItemScreenXYZ(SelectionItem* item,
                                         const float itemXYZ[3]);
+        
+        SelectionRayCaster createSelectionRayCaster() const;
+        
+        bool getSurfaceRayHit(const SelectionRayCaster& rayCaster,
+                              const Surface* surface,
+                              int32_t& triangleIndexOut,
+                              float hitXYZOut[3]);
 
         void setViewportAndOrthographicProjection(const int32_t viewport[4],
                                                   const  ProjectionViewTypeEnum::Enum projectionType);
@@ -581,7 +589,7 @@ namespace caret {
         /** Cylinder symbol */
         BrainOpenGLShapeCylinder* m_shapeCylinder;
         
-        std::list<FiberOrientation*> m_fiberOrientationsForDrawing;
+        std::vector<FiberOrientation*> m_fiberOrientationsForDrawing;
         
         double inverseRotationMatrix[16];
         bool inverseRotationMatrixValid;
@@ -0,0 +1,368 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "SelectionRayCaster.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "CaretAssert.h"
+#include "SurfaceFile.h"
+
+using namespace caret;
+
+namespace {
+    /*
+     * Multiply OpenGL (column major) matrices, result = left * right
+     */
+    void multiplyMatrices(const double left[16],
+                          const double right[16],
+                          double result[16])
+    {
+        for (int col = 0; col < 4; col++) {
+            for (int row = 0; row < 4; row++) {
+                double sum = 0.0;
+                for (int k = 0; k < 4; k++) {
+                    sum += left[k * 4 + row] * right[col * 4 + k];
+                }
+                result[col * 4 + row] = sum;
+            }
+        }
+    }
+    
+    /*
+     * Invert a 4x4 matrix with Gauss-Jordan elimination and partial pivoting.
+     * Layout does not matter since inverse of transpose is transpose of inverse.
+     */
+    bool invertMatrix(const double matrix[16],
+                      double inverseOut[16])
+    {
+        double work[4][8];
+        for (int row = 0; row < 4; row++) {
+            for (int col = 0; col < 4; col++) {
+                work[row][col] = matrix[row * 4 + col];
+                work[row][col + 4] = ((row == col) ? 1.0 : 0.0);
+            }
+        }
+        for (int col = 0; col < 4; col++) {
+            int pivot = col;
+            for (int row = col + 1; row < 4; row++) {
+                if (std::fabs(work[row][col]) > std::fabs(work[pivot][col])) {
+                    pivot = row;
+                }
+            }
+            if (work[pivot][col] == 0.0) {
+                return false;
+            }
+            if (pivot != col) {
+                for (int k = 0; k < 8; k++) {
+                    std::swap(work[pivot][k], work[col][k]);
+                }
+            }
+            const double scale = 1.0 / work[col][col];
+            for (int k = 0; k < 8; k++) {
+                work[col][k] *= scale;
+            }
+            for (int row = 0; row < 4; row++) {
+                if (row != col) {
+                    const double factor = work[row][col];
+                    if (factor != 0.0) {
+                        for (int k = 0; k < 8; k++) {
+                            work[row][k] -= factor * work[col][k];
+                        }
+                    }
+                }
+            }
+        }
+        for (int row = 0; row < 4; row++) {
+            for (int col = 0; col < 4; col++) {
+                inverseOut[row * 4 + col] = work[row][col + 4];
+            }
+        }
+        return true;
+    }
+    
+    /*
+     * Transform a point by an OpenGL matrix with perspective division
+     */
+    bool transformPoint(const double matrix[16],
+                        const double xyz[3],
+                        double xyzOut[3])
+    {
+        double result[4];
+        for (int row = 0; row < 4; row++) {
+            result[row] = (matrix[row] * xyz[0]
+                           + matrix[4 + row] * xyz[1]
+                           + matrix[8 + row] * xyz[2]
+                           + matrix[12 + row]);
+        }
+        if (result[3] == 0.0) {
+            return false;
+        }
+        for (int i = 0; i < 3; i++) {
+            xyzOut[i] = result[i] / result[3];
+        }
+        return true;
+    }
+}
+    
+/**
+ * \class caret::SelectionRayCaster
+ * \brief Identifies items by casting a ray from a window position into the model.
+ * \ingroup Brain
+ *
+ * The ray starts at the window position on the near clipping plane and
+ * ends on the far clipping plane, in the coordinates of the model as
+ * transformed by the given modelview and projection matrices.  Since the
+ * items are intersected on the CPU, nothing needs to be drawn or read
+ * from the frame buffer, and the results are the same whether or not
+ * an OpenGL context is available.  Window depths are computed the
+ * same way as OpenGL so that they may be compared to depths read
+ * from the depth buffer.
+ */
+
+/**
+ * Constructor.
+ *
+ * @param modelviewMatrix
+ *    The modelview matrix, in OpenGL layout.
+ * @param projectionMatrix
+ *    The projection matrix, in OpenGL layout.
+ * @param viewport
+ *    The viewport (x, y, width, height).
+ * @param windowX
+ *    Window X-coordinate of the ray.
+ * @param windowY
+ *    Window Y-coordinate of the ray.
+ */
+SelectionRayCaster::SelectionRayCaster(const double modelviewMatrix[16],
+                                       const double projectionMatrix[16],
+                                       const int32_t viewport[4],
+                                       const double windowX,
+                                       const double windowY)
+{
+    multiplyMatrices(projectionMatrix,
+                     modelviewMatrix,
+                     m_modelviewProjection);
+    for (int i = 0; i < 4; i++) {
+        m_viewport[i] = viewport[i];
+    }
+    m_valid = false;
+    for (int i = 0; i < 3; i++) {
+        m_origin[i] = 0.0;
+        m_direction[i] = 0.0;
+    }
+    
+    double inverseMatrix[16];
+    if ( ! invertMatrix(m_modelviewProjection,
+                        inverseMatrix)) {
+        return;
+    }
+    if ((m_viewport[2] <= 0)
+        || (m_viewport[3] <= 0)) {
+        return;
+    }
+    
+    /*
+     * Normalized device coordinates of window position
+     * on near (-1) and far (1) clipping planes
+     */
+    const double ndcX = ((windowX - m_viewport[0]) / m_viewport[2]) * 2.0 - 1.0;
+    const double ndcY = ((windowY - m_viewport[1]) / m_viewport[3]) * 2.0 - 1.0;
+    const double ndcNear[3] = { ndcX, ndcY, -1.0 };
+    const double ndcFar[3]  = { ndcX, ndcY,  1.0 };
+    double nearXYZ[3], farXYZ[3];
+    if (transformPoint(inverseMatrix, ndcNear, nearXYZ)
+        && transformPoint(inverseMatrix, ndcFar, farXYZ)) {
+        for (int i = 0; i < 3; i++) {
+            m_origin[i] = nearXYZ[i];
+            m_direction[i] = farXYZ[i] - nearXYZ[i];
+        }
+        m_valid = true;
+    }
+}
+
+/**
+ * @return True if the ray is valid.  The ray is invalid
+ * if the transformation cannot be inverted.
+ */
+bool
+SelectionRayCaster::isValid() const
+{
+    return m_valid;
+}
+
+/**
+ * Get the ray.  Points on the ray between the near and far
+ * clipping planes are origin + t * direction, for t in [0, 1].
+ *
+ * @param originOut
+ *    Output with origin of ray, on the near clipping plane.
+ * @param directionOut
+ *    Output with direction of ray, length is distance to the far clipping plane.
+ */
+void
+SelectionRayCaster::getRay(float originOut[3],
+                           float directionOut[3]) const
+{
+    for (int i = 0; i < 3; i++) {
+        originOut[i] = m_origin[i];
+        directionOut[i] = m_direction[i];
+    }
+}
+
+/**
+ * Transform a model coordinate to a window coordinate.
+ *
+ * @param xyz
+ *    The model coordinate.
+ * @param windowXYZOut
+ *    Output with window coordinates, Z is depth in [0, 1].
+ * @return True if transformation was successful.
+ */
+bool
+SelectionRayCaster::transformToWindow(const double xyz[3],
+                                      double windowXYZOut[3]) const
+{
+    double ndc[3];
+    if ( ! transformPoint(m_modelviewProjection,
+                          xyz,
+                          ndc)) {
+        return false;
+    }
+    windowXYZOut[0] = m_viewport[0] + (ndc[0] + 1.0) * 0.5 * m_viewport[2];
+    windowXYZOut[1] = m_viewport[1] + (ndc[1] + 1.0) * 0.5 * m_viewport[3];
+    windowXYZOut[2] = (ndc[2] + 1.0) * 0.5;
+    return true;
+}
+
+/**
+ * Get the window coordinate of a model coordinate (like gluProject()).
+ *
+ * @param xyz
+ *    The model coordinate.
+ * @param windowXYZOut
+ *    Output with window coordinates, Z is depth in [0, 1].
+ * @return True if transformation was successful.
+ */
+bool
+SelectionRayCaster::getWindowXYZ(const double xyz[3],
+                                 double windowXYZOut[3]) const
+{
+    return transformToWindow(xyz,
+                             windowXYZOut);
+}
+
+/**
+ * Get the window depth of a model coordinate, as it would be
+ * in the depth buffer.
+ *
+ * @param xyz
+ *    The model coordinate.
+ * @return Depth in [0, 1], or 1.0 (farthest) if the transformation fails.
+ */
+float
+SelectionRayCaster::getWindowDepth(const float xyz[3]) const
+{
+    const double dxyz[3] = { xyz[0], xyz[1], xyz[2] };
+    double windowXYZ[3];
+    if (transformToWindow(dxyz,
+                          windowXYZ)) {
+        return windowXYZ[2];
+    }
+    return 1.0;
+}
+
+/**
+ * Find the triangles of a surface hit by the ray.
+ *
+ * @param surfaceFile
+ *    The surface.
+ * @param hitsOut
+ *    Output with triangles hit by the ray between the near and far
+ *    clipping planes, sorted from nearest to farthest.
+ */
+void
+SelectionRayCaster::getSurfaceIntersections(const SurfaceFile* surfaceFile,
+                                            std::vector<SurfaceTriangleBVH::Hit>& hitsOut) const
+{
+    CaretAssert(surfaceFile);
+    hitsOut.clear();
+    if ( ! m_valid) {
+        return;
+    }
+    
+    surfaceFile->getTriangleBVH()->getRayIntersections(m_origin,
+                                                       m_direction,
+                                                       1.0,
+                                                       hitsOut);
+}
+
+/**
+ * Find where the ray enters an axis-aligned box, such as a voxel.
+ *
+ * @param centerXYZ
+ *    Center of the box.
+ * @param sizeXYZ
+ *    Size of the box along each axis.
+ * @param distanceOut
+ *    Output with distance along the ray, in [0, 1] between the
+ *    near and far clipping planes.
+ * @return True if the ray hits the box.
+ */
+bool
+SelectionRayCaster::getBoxIntersection(const float centerXYZ[3],
+                                       const float sizeXYZ[3],
+                                       float& distanceOut) const
+{
+    if ( ! m_valid) {
+        return false;
+    }
+    
+    float tMin = 0.0;
+    float tMax = 1.0;
+    for (int i = 0; i < 3; i++) {
+        const float halfSize = std::fabs(sizeXYZ[i]) * 0.5;
+        const float boxMin = centerXYZ[i] - halfSize;
+        const float boxMax = centerXYZ[i] + halfSize;
+        if (m_direction[i] == 0.0) {
+            if ((m_origin[i] < boxMin)
+                || (m_origin[i] > boxMax)) {
+                return false;
+            }
+        }
+        else {
+            float t1 = (boxMin - m_origin[i]) / m_direction[i];
+            float t2 = (boxMax - m_origin[i]) / m_direction[i];
+            if (t1 > t2) {
+                std::swap(t1, t2);
+            }
+            tMin = std::max(tMin, t1);
+            tMax = std::min(tMax, t2);
+            if (tMin > tMax) {
+                return false;
+            }
+        }
+    }
+    
+    distanceOut = tMin;
+    return true;
+}
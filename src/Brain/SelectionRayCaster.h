@@ -0,0 +1,75 @@
+#ifndef __SELECTION_RAY_CASTER_H__
+#define __SELECTION_RAY_CASTER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <vector>
+
+#include "SurfaceTriangleBVH.h"
+
+namespace caret {
+
+    class SurfaceFile;
+    
+    class SelectionRayCaster {
+        
+    public:
+        SelectionRayCaster(const double modelviewMatrix[16],
+                           const double projectionMatrix[16],
+                           const int32_t viewport[4],
+                           const double windowX,
+                           const double windowY);
+        
+        bool isValid() const;
+        
+        void getRay(float originOut[3],
+                    float directionOut[3]) const;
+        
+        float getWindowDepth(const float xyz[3]) const;
+        
+        bool getWindowXYZ(const double xyz[3],
+                          double windowXYZOut[3]) const;
+        
+        void getSurfaceIntersections(const SurfaceFile* surfaceFile,
+                                     std::vector<SurfaceTriangleBVH::Hit>& hitsOut) const;
+        
+        bool getBoxIntersection(const float centerXYZ[3],
+                                const float sizeXYZ[3],
+                                float& distanceOut) const;
+        
+    private:
+        bool transformToWindow(const double xyz[3],
+                               double windowXYZOut[3]) const;
+        
+        double m_modelviewProjection[16];
+        
+        int32_t m_viewport[4];
+        
+        float m_origin[3];
+        
+        float m_direction[3];
+        
+        bool m_valid;
+    };
+    
+} // namespace
+
+#endif  //__SELECTION_RAY_CASTER_H__
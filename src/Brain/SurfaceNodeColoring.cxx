@@ -46,6 +46,7 @@
 #include "EventModelSurfaceGet.h"
 #include "GiftiLabel.h"
 #include "GiftiLabelTable.h"
+#include "GiftiLabelTableLookup.h"
 #include "GroupAndNameHierarchyGroup.h"
 #include "LabelFile.h"
 #include "LabelDrawingProperties.h"
@@ -692,6 +693,13 @@ SurfaceNodeColoring::assignLabelTableColors(const GiftiLabelTable* labelTable,
     CaretColorEnum::toRGBAFloat(outlineColor, outlineRGBA);
     outlineRGBA[3] = 1.0;
     
+    const CaretPointer<const GiftiLabelTableLookup> labelLookup = labelTable->getLookup();
+    std::vector<char> labelDisplayed;
+    NodeAndVoxelColoring::getLabelDisplayedStatus(labelLookup,
+                                                  displayGroup,
+                                                  browserTabIndex,
+                                                  labelDisplayed);
+    
     /*
      * Assign colors from labels to nodes
      */
@@ -699,23 +707,24 @@ SurfaceNodeColoring::assignLabelTableColors(const GiftiLabelTable* labelTable,
     for (int32_t i = 0; i < numberOfIndices; i++) {
         CaretAssertVectorIndex(labelIndices, i);
         const int32_t labelKey= static_cast<int32_t>(labelIndices[i]);
-        const GiftiLabel* label = labelTable->getLabel(labelKey);
-        if (label == NULL) {
+        const int32_t labelIndex = labelLookup->find(labelKey);
+        if (labelIndex < 0) {
             continue;
         }
         
-        const GroupAndNameHierarchyItem* nameItem = label->getGroupNameSelectionItem();
-        if (nameItem != NULL) {
-            if (nameItem->isSelected(displayGroup,
-                                     browserTabIndex) == false) {
-                continue;
-            }
+        if ( ! labelDisplayed[labelIndex]) {
+            continue;
         }
+        const GiftiLabel* label = labelLookup->getLabel(labelIndex);
         
         /*
          * Initialize node color to its label's color
          */
-        label->getColor(nodeRGBA);
+        const float* labelRGBA = labelLookup->getColor(labelIndex);
+        nodeRGBA[0] = labelRGBA[0];
+        nodeRGBA[1] = labelRGBA[1];
+        nodeRGBA[2] = labelRGBA[2];
+        nodeRGBA[3] = labelRGBA[3];
         if (nodeRGBA[3] <= 0.0) {
             continue;
         }
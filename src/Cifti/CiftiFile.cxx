@@ -28,11 +28,16 @@
 #include "FileInformation.h"
 #include "MultiDimArray.h"
 #include "MultiDimIterator.h"
+#include "NiftiHalfFloat.h"
 #include "NiftiIO.h"
 
+#include <algorithm>
+
 using namespace std;
 using namespace caret;
 
+bool CiftiFile::s_compressedWriting = false;
+
 //private implementation classes
 namespace
 {
@@ -43,7 +48,7 @@ namespace
     public:
         CiftiOnDiskImpl(const QString& filename);//read-only
         CiftiOnDiskImpl(const QString& filename, const CiftiXML& xml, const CiftiVersion& version, const bool& swapEndian,
-                        const int16_t& datatype, const bool& rescale, const double& minval, const double& maxval);//make new empty file with read/write
+                        const int16_t& datatype, const bool& rescale, const double& minval, const double& maxval, const bool& compress);//make new empty file with read/write
         void getRow(float* dataOut, const std::vector<int64_t>& indexSelect, const bool& tolerateShortRead) const;
         void getColumn(float* dataOut, const int64_t& index) const;
         const CiftiXML& getCiftiXML() const { return m_xml; }
@@ -190,7 +195,7 @@ void CiftiFile::writeFile(const QString& fileName, const CiftiVersion& writingVe
         m_writingImpl.grabNew(NULL);//and make it re-magic the writing implementation again if data is set
     }
     CaretPointer<WriteImplInterface> tempWrite(new CiftiOnDiskImpl(myInfo.getAbsoluteFilePath(), m_xml, writingVersion, writeSwapped,
-                                                                   m_writingDataType, m_doWriteScaling, m_minScalingVal, m_maxScalingVal));
+                                                                   m_writingDataType, m_doWriteScaling, m_minScalingVal, m_maxScalingVal, s_compressedWriting));
     copyImplData(m_readingImpl, tempWrite, m_dims);
     if (collision)//if we rewrote the file, we need the handle to the new file, and to dump the temporary in-memory version
     {
@@ -386,7 +391,7 @@ void CiftiFile::verifyWriteImpl()
             }
         }
         m_writingImpl.grabNew(new CiftiOnDiskImpl(m_writingFile, m_xml, m_onDiskVersion, shouldSwap(m_endianPref),
-                                                  m_writingDataType, m_doWriteScaling, m_minScalingVal, m_maxScalingVal));//this constructor makes new file for writing
+                                                  m_writingDataType, m_doWriteScaling, m_minScalingVal, m_maxScalingVal, s_compressedWriting));//this constructor makes new file for writing
         if (m_readingImpl != NULL)
         {
             copyImplData(m_readingImpl, m_writingImpl, m_dims);
@@ -605,12 +610,26 @@ namespace
 }
 
 CiftiOnDiskImpl::CiftiOnDiskImpl(const QString& filename, const CiftiXML& xml, const CiftiVersion& version, const bool& swapEndian,
-                                 const int16_t& datatype, const bool& rescale, const double& minval, const double& maxval)
+                                 const int16_t& datatype, const bool& rescale, const double& minval, const double& maxval, const bool& compress)
 {//starts writing new file
     warnForBadExtension(filename, xml);
     NiftiHeader outHeader;
-    if (rescale)
+    NiftiHalfFloat::Format halfFormat = NiftiHalfFloat::fromDataType(datatype);
+    for (int i = 0; i < xml.getNumberOfDimensions() && halfFormat != NiftiHalfFloat::NONE; ++i)
     {
+        if (xml.getMappingType(i) == CiftiMappingType::LABELS)
+        {
+            CaretLogWarning("16-bit floats can't hold every label key, writing '" + filename + "' as FLOAT32");
+            halfFormat = NiftiHalfFloat::NONE;
+        }
+    }
+    if (halfFormat != NiftiHalfFloat::NONE)
+    {
+        if (rescale) throw DataFileException("scaling can't be used with 16-bit float cifti output");
+        NiftiHalfFloat::setHeaderFormat(outHeader, halfFormat);
+    } else if (NiftiHalfFloat::fromDataType(datatype) != NiftiHalfFloat::NONE) {
+        outHeader.setDataType(NIFTI_TYPE_FLOAT32);
+    } else if (rescale) {
         outHeader.setDataTypeAndScaleRange(datatype, minval, maxval);
     } else {
         outHeader.setDataType(datatype);
@@ -635,6 +654,12 @@ CiftiOnDiskImpl::CiftiOnDiskImpl(const QString& filename, const CiftiXML& xml, c
     vector<int64_t> matrixDims = xml.getDimensions();
     vector<int64_t> niftiDims(4, 1);//the reserved space and time dims
     niftiDims.insert(niftiDims.end(), matrixDims.begin(), matrixDims.end());
+    int64_t blockElements = -1;
+    if (compress)
+    {//whole rows per block, so that a row read decompresses at most two blocks, about 1MB of float32 per block
+        const int64_t TARGET_BLOCK_ELEMENTS = 1 << 18;
+        blockElements = matrixDims[0] * max(int64_t(1), TARGET_BLOCK_ELEMENTS / max(int64_t(1), matrixDims[0]));
+    }
     if (version.hasReversedFirstDims())
     {
         vector<int64_t> headerDims = niftiDims;
@@ -643,11 +668,11 @@ CiftiOnDiskImpl::CiftiOnDiskImpl(const QString& filename, const CiftiXML& xml, c
         headerDims[4] = headerDims[5];
         headerDims[5] = temp;
         outHeader.setDimensions(headerDims);//give the header the reversed dimensions
-        m_nifti.writeNew(filename, outHeader, 2, true, swapEndian);
+        m_nifti.writeNew(filename, outHeader, 2, true, swapEndian, blockElements);
         m_nifti.overrideDimensions(niftiDims);//and then tell the nifti reader to use the correct dimensions
     } else {
         outHeader.setDimensions(niftiDims);
-        m_nifti.writeNew(filename, outHeader, 2, true, swapEndian);
+        m_nifti.writeNew(filename, outHeader, 2, true, swapEndian, blockElements);
     }
     m_xml = xml;
 }
@@ -79,6 +79,10 @@ namespace caret
         void setWritingDataTypeNoScaling(const int16_t& type = NIFTI_TYPE_FLOAT32);
         void setWritingDataTypeAndScaling(const int16_t& type, const double& minval, const double& maxval);
         
+        ///new on-disk files use the workbench-specific block compressed layout, which other software can't read
+        static void setCompressedWritingEnabled(const bool& enabled) { s_compressedWriting = enabled; }
+        static bool isCompressedWritingEnabled() { return s_compressedWriting; }
+        
         void getRow(float* dataOut, const int64_t& index, const bool& tolerateShortRead) const;//backwards compatibility for old CiftiFile/CiftiInterface
         void getRow(float* dataOut, const int64_t& index) const;
         int64_t getNumberOfRows() const;
@@ -114,6 +118,7 @@ namespace caret
         bool m_doWriteScaling;
         int16_t m_writingDataType;
         double m_minScalingVal, m_maxScalingVal;
+        static bool s_compressedWriting;
         
         void verifyWriteImpl();
         static void copyImplData(const ReadImplInterface* from, WriteImplInterface* to, const std::vector<int64_t>& dims);
@@ -142,6 +142,14 @@ int main(int argc, char* argv[]) {
          */
         VolumeFile::setVoxelColoringEnabled(false);
         
+        /*
+         * Commands mostly work on whole frames, which would each be
+         * converted and kept when using integer or on-disk storage, so read
+         * everything into memory as float
+         */
+        VolumeFile::setNativeStorageEnabled(false);
+        VolumeFile::setOnDiskEnabled(false);
+        
         QCoreApplication myApp(argc, argv);//so that it doesn't need to link against gui
         
         result = runCommand(argc, argv);
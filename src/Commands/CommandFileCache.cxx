@@ -0,0 +1,310 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CommandFileCache.h"
+
+#include "BorderFile.h"
+#include "CaretLogger.h"
+#include "CiftiFile.h"
+#include "CommandException.h"
+#include "FileInformation.h"
+#include "FociFile.h"
+#include "GiftiLabelTable.h"
+#include "GiftiMetaData.h"
+#include "LabelFile.h"
+#include "MetricFile.h"
+#include "PaletteColorMapping.h"
+#include "SurfaceFile.h"
+#include "VolumeFile.h"
+
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    template <typename T>
+    CaretPointer<T> copyWithConstructor(const CaretPointer<T>& file)
+    {
+        return CaretPointer<T>(new T(*file));
+    }
+}
+
+CaretPointer<BorderFile> CommandFileCache::copyFile(const CaretPointer<BorderFile>& file)
+{
+    return copyWithConstructor(file);
+}
+
+CaretPointer<CiftiFile> CommandFileCache::copyFile(const CaretPointer<CiftiFile>& file)
+{
+    CaretPointer<CiftiFile> ret(new CiftiFile());//in memory
+    ret->setCiftiXML(file->getCiftiXML(), false);
+    vector<float> scratchRow(file->getDimensions()[0]);
+    for (MultiDimIterator<int64_t> iter = file->getIteratorOverRows(); !iter.atEnd(); ++iter)
+    {
+        file->getRow(scratchRow.data(), *iter);
+        ret->setRow(scratchRow.data(), *iter);
+    }
+    return ret;
+}
+
+CaretPointer<FociFile> CommandFileCache::copyFile(const CaretPointer<FociFile>& file)
+{
+    return copyWithConstructor(file);
+}
+
+CaretPointer<LabelFile> CommandFileCache::copyFile(const CaretPointer<LabelFile>& file)
+{
+    return copyWithConstructor(file);
+}
+
+CaretPointer<MetricFile> CommandFileCache::copyFile(const CaretPointer<MetricFile>& file)
+{
+    return copyWithConstructor(file);
+}
+
+CaretPointer<SurfaceFile> CommandFileCache::copyFile(const CaretPointer<SurfaceFile>& file)
+{
+    return copyWithConstructor(file);
+}
+
+CaretPointer<VolumeFile> CommandFileCache::copyFile(const CaretPointer<VolumeFile>& file)
+{//VolumeFile has no copy constructor
+    CaretPointer<VolumeFile> ret(new VolumeFile());
+    ret->reinitialize(file->getOriginalDimensions(), file->getSform(), file->getNumberOfComponents(), file->getType());
+    vector<int64_t> dims;
+    file->getDimensions(dims);
+    for (int64_t b = 0; b < dims[3]; ++b)
+    {
+        for (int64_t c = 0; c < dims[4]; ++c)
+        {
+            ret->setFrame(file->getFrame(b, c), b, c);
+        }
+        ret->setMapName(b, file->getMapName(b));
+        if (file->isMappedWithLabelTable())
+        {
+            *(ret->getMapLabelTable(b)) = *(file->getMapLabelTable(b));
+        } else if (file->isMappedWithPalette()) {
+            *(ret->getMapPaletteColorMapping(b)) = *(file->getMapPaletteColorMapping(b));
+        }
+    }
+    *(ret->getFileMetaData()) = *(file->getFileMetaData());
+    return ret;
+}
+
+bool CommandFileCache::isMemoryName(const AString& name)
+{
+    return !name.isEmpty() && name[0] == '@';
+}
+
+AString CommandFileCache::getKey(const AString& name)
+{
+    if (isMemoryName(name)) return name;
+    return FileInformation(name).getAbsoluteFilePath();//works for files that don't exist yet, unlike canonical path
+}
+
+const CommandFileCache::Entry* CommandFileCache::findEntry(const AString& name, const OperationParametersEnum::Enum& type) const
+{
+    map<AString, Entry>::const_iterator iter = m_files.find(getKey(name));
+    if (iter == m_files.end()) return NULL;
+    if (iter->second.m_type != type)
+    {
+        throw CommandException("file '" + name + "' is used as type " + OperationParametersEnum::toName(type) +
+                               ", but was previously used as type " + OperationParametersEnum::toName(iter->second.m_type));
+    }
+    return &(iter->second);
+}
+
+CommandFileCache::Entry& CommandFileCache::newEntry(const AString& name, const OperationParametersEnum::Enum& type)
+{
+    Entry& ret = m_files[getKey(name)];
+    ret = Entry();//drop whatever was there before, of any type
+    ret.m_type = type;
+    ret.m_ciftiWasInMemory = false;
+    return ret;
+}
+
+bool CommandFileCache::needsCopy(const AString& name) const
+{//on-disk inputs are instead released by releaseModifiedFiles() if a command modifies them
+    if (!isMemoryName(name)) return false;
+    map<AString, int>::const_iterator iter = m_lastUse.find(getKey(name));
+    return iter != m_lastUse.end() && iter->second > m_currentCommand;
+}
+
+bool CommandFileCache::getFile(const AString& name, CaretPointer<BorderFile>& fileOut) const
+{
+    const Entry* myEntry = findEntry(name, OperationParametersEnum::BORDER);
+    if (myEntry == NULL) return false;
+    fileOut = (needsCopy(name) ? copyFile(myEntry->m_border) : myEntry->m_border);
+    return true;
+}
+
+bool CommandFileCache::getFile(const AString& name, CaretPointer<CiftiFile>& fileOut) const
+{
+    const Entry* myEntry = findEntry(name, OperationParametersEnum::CIFTI);
+    if (myEntry == NULL) return false;
+    fileOut = (needsCopy(name) ? copyFile(myEntry->m_cifti) : myEntry->m_cifti);
+    return true;
+}
+
+bool CommandFileCache::getFile(const AString& name, CaretPointer<FociFile>& fileOut) const
+{
+    const Entry* myEntry = findEntry(name, OperationParametersEnum::FOCI);
+    if (myEntry == NULL) return false;
+    fileOut = (needsCopy(name) ? copyFile(myEntry->m_foci) : myEntry->m_foci);
+    return true;
+}
+
+bool CommandFileCache::getFile(const AString& name, CaretPointer<LabelFile>& fileOut) const
+{
+    const Entry* myEntry = findEntry(name, OperationParametersEnum::LABEL);
+    if (myEntry == NULL) return false;
+    fileOut = (needsCopy(name) ? copyFile(myEntry->m_label) : myEntry->m_label);
+    return true;
+}
+
+bool CommandFileCache::getFile(const AString& name, CaretPointer<MetricFile>& fileOut) const
+{
+    const Entry* myEntry = findEntry(name, OperationParametersEnum::METRIC);
+    if (myEntry == NULL) return false;
+    fileOut = (needsCopy(name) ? copyFile(myEntry->m_metric) : myEntry->m_metric);
+    return true;
+}
+
+bool CommandFileCache::getFile(const AString& name, CaretPointer<SurfaceFile>& fileOut) const
+{
+    const Entry* myEntry = findEntry(name, OperationParametersEnum::SURFACE);
+    if (myEntry == NULL) return false;
+    fileOut = (needsCopy(name) ? copyFile(myEntry->m_surface) : myEntry->m_surface);
+    return true;
+}
+
+bool CommandFileCache::getFile(const AString& name, CaretPointer<VolumeFile>& fileOut) const
+{
+    const Entry* myEntry = findEntry(name, OperationParametersEnum::VOLUME);
+    if (myEntry == NULL) return false;
+    fileOut = (needsCopy(name) ? copyFile(myEntry->m_volume) : myEntry->m_volume);
+    return true;
+}
+
+void CommandFileCache::addFile(const AString& name, const CaretPointer<BorderFile>& file)
+{
+    newEntry(name, OperationParametersEnum::BORDER).m_border = file;
+    file->clearModified();//so releaseModifiedFiles() can tell whether a command changed it
+}
+
+void CommandFileCache::addFile(const AString& name, const CaretPointer<CiftiFile>& file)
+{
+    Entry& myEntry = newEntry(name, OperationParametersEnum::CIFTI);
+    myEntry.m_cifti = file;
+    myEntry.m_ciftiWasInMemory = file->isInMemory();
+}
+
+void CommandFileCache::addFile(const AString& name, const CaretPointer<FociFile>& file)
+{
+    newEntry(name, OperationParametersEnum::FOCI).m_foci = file;
+    file->clearModified();//so releaseModifiedFiles() can tell whether a command changed it
+}
+
+void CommandFileCache::addFile(const AString& name, const CaretPointer<LabelFile>& file)
+{
+    newEntry(name, OperationParametersEnum::LABEL).m_label = file;
+    file->clearModified();//so releaseModifiedFiles() can tell whether a command changed it
+}
+
+void CommandFileCache::addFile(const AString& name, const CaretPointer<MetricFile>& file)
+{
+    newEntry(name, OperationParametersEnum::METRIC).m_metric = file;
+    file->clearModified();//so releaseModifiedFiles() can tell whether a command changed it
+}
+
+void CommandFileCache::addFile(const AString& name, const CaretPointer<SurfaceFile>& file)
+{
+    newEntry(name, OperationParametersEnum::SURFACE).m_surface = file;
+    file->clearModified();//so releaseModifiedFiles() can tell whether a command changed it
+}
+
+void CommandFileCache::addFile(const AString& name, const CaretPointer<VolumeFile>& file)
+{
+    newEntry(name, OperationParametersEnum::VOLUME).m_volume = file;
+    file->clearModified();//so releaseModifiedFiles() can tell whether a command changed it
+}
+
+void CommandFileCache::releaseFile(const AString& name)
+{
+    m_files.erase(getKey(name));
+}
+
+void CommandFileCache::releaseModifiedFiles()
+{
+    map<AString, Entry>::iterator iter = m_files.begin();
+    while (iter != m_files.end())
+    {
+        const Entry& myEntry = iter->second;
+        bool modified = false;
+        if (!isMemoryName(iter->first))
+        {
+            switch (myEntry.m_type)
+            {
+                case OperationParametersEnum::BORDER:
+                    modified = myEntry.m_border->isModified();
+                    break;
+                case OperationParametersEnum::CIFTI:
+                    modified = !myEntry.m_ciftiWasInMemory && myEntry.m_cifti->isInMemory();//setRow, setCiftiXML etc convert an on-disk cifti to in-memory
+                    break;
+                case OperationParametersEnum::FOCI:
+                    modified = myEntry.m_foci->isModified();
+                    break;
+                case OperationParametersEnum::LABEL:
+                    modified = myEntry.m_label->isModified();
+                    break;
+                case OperationParametersEnum::METRIC:
+                    modified = myEntry.m_metric->isModified();
+                    break;
+                case OperationParametersEnum::SURFACE:
+                    modified = myEntry.m_surface->isModified();
+                    break;
+                case OperationParametersEnum::VOLUME:
+                    modified = myEntry.m_volume->isModified();
+                    break;
+                default:
+                    break;
+            }
+        }
+        if (modified)
+        {
+            CaretLogInfo("input file '" + iter->first + "' was modified in memory, later commands will read it from disk again");
+            m_files.erase(iter++);
+        } else {
+            ++iter;
+        }
+    }
+}
+
+bool CommandFileCache::hasFile(const AString& name) const
+{
+    return m_files.find(getKey(name)) != m_files.end();
+}
+
+void CommandFileCache::clear()
+{
+    m_files.clear();
+}
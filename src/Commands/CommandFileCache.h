@@ -0,0 +1,117 @@
+#ifndef __COMMAND_FILE_CACHE_H__
+#define __COMMAND_FILE_CACHE_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AString.h"
+#include "CaretPointer.h"
+#include "OperationParametersEnum.h"
+
+#include <map>
+
+namespace caret {
+
+    class BorderFile;
+    class CiftiFile;
+    class FociFile;
+    class LabelFile;
+    class MetricFile;
+    class SurfaceFile;
+    class VolumeFile;
+
+    /// Keeps files alive between commands of a batch, so that loaded inputs (and their helpers) and in-memory intermediates can be reused
+    class CommandFileCache
+    {
+        struct Entry
+        {//only the pointer matching m_type is used
+            OperationParametersEnum::Enum m_type;
+            CaretPointer<BorderFile> m_border;
+            CaretPointer<CiftiFile> m_cifti;
+            CaretPointer<FociFile> m_foci;
+            CaretPointer<LabelFile> m_label;
+            CaretPointer<MetricFile> m_metric;
+            CaretPointer<SurfaceFile> m_surface;
+            CaretPointer<VolumeFile> m_volume;
+            bool m_ciftiWasInMemory;//on-disk cifti that ends up in memory has been modified
+        };
+        std::map<AString, Entry> m_files;
+        std::map<AString, int> m_lastUse;
+        int m_currentCommand;
+
+        const Entry* findEntry(const AString& name, const OperationParametersEnum::Enum& type) const;
+        Entry& newEntry(const AString& name, const OperationParametersEnum::Enum& type);
+        bool needsCopy(const AString& name) const;
+    public:
+        CommandFileCache() { m_currentCommand = 0; }
+
+        ///whether a filename given to a batch command refers to an in-memory file rather than a file on disk
+        static bool isMemoryName(const AString& name);
+
+        ///the key a filename is cached under: in-memory names as given, on-disk files by absolute path
+        static AString getKey(const AString& name);
+
+        ///the index of the last command that mentions each cache key, and of the command about to run
+        ///an in-memory file that a later command still needs is handed out as a copy, so that a command that modifies its input
+        ///in memory can't change what later commands read
+        void setLastUses(const std::map<AString, int>& lastUse) { m_lastUse = lastUse; }
+        void setCurrentCommand(const int& index) { m_currentCommand = index; }
+
+        ///deep copies of a file, in memory, for when something may modify one of two users of the same file
+        static CaretPointer<BorderFile> copyFile(const CaretPointer<BorderFile>& file);
+        static CaretPointer<CiftiFile> copyFile(const CaretPointer<CiftiFile>& file);
+        static CaretPointer<FociFile> copyFile(const CaretPointer<FociFile>& file);
+        static CaretPointer<LabelFile> copyFile(const CaretPointer<LabelFile>& file);
+        static CaretPointer<MetricFile> copyFile(const CaretPointer<MetricFile>& file);
+        static CaretPointer<SurfaceFile> copyFile(const CaretPointer<SurfaceFile>& file);
+        static CaretPointer<VolumeFile> copyFile(const CaretPointer<VolumeFile>& file);
+
+        ///lookup functions return false if the name isn't cached, and throw if it is cached as a different type
+        bool getFile(const AString& name, CaretPointer<BorderFile>& fileOut) const;
+        bool getFile(const AString& name, CaretPointer<CiftiFile>& fileOut) const;
+        bool getFile(const AString& name, CaretPointer<FociFile>& fileOut) const;
+        bool getFile(const AString& name, CaretPointer<LabelFile>& fileOut) const;
+        bool getFile(const AString& name, CaretPointer<MetricFile>& fileOut) const;
+        bool getFile(const AString& name, CaretPointer<SurfaceFile>& fileOut) const;
+        bool getFile(const AString& name, CaretPointer<VolumeFile>& fileOut) const;
+
+        ///add or replace a cached file
+        void addFile(const AString& name, const CaretPointer<BorderFile>& file);
+        void addFile(const AString& name, const CaretPointer<CiftiFile>& file);
+        void addFile(const AString& name, const CaretPointer<FociFile>& file);
+        void addFile(const AString& name, const CaretPointer<LabelFile>& file);
+        void addFile(const AString& name, const CaretPointer<MetricFile>& file);
+        void addFile(const AString& name, const CaretPointer<SurfaceFile>& file);
+        void addFile(const AString& name, const CaretPointer<VolumeFile>& file);
+
+        ///drop a cached file, for instance because the file on disk was overwritten, or because nothing later needs it
+        void releaseFile(const AString& name);
+
+        ///drop cached on-disk inputs that a command modified in memory, so that later commands read them from disk again
+        void releaseModifiedFiles();
+
+        bool hasFile(const AString& name) const;
+
+        void clear();
+    };
+
+}
+
+#endif //__COMMAND_FILE_CACHE_H__
@@ -31,6 +31,7 @@
 
 namespace caret {
 
+    class CommandFileCache;
     class ProgramParameters;
     
     /// Abstract class for a command operation.
@@ -45,6 +46,8 @@ namespace caret {
         
         virtual void setCiftiOutputDTypeNoScale(const int16_t& dtype);
         
+        virtual void setFileCache(CommandFileCache* cache);
+        
         virtual AString doCompletion(ProgramParameters& parameters, const bool& useExtGlob);
         
     protected:
@@ -62,6 +65,8 @@ namespace caret {
         
         virtual void disableProvenance();
         
+        virtual void enableProvenance();
+        
         CommandOperation(const AString& commandLineSwitch,
                          const AString& operationShortDescription);
         
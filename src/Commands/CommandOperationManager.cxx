@@ -58,6 +58,7 @@
 #include "AlgorithmCiftiROIsFromExtrema.h"
 #include "AlgorithmCiftiSeparate.h"
 #include "AlgorithmCiftiSmoothing.h"
+#include "AlgorithmCiftiTFCE.h"
 #include "AlgorithmCiftiTranspose.h"
 #include "AlgorithmCiftiVectorOperation.h"
 #include "AlgorithmCreateSignedDistanceVolume.h"
@@ -157,6 +158,7 @@
 #include "OperationCiftiLabelExportTable.h"
 #include "OperationCiftiLabelImport.h"
 #include "OperationCiftiMath.h"
+#include "OperationCiftiMatrixPyramid.h"
 #include "OperationCiftiMerge.h"
 #include "OperationCiftiPalette.h"
 #include "OperationCiftiResampleDconnMemory.h"
@@ -179,6 +181,7 @@
 #include "OperationLabelExportTable.h"
 #include "OperationLabelMask.h"
 #include "OperationLabelMerge.h"
+#include "OperationLabelProbabilityList.h"
 #include "OperationMetadataRemoveProvenance.h"
 #include "OperationMetadataStringReplace.h"
 #include "OperationMetricConvert.h"
@@ -228,6 +231,8 @@
 
 #include "AlgorithmException.h"
 #include "ApplicationInformation.h"
+#include "CaretCommandLine.h"
+#include "CommandFileCache.h"
 #include "CommandParser.h"
 #include "OperationException.h"
 
@@ -240,11 +245,19 @@
 #include "CommandUnitTest.h"
 #include "ProgramParameters.h"
 
+#include "CaretAssert.h"
 #include "CaretLogger.h"
+#include "CaretOMP.h"
+#include "CaretProfiler.h"
+#include "CiftiFile.h"
 #include "dot_wrapper.h"
+#include "NiftiHalfFloat.h"
 #include "StructureEnum.h"
+#include "VolumeFile.h"
 
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <map>
 
 using namespace caret;
@@ -318,6 +331,7 @@ CommandOperationManager::CommandOperationManager()
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmCiftiROIsFromExtrema()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmCiftiSeparate()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmCiftiSmoothing()));
+    this->commandOperations.push_back(new CommandParser(new AutoAlgorithmCiftiTFCE()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmCiftiTranspose()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmCiftiVectorOperation()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmCreateSignedDistanceVolume()));
@@ -414,6 +428,7 @@ CommandOperationManager::CommandOperationManager()
     this->commandOperations.push_back(new CommandParser(new AutoOperationCiftiLabelExportTable()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationCiftiLabelImport()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationCiftiMath()));
+    this->commandOperations.push_back(new CommandParser(new AutoOperationCiftiMatrixPyramid()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationCiftiMerge()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationCiftiPalette()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationCiftiResampleDconnMemory()));
@@ -434,6 +449,7 @@ CommandOperationManager::CommandOperationManager()
     this->commandOperations.push_back(new CommandParser(new AutoOperationLabelExportTable()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationLabelMask()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationLabelMerge()));
+    this->commandOperations.push_back(new CommandParser(new AutoOperationLabelProbabilityList()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationMetadataRemoveProvenance()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationMetadataStringReplace()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationMetricConvert()));
@@ -520,6 +536,16 @@ CommandOperationManager::~CommandOperationManager()
 
 namespace
 {
+    ///writes the -profile report when runCommand exits, even if the command throws
+    struct ProfileReportWriter
+    {
+        AString m_fileName;
+        ~ProfileReportWriter()
+        {
+            if (!m_fileName.isEmpty()) CaretProfiler::writeReport(m_fileName);
+        }
+    };
+    
     //quick hack to convert type argument to internal integer
     int16_t stringToCiftiType(const AString& input)
     {
@@ -535,6 +561,8 @@ namespace
         nameToCode["FLOAT32"] = NIFTI_TYPE_FLOAT32;
         nameToCode["FLOAT64"] = NIFTI_TYPE_FLOAT64;
         nameToCode["FLOAT128"] = NIFTI_TYPE_FLOAT128;
+        nameToCode["FLOAT16"] = NiftiHalfFloat::DTYPE_FLOAT16;
+        nameToCode["BFLOAT16"] = NiftiHalfFloat::DTYPE_BFLOAT16;
         map<AString, int16_t>::iterator iter = nameToCode.find(input);
         if (iter == nameToCode.end())
         {
@@ -542,6 +570,114 @@ namespace
         }
         return iter->second;
     }
+    
+    int16_t stringToVolumeType(const AString& input)
+    {
+        if (input == "FLOAT32") return NIFTI_TYPE_FLOAT32;
+        if (input == "FLOAT16") return NiftiHalfFloat::DTYPE_FLOAT16;
+        if (input == "BFLOAT16") return NiftiHalfFloat::DTYPE_BFLOAT16;
+        throw CommandException("Unrecognized volume datatype: '" + input + "'");
+    }
+    
+    struct BatchCommand
+    {
+        int m_lineNumber;
+        vector<AString> m_arguments;
+    };
+    
+    //split a script into commands with bash-like rules: whitespace separates arguments, '' and "" quote, \ escapes, # starts a comment, and a backslash before a newline continues the command
+    vector<BatchCommand> tokenizeBatchScript(const string& script)
+    {
+        vector<BatchCommand> ret;
+        BatchCommand current;
+        string token;
+        bool inToken = false, inSingle = false, inDouble = false, inComment = false;
+        int lineNumber = 1;
+        current.m_lineNumber = 1;
+        for (size_t i = 0; i < script.size(); ++i)
+        {
+            char c = script[i];
+            if (c == '\n') ++lineNumber;
+            if (inComment)
+            {
+                if (c != '\n') continue;
+                inComment = false;
+            }
+            if (inSingle)
+            {
+                if (c == '\'') inSingle = false; else token += c;
+                continue;
+            }
+            if (inDouble)
+            {
+                if (c == '"')
+                {
+                    inDouble = false;
+                } else if (c == '\\' && i + 1 < script.size() && (script[i + 1] == '"' || script[i + 1] == '\\' || script[i + 1] == '$' || script[i + 1] == '`')) {
+                    token += script[++i];
+                } else {
+                    token += c;
+                }
+                continue;
+            }
+            switch (c)
+            {
+                case '\'':
+                    inSingle = true;
+                    inToken = true;
+                    break;
+                case '"':
+                    inDouble = true;
+                    inToken = true;
+                    break;
+                case '\\':
+                    if (i + 1 < script.size())
+                    {
+                        ++i;
+                        if (script[i] == '\n')
+                        {
+                            ++lineNumber;//continuation, acts like whitespace
+                            if (inToken) current.m_arguments.push_back(AString::fromLocal8Bit(token.c_str()));
+                            token = "";
+                            inToken = false;
+                        } else {
+                            token += script[i];
+                            inToken = true;
+                        }
+                    }
+                    break;
+                case '#':
+                    if (!inToken)
+                    {
+                        inComment = true;
+                        break;
+                    }
+                    token += c;
+                    break;
+                case ' ':
+                case '\t':
+                case '\r':
+                case '\n':
+                    if (inToken) current.m_arguments.push_back(AString::fromLocal8Bit(token.c_str()));
+                    token = "";
+                    inToken = false;
+                    if (c == '\n')
+                    {
+                        if (!current.m_arguments.empty()) ret.push_back(current);
+                        current.m_arguments.clear();
+                        current.m_lineNumber = lineNumber;
+                    }
+                    break;
+                default:
+                    token += c;
+                    inToken = true;
+            }
+        }
+        if (inSingle || inDouble) throw CommandException("unterminated quote in batch script, starting on line " + AString::number(current.m_lineNumber));
+        if (inToken) current.m_arguments.push_back(AString::fromLocal8Bit(token.c_str()));
+        if (!current.m_arguments.empty()) ret.push_back(current);
+        return ret;
+    }
 }
 
 /**
@@ -575,6 +711,17 @@ CommandOperationManager::runCommand(ProgramParameters& parameters)
             CaretLogWarning("SIMD type '" + DotSIMDEnum::toName(impl) + "' not supported (could be cpu, compiler, or build options), using '" + DotSIMDEnum::toName(retval) + "'");
         }
     }
+    if (getGlobalOption(parameters, "-threads", 1, globalOptionArgs))
+    {
+        bool valid = false;
+        const int numThreads = globalOptionArgs[0].toInt(&valid);
+        if (!valid || numThreads < 1) throw CommandException("-threads requires a positive integer, got '" + globalOptionArgs[0] + "'");
+#ifdef CARET_OMP
+        omp_set_num_threads(numThreads);//also the total that CiftiStructureScheduler divides between nested regions
+#else
+        if (numThreads > 1) CaretLogWarning("this build does not support multithreading, ignoring -threads");
+#endif
+    }
     int16_t ciftiDType = NIFTI_TYPE_FLOAT32;
     bool ciftiScale = false;
     double ciftiMin = -1.0, ciftiMax = -1.0;
@@ -582,6 +729,10 @@ CommandOperationManager::runCommand(ProgramParameters& parameters)
     {
         ciftiDType = stringToCiftiType(globalOptionArgs[0]);
     }
+    if (getGlobalOption(parameters, "-volume-output-datatype", 1, globalOptionArgs))
+    {
+        VolumeFile::setWritingDataType(stringToVolumeType(globalOptionArgs[0]));
+    }
     if (getGlobalOption(parameters, "-cifti-output-range", 2, globalOptionArgs))
     {
         ciftiScale = true;
@@ -591,9 +742,16 @@ CommandOperationManager::runCommand(ProgramParameters& parameters)
         ciftiMax = globalOptionArgs[1].toDouble(&valid);
         if (!valid) throw CommandException("non-numeric option to -cifti-output-range: '" + globalOptionArgs[1] + "'");
     }
-
-    const uint64_t numberOfCommands = this->commandOperations.size();
-    const uint64_t numberOfDeprecated = this->deprecatedOperations.size();
+    if (getGlobalOption(parameters, "-cifti-output-compress", 0, globalOptionArgs))
+    {
+        CiftiFile::setCompressedWritingEnabled(true);
+    }
+    ProfileReportWriter profileWriter;//writes the report when this function exits, including by exception
+    if (getGlobalOption(parameters, "-profile", 1, globalOptionArgs))
+    {
+        profileWriter.m_fileName = globalOptionArgs[0];
+        CaretProfiler::setEnabled(true);
+    }
 
     if (parameters.hasNext() == false) {
         printHelpInfo();
@@ -626,29 +784,18 @@ CommandOperationManager::runCommand(ProgramParameters& parameters)
         printDeprecatedCommands();
     } else if (commandSwitch == "-all-commands-help") {
         printAllCommandsHelpInfo(myProgramName);
-    } else {
-        
-        CommandOperation* operation = NULL;
-        
-        for (uint64_t i = 0; i < numberOfCommands; i++)
+    } else if (commandSwitch == "-batch") {
+        if (!parameters.hasNext())
         {
-            if (this->commandOperations[i]->getCommandLineSwitch() == commandSwitch)
-            {
-                operation = this->commandOperations[i];
-                break;
-            }
-        }
-        if (operation == NULL)
-        {
-            for (uint64_t i = 0; i < numberOfDeprecated; i++)
-            {
-                if (this->deprecatedOperations[i]->getCommandLineSwitch() == commandSwitch)
-                {
-                    operation = this->deprecatedOperations[i];
-                    break;
-                }
-            }
+            printBatchHelp(myProgramName);
+            return;
         }
+        AString scriptName = parameters.nextString("batch script");
+        parameters.verifyAllParametersProcessed();
+        runBatch(scriptName, myProgramName, preventProvenance, ciftiDType, ciftiScale, ciftiMin, ciftiMax);
+    } else {
+        
+        CommandOperation* operation = findOperation(commandSwitch);
         
         if (operation == NULL) {
             if (!parameters.hasNext())
@@ -668,12 +815,119 @@ CommandOperationManager::runCommand(ProgramParameters& parameters)
                 } else {
                     operation->setCiftiOutputDTypeNoScale(ciftiDType);
                 }
+                CaretProfilerSection commandSection(commandSwitch);
                 operation->execute(parameters, preventProvenance);
             }
         }
     }
 }
 
+CommandOperation* CommandOperationManager::findOperation(const AString& commandSwitch)
+{
+    const uint64_t numberOfCommands = this->commandOperations.size();
+    for (uint64_t i = 0; i < numberOfCommands; i++)
+    {
+        if (this->commandOperations[i]->getCommandLineSwitch() == commandSwitch)
+        {
+            return this->commandOperations[i];
+        }
+    }
+    const uint64_t numberOfDeprecated = this->deprecatedOperations.size();
+    for (uint64_t i = 0; i < numberOfDeprecated; i++)
+    {
+        if (this->deprecatedOperations[i]->getCommandLineSwitch() == commandSwitch)
+        {
+            return this->deprecatedOperations[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Run every command in a script in this process, keeping files in memory between commands.
+ *
+ * Inputs that are read from disk are kept loaded (along with any helpers they have built, such as
+ * surface topology or geodesic helpers) until the last command that mentions them has finished.
+ * Outputs whose name starts with '@' are never written, but can be used as inputs by later commands.
+ * A command that modifies an input in memory doesn't affect later commands: in-memory files that are
+ * still needed afterwards are given to it as copies, and modified on-disk inputs are read again.
+ */
+void CommandOperationManager::runBatch(const AString& scriptName, const AString& programName, const bool& preventProvenance,
+                                       const int16_t& ciftiDType, const bool& ciftiScale, const double& ciftiMin, const double& ciftiMax)
+{
+    ifstream scriptFile(scriptName.toLocal8Bit().constData(), ios_base::in | ios_base::binary);
+    if (!scriptFile.good()) throw CommandException("failed to open batch script '" + scriptName + "'");
+    string scriptText((istreambuf_iterator<char>(scriptFile)), istreambuf_iterator<char>());
+    vector<BatchCommand> commands = tokenizeBatchScript(scriptText);
+    map<AString, int> lastUse;//cache key to index of last command that mentions it
+    for (int i = 0; i < (int)commands.size(); ++i)
+    {
+        if (commands[i].m_arguments[0] == programName)
+        {
+            commands[i].m_arguments.erase(commands[i].m_arguments.begin());//allow lines copied from a shell script
+            if (commands[i].m_arguments.empty()) throw CommandException("batch script line " + AString::number(commands[i].m_lineNumber) + " has no command");
+        }
+        commands[i].m_arguments[0] = fixUnicode(commands[i].m_arguments[0], false);
+        if (findOperation(commands[i].m_arguments[0]) == NULL)
+        {//check all commands before running anything
+            throw CommandException("batch script line " + AString::number(commands[i].m_lineNumber) + ": command \"" + commands[i].m_arguments[0] + "\" not found");
+        }
+        for (int j = 1; j < (int)commands[i].m_arguments.size(); ++j)
+        {//most arguments aren't files, but extra entries are harmless
+            lastUse[CommandFileCache::getKey(commands[i].m_arguments[j])] = i;
+        }
+    }
+    CommandFileCache fileCache;
+    fileCache.setLastUses(lastUse);
+    for (int i = 0; i < (int)commands.size(); ++i)
+    {
+        const BatchCommand& thisCommand = commands[i];
+        fileCache.setCurrentCommand(i);
+        CommandOperation* operation = findOperation(thisCommand.m_arguments[0]);
+        CaretAssert(operation != NULL);
+        ProgramParameters lineParameters;
+        for (int j = 1; j < (int)thisCommand.m_arguments.size(); ++j)
+        {
+            lineParameters.addParameter(thisCommand.m_arguments[j]);
+        }
+        caret_global_commandLine_init(programName, thisCommand.m_arguments);//for provenance, use the command as if it were run by itself, with the same quoting as a real command line
+        CaretLogInfo("batch script line " + AString::number(thisCommand.m_lineNumber) + ": " + caret_global_commandLine);
+        if (ciftiScale)
+        {
+            operation->setCiftiOutputDTypeAndScale(ciftiDType, ciftiMin, ciftiMax);
+        } else {
+            operation->setCiftiOutputDTypeNoScale(ciftiDType);
+        }
+        operation->setFileCache(&fileCache);
+        try
+        {
+            CaretProfilerSection lineSection("batch line " + AString::number(thisCommand.m_lineNumber) + ": " + thisCommand.m_arguments[0]);
+            operation->execute(lineParameters, preventProvenance);
+        } catch (CaretException& e) {
+            operation->setFileCache(NULL);
+            throw CommandException("batch script line " + AString::number(thisCommand.m_lineNumber) + ": " + e.whatString());
+        } catch (...) {
+            operation->setFileCache(NULL);
+            throw;
+        }
+        operation->setFileCache(NULL);
+        fileCache.releaseModifiedFiles();//a separate process would read the unmodified file
+        for (int j = 1; j < (int)thisCommand.m_arguments.size(); ++j)
+        {//release anything that no later command needs
+            const AString& thisArg = thisCommand.m_arguments[j];
+            AString key = CommandFileCache::getKey(thisArg);
+            if (lastUse[key] == i && fileCache.hasFile(thisArg))
+            {
+                if (CommandFileCache::isMemoryName(thisArg))
+                {
+                    CaretLogWarning("in-memory file '" + thisArg + "' is not used after batch script line " + AString::number(thisCommand.m_lineNumber) + ", discarding it");
+                }
+                fileCache.releaseFile(thisArg);
+            }
+        }
+    }
+}
+
 AString CommandOperationManager::doCompletion(ProgramParameters& parameters, const bool& useExtGlob)
 {
     AString ret;
@@ -704,22 +958,38 @@ AString CommandOperationManager::doCompletion(ProgramParameters& parameters, con
         }
         return ret;
     }
+    OptionInfo threadsInfo = parseGlobalOption(parameters, "-threads", 1, globalOptionArgs, true);
+    if (threadsInfo.specified && !threadsInfo.complete)
+    {//can't tab complete a literal number
+        return "";
+    }
     OptionInfo ciftiDTypeInfo = parseGlobalOption(parameters, "-cifti-output-datatype", 1, globalOptionArgs, true);
     if (ciftiDTypeInfo.specified && !ciftiDTypeInfo.complete)
     {
-        return "wordlist INT8 UINT8 INT16 UINT16 INT32 UINT32 INT64 UINT64 FLOAT32 FLOAT64 FLOAT128";
+        return "wordlist INT8 UINT8 INT16 UINT16 INT32 UINT32 INT64 UINT64 FLOAT32 FLOAT64 FLOAT128 FLOAT16 BFLOAT16";
+    }
+    OptionInfo volumeDTypeInfo = parseGlobalOption(parameters, "-volume-output-datatype", 1, globalOptionArgs, true);
+    if (volumeDTypeInfo.specified && !volumeDTypeInfo.complete)
+    {
+        return "wordlist FLOAT32 FLOAT16 BFLOAT16";
     }
     OptionInfo ciftiRangeInfo = parseGlobalOption(parameters, "-cifti-output-range", 2, globalOptionArgs, true);
     if (ciftiRangeInfo.specified && !ciftiRangeInfo.complete)
     {//can't tab complete a literal number
         return "";
     }
-    ret = "wordlist -disable-provenance\\ -logging\\ -simd\\ -cifti-output-datatype\\ -cifti-output-range";//we could prevent suggesting an already-provided global option, but that would be a bit surprising
+    /*OptionInfo compressInfo = */parseGlobalOption(parameters, "-cifti-output-compress", 0, globalOptionArgs, true);
+    OptionInfo profileInfo = parseGlobalOption(parameters, "-profile", 1, globalOptionArgs, true);
+    if (profileInfo.specified && !profileInfo.complete)
+    {//output file
+        return "fileglob *";
+    }
+    ret = "wordlist -disable-provenance\\ -logging\\ -simd\\ -threads\\ -cifti-output-datatype\\ -volume-output-datatype\\ -cifti-output-range\\ -cifti-output-compress\\ -profile";//we could prevent suggesting an already-provided global option, but that would be a bit surprising
     const uint64_t numberOfCommands = this->commandOperations.size();
     const uint64_t numberOfDeprecated = this->deprecatedOperations.size();
     if (!parameters.hasNext())
     {//suggest all commands, including deprecated and informational (order doesn't matter, bash sorts them before displaying)
-        ret += "\\ -help\\ -arguments-help\\ -cifti-help\\ -gifti-help\\ -parallel-help\\ -version\\ -list-commands\\ -list-deprecated-commands\\ -all-commands-help";
+        ret += "\\ -help\\ -arguments-help\\ -cifti-help\\ -gifti-help\\ -parallel-help\\ -version\\ -list-commands\\ -list-deprecated-commands\\ -all-commands-help\\ -batch";
         for (uint64_t i = 0; i < numberOfCommands; i++)
         {
             ret += "\\ " + commandOperations[i]->getCommandLineSwitch();
@@ -976,6 +1246,10 @@ void CommandOperationManager::printHelpInfo()
     cout << "   -all-commands-help          show all processing subcommands and their help" << endl;
     cout << "                                  info - VERY LONG" << endl;
     cout << endl;
+    cout << "Batch mode:" << endl;
+    cout << "   -batch <script>             run all commands in a script in one process," << endl;
+    cout << "                                  run without a script for details" << endl;
+    cout << endl;
     cout << "To get the help information of a processing subcommand, run it without any" << endl;
     cout << "   additional arguments." << endl;
     cout << endl;
@@ -1068,6 +1342,16 @@ void CommandOperationManager::printGlobalOptions()
     cout << "                          FLOAT32" << endl;
     cout << "                          FLOAT64" << endl;
     cout << "                          FLOAT128" << endl;
+    cout << "                          FLOAT16" << endl;
+    cout << "                          BFLOAT16" << endl;
+    cout << "                                        the 16-bit float types are stored as" << endl;
+    cout << "                                        UINT16 with a workbench extension, other" << endl;
+    cout << "                                        software will read the raw bits" << endl;
+    cout << endl;
+    cout << "   -volume-output-datatype <type>    write volume output with the given" << endl;
+    cout << "                                        datatype (default FLOAT32), label" << endl;
+    cout << "                                        volumes are always FLOAT32, valid values" << endl;
+    cout << "                                        are FLOAT32, FLOAT16, BFLOAT16" << endl;
     cout << endl;
     //guide for wrap, assuming 80 columns:                                                  |
     cout << "   -cifti-output-range <min> <max>   write cifti output with scaling and offset" << endl;
@@ -1076,6 +1360,11 @@ void CommandOperationManager::printGlobalOptions()
     cout << "                                        represented, mostly useful with integer" << endl;
     cout << "                                        output datatypes (see above)" << endl;
     cout << endl;
+    cout << "   -cifti-output-compress            write cifti output as zlib-compressed" << endl;
+    cout << "                                        blocks that workbench can still read" << endl;
+    cout << "                                        randomly, other software can't read these" << endl;
+    cout << "                                        files" << endl;
+    cout << endl;
     cout << "   -logging <level>                  set the logging level, valid values are:" << endl;
     vector<LogLevelEnum::Enum> logLevels;
     LogLevelEnum::getAllEnums(logLevels);
@@ -1097,6 +1386,18 @@ void CommandOperationManager::printGlobalOptions()
         cout << "         " << DotSIMDEnum::toName(*iter) << endl;
     }
     cout << endl;
+    //guide for wrap, assuming 80 columns:                                                  |
+    cout << "   -threads <num>                    use at most <num> threads (default: the" << endl;
+    cout << "                                        OMP_NUM_THREADS environment variable, or" << endl;
+    cout << "                                        all cores), see -parallel-help" << endl;
+    cout << endl;
+    //guide for wrap, assuming 80 columns:                                                  |
+    cout << "   -profile <report>                 write a JSON report of the wall and cpu" << endl;
+    cout << "                                        time, bytes of nifti and cifti I/O," << endl;
+    cout << "                                        and peak memory of the command and each" << endl;
+    cout << "                                        algorithm it runs, including" << endl;
+    cout << "                                        sub-algorithms" << endl;
+    cout << endl;
 }
 
 void CommandOperationManager::printCiftiHelp()
@@ -1202,11 +1503,24 @@ void CommandOperationManager::printParallelHelp(const AString& programName)
     cout << endl;//guide for wrap, assuming 80 columns:                                     |
     cout << "$ OMP_NUM_THREADS=4 "<< programName << " -volume-smoothing input.nii.gz 4 output.nii.gz" << endl;
     cout << endl;//guide for wrap, assuming 80 columns:                                     |
+    cout << "   The -threads global option does the same thing for a single command, and" << endl;
+    cout << "   takes precedence over OMP_NUM_THREADS." << endl;
+    cout << endl;//guide for wrap, assuming 80 columns:                                     |
     cout << "   If you have a multi-socket system, be aware that the parallelization can be" << endl;
     cout << "   much slower when threads are on different sockets, and this interacts badly" << endl;
-    cout << "   with the default behavior of using all available cores.  It is advisable to" << endl;
-    cout << "   use other tools to restrict the entire script to execute on a single socket," << endl;
-    cout << "   especially if a queueing system is involved." << endl;
+    cout << "   with the default behavior of using all available cores.  Setting" << endl;
+    cout << "   'OMP_PROC_BIND=spread' and 'OMP_PLACES=cores' keeps each thread on one core," << endl;
+    cout << "   so the large row caches of commands like -cifti-correlation, which are" << endl;
+    cout << "   allocated by all threads, are spread over the memory of every socket." << endl;
+    cout << "   Otherwise, it is advisable to use other tools to restrict the entire script" << endl;
+    cout << "   to execute on a single socket, especially if a queueing system is involved." << endl;
+    cout << endl;//guide for wrap, assuming 80 columns:                                     |
+    cout << "   Commands that process dense cifti files by structure (smoothing, dilation," << endl;
+    cout << "   gradient, resampling) process the structures concurrently, dividing the" << endl;
+    cout << "   threads between them by size." << endl;
+    cout << endl;//guide for wrap, assuming 80 columns:                                     |
+    cout << "   When a command is given many input files, they are read in parallel, in" << endl;
+    cout << "   groups that are expected to use at most 2GB of memory while reading." << endl;
     cout << endl;//guide for wrap, assuming 80 columns:                                     |
     cout << "   Also note that wb_view contains a few features that use multithreading," << endl;
     cout << "   which can be controlled by setting the same environment variables before" << endl;
@@ -1214,6 +1528,33 @@ void CommandOperationManager::printParallelHelp(const AString& programName)
     cout << endl;//guide for wrap, assuming 80 columns:                                     |
 }
 
+void CommandOperationManager::printBatchHelp(const AString& programName)
+{
+    //guide for wrap, assuming 80 columns:                                                  |
+    cout << "$ " << programName << " -batch <script>" << endl;
+    cout << endl;
+    cout << "   Runs each command in the script file in order, in a single process.  Each" << endl;
+    cout << "   line of the script is one command, written the same way as on the command" << endl;
+    cout << "   line, optionally starting with '" << programName << "'.  Quoting and escaping follow" << endl;
+    cout << "   the rules of bash, without variables or globbing, '#' starts a comment, and" << endl;
+    cout << "   a backslash at the end of a line continues the command on the next line." << endl;
+    cout << endl;//guide for wrap, assuming 80 columns:                                     |
+    cout << "   Any output filename that starts with '@' is not written to disk, and is" << endl;
+    cout << "   instead kept in memory so that later commands in the script can use it as" << endl;
+    cout << "   an input by the same name.  Files read from disk are kept loaded until the" << endl;
+    cout << "   last command that uses them, so that reading them again, and recomputing" << endl;
+    cout << "   things like surface neighbor information, is avoided.  For example:" << endl;
+    cout << endl;//guide for wrap, assuming 80 columns:                                     |
+    cout << "      -metric-smoothing mid.surf.gii data.func.gii 2 @smooth" << endl;
+    cout << "      -metric-math 'x > 1' thresh.func.gii -var x @smooth" << endl;
+    cout << endl;//guide for wrap, assuming 80 columns:                                     |
+    cout << "   Global options must be given before -batch, and apply to every command in" << endl;
+    cout << "   the script.  Commands that modify an input file in place do not change" << endl;
+    cout << "   what later commands see: they get the file as it is on disk, or as the" << endl;
+    cout << "   command that created an '@' file wrote it." << endl;
+    cout << endl;
+}
+
 void CommandOperationManager::printVersionInfo()
 {
     ApplicationInformation myInfo;
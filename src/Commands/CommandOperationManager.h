@@ -55,6 +55,11 @@ namespace caret {
 
         CommandOperationManager& operator=(const CommandOperationManager&);
 
+        CommandOperation* findOperation(const AString& commandSwitch);
+        
+        void runBatch(const AString& scriptName, const AString& programName, const bool& preventProvenance,
+                      const int16_t& ciftiDType, const bool& ciftiScale, const double& ciftiMin, const double& ciftiMax);
+        
         void printAllCommands();
         
         void printDeprecatedCommands();
@@ -75,6 +80,8 @@ namespace caret {
         
         void printParallelHelp(const AString& programName);
         
+        void printBatchHelp(const AString& programName);
+        
         void printVersionInfo();
         
         bool getGlobalOption(ProgramParameters& parameters, const AString& optionString, const int& numArgs, std::vector<AString>& arguments);
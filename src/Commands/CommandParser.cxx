@@ -27,7 +27,10 @@
 #include "CaretCommandLine.h"
 #include "CaretDataFileHelper.h"
 #include "CaretLogger.h"
+#include "CaretOMP.h"
+#include "CaretProfiler.h"
 #include "CiftiFile.h"
+#include "CommandFileCache.h"
 #include "DataFileException.h"
 #include "FileInformation.h"
 #include "FociFile.h"
@@ -40,7 +43,10 @@
 
 #include <QDir>
 
+#include <exception>
 #include <iostream>
+#include <map>
+#include <set>
 
 using namespace caret;
 using namespace std;
@@ -55,6 +61,7 @@ CommandParser::CommandParser(AutoOperationInterface* myAutoOper) :
     OperationParserInterface(myAutoOper)
 {
     m_doProvenance = true;
+    m_fileCache = NULL;
     m_ciftiScale = false;
     m_ciftiDType = NIFTI_TYPE_FLOAT32;
     m_ciftiMax = -1.0;//these values won't get used, but don't leave them uninitialized
@@ -66,6 +73,28 @@ void CommandParser::disableProvenance()
     m_doProvenance = false;
 }
 
+void CommandParser::enableProvenance()
+{
+    m_doProvenance = true;
+}
+
+void CommandParser::setFileCache(CommandFileCache* cache)
+{
+    m_fileCache = cache;
+}
+
+template <typename T>
+bool CommandParser::getCachedInput(const AString& name, CaretPointer<T>& fileOut)
+{
+    if (m_fileCache == NULL) return false;
+    if (m_fileCache->getFile(name, fileOut)) return true;
+    if (CommandFileCache::isMemoryName(name))
+    {
+        throw CommandException("in-memory file '" + name + "' was not created by an earlier command");
+    }
+    return false;
+}
+
 void CommandParser::setCiftiOutputDTypeAndScale(const int16_t& dtype, const double& minVal, const double& maxVal)
 {
     m_ciftiDType = dtype;
@@ -90,10 +119,16 @@ void CommandParser::executeOperation(ProgramParameters& parameters)
     //the idea is to have m_provenance set before the command executes, so it can be overridden, but have m_parentProvenance set AFTER the processing is complete
     //the parent provenance should never be generated manually
     m_parentProvenance = "";//in case someone tries to use the same instance more than once
+    m_inputCiftiNames.clear();//ditto, batch mode reuses instances
+    m_inputAssociation.clear();
     m_workingDir = QDir::currentPath();//get the current path, in case some stupid command changes the working directory
     //these get set on output files during writeOutput (and for on-disk in provenanceBeforeOperation)
     parseComponent(myAlgParams.getPointer(), parameters, myOutAssoc);//parsing block
     parameters.verifyAllParametersProcessed();
+    {
+        CaretProfilerSection readSection("read inputs");
+        loadInputs();//don't read anything until we know the command line is valid
+    }
     makeOnDiskOutputs(myOutAssoc);//check for input on-disk files used as output on-disk files
     //code to show what arguments map to what parameters should go here
     if (m_doProvenance) provenanceBeforeOperation(myOutAssoc);
@@ -105,6 +140,7 @@ void CommandParser::executeOperation(ProgramParameters& parameters)
     }
     if (m_doProvenance) provenanceAfterOperation(myOutAssoc);
     //TODO: deallocate input files - give abstract parameter a virtual deallocate method? use CaretPointer and rely on reference counting?
+    CaretProfilerSection writeSection("write outputs");
     writeOutput(myOutAssoc);
 }
 
@@ -112,9 +148,12 @@ void CommandParser::showParsedOperation(ProgramParameters& parameters)
 {
     CaretPointer<OperationParameters> myAlgParams(m_autoOper->getParameters());//could be an autopointer, but this is safer
     vector<OutputAssoc> myOutAssoc;
+    m_inputCiftiNames.clear();
+    m_inputAssociation.clear();
     
     parseComponent(myAlgParams.getPointer(), parameters, myOutAssoc, true);//parsing block
     parameters.verifyAllParametersProcessed();
+    loadInputs(true);
     //don't execute or write parsed output
 }
 
@@ -150,7 +189,6 @@ void CommandParser::parseComponent(ParameterComponent* myComponent, ProgramParam
                 continue;//so skip trying to parse it as a required argument
             }
         }
-        const OperationParametersEnum::Enum nextType = myComponent->m_paramList[i]->getType();// need in catch statement below
         try {
             switch (myComponent->m_paramList[i]->getType())
             {
@@ -165,59 +203,6 @@ void CommandParser::parseComponent(ParameterComponent* myComponent, ProgramParam
                     }
                     break;
                 }
-                case OperationParametersEnum::BORDER:
-                {
-                    CaretPointer<BorderFile> myFile(new BorderFile());
-                    myFile->readFile(nextArg);
-                    if (m_doProvenance)
-                    {
-                        const GiftiMetaData* md = myFile->getFileMetaData();
-                        if (md != NULL)
-                        {
-                            AString prov = md->get(PROVENANCE_NAME);
-                            if (prov != "")
-                            {
-                                m_parentProvenance += nextArg + ":\n" + prov + "\n\n";
-                            }
-                        }
-                    }
-                    ((BorderParameter*)myComponent->m_paramList[i])->m_parameter = myFile;
-                    if (debug)
-                    {
-                        cout << "Parameter <" << myComponent->m_paramList[i]->m_shortName << "> opened file with name ";
-                        cout << nextArg << endl;
-                    }
-                    break;
-                }
-                case OperationParametersEnum::CIFTI:
-                {
-                    FileInformation myInfo(nextArg);
-                    CaretPointer<CiftiFile> myFile(new CiftiFile());
-                    myFile->openFile(nextArg);
-                    m_inputCiftiNames[myInfo.getCanonicalFilePath()] = myFile;//track input cifti, so we can check their size
-                    if (m_doProvenance)//just an optimization, if we aren't going to write provenance, don't generate it, either
-                    {
-                        const GiftiMetaData* md = myFile->getCiftiXML().getFileMetaData();
-                        if (md != NULL)
-                        {
-                            if (md->exists(PROVENANCE_NAME))
-                            {
-                                AString provenance = md->get(PROVENANCE_NAME);
-                                if (provenance != "")
-                                {
-                                    m_parentProvenance += nextArg + ":\n" + provenance + "\n\n";
-                                }
-                            }
-                        }
-                    }
-                    ((CiftiParameter*)myComponent->m_paramList[i])->m_parameter = myFile;
-                    if (debug)
-                    {
-                        cout << "Parameter <" << myComponent->m_paramList[i]->m_shortName << "> opened file with name ";
-                        cout << nextArg << endl;
-                    }
-                    break;
-                }
                 case OperationParametersEnum::DOUBLE:
                 {
                     parameters.backup();
@@ -229,30 +214,6 @@ void CommandParser::parseComponent(ParameterComponent* myComponent, ProgramParam
                     }
                     break;
                 }
-                case OperationParametersEnum::FOCI:
-                {
-                    CaretPointer<FociFile> myFile(new FociFile());
-                    myFile->readFile(nextArg);
-                    if (m_doProvenance)
-                    {
-                        const GiftiMetaData* md = myFile->getFileMetaData();
-                        if (md != NULL)
-                        {
-                            AString prov = md->get(PROVENANCE_NAME);
-                            if (prov != "")
-                            {
-                                m_parentProvenance += nextArg + ":\n" + prov + "\n\n";
-                            }
-                        }
-                    }
-                    ((FociParameter*)myComponent->m_paramList[i])->m_parameter = myFile;
-                    if (debug)
-                    {
-                        cout << "Parameter <" << myComponent->m_paramList[i]->m_shortName << "> opened file with name ";
-                        cout << nextArg << endl;
-                    }
-                    break;
-                }
                 case OperationParametersEnum::INT:
                 {
                     parameters.backup();
@@ -264,54 +225,6 @@ void CommandParser::parseComponent(ParameterComponent* myComponent, ProgramParam
                     }
                     break;
                 }
-                case OperationParametersEnum::LABEL:
-                {
-                    CaretPointer<LabelFile> myFile(new LabelFile());
-                    myFile->readFile(nextArg);
-                    if (m_doProvenance)
-                    {
-                        const GiftiMetaData* md = myFile->getFileMetaData();
-                        if (md != NULL)
-                        {
-                            AString prov = md->get(PROVENANCE_NAME);
-                            if (prov != "")
-                            {
-                                m_parentProvenance += nextArg + ":\n" + prov + "\n\n";
-                            }
-                        }
-                    }
-                    ((LabelParameter*)myComponent->m_paramList[i])->m_parameter = myFile;
-                    if (debug)
-                    {
-                        cout << "Parameter <" << myComponent->m_paramList[i]->m_shortName << "> opened file with name ";
-                        cout << nextArg << endl;
-                    }
-                    break;
-                }
-                case OperationParametersEnum::METRIC:
-                {
-                    CaretPointer<MetricFile> myFile(new MetricFile());
-                    myFile->readFile(nextArg);
-                    if (m_doProvenance)
-                    {
-                        const GiftiMetaData* md = myFile->getFileMetaData();
-                        if (md != NULL)
-                        {
-                            AString prov = md->get(PROVENANCE_NAME);
-                            if (prov != "")
-                            {
-                                m_parentProvenance += nextArg + ":\n" + prov + "\n\n";
-                            }
-                        }
-                    }
-                    ((MetricParameter*)myComponent->m_paramList[i])->m_parameter = myFile;
-                    if (debug)
-                    {
-                        cout << "Parameter <" << myComponent->m_paramList[i]->m_shortName << "> opened file with name ";
-                        cout << nextArg << endl;
-                    }
-                    break;
-                }
                 case OperationParametersEnum::STRING:
                 {
                     ((StringParameter*)myComponent->m_paramList[i])->m_parameter = nextArg;
@@ -322,83 +235,30 @@ void CommandParser::parseComponent(ParameterComponent* myComponent, ProgramParam
                     }
                     break;
                 }
+                case OperationParametersEnum::BORDER:
+                case OperationParametersEnum::CIFTI:
+                case OperationParametersEnum::FOCI:
+                case OperationParametersEnum::LABEL:
+                case OperationParametersEnum::METRIC:
                 case OperationParametersEnum::SURFACE:
-                {
-                    CaretPointer<SurfaceFile> myFile(new SurfaceFile());
-                    myFile->readFile(nextArg);
-                    if (m_doProvenance)
-                    {
-                        const GiftiMetaData* md = myFile->getFileMetaData();
-                        if (md != NULL)
-                        {
-                            AString prov = md->get(PROVENANCE_NAME);
-                            if (prov != "")
-                            {
-                                m_parentProvenance += nextArg + ":\n" + prov + "\n\n";
-                            }
-                        }
-                    }
-                    ((SurfaceParameter*)myComponent->m_paramList[i])->m_parameter = myFile;
-                    if (debug)
-                    {
-                        cout << "Parameter <" << myComponent->m_paramList[i]->m_shortName << "> opened file with name ";
-                        cout << nextArg << endl;
-                    }
-                    break;
-                }
                 case OperationParametersEnum::VOLUME:
-                {
-                    CaretPointer<VolumeFile> myFile(new VolumeFile());
-                    myFile->readFile(nextArg);
-                    if (m_doProvenance)
-                    {
-                        const GiftiMetaData* md = myFile->getFileMetaData();
-                        if (md != NULL)
-                        {
-                            AString prov = md->get(PROVENANCE_NAME);
-                            if (prov != "")
-                            {
-                                m_parentProvenance += nextArg + ":\n" + prov + "\n\n";
-                            }
-                        }
-                    }
-                    ((VolumeParameter*)myComponent->m_paramList[i])->m_parameter = myFile;
+                {//files are read after parsing is complete, so that they can be read in parallel, see loadInputs()
+                    InputAssoc tempItem;
+                    tempItem.m_fileName = nextArg;
+                    tempItem.m_param = myComponent->m_paramList[i];
+                    m_inputAssociation.push_back(tempItem);
                     if (debug)
                     {
-                        cout << "Parameter <" << myComponent->m_paramList[i]->m_shortName << "> opened file with name ";
+                        cout << "Parameter <" << myComponent->m_paramList[i]->m_shortName << "> given input name ";
                         cout << nextArg << endl;
                     }
                     break;
                 }
             };
         }
-        catch (const bad_alloc&) {
-            switch (nextType)
-            {
-                case OperationParametersEnum::BORDER:
-                case OperationParametersEnum::CIFTI:
-                case OperationParametersEnum::FOCI:
-                case OperationParametersEnum::LABEL:
-                case OperationParametersEnum::METRIC:
-                case OperationParametersEnum::SURFACE:
-                case OperationParametersEnum::VOLUME:
-                    /*
-                     * Provide information to the user about which
-                     * file caused the std::bad_alloc including
-                     * the size of the file.
-                     */
-                    throw DataFileException(nextArg,
-                                            CaretDataFileHelper::createBadAllocExceptionMessage(nextArg));
-
-                    break;
-                case OperationParametersEnum::DOUBLE:
-                case OperationParametersEnum::INT:
-                case OperationParametersEnum::STRING:
-                case OperationParametersEnum::BOOL:
-                    throw DataFileException("Unable to allocate memory for input: "
-                                            + nextArg);
-                    break;
-            }
+        catch (const bad_alloc&) {//files are read later, see loadInputs()
+            throw DataFileException("Unable to allocate memory for input: "
+                                    + nextArg);
         }
     }
     for (int i = 0; i < (int)myComponent->m_outputList.size(); ++i)
@@ -482,6 +342,309 @@ void CommandParser::parseComponent(ParameterComponent* myComponent, ProgramParam
     parseRemainingOptions(myComponent, parameters, outAssociation, debug);
 }
 
+namespace
+{
+    //files that are estimated to take less than this much memory in total are read at the same time
+    const int64_t PARALLEL_LOAD_MEMORY_LIMIT = ((int64_t)2) * 1024 * 1024 * 1024;
+    
+    int64_t estimateInputMemory(const AString& fileName, const OperationParametersEnum::Enum& type)
+    {
+        if (type == OperationParametersEnum::CIFTI) return 0;//only the header is read, the data stays on disk
+        FileInformation myInfo(fileName);
+        if (myInfo.isRemoteFile()) return PARALLEL_LOAD_MEMORY_LIMIT;
+        int64_t ret = myInfo.size();
+        if (fileName.endsWith(".gz")) ret *= 4;//rough guess at compression ratio, mainly for volumes
+        return ret;
+    }
+    
+    //the readers for these types don't share mutable static state once the first file of the type has been read:
+    //nifti volumes only parse xml for the caret extension, which CaretVolumeExtension does under a lock, and cifti only reads the header
+    //with a QXmlStreamReader per file - the SAX-based GIFTI and XML readers haven't been checked for this, so they stay serial
+    bool canReadInParallel(const OperationParametersEnum::Enum& type)
+    {
+        return type == OperationParametersEnum::VOLUME || type == OperationParametersEnum::CIFTI;
+    }
+}
+
+void CommandParser::createInput(AbstractParameter* param)
+{
+    switch (param->getType())
+    {
+        case OperationParametersEnum::BORDER:
+            ((BorderParameter*)param)->m_parameter.grabNew(new BorderFile());
+            break;
+        case OperationParametersEnum::CIFTI:
+            ((CiftiParameter*)param)->m_parameter.grabNew(new CiftiFile());
+            break;
+        case OperationParametersEnum::FOCI:
+            ((FociParameter*)param)->m_parameter.grabNew(new FociFile());
+            break;
+        case OperationParametersEnum::LABEL:
+            ((LabelParameter*)param)->m_parameter.grabNew(new LabelFile());
+            break;
+        case OperationParametersEnum::METRIC:
+            ((MetricParameter*)param)->m_parameter.grabNew(new MetricFile());
+            break;
+        case OperationParametersEnum::SURFACE:
+            ((SurfaceParameter*)param)->m_parameter.grabNew(new SurfaceFile());
+            break;
+        case OperationParametersEnum::VOLUME:
+            ((VolumeParameter*)param)->m_parameter.grabNew(new VolumeFile());
+            break;
+        default:
+            CaretAssert(false);
+    }
+}
+
+CaretDataFile* CommandParser::getInputDataFile(AbstractParameter* param)
+{
+    switch (param->getType())
+    {
+        case OperationParametersEnum::BORDER:
+            return ((BorderParameter*)param)->m_parameter;
+        case OperationParametersEnum::FOCI:
+            return ((FociParameter*)param)->m_parameter;
+        case OperationParametersEnum::LABEL:
+            return ((LabelParameter*)param)->m_parameter;
+        case OperationParametersEnum::METRIC:
+            return ((MetricParameter*)param)->m_parameter;
+        case OperationParametersEnum::SURFACE:
+            return ((SurfaceParameter*)param)->m_parameter;
+        case OperationParametersEnum::VOLUME:
+            return ((VolumeParameter*)param)->m_parameter;
+        default:
+            return NULL;//cifti isn't a CaretDataFile
+    }
+}
+
+void CommandParser::readInput(const InputAssoc& input)
+{
+    if (input.m_param->getType() == OperationParametersEnum::CIFTI)
+    {
+        ((CiftiParameter*)input.m_param)->m_parameter->openFile(input.m_fileName);
+    } else {
+        CaretDataFile* myFile = getInputDataFile(input.m_param);
+        CaretAssert(myFile != NULL);
+        myFile->readFile(input.m_fileName);
+    }
+}
+
+bool CommandParser::useCachedInput(const InputAssoc& input)
+{
+    AbstractParameter* param = input.m_param;
+    switch (param->getType())
+    {
+        case OperationParametersEnum::BORDER:
+            return getCachedInput(input.m_fileName, ((BorderParameter*)param)->m_parameter);
+        case OperationParametersEnum::CIFTI:
+            return getCachedInput(input.m_fileName, ((CiftiParameter*)param)->m_parameter);
+        case OperationParametersEnum::FOCI:
+            return getCachedInput(input.m_fileName, ((FociParameter*)param)->m_parameter);
+        case OperationParametersEnum::LABEL:
+            return getCachedInput(input.m_fileName, ((LabelParameter*)param)->m_parameter);
+        case OperationParametersEnum::METRIC:
+            return getCachedInput(input.m_fileName, ((MetricParameter*)param)->m_parameter);
+        case OperationParametersEnum::SURFACE:
+            return getCachedInput(input.m_fileName, ((SurfaceParameter*)param)->m_parameter);
+        case OperationParametersEnum::VOLUME:
+            return getCachedInput(input.m_fileName, ((VolumeParameter*)param)->m_parameter);
+        default:
+            CaretAssert(false);
+            return false;
+    }
+}
+
+void CommandParser::cacheInput(const InputAssoc& input)
+{
+    CaretAssert(m_fileCache != NULL);
+    AbstractParameter* param = input.m_param;
+    switch (param->getType())
+    {
+        case OperationParametersEnum::BORDER:
+            m_fileCache->addFile(input.m_fileName, ((BorderParameter*)param)->m_parameter);
+            break;
+        case OperationParametersEnum::CIFTI:
+            m_fileCache->addFile(input.m_fileName, ((CiftiParameter*)param)->m_parameter);
+            break;
+        case OperationParametersEnum::FOCI:
+            m_fileCache->addFile(input.m_fileName, ((FociParameter*)param)->m_parameter);
+            break;
+        case OperationParametersEnum::LABEL:
+            m_fileCache->addFile(input.m_fileName, ((LabelParameter*)param)->m_parameter);
+            break;
+        case OperationParametersEnum::METRIC:
+            m_fileCache->addFile(input.m_fileName, ((MetricParameter*)param)->m_parameter);
+            break;
+        case OperationParametersEnum::SURFACE:
+            m_fileCache->addFile(input.m_fileName, ((SurfaceParameter*)param)->m_parameter);
+            break;
+        case OperationParametersEnum::VOLUME:
+            m_fileCache->addFile(input.m_fileName, ((VolumeParameter*)param)->m_parameter);
+            break;
+        default:
+            CaretAssert(false);
+    }
+}
+
+void CommandParser::copyInput(const InputAssoc& to, const InputAssoc& from)
+{//commands may modify their inputs in memory, so two parameters naming the same file must not share an object
+    CaretAssert(to.m_param->getType() == from.m_param->getType());
+    AbstractParameter* toParam = to.m_param, *fromParam = from.m_param;
+    switch (toParam->getType())
+    {
+        case OperationParametersEnum::BORDER:
+            ((BorderParameter*)toParam)->m_parameter = CommandFileCache::copyFile(((BorderParameter*)fromParam)->m_parameter);
+            break;
+        case OperationParametersEnum::CIFTI:
+            if (((CiftiParameter*)fromParam)->m_parameter->isInMemory())
+            {
+                ((CiftiParameter*)toParam)->m_parameter = CommandFileCache::copyFile(((CiftiParameter*)fromParam)->m_parameter);
+            } else {//on-disk cifti only reads the header, and modifying it switches that object to in-memory, so opening it again is cheaper than copying
+                createInput(toParam);
+                readInput(to);
+            }
+            break;
+        case OperationParametersEnum::FOCI:
+            ((FociParameter*)toParam)->m_parameter = CommandFileCache::copyFile(((FociParameter*)fromParam)->m_parameter);
+            break;
+        case OperationParametersEnum::LABEL:
+            ((LabelParameter*)toParam)->m_parameter = CommandFileCache::copyFile(((LabelParameter*)fromParam)->m_parameter);
+            break;
+        case OperationParametersEnum::METRIC:
+            ((MetricParameter*)toParam)->m_parameter = CommandFileCache::copyFile(((MetricParameter*)fromParam)->m_parameter);
+            break;
+        case OperationParametersEnum::SURFACE:
+            ((SurfaceParameter*)toParam)->m_parameter = CommandFileCache::copyFile(((SurfaceParameter*)fromParam)->m_parameter);
+            break;
+        case OperationParametersEnum::VOLUME:
+            ((VolumeParameter*)toParam)->m_parameter = CommandFileCache::copyFile(((VolumeParameter*)fromParam)->m_parameter);
+            break;
+        default:
+            CaretAssert(false);
+    }
+}
+
+void CommandParser::loadInputs(bool debug)
+{
+    const int numInputs = (int)m_inputAssociation.size();
+    vector<int> readIndices, copyFrom(numInputs, -1);//when a file is given more than once, read it once and copy it
+    map<pair<OperationParametersEnum::Enum, AString>, int> firstUse;
+    for (int i = 0; i < numInputs; ++i)
+    {
+        const InputAssoc& thisInput = m_inputAssociation[i];
+        pair<OperationParametersEnum::Enum, AString> key(thisInput.m_param->getType(), CommandFileCache::getKey(thisInput.m_fileName));
+        map<pair<OperationParametersEnum::Enum, AString>, int>::iterator iter = firstUse.find(key);
+        if (iter != firstUse.end())
+        {
+            copyFrom[i] = iter->second;
+            continue;
+        }
+        firstUse[key] = i;
+        if (useCachedInput(thisInput)) continue;
+        createInput(thisInput.m_param);//file constructors register event listeners, so don't construct them in parallel
+        readIndices.push_back(i);
+    }
+    //the first file of each type, and remote files, are read by themselves - readers lazily initialize static things like enum tables,
+    //and reading a file of the same type first means those are already set up before reading in parallel
+    //GIFTI-based files (border, foci, label, metric, surface) are always read one at a time, see canReadInParallel()
+    vector<int> serialReads, parallelReads;
+    set<OperationParametersEnum::Enum> typesRead;
+    for (int i = 0; i < (int)readIndices.size(); ++i)
+    {
+        const InputAssoc& thisInput = m_inputAssociation[readIndices[i]];
+        if (typesRead.insert(thisInput.m_param->getType()).second || !canReadInParallel(thisInput.m_param->getType()) ||
+            FileInformation(thisInput.m_fileName).isRemoteFile())
+        {
+            serialReads.push_back(readIndices[i]);
+        } else {
+            parallelReads.push_back(readIndices[i]);
+        }
+    }
+    for (int i = 0; i < (int)serialReads.size(); ++i)
+    {
+        const InputAssoc& thisInput = m_inputAssociation[serialReads[i]];
+        try
+        {
+            readInput(thisInput);
+        } catch (const bad_alloc&) {
+            throw DataFileException(thisInput.m_fileName,
+                                    CaretDataFileHelper::createBadAllocExceptionMessage(thisInput.m_fileName));
+        }
+    }
+    int waveStart = 0;
+    while (waveStart < (int)parallelReads.size())
+    {//read in groups that are expected to fit in the memory limit together, a file larger than the limit is read by itself
+        int waveEnd = waveStart;
+        int64_t waveMemory = 0;
+        do
+        {
+            const InputAssoc& thisInput = m_inputAssociation[parallelReads[waveEnd]];
+            waveMemory += estimateInputMemory(thisInput.m_fileName, thisInput.m_param->getType());
+            ++waveEnd;
+        } while (waveEnd < (int)parallelReads.size() &&
+                 waveMemory + estimateInputMemory(m_inputAssociation[parallelReads[waveEnd]].m_fileName, m_inputAssociation[parallelReads[waveEnd]].m_param->getType()) <= PARALLEL_LOAD_MEMORY_LIMIT);
+        vector<exception_ptr> readErrors(waveEnd - waveStart);
+#pragma omp CARET_PARFOR schedule(dynamic)
+        for (int i = waveStart; i < waveEnd; ++i)
+        {
+            const InputAssoc& thisInput = m_inputAssociation[parallelReads[i]];
+            try
+            {
+                try
+                {
+                    readInput(thisInput);
+                } catch (const bad_alloc&) {
+                    throw DataFileException(thisInput.m_fileName,
+                                            CaretDataFileHelper::createBadAllocExceptionMessage(thisInput.m_fileName));
+                }
+            } catch (...) {//exceptions can't leave an openmp region
+                readErrors[i - waveStart] = current_exception();
+            }
+        }
+        for (int i = 0; i < (int)readErrors.size(); ++i)
+        {//report the first failed file in command line order, regardless of which thread finished first
+            if (readErrors[i]) rethrow_exception(readErrors[i]);
+        }
+        waveStart = waveEnd;
+    }
+    for (int i = 0; i < numInputs; ++i)
+    {//bookkeeping in command line order, so provenance doesn't depend on reading order
+        const InputAssoc& thisInput = m_inputAssociation[i];
+        if (copyFrom[i] != -1)
+        {
+            copyInput(thisInput, m_inputAssociation[copyFrom[i]]);
+        } else if (m_fileCache != NULL && !CommandFileCache::isMemoryName(thisInput.m_fileName)) {
+            cacheInput(thisInput);
+        }
+        const GiftiMetaData* md = NULL;
+        if (thisInput.m_param->getType() == OperationParametersEnum::CIFTI)
+        {
+            CiftiFile* myFile = ((CiftiParameter*)thisInput.m_param)->m_parameter;
+            if (m_fileCache == NULL || !CommandFileCache::isMemoryName(thisInput.m_fileName))
+            {
+                FileInformation myInfo(thisInput.m_fileName);
+                m_inputCiftiNames[myInfo.getCanonicalFilePath()] = myFile;//track input cifti, so we can check their size
+            }
+            md = myFile->getCiftiXML().getFileMetaData();
+        } else {
+            md = getInputDataFile(thisInput.m_param)->getFileMetaData();
+        }
+        if (m_doProvenance && md != NULL)//just an optimization, if we aren't going to write provenance, don't generate it, either
+        {
+            AString prov = md->get(PROVENANCE_NAME);
+            if (prov != "")
+            {
+                m_parentProvenance += thisInput.m_fileName + ":\n" + prov + "\n\n";
+            }
+        }
+        if (debug)
+        {
+            cout << "Parameter <" << thisInput.m_param->m_shortName << "> opened file with name ";
+            cout << thisInput.m_fileName << endl;
+        }
+    }
+}
+
 bool CommandParser::parseOption(const AString& mySwitch, ParameterComponent* myComponent, ProgramParameters& parameters, vector<OutputAssoc>& outAssociation, bool debug)
 {
     for (uint32_t i = 0; i < myComponent->m_optionList.size(); ++i)
@@ -949,7 +1112,10 @@ void CommandParser::makeOnDiskOutputs(const vector<OutputAssoc>& outAssociation)
                 CiftiParameter* myCiftiParam = (CiftiParameter*)myParam;
                 FileInformation myInfo(outAssociation[i].m_fileName);
                 map<AString, const CiftiFile*>::iterator iter = m_inputCiftiNames.find(myInfo.getCanonicalFilePath());
-                if (iter != m_inputCiftiNames.end())
+                if (isMemoryOutput(outAssociation[i].m_fileName))
+                {
+                    myCiftiParam->m_parameter.grabNew(new CiftiFile());//stays in memory for later commands in the batch
+                } else if (iter != m_inputCiftiNames.end())
                 {
                     vector<int64_t> dims = iter->second->getDimensions();
                     int64_t totalSize = sizeof(float);
@@ -980,11 +1146,57 @@ void CommandParser::makeOnDiskOutputs(const vector<OutputAssoc>& outAssociation)
     }
 }
 
+bool CommandParser::isMemoryOutput(const AString& fileName)
+{
+    return m_fileCache != NULL && CommandFileCache::isMemoryName(fileName);
+}
+
+void CommandParser::keepMemoryOutput(const OutputAssoc& output)
+{
+    CaretAssert(m_fileCache != NULL);
+    AbstractParameter* myParam = output.m_param;
+    switch (myParam->getType())
+    {
+        case OperationParametersEnum::BORDER:
+            m_fileCache->addFile(output.m_fileName, ((BorderParameter*)myParam)->m_parameter);
+            break;
+        case OperationParametersEnum::CIFTI:
+            m_fileCache->addFile(output.m_fileName, ((CiftiParameter*)myParam)->m_parameter);
+            break;
+        case OperationParametersEnum::FOCI:
+            m_fileCache->addFile(output.m_fileName, ((FociParameter*)myParam)->m_parameter);
+            break;
+        case OperationParametersEnum::LABEL:
+            m_fileCache->addFile(output.m_fileName, ((LabelParameter*)myParam)->m_parameter);
+            break;
+        case OperationParametersEnum::METRIC:
+            m_fileCache->addFile(output.m_fileName, ((MetricParameter*)myParam)->m_parameter);
+            break;
+        case OperationParametersEnum::SURFACE:
+            m_fileCache->addFile(output.m_fileName, ((SurfaceParameter*)myParam)->m_parameter);
+            break;
+        case OperationParametersEnum::VOLUME:
+            m_fileCache->addFile(output.m_fileName, ((VolumeParameter*)myParam)->m_parameter);
+            break;
+        default:
+            throw CommandException("output '" + output.m_fileName + "' is not a file type, it can't be kept in memory");
+    }
+}
+
 void CommandParser::writeOutput(const vector<OutputAssoc>& outAssociation)
 {
     for (uint32_t i = 0; i < outAssociation.size(); ++i)
     {
         AbstractParameter* myParam = outAssociation[i].m_param;
+        if (isMemoryOutput(outAssociation[i].m_fileName))
+        {
+            keepMemoryOutput(outAssociation[i]);
+            continue;
+        }
+        if (m_fileCache != NULL)
+        {
+            m_fileCache->releaseFile(outAssociation[i].m_fileName);//the file on disk is being replaced, so a cached copy of it would be stale
+        }
         switch (myParam->getType())
         {
             case OperationParametersEnum::BOOL://ignores the name you give the output for now, but what gives primitive type output and how is it used?
@@ -33,6 +33,9 @@
 
 namespace caret {
 
+    class CaretDataFile;
+    class CommandFileCache;
+    
     class CommandParser : public CommandOperation, OperationParserInterface
     {
         int m_minIndent, m_maxIndent, m_indentIncrement, m_maxWidth;
@@ -42,11 +45,18 @@ namespace caret {
         int16_t m_ciftiDType;
         const static AString PROVENANCE_NAME, PARENT_PROVENANCE_NAME, PROGRAM_PROVENANCE_NAME, CWD_PROVENANCE_NAME;//TODO: put this elsewhere?
         std::map<AString, const CiftiFile*> m_inputCiftiNames;
+        CommandFileCache* m_fileCache;//only set in batch mode, not owned
         struct OutputAssoc
         {//how the output is stored is up to the parser, in the GUI it should load into memory without writing to disk
             AString m_fileName;
             AbstractParameter* m_param;
         };
+        struct InputAssoc
+        {//input files are read after parsing, so that they can be read in parallel
+            AString m_fileName;
+            AbstractParameter* m_param;
+        };
+        std::vector<InputAssoc> m_inputAssociation;
         struct CompletionInfo
         {
             bool complete, found;//found is only used for options
@@ -60,6 +70,17 @@ namespace caret {
         void provenanceAfterOperation(const std::vector<OutputAssoc>& outAssociation);
         void makeOnDiskOutputs(const std::vector<OutputAssoc>& outAssociation);//ensures on-disk inputs aren't used as on-disk outputs, keeping outputs in-memory when needed
         void writeOutput(const std::vector<OutputAssoc>& outAssociation);
+        template <typename T>
+        bool getCachedInput(const AString& name, CaretPointer<T>& fileOut);
+        bool useCachedInput(const InputAssoc& input);
+        void cacheInput(const InputAssoc& input);
+        void createInput(AbstractParameter* param);
+        void readInput(const InputAssoc& input);
+        void copyInput(const InputAssoc& to, const InputAssoc& from);
+        CaretDataFile* getInputDataFile(AbstractParameter* param);
+        void loadInputs(bool debug = false);
+        bool isMemoryOutput(const AString& fileName);
+        void keepMemoryOutput(const OutputAssoc& output);
         AString getIndentString(int desired);
         void addHelpComponent(AString& info, ParameterComponent* myComponent, int curIndent);
         void addHelpOptions(AString& info, ParameterComponent* myAlgParams, int curIndent);
@@ -74,6 +95,8 @@ namespace caret {
     public:
         CommandParser(AutoOperationInterface* myAutoOper);
         void disableProvenance();
+        void enableProvenance();
+        void setFileCache(CommandFileCache* cache);
         void setCiftiOutputDTypeAndScale(const int16_t& dtype, const double& minVal, const double& maxVal);
         void setCiftiOutputDTypeNoScale(const int16_t& dtype);
         void executeOperation(ProgramParameters& parameters);
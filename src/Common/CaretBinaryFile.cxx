@@ -28,6 +28,7 @@
 #include "CaretAssert.h"
 #include "CaretBinaryFile.h"
 #include "CaretLogger.h"
+#include "CaretProfiler.h"
 #include "DataFileException.h"
 
 #include <QFile>
@@ -134,6 +135,7 @@ void CaretBinaryFile::read(void* dataOut, const int64_t& count, int64_t* numRead
     CaretAssert(count >= 0);//not sure about allowing 0
     if (!getOpenForRead()) throw DataFileException("file is not open for reading");
     m_impl->read(dataOut, count, numRead);
+    if (CaretProfiler::isEnabled()) CaretProfiler::addBytesRead(numRead == NULL ? count : *numRead);
 }
 
 void CaretBinaryFile::seek(const int64_t& position)
@@ -141,6 +143,7 @@ void CaretBinaryFile::seek(const int64_t& position)
     CaretAssert(position >= 0);
     if (m_curMode == NONE) throw DataFileException("file is not open, can't seek");
     m_impl->seek(position);
+    if (CaretProfiler::isEnabled()) CaretProfiler::addSeek();
 }
 
 int64_t CaretBinaryFile::pos()
@@ -160,6 +163,7 @@ void CaretBinaryFile::write(const void* dataIn, const int64_t& count)
     CaretAssert(count >= 0);//not sure about allowing 0
     if (!getOpenForWrite()) throw DataFileException("file is not open for writing");
     m_impl->write(dataIn, count);
+    if (CaretProfiler::isEnabled()) CaretProfiler::addBytesWritten(count);
 }
 
 #ifdef ZLIB_VERSION
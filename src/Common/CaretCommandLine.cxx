@@ -22,6 +22,7 @@
 #include "ProgramParameters.h"
 
 using namespace caret;
+using namespace std;
 
 AString caret::caret_global_commandLine;
 
@@ -33,7 +34,7 @@ namespace
         {
             caret_global_commandLine += " ";
         }
-        if (param.indexOfAnyChar(" $();&<>\"`*?{|") != -1)//check for things that the shell is likely to treat specially EXCEPT for ' itself - assume bash for now, but ignore some more specialized cases
+        if (param.isEmpty() || param.indexOfAnyChar(" \t\n\r$();&<>\"`*?{|") != -1 || param.startsWith("#"))//check for things that the shell is likely to treat specially EXCEPT for ' itself - assume bash for now, but ignore some more specialized cases
         {//NOTE: not checking for \ or replacing with \\, because it is rare except in windows native paths where it will wreak havok to double it
             if (param.indexOf('\'') != -1)//oh joy, ' also
             {//we COULD check if it is safe to use "", but "" and non-CDATA xml text don't look nice (we avoid CDATA in CIFTI because the matlab GIFTI toolbox at least used to choke on it after conversion)
@@ -60,13 +61,23 @@ void caret::caret_global_commandLine_init(const ProgramParameters& params)
 {
     int32_t numParams = params.getNumberOfParameters();
     caret_global_commandLine = "";
-    add_parameter(params.getProgramName());
+    if (!params.getProgramName().isEmpty()) add_parameter(params.getProgramName());
     for (int32_t i = 0; i < numParams; ++i)
     {
         add_parameter(params.getParameter(i));
     }
 }
 
+void caret::caret_global_commandLine_init(const AString& programName, const vector<AString>& arguments)
+{
+    caret_global_commandLine = "";
+    add_parameter(programName);
+    for (int32_t i = 0; i < (int32_t)arguments.size(); ++i)
+    {
+        add_parameter(arguments[i]);
+    }
+}
+
 void caret::caret_global_commandLine_init(const int& argc, const char *const * argv)
 {
     ProgramParameters params(argc, argv);
@@ -23,6 +23,8 @@
 
 #include "AString.h"
 
+#include <vector>
+
 namespace caret {
     
     class ProgramParameters;
@@ -33,6 +35,9 @@ namespace caret {
     
     void caret_global_commandLine_init(const int& argc, const char *const * argv);
     
+    ///for commands that didn't come from the real command line, such as the lines of a batch script
+    void caret_global_commandLine_init(const AString& programName, const std::vector<AString>& arguments);
+    
 }
 
 #endif //__CARET_COMMAND_LINE_H__
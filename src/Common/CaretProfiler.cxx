@@ -0,0 +1,296 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CaretProfiler.h"
+
+#include "CaretAssert.h"
+#include "CaretCommandLine.h"
+#include "CaretLogger.h"
+#include "CaretMutex.h"
+#include "CaretOMP.h"
+#include "ElapsedTimer.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+
+#include <ctime>
+#include <thread>
+
+#ifdef __GNUC__
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
+
+#ifdef CARET_OS_WINDOWS
+#include "windows.h"
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace caret;
+using namespace std;
+
+bool CaretProfiler::s_enabled = false;
+CaretPointer<CaretProfiler::Section> CaretProfiler::s_root;
+CaretProfiler::Section* CaretProfiler::s_current = NULL;
+
+namespace
+{
+    CaretMutex s_profilerMutex;//guards s_current and the I/O counters, since I/O happens on any thread
+    CaretPointer<ElapsedTimer> s_wallTimer;//not a static object, because CaretObject tracking may not exist yet during static initialization
+    thread::id s_profilingThread;
+    AString s_commandLine;//batch mode changes the global command line for each command
+
+    QJsonObject sectionToJson(const AString& name, const double& wall, const double& cpu, const int64_t& bytesRead, const int64_t& bytesWritten,
+                              const int64_t& seeks, const int64_t& peakResident)
+    {
+        QJsonObject ret;
+        ret["name"] = name;
+        ret["wall_seconds"] = wall;
+        ret["cpu_seconds"] = cpu;
+        ret["bytes_read"] = (double)bytesRead;//QJsonValue has no 64-bit integer, doubles are exact to 2^53
+        ret["bytes_written"] = (double)bytesWritten;
+        ret["seeks"] = (double)seeks;
+        ret["peak_resident_bytes"] = (double)peakResident;
+        return ret;
+    }
+}
+
+CaretProfiler::Section::Section()
+{
+    m_parent = NULL;
+    m_startWall = 0.0;
+    m_startCPU = 0.0;
+    m_wallSeconds = 0.0;
+    m_cpuSeconds = 0.0;
+    m_bytesRead = 0;
+    m_bytesWritten = 0;
+    m_seeks = 0;
+    m_peakResidentBytes = -1;
+    m_stopped = false;
+}
+
+void CaretProfiler::setEnabled(const bool& enabled)
+{
+    CaretMutexLocker locked(&s_profilerMutex);
+    s_enabled = enabled;
+    if (!enabled) return;
+    s_profilingThread = this_thread::get_id();
+    s_commandLine = caret_global_commandLine;
+    s_wallTimer.grabNew(new ElapsedTimer());
+    s_wallTimer->start();
+    s_root.grabNew(new Section());
+    s_root->m_name = "wb_command";
+    s_root->m_startCPU = getProcessCPUSeconds();
+    s_current = s_root;
+}
+
+bool CaretProfiler::isProfilingThread()
+{
+    return this_thread::get_id() == s_profilingThread;
+}
+
+void CaretProfiler::startSection(const AString& name)
+{
+    startSection([name]() { return name; });
+}
+
+void CaretProfiler::startSection(const function<AString()>& nameFunction)
+{
+    if (!s_enabled || !isProfilingThread()) return;
+    nameCurrentSection();//a parent that starts a child is running its own code, so its type is complete
+    CaretPointer<Section> newSection(new Section());
+    newSection->m_nameFunction = nameFunction;
+    newSection->m_startWall = s_wallTimer->getElapsedTimeSeconds();
+    newSection->m_startCPU = getProcessCPUSeconds();
+    CaretMutexLocker locked(&s_profilerMutex);
+    CaretAssert(s_current != NULL);
+    newSection->m_parent = s_current;
+    s_current->m_children.push_back(newSection);
+    s_current = newSection;
+}
+
+void CaretProfiler::nameSection(Section* section)
+{
+    if (section->m_nameFunction)
+    {
+        section->m_name = section->m_nameFunction();
+        section->m_nameFunction = function<AString()>();//don't keep pointers to objects that will be destroyed
+    }
+}
+
+void CaretProfiler::nameCurrentSection()
+{
+    if (!s_enabled || !isProfilingThread()) return;
+    nameSection(s_current);
+}
+
+void CaretProfiler::stopSection(Section* section)
+{
+    if (section->m_nameFunction)
+    {//never found a point where the type was complete
+        section->m_nameFunction = function<AString()>();
+        section->m_name = "unnamed";
+    }
+    section->m_wallSeconds = s_wallTimer->getElapsedTimeSeconds() - section->m_startWall;
+    section->m_cpuSeconds = getProcessCPUSeconds() - section->m_startCPU;
+    section->m_peakResidentBytes = getPeakResidentBytes();
+    section->m_stopped = true;
+    if (section->m_parent != NULL)
+    {
+        section->m_parent->m_bytesRead += section->m_bytesRead;
+        section->m_parent->m_bytesWritten += section->m_bytesWritten;
+        section->m_parent->m_seeks += section->m_seeks;
+    }
+}
+
+void CaretProfiler::stopSection()
+{
+    if (!s_enabled || !isProfilingThread()) return;
+    CaretMutexLocker locked(&s_profilerMutex);
+    CaretAssert(s_current != NULL && s_current != s_root);
+    if (s_current == NULL || s_current == s_root) return;//unbalanced, shouldn't happen
+    stopSection(s_current);
+    s_current = s_current->m_parent;
+}
+
+void CaretProfiler::addBytesRead(const int64_t& bytes)
+{
+    if (!s_enabled) return;
+    CaretMutexLocker locked(&s_profilerMutex);
+    if (s_current != NULL) s_current->m_bytesRead += bytes;
+}
+
+void CaretProfiler::addBytesWritten(const int64_t& bytes)
+{
+    if (!s_enabled) return;
+    CaretMutexLocker locked(&s_profilerMutex);
+    if (s_current != NULL) s_current->m_bytesWritten += bytes;
+}
+
+void CaretProfiler::addSeek()
+{
+    if (!s_enabled) return;
+    CaretMutexLocker locked(&s_profilerMutex);
+    if (s_current != NULL) ++(s_current->m_seeks);
+}
+
+AString CaretProfiler::demangle(const char* typeName)
+{
+#ifdef __GNUC__
+    int status = -1;
+    char* demangled = abi::__cxa_demangle(typeName, NULL, NULL, &status);
+    if (status == 0 && demangled != NULL)
+    {
+        AString ret(demangled);
+        free(demangled);
+        if (ret.startsWith("caret::")) ret = ret.mid(7);
+        return ret;
+    }
+    free(demangled);
+#endif
+    AString ret(typeName);//MSVC names are already readable, other than the prefix
+    if (ret.startsWith("class ")) ret = ret.mid(6);
+    if (ret.startsWith("caret::")) ret = ret.mid(7);
+    return ret;
+}
+
+int64_t CaretProfiler::getPeakResidentBytes()
+{
+#ifdef CARET_OS_WINDOWS
+    return -1;//needs psapi, not worth another library for this
+#else
+    struct rusage myUsage;
+    if (getrusage(RUSAGE_SELF, &myUsage) != 0) return -1;
+#ifdef CARET_OS_MACOSX
+    return myUsage.ru_maxrss;//bytes on mac
+#else
+    return ((int64_t)myUsage.ru_maxrss) * 1024;//kilobytes on linux
+#endif
+#endif
+}
+
+double CaretProfiler::getProcessCPUSeconds()
+{//all threads of the process
+#ifdef CARET_OS_WINDOWS
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime)) return ((double)clock()) / CLOCKS_PER_SEC;
+    uint64_t kernel = (((uint64_t)kernelTime.dwHighDateTime) << 32) | kernelTime.dwLowDateTime;
+    uint64_t user = (((uint64_t)userTime.dwHighDateTime) << 32) | userTime.dwLowDateTime;
+    return (kernel + user) * 1e-7;//100 nanosecond units
+#else
+    struct rusage myUsage;
+    if (getrusage(RUSAGE_SELF, &myUsage) != 0) return ((double)clock()) / CLOCKS_PER_SEC;
+    return myUsage.ru_utime.tv_sec + myUsage.ru_stime.tv_sec + (myUsage.ru_utime.tv_usec + myUsage.ru_stime.tv_usec) * 1e-6;
+#endif
+}
+
+void CaretProfiler::writeReport(const AString& fileName)
+{
+    if (!s_enabled || s_root == NULL) return;
+    {
+        CaretMutexLocker locked(&s_profilerMutex);
+        while (s_current != NULL && s_current != s_root)
+        {//an exception skipped some stops
+            stopSection(s_current);
+            s_current = s_current->m_parent;
+        }
+        stopSection(s_root);
+        s_current = NULL;
+    }
+    function<QJsonObject(const Section*)> toJson = [&toJson](const Section* section) -> QJsonObject
+    {
+        QJsonObject ret = sectionToJson(section->m_name, section->m_wallSeconds, section->m_cpuSeconds, section->m_bytesRead,
+                                        section->m_bytesWritten, section->m_seeks, section->m_peakResidentBytes);
+        if (!section->m_children.empty())
+        {
+            QJsonArray children;
+            for (size_t i = 0; i < section->m_children.size(); ++i)
+            {
+                children.append(toJson(section->m_children[i]));
+            }
+            ret["children"] = children;
+        }
+        return ret;
+    };
+    QJsonObject report;
+    report["command_line"] = s_commandLine;
+    report["date"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+#ifdef CARET_OMP
+    report["threads"] = omp_get_max_threads();
+#else
+    report["threads"] = 1;
+#endif
+    report["cpu_cores"] = QThread::idealThreadCount();
+    report["total"] = toJson(s_root);
+    QFile reportFile(fileName);
+    if (!reportFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        CaretLogSevere("failed to open profile report file '" + fileName + "' for writing");
+    } else {
+        reportFile.write(QJsonDocument(report).toJson());
+        reportFile.close();
+    }
+    s_enabled = false;
+}
@@ -0,0 +1,95 @@
+#ifndef __CARET_PROFILER_H__
+#define __CARET_PROFILER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AString.h"
+#include "CaretPointer.h"
+
+#include <functional>
+#include <stdint.h>
+#include <vector>
+
+namespace caret {
+
+    ///records a tree of timed sections (commands, file reading, algorithms and their sub-algorithms), with the CaretBinaryFile I/O done during each
+    ///everything does nothing until setEnabled(true), sections are only recorded on the thread that enabled profiling,
+    ///I/O done by other threads (parallel file reading, etc) is counted in the enabling thread's current section
+    class CaretProfiler
+    {
+        struct Section
+        {
+            AString m_name;
+            std::function<AString()> m_nameFunction;//for algorithms, whose type can't be found from the base class constructor
+            Section* m_parent;
+            std::vector<CaretPointer<Section> > m_children;
+            double m_startWall, m_startCPU, m_wallSeconds, m_cpuSeconds;
+            int64_t m_bytesRead, m_bytesWritten, m_seeks, m_peakResidentBytes;//I/O includes children once the section stops
+            bool m_stopped;
+            Section();
+        };
+        static bool s_enabled;
+        static CaretPointer<Section> s_root;
+        static Section* s_current;
+        static void stopSection(Section* section);
+        static void nameSection(Section* section);
+        static bool isProfilingThread();
+        CaretProfiler();
+    public:
+        static void setEnabled(const bool& enabled);
+        static bool isEnabled() { return s_enabled; }
+
+        ///start a child of the current section
+        static void startSection(const AString& name);
+        ///start a section whose name is found later, once the object it describes is fully constructed
+        static void startSection(const std::function<AString()>& nameFunction);
+        ///gives the current section its name if it was started with a name function, call when the described object is fully constructed
+        static void nameCurrentSection();
+        ///stops the current section
+        static void stopSection();
+
+        static void addBytesRead(const int64_t& bytes);
+        static void addBytesWritten(const int64_t& bytes);
+        static void addSeek();
+
+        ///readable name of a type from typeid
+        static AString demangle(const char* typeName);
+        static int64_t getPeakResidentBytes();
+        static double getProcessCPUSeconds();
+
+        ///stops any open sections and writes the whole tree as JSON, logs an error instead of throwing, so it can be used during exception cleanup
+        static void writeReport(const AString& fileName);
+    };
+
+    ///starts a section on construction and stops it on destruction, so that sections end even when an exception is thrown
+    class CaretProfilerSection
+    {
+        bool m_started;
+        CaretProfilerSection(const CaretProfilerSection&);
+        CaretProfilerSection& operator=(const CaretProfilerSection&);
+    public:
+        CaretProfilerSection(const AString& name) : m_started(CaretProfiler::isEnabled()) { if (m_started) CaretProfiler::startSection(name); }
+        ~CaretProfilerSection() { if (m_started) CaretProfiler::stopSection(); }
+    };
+
+}
+
+#endif //__CARET_PROFILER_H__
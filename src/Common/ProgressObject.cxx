@@ -20,6 +20,7 @@
 
 #include "ProgressObject.h"
 #include "CaretAssert.h"
+#include "CaretProfiler.h"
 #include "EventProgressUpdate.h"
 #include "EventManager.h"
 
@@ -118,6 +119,7 @@ ProgressObject::ProgressObject(const float weight, const float childResolution)
 LevelProgress::LevelProgress(ProgressObject* myProgObj, const float finishedProgress, const float internalWeight, const float internalResolution)
 {
     CaretAssertMessage(internalWeight > 0.0f, "nonpositive weight in ProgressObject::startLevel");
+    CaretProfiler::nameCurrentSection();//algorithms make a LevelProgress in their constructor, where their type is complete
     m_lastReported = 0.0f;
     m_maximum = finishedProgress;
     m_progObjRef = myProgObj;
@@ -28,19 +28,51 @@
 
 #include <QByteArray>
 
+#include <cstring>
+
 using namespace caret;
 using namespace std;
 
 const char magic[] = "\0\0\0\0cst\0";
 
+namespace
+{
+    const int64_t DEFAULT_FIBERS_CACHE_BYTES = 256 * 1024 * 1024;
+}
+
+CaretSparseFile::CaretSparseFile()
+{
+    m_mappedValues = NULL;
+    m_dims[0] = 0;
+    m_dims[1] = 0;
+    m_valuesOffset = 0;
+    m_cacheBytes = 0;
+    m_cacheLimitBytes = DEFAULT_FIBERS_CACHE_BYTES;
+}
+
 CaretSparseFile::CaretSparseFile(const AString& fileName)
 {
+    m_mappedValues = NULL;
+    m_cacheBytes = 0;
+    m_cacheLimitBytes = DEFAULT_FIBERS_CACHE_BYTES;
     readFile(fileName);
 }
 
+void CaretSparseFile::unmapFile()
+{
+    if (m_mappedValues != NULL)
+    {
+        m_mappedFile.unmap((uchar*)m_mappedValues);
+        m_mappedValues = NULL;
+    }
+    m_mappedFile.close();
+}
+
 void CaretSparseFile::readFile(const AString& filename)
 {
     m_file.close();
+    unmapFile();
+    clearFibersCache();
     if (filename.endsWith(".gz"))
     {
         throw DataFileException("wbsparse files cannot be read while compressed");
@@ -94,109 +126,256 @@ void CaretSparseFile::readFile(const AString& filename)
     {
         throw DataFileException("cifti XML doesn't match dimensions of sparse file");
     }
+    int64_t valuesBytes = m_indexArray[m_dims[1]] * 2 * sizeof(int64_t);
+    if (valuesBytes > 0)
+    {//the offset is a multiple of 8, so the mapped pointer is aligned for int64_t
+        m_mappedFile.setFileName(filename);
+        if (m_mappedFile.open(QIODevice::ReadOnly))
+        {
+            m_mappedValues = (const int64_t*)m_mappedFile.map(m_valuesOffset, valuesBytes);
+        }
+        if (m_mappedValues == NULL)
+        {
+            m_mappedFile.close();
+            CaretLogFine("unable to memory map sparse file '" + filename + "', using file reads instead");
+        } else {
+            m_file.close();
+        }
+    }
 }
 
 CaretSparseFile::~CaretSparseFile()
 {
+    unmapFile();
 }
 
-void CaretSparseFile::getRow(const int64_t& index, int64_t* rowOut)
+void CaretSparseFile::readRowPairs(const int64_t& index, CaretSparseRowView& viewOut) const
 {
     CaretAssert(index >= 0 && index < m_dims[1]);
     int64_t start = m_indexArray[index], end = m_indexArray[index + 1];
     int64_t numToRead = (end - start) * 2;
-    m_scratchArray.resize(numToRead);
-    m_file.seek(m_valuesOffset + start * sizeof(int64_t) * 2);
-    m_file.read(m_scratchArray.data(), numToRead * sizeof(int64_t));
-    if (ByteOrderEnum::isSystemBigEndian())
+    viewOut.m_numNonzero = end - start;
+    if (m_mappedValues != NULL && !ByteOrderEnum::isSystemBigEndian())
+    {
+        viewOut.m_data = m_mappedValues + start * 2;
+    } else {
+        viewOut.m_storage.resize(numToRead);
+        if (m_mappedValues != NULL)
+        {
+            memcpy(viewOut.m_storage.data(), m_mappedValues + start * 2, numToRead * sizeof(int64_t));
+        } else {
+            CaretMutexLocker locked(&m_fileMutex);//seek and read must not be interleaved between threads
+            m_file.seek(m_valuesOffset + start * sizeof(int64_t) * 2);
+            m_file.read(viewOut.m_storage.data(), numToRead * sizeof(int64_t));
+        }
+        if (ByteOrderEnum::isSystemBigEndian())
+        {
+            ByteSwapping::swapBytes(viewOut.m_storage.data(), numToRead);
+        }
+        viewOut.m_data = viewOut.m_storage.data();
+    }
+    int64_t lastIndex = -1;
+    for (int64_t i = 0; i < viewOut.m_numNonzero; ++i)
+    {
+        int64_t thisIndex = viewOut.getIndex(i);
+        if (thisIndex <= lastIndex || thisIndex >= m_dims[0]) throw DataFileException("impossible index value found in file");
+        lastIndex = thisIndex;
+    }
+}
+
+void CaretSparseFile::getRowView(const int64_t& index, CaretSparseRowView& viewOut) const
+{
+    readRowPairs(index, viewOut);
+}
+
+void CaretSparseFile::getRow(const int64_t& index, int64_t* rowOut) const
+{
+    CaretSparseRowView myView;
+    readRowPairs(index, myView);
+    for (int64_t i = 0; i < m_dims[0]; ++i)
+    {
+        rowOut[i] = 0;
+    }
+    int64_t numNonzero = myView.getNumberOfNonzero();
+    for (int64_t i = 0; i < numNonzero; ++i)
+    {
+        rowOut[myView.getIndex(i)] = myView.getValue(i);
+    }
+}
+
+void CaretSparseFile::getRowSparse(const int64_t& index, vector<int64_t>& indicesOut, vector<int64_t>& valuesOut) const
+{
+    CaretSparseRowView myView;
+    readRowPairs(index, myView);
+    int64_t numNonzero = myView.getNumberOfNonzero();
+    indicesOut.resize(numNonzero);
+    valuesOut.resize(numNonzero);
+    for (int64_t i = 0; i < numNonzero; ++i)
     {
-        ByteSwapping::swapBytes(m_scratchArray.data(), numToRead);
+        indicesOut[i] = myView.getIndex(i);
+        valuesOut[i] = myView.getValue(i);
     }
-    int64_t curIndex = 0;
-    for (int64_t i = 0; i < numToRead; i += 2)
+}
+
+void CaretSparseFile::getFibersRow(const int64_t& index, FiberFractions* rowOut) const
+{
+    CaretSparseRowView myView;
+    readRowPairs(index, myView);
+    int64_t numNonzero = myView.getNumberOfNonzero(), curIndex = 0;
+    for (int64_t i = 0; i < numNonzero; ++i)
     {
-        int64_t index = m_scratchArray[i];
-        if (index < curIndex || index >= m_dims[0]) throw DataFileException("impossible index value found in file");
-        while (curIndex < index)
+        int64_t thisIndex = myView.getIndex(i);
+        while (curIndex < thisIndex)
         {
-            rowOut[curIndex] = 0;
+            rowOut[curIndex].zero();
             ++curIndex;
         }
+        int64_t value = myView.getValue(i);
+        if (value == 0)
+        {
+            rowOut[thisIndex].zero();
+        } else {
+            decodeFibers((uint64_t)value, rowOut[thisIndex]);
+        }
         ++curIndex;
-        rowOut[index] = m_scratchArray[i + 1];
     }
     while (curIndex < m_dims[0])
     {
-        rowOut[curIndex] = 0;
+        rowOut[curIndex].zero();
         ++curIndex;
     }
 }
 
-void CaretSparseFile::getRowSparse(const int64_t& index, vector<int64_t>& indicesOut, vector<int64_t>& valuesOut)
+void CaretSparseFile::getFibersRowSparse(const int64_t& index, vector<int64_t>& indicesOut, vector<FiberFractions>& valuesOut) const
 {
-    CaretAssert(index >= 0 && index < m_dims[1]);
-    int64_t start = m_indexArray[index], end = m_indexArray[index + 1];
-    int64_t numToRead = (end - start) * 2, numNonzero = end - start;
-    m_scratchArray.resize(numToRead);
-    m_file.seek(m_valuesOffset + start * sizeof(int64_t) * 2);
-    m_file.read(m_scratchArray.data(), numToRead * sizeof(int64_t));
-    if (ByteOrderEnum::isSystemBigEndian())
-    {
-        ByteSwapping::swapBytes(m_scratchArray.data(), numToRead);
-    }
+    CaretSparseRowView myView;
+    readRowPairs(index, myView);
+    int64_t numNonzero = myView.getNumberOfNonzero();
     indicesOut.resize(numNonzero);
     valuesOut.resize(numNonzero);
-    int64_t lastIndex = -1;
     for (int64_t i = 0; i < numNonzero; ++i)
     {
-        indicesOut[i] = m_scratchArray[i * 2];
-        valuesOut[i] = m_scratchArray[i * 2 + 1];
-        if (indicesOut[i] <= lastIndex || indicesOut[i] >= m_dims[0]) throw DataFileException("impossible index value found in file");
-        lastIndex = indicesOut[i];
+        indicesOut[i] = myView.getIndex(i);
+        decodeFibers((uint64_t)myView.getValue(i), valuesOut[i]);
     }
 }
 
-void CaretSparseFile::getFibersRow(const int64_t& index, FiberFractions* rowOut)
+CaretPointer<const FiberFractionsRow> CaretSparseFile::getFibersRowSparseCached(const int64_t& index) const
 {
-    if (m_scratchRow.size() != (size_t)m_dims[0]) m_scratchRow.resize(m_dims[0]);
-    getRow(index, (int64_t*)m_scratchRow.data());
-    for (int64_t i = 0; i < m_dims[0]; ++i)
     {
-        if (m_scratchRow[i] == 0)
+        CaretMutexLocker locked(&m_cacheMutex);
+        map<int64_t, CacheEntry>::iterator iter = m_fibersCache.find(index);
+        if (iter != m_fibersCache.end())
         {
-            rowOut[i].zero();
-        } else {
-             decodeFibers(m_scratchRow[i], rowOut[i]);
+            m_fibersLru.splice(m_fibersLru.begin(), m_fibersLru, iter->second.m_lruPosition);
+            return iter->second.m_row;
         }
     }
+    CaretPointer<FiberFractionsRow> newRow;
+    newRow.grabNew(new FiberFractionsRow());
+    getFibersRowSparse(index, newRow->indices, newRow->fibers);//decode without holding the lock, so other rows can be read meanwhile
+    CaretPointer<const FiberFractionsRow> ret = newRow;
+    int64_t rowBytes = sizeof(FiberFractionsRow) + (int64_t)newRow->indices.size() * (sizeof(int64_t) + sizeof(FiberFractions) + 3 * sizeof(float));
+    CaretMutexLocker locked(&m_cacheMutex);
+    if (rowBytes > m_cacheLimitBytes) return ret;
+    map<int64_t, CacheEntry>::iterator iter = m_fibersCache.find(index);
+    if (iter != m_fibersCache.end()) return iter->second.m_row;//another thread got here first
+    m_fibersLru.push_front(index);
+    CacheEntry& newEntry = m_fibersCache[index];
+    newEntry.m_row = ret;
+    newEntry.m_lruPosition = m_fibersLru.begin();
+    newEntry.m_bytes = rowBytes;
+    m_cacheBytes += rowBytes;
+    while (m_cacheBytes > m_cacheLimitBytes)
+    {
+        map<int64_t, CacheEntry>::iterator oldest = m_fibersCache.find(m_fibersLru.back());
+        CaretAssert(oldest != m_fibersCache.end());
+        m_cacheBytes -= oldest->second.m_bytes;
+        m_fibersCache.erase(oldest);
+        m_fibersLru.pop_back();
+    }
+    return ret;
 }
 
-void CaretSparseFile::getFibersRowSparse(const int64_t& index, vector<int64_t>& indicesOut, vector<FiberFractions>& valuesOut)
+void CaretSparseFile::setFibersRowCacheSize(const int64_t& maxBytes)
 {
-    getRowSparse(index, indicesOut, m_scratchSparseRow);
-    size_t numNonzero = m_scratchSparseRow.size();
-    valuesOut.resize(numNonzero);
-    for (size_t i = 0; i < numNonzero; ++i)
+    CaretMutexLocker locked(&m_cacheMutex);
+    m_cacheLimitBytes = maxBytes;
+    while (m_cacheBytes > m_cacheLimitBytes && !m_fibersLru.empty())
     {
-        decodeFibers(((uint64_t*)m_scratchSparseRow.data())[i], valuesOut[i]);
+        map<int64_t, CacheEntry>::iterator oldest = m_fibersCache.find(m_fibersLru.back());
+        CaretAssert(oldest != m_fibersCache.end());
+        m_cacheBytes -= oldest->second.m_bytes;
+        m_fibersCache.erase(oldest);
+        m_fibersLru.pop_back();
     }
 }
 
+void CaretSparseFile::clearFibersCache()
+{
+    CaretMutexLocker locked(&m_cacheMutex);
+    m_fibersCache.clear();
+    m_fibersLru.clear();
+    m_cacheBytes = 0;
+}
+
 void CaretSparseFile::decodeFibers(const uint64_t& coded, FiberFractions& decoded)
 {
     decoded.fiberFractions.resize(3);
-    decoded.totalCount = coded>>32;
+    decodeFibers(coded, decoded.totalCount, decoded.fiberFractions.data(), decoded.distance);
+}
+
+void CaretSparseFile::decodeFibers(const uint64_t& coded, uint32_t& totalCountOut, float fractionsOut[3], float& distanceOut)
+{
+    totalCountOut = coded>>32;
     uint32_t temp = coded & ((1LL<<32) - 1);
     const static uint32_t MASK = ((1<<10) - 1);
-    decoded.distance = (temp & MASK);
-    decoded.fiberFractions[1] = ((temp>>10) & MASK) / 1000.0f;
-    decoded.fiberFractions[0] = ((temp>>20) & MASK) / 1000.0f;
-    decoded.fiberFractions[2] = 1.0f - decoded.fiberFractions[0] - decoded.fiberFractions[1];
-    if (decoded.fiberFractions[2] < -0.002f || (temp & (3<<30)))
+    distanceOut = (temp & MASK);
+    fractionsOut[1] = ((temp>>10) & MASK) / 1000.0f;
+    fractionsOut[0] = ((temp>>20) & MASK) / 1000.0f;
+    fractionsOut[2] = 1.0f - fractionsOut[0] - fractionsOut[1];
+    if (fractionsOut[2] < -0.002f || (temp & (3<<30)))
     {
         throw DataFileException("error decoding value '" + AString::number(coded) + "' from workbench sparse trajectory file");
     }
-    if (decoded.fiberFractions[2] < 0.0f) decoded.fiberFractions[2] = 0.0f;
+    if (fractionsOut[2] < 0.0f) fractionsOut[2] = 0.0f;
+}
+
+void CaretSparseFile::addFibersRowToSums(const int64_t& index, FiberFractionsSums& sums) const
+{
+    CaretAssert((int64_t)sums.totalCount.size() == m_dims[0]);
+    CaretSparseRowView myView;
+    readRowPairs(index, myView);
+    const int64_t numNonzero = myView.getNumberOfNonzero();
+    double* totalCountSum = sums.totalCount.data();
+    double* distanceSum = sums.distance.data();
+    double* countSums[3] = { sums.fiberCounts[0].data(), sums.fiberCounts[1].data(), sums.fiberCounts[2].data() };
+    for (int64_t i = 0; i < numNonzero; ++i)
+    {
+        uint32_t totalCount;
+        float fractions[3], distance;
+        decodeFibers((uint64_t)myView.getValue(i), totalCount, fractions, distance);
+        if (totalCount == 0) continue;//these only count toward the number of rows, like in FiberOrientationTrajectory::addFiberFractionsForAveraging
+        const int64_t column = myView.getIndex(i);
+        totalCountSum[column] += totalCount;
+        for (int j = 0; j < 3; ++j)
+        {
+            countSums[j][column] += fractions[j] * totalCount;
+        }
+        distanceSum[column] += distance;
+    }
+    ++sums.numRows;
+}
+
+void FiberFractionsSums::resize(const int64_t& numColumns)
+{
+    totalCount.assign(numColumns, 0.0);
+    distance.assign(numColumns, 0.0);
+    for (int j = 0; j < 3; ++j)
+    {
+        fiberCounts[j].assign(numColumns, 0.0);
+    }
+    numRows = 0;
 }
 
 void FiberFractions::zero()
@@ -206,11 +385,19 @@ void FiberFractions::zero()
     distance = 0.0f;
 }
 
-CaretSparseFileWriter::CaretSparseFileWriter(const AString& fileName, const CiftiXML& xml)
+CaretSparseFileWriter::CaretSparseFileWriter(const AString& fileName, const CiftiXML& xml, const bool& trajectory)
 {
-    if (!fileName.endsWith(".trajTEMP.wbsparse"))
-    {//for now (and maybe forever), this format is single-purpose
-        CaretLogWarning("sparse trajectory file '" + fileName + "' should be saved ending in .trajTEMP.wbsparse");
+    if (trajectory)
+    {
+        if (!fileName.endsWith(".trajTEMP.wbsparse"))
+        {//for now (and maybe forever), trajectories are the main purpose of this format
+            CaretLogWarning("sparse trajectory file '" + fileName + "' should be saved ending in .trajTEMP.wbsparse");
+        }
+    } else {
+        if (!fileName.endsWith(".wbsparse"))
+        {
+            CaretLogWarning("sparse file '" + fileName + "' should be saved ending in .wbsparse");
+        }
     }
     m_finished = false;
     int64_t dimensions[2] = { xml.getDimensionLength(CiftiXML::ALONG_ROW), xml.getDimensionLength(CiftiXML::ALONG_COLUMN) };
@@ -21,11 +21,17 @@
  */
 /*LICENSE_END*/
 
+#include <list>
+#include <map>
 #include <vector>
 #include "stdint.h"
 
+#include <QFile>
+
 #include "AString.h"
 #include "CaretBinaryFile.h"
+#include "CaretMutex.h"
+#include "CaretPointer.h"
 #include "CiftiXML.h"
 #include "DataFile.h"
 #include "DataFileException.h"
@@ -40,19 +46,72 @@ namespace caret {
         void zero();
     };
     
+    ///decoded sparse row of fiber fractions, as stored in the row cache
+    struct FiberFractionsRow
+    {
+        std::vector<int64_t> indices;
+        std::vector<FiberFractions> fibers;
+    };
+    
+    ///sums of fiber fractions over several rows, one array per field rather than a FiberFractions per column, for averaging trajectories
+    struct FiberFractionsSums
+    {
+        std::vector<double> totalCount, fiberCounts[3], distance;//fiberCounts are the fractions times totalCount
+        int64_t numRows;
+        FiberFractionsSums() : numRows(0) { }
+        void resize(const int64_t& numColumns);//also zeroes
+    };
+    
+    ///the nonzero elements of one row, pointing directly into the memory-mapped file when possible
+    ///only valid until the file it came from is destroyed or reads another file
+    class CaretSparseRowView
+    {
+        const int64_t* m_data;//index, value pairs
+        int64_t m_numNonzero;
+        std::vector<int64_t> m_storage;//used when the file couldn't be mapped, or needs byteswapping
+        CaretSparseRowView(const CaretSparseRowView&);
+        CaretSparseRowView& operator=(const CaretSparseRowView&);
+        friend class CaretSparseFile;
+    public:
+        CaretSparseRowView() { m_data = NULL; m_numNonzero = 0; }
+        int64_t getNumberOfNonzero() const { return m_numNonzero; }
+        int64_t getIndex(const int64_t& i) const { return m_data[i * 2]; }
+        int64_t getValue(const int64_t& i) const { return m_data[i * 2 + 1]; }
+    };
+    
+    ///all row reading functions are const and may be called from multiple threads at once
     class CaretSparseFile /* : public DataFile */
     {
         static void decodeFibers(const uint64_t& coded, FiberFractions& decoded);//takes a uint because right shift on signed is implementation dependent
-        CaretBinaryFile m_file;
+        static void decodeFibers(const uint64_t& coded, uint32_t& totalCountOut, float fractionsOut[3], float& distanceOut);
+        mutable CaretBinaryFile m_file;//only used when mapping fails
+        mutable CaretMutex m_fileMutex;
+        QFile m_mappedFile;
+        const int64_t* m_mappedValues;
         int64_t m_dims[2], m_valuesOffset;
-        std::vector<uint64_t> m_indexArray, m_scratchRow;
-        std::vector<int64_t> m_scratchArray, m_scratchSparseRow;
+        std::vector<uint64_t> m_indexArray;
         CaretSparseFile(const CaretSparseFile& rhs);
         CiftiXML m_xml;
+        
+        struct CacheEntry
+        {
+            CaretPointer<const FiberFractionsRow> m_row;
+            std::list<int64_t>::iterator m_lruPosition;
+            int64_t m_bytes;
+        };
+        mutable CaretMutex m_cacheMutex;
+        mutable std::map<int64_t, CacheEntry> m_fibersCache;
+        mutable std::list<int64_t> m_fibersLru;//most recently used at the front
+        mutable int64_t m_cacheBytes;
+        int64_t m_cacheLimitBytes;
+        
+        void readRowPairs(const int64_t& index, CaretSparseRowView& viewOut) const;
+        void unmapFile();
+        void clearFibersCache();
     public:
-        const int64_t* getDimensions() { return m_dims; }
+        const int64_t* getDimensions() const { return m_dims; }
 
-        CaretSparseFile() {};
+        CaretSparseFile();
         
         virtual void readFile(const AString& filename);
         
@@ -63,13 +122,28 @@ namespace caret {
         ///get a reference to the XML data
         const CiftiXML& getCiftiXML() const { return m_xml; }
         
-        void getRow(const int64_t& index, int64_t* rowOut);
+        ///whether rows are read from a memory mapping rather than by seeking
+        bool isMemoryMapped() const { return m_mappedValues != NULL; }
         
-        void getRowSparse(const int64_t& index, std::vector<int64_t>& indicesOut, std::vector<int64_t>& valuesOut);
+        void getRow(const int64_t& index, int64_t* rowOut) const;
+        
+        void getRowSparse(const int64_t& index, std::vector<int64_t>& indicesOut, std::vector<int64_t>& valuesOut) const;
+        
+        ///no copying when the file is mapped and little endian
+        void getRowView(const int64_t& index, CaretSparseRowView& viewOut) const;
 
-        void getFibersRow(const int64_t& index, FiberFractions* rowOut);
+        void getFibersRow(const int64_t& index, FiberFractions* rowOut) const;
+        
+        void getFibersRowSparse(const int64_t& index, std::vector<int64_t>& indicesOut, std::vector<FiberFractions>& valuesOut) const;
+        
+        ///adds the entries of one row with a nonzero total count, only touching those columns, and counts the row
+        void addFibersRowToSums(const int64_t& index, FiberFractionsSums& sums) const;
+        
+        ///decodes through a bounded least recently used cache, for repeated access to the same rows
+        CaretPointer<const FiberFractionsRow> getFibersRowSparseCached(const int64_t& index) const;
         
-        void getFibersRowSparse(const int64_t& index, std::vector<int64_t>& indicesOut, std::vector<FiberFractions>& valuesOut);
+        ///approximate memory limit for the decoded row cache, 0 disables it
+        void setFibersRowCacheSize(const int64_t& maxBytes);
 
         virtual ~CaretSparseFile();
     };
@@ -86,7 +160,8 @@ namespace caret {
         CaretSparseFileWriter(const CaretSparseFileWriter& rhs);
         CiftiXML m_xml;
     public:
-        CaretSparseFileWriter(const AString& fileName, const CiftiXML& xml);
+        ///trajectory files should end in .trajTEMP.wbsparse, other sparse matrices (like -probtrackx-dot-convert counts) just in .wbsparse
+        CaretSparseFileWriter(const AString& fileName, const CiftiXML& xml, const bool& trajectory = true);
         
         ~CaretSparseFileWriter();
         
@@ -29,6 +29,7 @@
 #include "PaletteColorMappingXmlElements.h"
 #include "PaletteNormalizationModeEnum.h"
 #include "CaretLogger.h"
+#include "CaretMutex.h"
 #include "XmlUnexpectedElementSaxParser.h"
 #include <ctime>
 
@@ -56,6 +57,8 @@ CaretVolumeExtension::clear() {
 
 void CaretVolumeExtension::readFromXmlString(const AString& s)
 {
+    static CaretMutex parseMutex;//volumes can be read in parallel, and the SAX parser hasn't been checked for thread safety
+    CaretMutexLocker locked(&parseMutex);
     CaretVolumeExtensionXMLReader myReader(this);
     CaretPointer<XmlSaxParser> myParser(XmlSaxParser::createXmlParser());
     try
@@ -435,6 +435,73 @@ ChartableTwoFileMatrixChart::getMatrixChartGraphicsPrimitiveGridColorIdentifier(
     return ciftiMapFile->getMatrixChartGraphicsPrimitiveGridColorIdentifier();
 }
 
+/**
+ * @return True if the matrix is too large to chart with a cell for every
+ * element, so the part in view is charted at a level of detail that fits the view.
+ */
+bool
+ChartableTwoFileMatrixChart::isMatrixChartingLevelOfDetailUsed() const
+{
+    const CiftiMappableDataFile* ciftiMapFile = getCiftiMappableDataFile();
+    CaretAssert(ciftiMapFile);
+    
+    return ciftiMapFile->isMatrixChartingLevelOfDetailUsed();
+}
+
+/**
+ * @return The graphics primitive for the part of a large matrix that is in view.
+ * Cells use the same coordinates as getMatrixChartingGraphicsPrimitive().
+ *
+ * @param matrixViewMode
+ *     The matrix visualization mode (upper/lower).
+ * @param gridMode
+ *     The grid mode (filled or outline)
+ * @param viewBounds
+ *     Part of the matrix in view (minimum X, maximum X, minimum Y, maximum Y).
+ * @param cellsPerPixel
+ *     Number of matrix cells in one pixel of the view.
+ */
+GraphicsPrimitiveV3fC4f*
+ChartableTwoFileMatrixChart::getMatrixChartingGraphicsPrimitiveForView(const ChartTwoMatrixTriangularViewingModeEnum::Enum matrixViewMode,
+                                                                       const CiftiMappableDataFile::MatrixGridMode gridMode,
+                                                                       const float viewBounds[4],
+                                                                       const float cellsPerPixel) const
+{
+    const CiftiMappableDataFile* ciftiMapFile = getCiftiMappableDataFile();
+    CaretAssert(ciftiMapFile);
+    
+    return ciftiMapFile->getMatrixChartingGraphicsPrimitiveForView(matrixViewMode,
+                                                                   gridMode,
+                                                                   viewBounds,
+                                                                   cellsPerPixel);
+}
+
+/**
+ * Get the matrix row and column for a cell of the primitive for the part of
+ * a large matrix that is in view.
+ *
+ * @param cellIndex
+ *     Index of the cell in the primitive.
+ * @param rowIndexOut
+ *     Output with index of row.
+ * @param columnIndexOut
+ *     Output with index of column.
+ * @return
+ *     True if the outputs are valid, else false.
+ */
+bool
+ChartableTwoFileMatrixChart::getMatrixChartingForViewRowAndColumn(const int32_t cellIndex,
+                                                                  int32_t& rowIndexOut,
+                                                                  int32_t& columnIndexOut) const
+{
+    const CiftiMappableDataFile* ciftiMapFile = getCiftiMappableDataFile();
+    CaretAssert(ciftiMapFile);
+    
+    return ciftiMapFile->getMatrixChartingForViewRowAndColumn(cellIndex,
+                                                              rowIndexOut,
+                                                              columnIndexOut);
+}
+
 /**
  * @return The selected row/column dimension.
  */
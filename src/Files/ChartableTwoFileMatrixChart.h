@@ -64,6 +64,17 @@ namespace caret {
         
         int32_t getMatrixChartGraphicsPrimitiveGridColorIdentifier() const;
         
+        bool isMatrixChartingLevelOfDetailUsed() const;
+        
+        GraphicsPrimitiveV3fC4f* getMatrixChartingGraphicsPrimitiveForView(const ChartTwoMatrixTriangularViewingModeEnum::Enum matrixViewMode,
+                                                                           const CiftiMappableDataFile::MatrixGridMode gridMode,
+                                                                           const float viewBounds[4],
+                                                                           const float cellsPerPixel) const;
+        
+        bool getMatrixChartingForViewRowAndColumn(const int32_t cellIndex,
+                                                  int32_t& rowIndexOut,
+                                                  int32_t& columnIndexOut) const;
+        
         bool isMatrixTriangularViewingModeSupported() const;
 
         // ADD_NEW_METHODS_HERE
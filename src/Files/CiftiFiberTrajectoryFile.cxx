@@ -1222,9 +1222,9 @@ CiftiFiberTrajectoryFile::loadDataForSurfaceNode(const StructureEnum::Enum struc
         }
     }
     else {
-        m_sparseFile->getFibersRowSparse(rowIndex,
-                                         fiberIndices,
-                                         fiberFractions);
+        const CaretPointer<const FiberFractionsRow> fibersRow = m_sparseFile->getFibersRowSparseCached(rowIndex);
+        fiberIndices = fibersRow->indices;
+        fiberFractions = fibersRow->fibers;
     }
     CaretAssert(fiberIndices.size() == fiberFractions.size());
 
@@ -1389,9 +1389,6 @@ CiftiFiberTrajectoryFile::loadRowsForAveraging(const std::vector<int64_t>& rowIn
     const CiftiXML& trajXML = m_sparseFile->getCiftiXML();
     const int64_t numberOfColumns = trajXML.getDimensionLength(CiftiXML::ALONG_ROW);
     
-    std::vector<FiberFractions> fiberFractionsForRowVector(numberOfColumns);
-    FiberFractions* fiberFractionsForRow = &fiberFractionsForRowVector[0];
-    
     const int64_t numberOfRowsToLoad = static_cast<int64_t>(rowIndices.size());
     if (numberOfRowsToLoad <= 0) {
         return false;
@@ -1414,6 +1411,14 @@ CiftiFiberTrajectoryFile::loadRowsForAveraging(const std::vector<int64_t>& rowIn
                                                                                 fiberOrientation));
     }
     
+    /*
+     * Sum only the nonzero entries of each sparse row into one array per
+     * field, instead of decoding every row into a FiberFractions for every
+     * column and adding each of them to its trajectory.
+     */
+    FiberFractionsSums fiberFractionsSums;
+    fiberFractionsSums.resize(numberOfColumns);
+    
     bool userCancelled = false;
     
     for (int64_t iRow = 0; iRow < numberOfRowsToLoad; iRow++) {
@@ -1429,13 +1434,8 @@ CiftiFiberTrajectoryFile::loadRowsForAveraging(const std::vector<int64_t>& rowIn
             }
         }
         
-        m_sparseFile->getFibersRow(rowIndex,
-                                   fiberFractionsForRow);
-        
-        for (int64_t iCol = 0; iCol < numberOfColumns; iCol++) {
-            FiberOrientationTrajectory* fot = m_fiberOrientationTrajectories[iCol];
-            fot->addFiberFractionsForAveraging(fiberFractionsForRow[iCol]);
-        }
+        m_sparseFile->addFibersRowToSums(rowIndex,
+                                         fiberFractionsSums);
     }
     
     if (userCancelled) {
@@ -1443,6 +1443,18 @@ CiftiFiberTrajectoryFile::loadRowsForAveraging(const std::vector<int64_t>& rowIn
         return false;
     }
     
+    for (int64_t iCol = 0; iCol < numberOfColumns; iCol++) {
+        const double fiberCountsSum[3] = {
+            fiberFractionsSums.fiberCounts[0][iCol],
+            fiberFractionsSums.fiberCounts[1][iCol],
+            fiberFractionsSums.fiberCounts[2][iCol]
+        };
+        m_fiberOrientationTrajectories[iCol]->setSumsForAveraging(fiberFractionsSums.totalCount[iCol],
+                                                                  fiberCountsSum,
+                                                                  fiberFractionsSums.distance[iCol],
+                                                                  fiberFractionsSums.numRows);
+    }
+    
     finishFiberOrientationTrajectoriesAveraging();
     
     return true;
@@ -1490,11 +1502,9 @@ CiftiFiberTrajectoryFile::loadMapDataForVoxelAtCoordinate(const float xyz[3])
         return -1;
     }
     
-    std::vector<int64_t> fiberIndices;
-    std::vector<FiberFractions> fiberFractions;
-    m_sparseFile->getFibersRowSparse(rowIndex,
-                                     fiberIndices,
-                                     fiberFractions);
+    const CaretPointer<const FiberFractionsRow> fibersRow = m_sparseFile->getFibersRowSparseCached(rowIndex);
+    const std::vector<int64_t>& fiberIndices = fibersRow->indices;
+    const std::vector<FiberFractions>& fiberFractions = fibersRow->fibers;
     CaretAssert(fiberIndices.size() == fiberFractions.size());
     
     const int64_t numFibers = static_cast<int64_t>(fiberIndices.size());
@@ -1617,11 +1627,9 @@ CiftiFiberTrajectoryFile::loadDataForRowIndex(const int64_t rowIndex)
     
     validateAssignedMatchingFiberOrientationFile();
     
-    std::vector<int64_t> fiberIndices;
-    std::vector<FiberFractions> fiberFractions;
-    m_sparseFile->getFibersRowSparse(rowIndex,
-                                     fiberIndices,
-                                     fiberFractions);
+    const CaretPointer<const FiberFractionsRow> fibersRow = m_sparseFile->getFibersRowSparseCached(rowIndex);
+    const std::vector<int64_t>& fiberIndices = fibersRow->indices;
+    const std::vector<FiberFractions>& fiberFractions = fibersRow->fibers;
     CaretAssert(fiberIndices.size() == fiberFractions.size());
     
     const int64_t numFibers = static_cast<int64_t>(fiberIndices.size());
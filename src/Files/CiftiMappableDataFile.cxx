@@ -18,6 +18,8 @@
  */
 /*LICENSE_END*/
 
+#include <algorithm>
+#include <cmath>
 #include <set>
 
 #define __CIFTI_MAPPABLE_DATA_FILE_DECLARE__
@@ -36,6 +38,7 @@
 #include "CiftiFiberTrajectoryFile.h"
 #include "CiftiFile.h"
 #include "CiftiMappableConnectivityMatrixDataFile.h"
+#include "CiftiMatrixPyramid.h"
 #include "CiftiParcelLabelFile.h"
 #include "CiftiParcelReordering.h"
 #include "CiftiParcelScalarFile.h"
@@ -52,11 +55,13 @@
 #include "FileInformation.h"
 #include "GiftiLabel.h"
 #include "GiftiLabelTable.h"
+#include "GiftiLabelTableLookup.h"
 #include "GiftiMetaData.h"
 #include "GraphicsPrimitiveV3fC4f.h"
 #include "GroupAndNameHierarchyModel.h"
 #include "Histogram.h"
 #include "MapFileDataSelector.h"
+#include "MathFunctions.h"
 #include "NodeAndVoxelColoring.h"
 #include "PaletteColorMapping.h"
 #include "PaletteFile.h"
@@ -460,6 +465,9 @@ CiftiMappableDataFile::clearPrivate()
      */
     
     m_ciftiFile.grabNew(NULL);
+    m_matrixChartingPyramid.grabNew(NULL);
+    m_matrixChartingPyramidRowIndices.clear();
+    invalidateMatrixChartingViewPrimitives();
     
     resetDataLoadingMembers();
     
@@ -1378,6 +1386,12 @@ CiftiMappableDataFile::updateForChangeInMapDataWithMapIndex(const int32_t mapInd
 {
     CaretAssertVectorIndex(m_mapContent, mapIndex);
     m_mapContent[mapIndex]->updateForChangeInMapData();
+    
+    /*
+     * Pooled levels of detail are no longer valid
+     */
+    m_matrixChartingPyramid.grabNew(NULL);
+    invalidateMatrixChartingViewPrimitives();
 }
 
 
@@ -1399,6 +1413,7 @@ CiftiMappableDataFile::invalidateColoringInAllMaps()
      */
     m_matrixGraphicsPrimitive.reset();
     m_matrixGraphicsOutlinePrimitive.reset();
+    invalidateMatrixChartingViewPrimitives();
     invalidateHistogramChartColoring();
 }
 
@@ -1690,29 +1705,391 @@ CiftiMappableDataFile::getMatrixChartingGraphicsPrimitive(const ChartTwoMatrixTr
     return matrixPrimitive;
 }
 
+/**
+ * @return True if the matrix is too large to chart with a cell for every
+ * element of the matrix.  The part of the matrix that is in view is then
+ * charted at a level of detail that fits the view with
+ * getMatrixChartingGraphicsPrimitiveForView().
+ */
+bool
+CiftiMappableDataFile::isMatrixChartingLevelOfDetailUsed() const
+{
+    if (m_ciftiFile == NULL) {
+        return false;
+    }
+    
+    bool useMapFileHelperFlag = false;
+    bool useMatrixFileHelperFlag = false;
+    std::vector<int32_t> rowIndices;
+    getMatrixChartingLoadingMethod(useMapFileHelperFlag,
+                                   useMatrixFileHelperFlag,
+                                   rowIndices);
+    
+    /*
+     * Pooled cells are colored with the file's palette.  Label
+     * tables and per-map palettes cannot color pooled values.
+     */
+    if (useMatrixFileHelperFlag
+        && isMappedWithPalette()) {
+        const int64_t numberOfCells = (m_ciftiFile->getNumberOfRows()
+                                       * m_ciftiFile->getNumberOfColumns());
+        return (numberOfCells > s_matrixChartingLevelOfDetailMinimumCells);
+    }
+    
+    return false;
+}
 
 /**
- * Get the matrix RGBA coloring for this matrix data creator.
+ * @return The graphics primitive for the part of a large matrix that is in
+ * view, at the level of detail that fits the view.  Each cell of the
+ * primitive is a pooled block of matrix cells, drawn with the width and
+ * height of the block, so the primitive uses the same coordinates as
+ * getMatrixChartingGraphicsPrimitive().  The part in view is extended to
+ * whole tiles so that small changes to panning and zooming reuse the
+ * primitive, and changing the palette only recolors the pooled cells.
+ * NULL is returned if there is nothing to draw, including the grid outline
+ * when cells are pooled.
  *
- * @param numberOfRowsOut
- *    Number of rows in the coloring matrix.
- * @param numberOfColumnsOut
- *    Number of rows in the coloring matrix.
- * @param rgbaOut
- *    RGBA coloring output with number of elements
- *    (numberOfRowsOut * numberOfColumnsOut * 4).
- * @return
- *    True if data output data is valid, else false.
+ * @param matrixViewMode
+ *     The matrix visualization mode (upper/lower).
+ * @param gridMode
+ *     The grid mode (filled or outline)
+ * @param viewBounds
+ *     Part of the matrix in view (minimum X, maximum X, minimum Y, maximum Y)
+ *     where cells are 1.0 x 1.0 and the first row is at the top.
+ * @param cellsPerPixel
+ *     Number of matrix cells in one pixel of the view.
  */
-bool
-CiftiMappableDataFile::getMatrixForChartingRGBA(int32_t& numberOfRowsOut,
-                                             int32_t& numberOfColumnsOut,
-                                             std::vector<float>& rgbaOut) const
+GraphicsPrimitiveV3fC4f*
+CiftiMappableDataFile::getMatrixChartingGraphicsPrimitiveForView(const ChartTwoMatrixTriangularViewingModeEnum::Enum matrixViewMode,
+                                                                 const MatrixGridMode gridMode,
+                                                                 const float viewBounds[4],
+                                                                 const float cellsPerPixel) const
 {
+    CaretAssert(m_ciftiFile);
+    const int32_t numberOfRows    = m_ciftiFile->getNumberOfRows();
+    const int32_t numberOfColumns = m_ciftiFile->getNumberOfColumns();
+    
     bool useMapFileHelperFlag = false;
     bool useMatrixFileHelperFlag = false;
+    std::vector<int32_t> rowIndices;
+    getMatrixChartingLoadingMethod(useMapFileHelperFlag,
+                                   useMatrixFileHelperFlag,
+                                   rowIndices);
     
-    std::vector<int32_t> parcelReorderedRowIndices;
+    /*
+     * Creating the pyramid reads all of the matrix once, so it
+     * is kept until the data or the ordering of the rows changes.
+     */
+    if ((m_matrixChartingPyramid == NULL)
+        || (rowIndices != m_matrixChartingPyramidRowIndices)) {
+        m_matrixChartingPyramid.grabNew(new CiftiMatrixPyramid());
+        m_matrixChartingPyramidRowIndices = rowIndices;
+        invalidateMatrixChartingViewPrimitives();
+        
+        /*
+         * Use levels saved beside the file (by wb_command) if they are up to date
+         */
+        bool validCacheFlag = false;
+        const AString filename = getFileName();
+        if (rowIndices.empty()
+            && ( ! isModifiedExcludingPaletteColorMapping())
+            && ( ! DataFile::isFileOnNetwork(filename))) {
+            if (m_matrixChartingPyramid->readCacheFile(filename)) {
+                if ((m_matrixChartingPyramid->getNumberOfRows() == numberOfRows)
+                    && (m_matrixChartingPyramid->getNumberOfColumns() == numberOfColumns)) {
+                    validCacheFlag = true;
+                }
+            }
+        }
+        
+        if ( ! validCacheFlag) {
+            try {
+                m_matrixChartingPyramid->build(m_ciftiFile,
+                                               rowIndices);
+            }
+            catch (const CaretException& e) {
+                CaretLogSevere("Unable to create levels of detail for matrix chart: "
+                               + e.whatString());
+                m_matrixChartingPyramid.grabNew(new CiftiMatrixPyramid());
+            }
+        }
+    }
+    const CiftiMatrixPyramid* pyramid = m_matrixChartingPyramid;
+    if ( ! pyramid->isValid()) {
+        return NULL;
+    }
+    
+    const int32_t numberOfRowsInView = std::min(static_cast<int32_t>(std::ceil(viewBounds[3] - viewBounds[2])),
+                                                numberOfRows);
+    const int32_t level = pyramid->getLevelForView(cellsPerPixel,
+                                                   numberOfRowsInView);
+    uint8_t gridByteRGBA[4] = { 0, 0, 0, 0 };
+    int32_t viewPrimitiveIndex = 0;
+    switch (gridMode) {
+        case MatrixGridMode::FILLED:
+            viewPrimitiveIndex = 0;
+            break;
+        case MatrixGridMode::OUTLINE:
+        {
+            if (level > 0) {
+                /*
+                 * Pooled cells are not matrix cells so do not outline them
+                 */
+                return NULL;
+            }
+            viewPrimitiveIndex = 1;
+            EventCaretPreferencesGet preferencesEvent;
+            EventManager::get()->sendEvent(preferencesEvent.getPointer());
+            CaretPreferences* caretPreferences = preferencesEvent.getCaretPreferences();
+            if (caretPreferences != NULL) {
+                caretPreferences->getBackgroundAndForegroundColors()->getColorChartMatrixGridLines(gridByteRGBA);
+            }
+        }
+            break;
+    }
+    
+    /*
+     * Find the pooled cells in view, extended to whole tiles.
+     * Rows are numbered from the top, Y is from the bottom.
+     */
+    const int32_t poolSize = CiftiMatrixPyramid::getPoolSize(level);
+    const int32_t tileSize = 64;
+    int32_t levelRows = 0;
+    int32_t levelColumns = 0;
+    pyramid->getLevelDimensions(level,
+                                levelRows,
+                                levelColumns);
+    const int32_t firstRowInView    = static_cast<int32_t>(std::floor((numberOfRows - viewBounds[3]) / poolSize));
+    const int32_t lastRowInView     = static_cast<int32_t>(std::ceil((numberOfRows - viewBounds[2]) / poolSize));
+    const int32_t firstColumnInView = static_cast<int32_t>(std::floor(viewBounds[0] / poolSize));
+    const int32_t lastColumnInView  = static_cast<int32_t>(std::ceil(viewBounds[1] / poolSize));
+    const int32_t rowStart    = MathFunctions::clamp((firstRowInView / tileSize) * tileSize, 0, levelRows);
+    const int32_t rowEnd      = MathFunctions::clamp(((lastRowInView + tileSize - 1) / tileSize) * tileSize, 0, levelRows);
+    const int32_t columnStart = MathFunctions::clamp((firstColumnInView / tileSize) * tileSize, 0, levelColumns);
+    const int32_t columnEnd   = MathFunctions::clamp(((lastColumnInView + tileSize - 1) / tileSize) * tileSize, 0, levelColumns);
+    if ((rowStart >= rowEnd)
+        || (columnStart >= columnEnd)) {
+        return NULL;
+    }
+    
+    MatrixChartingViewPrimitive& viewPrimitive = m_matrixChartingViewPrimitives[viewPrimitiveIndex];
+    if (viewPrimitive.m_primitive
+        && (viewPrimitive.m_matrixViewMode == matrixViewMode)
+        && (viewPrimitive.m_level == level)
+        && (viewPrimitive.m_rowStart == rowStart)
+        && (viewPrimitive.m_rowEnd == rowEnd)
+        && (viewPrimitive.m_columnStart == columnStart)
+        && (viewPrimitive.m_columnEnd == columnEnd)
+        && std::equal(gridByteRGBA, gridByteRGBA + 4, viewPrimitive.m_gridRGBA)) {
+        return viewPrimitive.m_primitive.get();
+    }
+    viewPrimitive.m_primitive.reset();
+    
+    const int32_t numberOfViewRows    = rowEnd - rowStart;
+    const int32_t numberOfViewColumns = columnEnd - columnStart;
+    const int64_t numberOfViewCells   = static_cast<int64_t>(numberOfViewRows) * numberOfViewColumns;
+    std::vector<float> cellsRGBA;
+    switch (gridMode) {
+        case MatrixGridMode::FILLED:
+        {
+            std::vector<float> data;
+            pyramid->getLevelData(m_ciftiFile,
+                                  level,
+                                  CiftiMatrixPyramid::MEAN,
+                                  rowStart,
+                                  rowEnd,
+                                  columnStart,
+                                  columnEnd,
+                                  data);
+            cellsRGBA.resize(numberOfViewCells * 4);
+            if ( ! helpMatrixFileColorChartData(&data[0],
+                                                numberOfViewCells,
+                                                &cellsRGBA[0])) {
+                return NULL;
+            }
+        }
+            break;
+        case MatrixGridMode::OUTLINE:
+        {
+            const float cellOutlineRGBA[4] = {
+                static_cast<float>(gridByteRGBA[0]) / 255.0f,
+                static_cast<float>(gridByteRGBA[1]) / 255.0f,
+                static_cast<float>(gridByteRGBA[2]) / 255.0f,
+                1.0f
+            };
+            cellsRGBA.resize(numberOfViewCells * 4);
+            for (int64_t i = 0; i < numberOfViewCells; i++) {
+                std::copy(cellOutlineRGBA, cellOutlineRGBA + 4, cellsRGBA.begin() + i * 4);
+            }
+        }
+            break;
+    }
+    
+    GraphicsPrimitiveV3fC4f* matrixPrimitive = NULL;
+    switch (gridMode) {
+        case MatrixGridMode::FILLED:
+            matrixPrimitive = GraphicsPrimitive::newPrimitiveV3fC4f(GraphicsPrimitive::PrimitiveType::OPENGL_TRIANGLES);
+            matrixPrimitive->reserveForNumberOfVertices(numberOfViewCells * 6);
+            break;
+        case MatrixGridMode::OUTLINE:
+            matrixPrimitive = GraphicsPrimitive::newPrimitiveV3fC4f(GraphicsPrimitive::PrimitiveType::OPENGL_LINES);
+            matrixPrimitive->reserveForNumberOfVertices(numberOfViewCells * 8);
+            break;
+    }
+    matrixPrimitive->setUsageTypeAll(GraphicsPrimitive::UsageType::MODIFIED_ONCE_DRAWN_MANY_TIMES);
+    
+    /*
+     * As with the full matrix, cells that are not drawn are kept with alpha zero
+     * so that the row and column can be derived from the primitive index.
+     */
+    const float cellNotDrawRGBA[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    const bool triangularFlag = ((matrixViewMode != ChartTwoMatrixTriangularViewingModeEnum::MATRIX_VIEW_FULL)
+                                 && (numberOfRows == numberOfColumns));
+    int64_t rgbaOffset = 0;
+    for (int32_t pooledRow = rowStart; pooledRow < rowEnd; pooledRow++) {
+        const float cellMaxY = numberOfRows - pooledRow * poolSize;
+        const float cellMinY = numberOfRows - std::min((pooledRow + 1) * poolSize, numberOfRows);
+        for (int32_t pooledColumn = columnStart; pooledColumn < columnEnd; pooledColumn++) {
+            const float cellMinX = pooledColumn * poolSize;
+            const float cellMaxX = std::min((pooledColumn + 1) * poolSize, numberOfColumns);
+            CaretAssertVectorIndex(cellsRGBA, rgbaOffset + 3);
+            const float* rgba = &cellsRGBA[rgbaOffset];
+            rgbaOffset += 4;
+            
+            /*
+             * Pooled cells on the diagonal contain both upper and lower cells
+             * and are treated as diagonal cells.
+             */
+            bool drawCellFlag = true;
+            if (triangularFlag) {
+                switch (matrixViewMode) {
+                    case ChartTwoMatrixTriangularViewingModeEnum::MATRIX_VIEW_FULL:
+                        break;
+                    case ChartTwoMatrixTriangularViewingModeEnum::MATRIX_VIEW_FULL_NO_DIAGONAL:
+                        drawCellFlag = (pooledRow != pooledColumn);
+                        break;
+                    case ChartTwoMatrixTriangularViewingModeEnum::MATRIX_VIEW_LOWER_NO_DIAGONAL:
+                        drawCellFlag = (pooledRow > pooledColumn);
+                        break;
+                    case ChartTwoMatrixTriangularViewingModeEnum::MATRIX_VIEW_UPPER_NO_DIAGONAL:
+                        drawCellFlag = (pooledRow < pooledColumn);
+                        break;
+                }
+            }
+            
+            const float* cellRGBA = (drawCellFlag ? rgba : cellNotDrawRGBA);
+            switch (gridMode) {
+                case MatrixGridMode::FILLED:
+                    matrixPrimitive->addVertex(cellMinX, cellMaxY, 0.0, cellRGBA);
+                    matrixPrimitive->addVertex(cellMinX, cellMinY, 0.0, cellRGBA);
+                    matrixPrimitive->addVertex(cellMaxX, cellMinY, 0.0, cellRGBA);
+                    
+                    matrixPrimitive->addVertex(cellMinX, cellMaxY, 0.0, cellRGBA);
+                    matrixPrimitive->addVertex(cellMaxX, cellMinY, 0.0, cellRGBA);
+                    matrixPrimitive->addVertex(cellMaxX, cellMaxY, 0.0, cellRGBA);
+                    break;
+                case MatrixGridMode::OUTLINE:
+                    matrixPrimitive->addVertex(cellMinX, cellMinY, 0.0, cellRGBA);
+                    matrixPrimitive->addVertex(cellMaxX, cellMinY, 0.0, cellRGBA);
+                    
+                    matrixPrimitive->addVertex(cellMaxX, cellMinY, 0.0, cellRGBA);
+                    matrixPrimitive->addVertex(cellMaxX, cellMaxY, 0.0, cellRGBA);
+                    
+                    matrixPrimitive->addVertex(cellMaxX, cellMaxY, 0.0, cellRGBA);
+                    matrixPrimitive->addVertex(cellMinX, cellMaxY, 0.0, cellRGBA);
+                    
+                    matrixPrimitive->addVertex(cellMinX, cellMaxY, 0.0, cellRGBA);
+                    matrixPrimitive->addVertex(cellMinX, cellMinY, 0.0, cellRGBA);
+                    break;
+            }
+        }
+    }
+    
+    viewPrimitive.m_primitive.reset(matrixPrimitive);
+    viewPrimitive.m_matrixViewMode = matrixViewMode;
+    viewPrimitive.m_level          = level;
+    viewPrimitive.m_rowStart       = rowStart;
+    viewPrimitive.m_rowEnd         = rowEnd;
+    viewPrimitive.m_columnStart    = columnStart;
+    viewPrimitive.m_columnEnd      = columnEnd;
+    std::copy(gridByteRGBA, gridByteRGBA + 4, viewPrimitive.m_gridRGBA);
+    
+    return matrixPrimitive;
+}
+
+/**
+ * Get the matrix row and column for a cell of the primitive last returned by
+ * getMatrixChartingGraphicsPrimitiveForView() for filled cells.  When cells
+ * are pooled, the row and column are at the center of the pooled cell.
+ *
+ * @param cellIndex
+ *     Index of the cell in the primitive.
+ * @param rowIndexOut
+ *     Output with index of row.
+ * @param columnIndexOut
+ *     Output with index of column.
+ * @return
+ *     True if the outputs are valid, else false.
+ */
+bool
+CiftiMappableDataFile::getMatrixChartingForViewRowAndColumn(const int32_t cellIndex,
+                                                            int32_t& rowIndexOut,
+                                                            int32_t& columnIndexOut) const
+{
+    const MatrixChartingViewPrimitive& viewPrimitive = m_matrixChartingViewPrimitives[0];
+    if (( ! viewPrimitive.m_primitive)
+        || (m_ciftiFile == NULL)) {
+        return false;
+    }
+    
+    const int32_t numberOfViewColumns = viewPrimitive.m_columnEnd - viewPrimitive.m_columnStart;
+    const int32_t numberOfViewRows    = viewPrimitive.m_rowEnd - viewPrimitive.m_rowStart;
+    if ((cellIndex < 0)
+        || (cellIndex >= (numberOfViewRows * numberOfViewColumns))) {
+        return false;
+    }
+    
+    const int32_t poolSize = CiftiMatrixPyramid::getPoolSize(viewPrimitive.m_level);
+    const int32_t pooledRow    = viewPrimitive.m_rowStart + (cellIndex / numberOfViewColumns);
+    const int32_t pooledColumn = viewPrimitive.m_columnStart + (cellIndex % numberOfViewColumns);
+    rowIndexOut    = std::min(static_cast<int32_t>(pooledRow * poolSize + poolSize / 2),
+                              static_cast<int32_t>(m_ciftiFile->getNumberOfRows() - 1));
+    columnIndexOut = std::min(static_cast<int32_t>(pooledColumn * poolSize + poolSize / 2),
+                              static_cast<int32_t>(m_ciftiFile->getNumberOfColumns() - 1));
+    
+    return true;
+}
+
+/**
+ * Invalidate the primitives for the part of a large matrix in view.
+ */
+void
+CiftiMappableDataFile::invalidateMatrixChartingViewPrimitives() const
+{
+    m_matrixChartingViewPrimitives[0].m_primitive.reset();
+    m_matrixChartingViewPrimitives[1].m_primitive.reset();
+}
+
+
+/**
+ * Get how matrix chart data is loaded for this file.
+ *
+ * @param useMapFileHelperFlagOut
+ *    True if each column (map) is colored with its own palette or label table.
+ * @param useMatrixFileHelperFlagOut
+ *    True if all data in the file is colored with the file's palette.
+ * @param rowIndicesOut
+ *    Output with reordered row indices (empty if rows are not reordered).
+ */
+void
+CiftiMappableDataFile::getMatrixChartingLoadingMethod(bool& useMapFileHelperFlagOut,
+                                                      bool& useMatrixFileHelperFlagOut,
+                                                      std::vector<int32_t>& rowIndicesOut) const
+{
+    useMapFileHelperFlagOut = false;
+    useMatrixFileHelperFlagOut = false;
+    rowIndicesOut.clear();
     
     switch (getDataFileType()) {
         case DataFileTypeEnum::CONNECTIVITY_DENSE:
@@ -1729,7 +2106,7 @@ CiftiMappableDataFile::getMatrixForChartingRGBA(int32_t& numberOfRowsOut,
             break;
         case DataFileTypeEnum::CONNECTIVITY_PARCEL:
         {
-            useMatrixFileHelperFlag    = true;
+            useMatrixFileHelperFlagOut = true;
             
             const CiftiConnectivityMatrixParcelFile* parcelConnFile = dynamic_cast<const CiftiConnectivityMatrixParcelFile*>(this);
             CaretAssert(parcelConnFile);
@@ -1748,7 +2125,7 @@ CiftiMappableDataFile::getMatrixForChartingRGBA(int32_t& numberOfRowsOut,
                     const CiftiParcelReordering* parcelReordering = parcelConnFile->getParcelReordering(parcelLabelReorderingFile,
                                                                                                         parcelLabelFileMapIndex);
                     if (parcelReordering != NULL) {
-                        parcelReorderedRowIndices = parcelReordering->getReorderedParcelIndices();
+                        rowIndicesOut = parcelReordering->getReorderedParcelIndices();
                     }
                 }
             }
@@ -1758,7 +2135,7 @@ CiftiMappableDataFile::getMatrixForChartingRGBA(int32_t& numberOfRowsOut,
             break;
         case DataFileTypeEnum::CONNECTIVITY_PARCEL_LABEL:
         {
-            useMapFileHelperFlag = true;
+            useMapFileHelperFlagOut = true;
             
             const CiftiParcelLabelFile* parcelLabelFile = dynamic_cast<const CiftiParcelLabelFile*>(this);
             CaretAssert(parcelLabelFile);
@@ -1777,7 +2154,7 @@ CiftiMappableDataFile::getMatrixForChartingRGBA(int32_t& numberOfRowsOut,
                     const CiftiParcelReordering* parcelReordering = parcelLabelFile->getParcelReordering(parcelLabelReorderingFile,
                                                                                                          parcelLabelFileMapIndex);
                     if (parcelReordering != NULL) {
-                        parcelReorderedRowIndices = parcelReordering->getReorderedParcelIndices();
+                        rowIndicesOut = parcelReordering->getReorderedParcelIndices();
                     }
                 }
             }
@@ -1785,7 +2162,7 @@ CiftiMappableDataFile::getMatrixForChartingRGBA(int32_t& numberOfRowsOut,
             break;
         case DataFileTypeEnum::CONNECTIVITY_PARCEL_SCALAR:
         {
-            useMapFileHelperFlag = true;
+            useMapFileHelperFlagOut = true;
             
             const CiftiParcelScalarFile* parcelScalarFile = dynamic_cast<const CiftiParcelScalarFile*>(this);
             CaretAssert(parcelScalarFile);
@@ -1804,7 +2181,7 @@ CiftiMappableDataFile::getMatrixForChartingRGBA(int32_t& numberOfRowsOut,
                     const CiftiParcelReordering* parcelReordering = parcelScalarFile->getParcelReordering(parcelLabelReorderingFile,
                                                                                                           parcelLabelFileMapIndex);
                     if (parcelReordering != NULL) {
-                        parcelReorderedRowIndices = parcelReordering->getReorderedParcelIndices();
+                        rowIndicesOut = parcelReordering->getReorderedParcelIndices();
                     }
                 }
             }
@@ -1812,7 +2189,7 @@ CiftiMappableDataFile::getMatrixForChartingRGBA(int32_t& numberOfRowsOut,
             break;
         case DataFileTypeEnum::CONNECTIVITY_PARCEL_SERIES:
         {
-            useMapFileHelperFlag = true;
+            useMapFileHelperFlagOut = true;
             
             const CiftiParcelSeriesFile* parcelSeriesFile = dynamic_cast<const CiftiParcelSeriesFile*>(this);
             CaretAssert(parcelSeriesFile);
@@ -1830,14 +2207,14 @@ CiftiMappableDataFile::getMatrixForChartingRGBA(int32_t& numberOfRowsOut,
                     const CiftiParcelReordering* parcelReordering = parcelSeriesFile->getParcelReordering(parcelLabelReorderingFile,
                                                                                                           parcelLabelFileMapIndex);
                     if (parcelReordering != NULL) {
-                        parcelReorderedRowIndices = parcelReordering->getReorderedParcelIndices();
+                        rowIndicesOut = parcelReordering->getReorderedParcelIndices();
                     }
                 }
             }
         }
             break;
         case DataFileTypeEnum::CONNECTIVITY_SCALAR_DATA_SERIES:
-            useMatrixFileHelperFlag = true;
+            useMatrixFileHelperFlagOut = true;
             break;
         case DataFileTypeEnum::ANNOTATION:
             break;
@@ -1870,6 +2247,32 @@ CiftiMappableDataFile::getMatrixForChartingRGBA(int32_t& numberOfRowsOut,
         case DataFileTypeEnum::VOLUME:
             break;
     }
+}
+
+/**
+ * Get the matrix RGBA coloring for this matrix data creator.
+ *
+ * @param numberOfRowsOut
+ *    Number of rows in the coloring matrix.
+ * @param numberOfColumnsOut
+ *    Number of rows in the coloring matrix.
+ * @param rgbaOut
+ *    RGBA coloring output with number of elements
+ *    (numberOfRowsOut * numberOfColumnsOut * 4).
+ * @return
+ *    True if data output data is valid, else false.
+ */
+bool
+CiftiMappableDataFile::getMatrixForChartingRGBA(int32_t& numberOfRowsOut,
+                                             int32_t& numberOfColumnsOut,
+                                             std::vector<float>& rgbaOut) const
+{
+    bool useMapFileHelperFlag = false;
+    bool useMatrixFileHelperFlag = false;
+    std::vector<int32_t> parcelReorderedRowIndices;
+    getMatrixChartingLoadingMethod(useMapFileHelperFlag,
+                                   useMatrixFileHelperFlag,
+                                   parcelReorderedRowIndices);
     
     if (( ! useMapFileHelperFlag)
         && ( ! useMatrixFileHelperFlag)) {
@@ -2516,6 +2919,7 @@ CiftiMappableDataFile::updateScalarColoringForMap(const int32_t mapIndex,
     invalidateHistogramChartColoring();
     m_matrixGraphicsPrimitive.reset();
     m_matrixGraphicsOutlinePrimitive.reset();
+    invalidateMatrixChartingViewPrimitives();
 }
 
 /**
@@ -2982,10 +3386,17 @@ CiftiMappableDataFile::getVoxelColorsForSliceInMap(const PaletteFile* paletteFil
     const GiftiLabelTable* labelTable = (isMappedWithLabelTable()
                                          ? getMapLabelTable(mapIndex)
                                          : NULL);
+    CaretPointer<const GiftiLabelTableLookup> labelLookup;
+    std::vector<char> labelDisplayed;
     if (isMappedWithLabelTable()) {
         CaretAssert(labelTable);
         getMapData(mapIndex,
                    dataValues);
+        labelLookup = labelTable->getLookup();
+        NodeAndVoxelColoring::getLabelDisplayedStatus(labelLookup,
+                                                      displayGroup,
+                                                      tabIndex,
+                                                      labelDisplayed);
     }
     
     int64_t validVoxelCount = 0;
@@ -3031,11 +3442,9 @@ CiftiMappableDataFile::getVoxelColorsForSliceInMap(const PaletteFile* paletteFil
                                  */
                                 CaretAssertVectorIndex(dataValues, dataOffset);
                                 const int32_t dataValue = dataValues[dataOffset];
-                                const GiftiLabel* label = labelTable->getLabel(dataValue);
-                                if (label != NULL) {
-                                    const GroupAndNameHierarchyItem* item = label->getGroupNameSelectionItem();
-                                    CaretAssert(item);
-                                    if (item->isSelected(displayGroup, tabIndex) == false) {
+                                const int32_t labelIndex = labelLookup->find(dataValue);
+                                if (labelIndex >= 0) {
+                                    if ( ! labelDisplayed[labelIndex]) {
                                         alpha = 0.0;
                                     }
                                 }
@@ -3085,11 +3494,9 @@ CiftiMappableDataFile::getVoxelColorsForSliceInMap(const PaletteFile* paletteFil
                                  */
                                 CaretAssertVectorIndex(dataValues, dataOffset);
                                 const int32_t dataValue = dataValues[dataOffset];
-                                const GiftiLabel* label = labelTable->getLabel(dataValue);
-                                if (label != NULL) {
-                                    const GroupAndNameHierarchyItem* item = label->getGroupNameSelectionItem();
-                                    CaretAssert(item);
-                                    if (item->isSelected(displayGroup, tabIndex) == false) {
+                                const int32_t labelIndex = labelLookup->find(dataValue);
+                                if (labelIndex >= 0) {
+                                    if ( ! labelDisplayed[labelIndex]) {
                                         alpha = 0.0;
                                     }
                                 }
@@ -3139,11 +3546,9 @@ CiftiMappableDataFile::getVoxelColorsForSliceInMap(const PaletteFile* paletteFil
                                  */
                                 CaretAssertVectorIndex(dataValues, dataOffset);
                                 const int32_t dataValue = dataValues[dataOffset];
-                                const GiftiLabel* label = labelTable->getLabel(dataValue);
-                                if (label != NULL) {
-                                    const GroupAndNameHierarchyItem* item = label->getGroupNameSelectionItem();
-                                    CaretAssert(item);
-                                    if (item->isSelected(displayGroup, tabIndex) == false) {
+                                const int32_t labelIndex = labelLookup->find(dataValue);
+                                if (labelIndex >= 0) {
+                                    if ( ! labelDisplayed[labelIndex]) {
                                         alpha = 0.0;
                                     }
                                 }
@@ -3232,10 +3637,17 @@ CiftiMappableDataFile::getVoxelColorsForSliceInMap(const int32_t mapIndex,
     const GiftiLabelTable* labelTable = (isMappedWithLabelTable()
                                          ? getMapLabelTable(mapIndex)
                                          : NULL);
+    CaretPointer<const GiftiLabelTableLookup> labelLookup;
+    std::vector<char> labelDisplayed;
     if (isMappedWithLabelTable()) {
         CaretAssert(labelTable);
         getMapData(mapIndex,
                    dataValues);
+        labelLookup = labelTable->getLookup();
+        NodeAndVoxelColoring::getLabelDisplayedStatus(labelLookup,
+                                                      displayGroup,
+                                                      tabIndex,
+                                                      labelDisplayed);
     }
     
     int64_t rowIJK[3] = { firstVoxelIJK[0], firstVoxelIJK[1], firstVoxelIJK[2] };
@@ -3278,11 +3690,9 @@ CiftiMappableDataFile::getVoxelColorsForSliceInMap(const int32_t mapIndex,
                          */
                         CaretAssertVectorIndex(dataValues, dataOffset);
                         const int32_t dataValue = dataValues[dataOffset];
-                        const GiftiLabel* label = labelTable->getLabel(dataValue);
-                        if (label != NULL) {
-                            const GroupAndNameHierarchyItem* item = label->getGroupNameSelectionItem();
-                            CaretAssert(item);
-                            if (item->isSelected(displayGroup, tabIndex) == false) {
+                        const int32_t labelIndex = labelLookup->find(dataValue);
+                        if (labelIndex >= 0) {
+                            if ( ! labelDisplayed[labelIndex]) {
                                 alpha = 0.0;
                             }
                         }
@@ -3452,10 +3862,17 @@ CiftiMappableDataFile::getVoxelColorsForSubSliceInMap(const PaletteFile* palette
     const GiftiLabelTable* labelTable = (isMappedWithLabelTable()
                                          ? getMapLabelTable(mapIndex)
                                          : NULL);
+    CaretPointer<const GiftiLabelTableLookup> labelLookup;
+    std::vector<char> labelDisplayed;
     if (isMappedWithLabelTable()) {
         CaretAssert(labelTable);
         getMapData(mapIndex,
                    dataValues);
+        labelLookup = labelTable->getLookup();
+        NodeAndVoxelColoring::getLabelDisplayedStatus(labelLookup,
+                                                      displayGroup,
+                                                      tabIndex,
+                                                      labelDisplayed);
     }
     
     /*
@@ -3515,11 +3932,9 @@ CiftiMappableDataFile::getVoxelColorsForSubSliceInMap(const PaletteFile* palette
                                  */
                                 CaretAssertVectorIndex(dataValues, dataOffset);
                                 const int32_t dataValue = dataValues[dataOffset];
-                                const GiftiLabel* label = labelTable->getLabel(dataValue);
-                                if (label != NULL) {
-                                    const GroupAndNameHierarchyItem* item = label->getGroupNameSelectionItem();
-                                    CaretAssert(item);
-                                    if (item->isSelected(displayGroup, tabIndex) == false) {
+                                const int32_t labelIndex = labelLookup->find(dataValue);
+                                if (labelIndex >= 0) {
+                                    if ( ! labelDisplayed[labelIndex]) {
                                         alpha = 0.0;
                                     }
                                 }
@@ -3595,11 +4010,9 @@ CiftiMappableDataFile::getVoxelColorsForSubSliceInMap(const PaletteFile* palette
                                  */
                                 CaretAssertVectorIndex(dataValues, dataOffset);
                                 const int32_t dataValue = dataValues[dataOffset];
-                                const GiftiLabel* label = labelTable->getLabel(dataValue);
-                                if (label != NULL) {
-                                    const GroupAndNameHierarchyItem* item = label->getGroupNameSelectionItem();
-                                    CaretAssert(item);
-                                    if (item->isSelected(displayGroup, tabIndex) == false) {
+                                const int32_t labelIndex = labelLookup->find(dataValue);
+                                if (labelIndex >= 0) {
+                                    if ( ! labelDisplayed[labelIndex]) {
                                         alpha = 0.0;
                                     }
                                 }
@@ -3676,11 +4089,9 @@ CiftiMappableDataFile::getVoxelColorsForSubSliceInMap(const PaletteFile* palette
                                  */
                                 CaretAssertVectorIndex(dataValues, dataOffset);
                                 const int32_t dataValue = dataValues[dataOffset];
-                                const GiftiLabel* label = labelTable->getLabel(dataValue);
-                                if (label != NULL) {
-                                    const GroupAndNameHierarchyItem* item = label->getGroupNameSelectionItem();
-                                    CaretAssert(item);
-                                    if (item->isSelected(displayGroup, tabIndex) == false) {
+                                const int32_t labelIndex = labelLookup->find(dataValue);
+                                if (labelIndex >= 0) {
+                                    if ( ! labelDisplayed[labelIndex]) {
                                         alpha = 0.0;
                                     }
                                 }
@@ -3745,11 +4156,9 @@ CiftiMappableDataFile::getVoxelColorsForSubSliceInMap(const PaletteFile* palette
                                  */
                                 CaretAssertVectorIndex(dataValues, dataOffset);
                                 const int32_t dataValue = dataValues[dataOffset];
-                                const GiftiLabel* label = labelTable->getLabel(dataValue);
-                                if (label != NULL) {
-                                    const GroupAndNameHierarchyItem* item = label->getGroupNameSelectionItem();
-                                    CaretAssert(item);
-                                    if (item->isSelected(displayGroup, tabIndex) == false) {
+                                const int32_t labelIndex = labelLookup->find(dataValue);
+                                if (labelIndex >= 0) {
+                                    if ( ! labelDisplayed[labelIndex]) {
                                         alpha = 0.0;
                                     }
                                 }
@@ -6756,6 +7165,34 @@ CiftiMappableDataFile::helpMatrixFileLoadChartDataMatrixRGBA(int32_t& numberOfRo
                             iRow);
     }
     
+    /*
+     * Color the data.
+     */
+    const int32_t numRGBA = numberOfData * 4;
+    rgbaOut.resize(numRGBA);
+    return helpMatrixFileColorChartData(&data[0],
+                                        numberOfData,
+                                        &rgbaOut[0]);
+}
+
+/**
+ * Color matrix chart data for a connectivity matrix file
+ * where one palette is used for all data in the file.
+ *
+ * @param data
+ *    The data.
+ * @param numberOfData
+ *    Number of elements in data.
+ * @param rgbaOut
+ *    RGBA coloring (number of elements is numberOfData * 4).
+ * @return
+ *    True if output data is valid, else false.
+ */
+bool
+CiftiMappableDataFile::helpMatrixFileColorChartData(const float* data,
+                                                    const int64_t numberOfData,
+                                                    float* rgbaOut) const
+{
     /*
      * Get palette for color mapping.
      */
@@ -6789,15 +7226,13 @@ CiftiMappableDataFile::helpMatrixFileLoadChartDataMatrixRGBA(int32_t& numberOfRo
         /*
          * Color the data.
          */
-        const int32_t numRGBA = numberOfData * 4;
-        rgbaOut.resize(numRGBA);
         NodeAndVoxelColoring::colorScalarsWithPalette(fileFastStats,
                                                       pcm,
                                                       palette,
-                                                      &data[0],
-                                                      &data[0],
+                                                      data,
+                                                      data,
                                                       numberOfData,
-                                                      &rgbaOut[0]);
+                                                      rgbaOut);
         
         return true;
     }
@@ -39,6 +39,7 @@ namespace caret {
     class ChartData;
     class ChartDataCartesian;
     class CiftiFile;
+    class CiftiMatrixPyramid;
     class CiftiParcelsMap;
     class CiftiXML;
     class FastStatistics;
@@ -497,6 +498,17 @@ namespace caret {
         GraphicsPrimitiveV3fC4f* getMatrixChartingGraphicsPrimitive(const ChartTwoMatrixTriangularViewingModeEnum::Enum matrixViewMode,
                                                                     const MatrixGridMode gridMode) const;
         
+        bool isMatrixChartingLevelOfDetailUsed() const;
+        
+        GraphicsPrimitiveV3fC4f* getMatrixChartingGraphicsPrimitiveForView(const ChartTwoMatrixTriangularViewingModeEnum::Enum matrixViewMode,
+                                                                           const MatrixGridMode gridMode,
+                                                                           const float viewBounds[4],
+                                                                           const float cellsPerPixel) const;
+        
+        bool getMatrixChartingForViewRowAndColumn(const int32_t cellIndex,
+                                                  int32_t& rowIndexOut,
+                                                  int32_t& columnIndexOut) const;
+        
         /** Identifier for the matrix primitives alternative color used for the grid coloring */
         int32_t getMatrixChartGraphicsPrimitiveGridColorIdentifier() const { return 1; }
         
@@ -536,6 +548,10 @@ namespace caret {
                                                    const std::vector<int32_t>& rowIndicesIn,
                                                    std::vector<float>& rgbaOut) const;
         
+        bool helpMatrixFileColorChartData(const float* data,
+                                          const int64_t numberOfData,
+                                          float* rgbaOut) const;
+        
     private:
         class MapContent : public CaretObjectTracksModification {
             
@@ -655,8 +671,29 @@ namespace caret {
             CaretPointer<GiftiMetaData> m_metadataForMapsWithNoMetaData;
         };
         
+        /** Primitive for the part of a large matrix in view and the pooled cells it contains */
+        struct MatrixChartingViewPrimitive {
+            std::unique_ptr<GraphicsPrimitiveV3fC4f> m_primitive;
+            ChartTwoMatrixTriangularViewingModeEnum::Enum m_matrixViewMode = ChartTwoMatrixTriangularViewingModeEnum::MATRIX_VIEW_FULL;
+            int32_t m_level = -1;
+            int32_t m_rowStart = 0;
+            int32_t m_rowEnd = 0;
+            int32_t m_columnStart = 0;
+            int32_t m_columnEnd = 0;
+            uint8_t m_gridRGBA[4] = { 0, 0, 0, 0 };
+        };
+        
         void clearPrivate();
         
+        void getMatrixChartingLoadingMethod(bool& useMapFileHelperFlagOut,
+                                            bool& useMatrixFileHelperFlagOut,
+                                            std::vector<int32_t>& rowIndicesOut) const;
+        
+        void invalidateMatrixChartingViewPrimitives() const;
+        
+        /** Matrices with more cells than this are charted with levels of detail */
+        static const int64_t s_matrixChartingLevelOfDetailMinimumCells = 512 * 512;
+        
     protected:
         void initializeAfterReading(const AString& filename);
         
@@ -757,6 +794,15 @@ namespace caret {
         
         mutable uint8_t m_previousMatrixGridRGBA[4] = { 0, 1, 2, 3 };
         
+        /** Pooled levels of detail for charting a large matrix */
+        mutable CaretPointer<CiftiMatrixPyramid> m_matrixChartingPyramid;
+        
+        /** Row ordering used when the levels of detail were created */
+        mutable std::vector<int32_t> m_matrixChartingPyramidRowIndices;
+        
+        /** Primitives for the part of a large matrix in view, filled and outline */
+        mutable MatrixChartingViewPrimitive m_matrixChartingViewPrimitives[2];
+        
         int32_t m_fileHistogramNumberOfBuckets = 100;
         
         /** Histogram with limited values used when statistics computed on all data in file */
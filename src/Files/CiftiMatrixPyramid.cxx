@@ -0,0 +1,351 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CiftiMatrixPyramid.h"
+
+#include "CaretAssert.h"
+#include "CaretException.h"
+#include "CiftiFile.h"
+#include "DataFileException.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+
+#include <cmath>
+#include <limits>
+
+using namespace caret;
+using namespace std;
+
+const int64_t CiftiMatrixPyramid::DEFAULT_MAXIMUM_STORED_CELLS;
+
+namespace
+{
+    const quint32 CACHE_MAGIC = 0x57424d50;//"WBMP"
+    const qint32 CACHE_VERSION = 1;
+    const int32_t MAXIMUM_ROWS_POOLED_FROM_FILE = 4096;//more than this and a view waits on reading too much of the file
+
+    //sums and counts, so that pooling a level into the next keeps the mean over the original cells
+    struct PoolAccumulator
+    {
+        vector<double> m_sum;
+        vector<int32_t> m_count;
+        vector<float> m_maxMagnitude;
+        void init(const int64_t& size)
+        {
+            m_sum.assign(size, 0.0);
+            m_count.assign(size, 0);
+            m_maxMagnitude.assign(size, 0.0f);
+        }
+        void add(const int64_t& index, const float& value)
+        {
+            if (!std::isfinite(value)) return;
+            m_sum[index] += value;
+            if (m_count[index] == 0 || abs(value) > abs(m_maxMagnitude[index]))
+            {
+                m_maxMagnitude[index] = value;
+            }
+            ++m_count[index];
+        }
+        void addPooled(const int64_t& index, const PoolAccumulator& other, const int64_t& otherIndex)
+        {
+            if (other.m_count[otherIndex] == 0) return;
+            m_sum[index] += other.m_sum[otherIndex];
+            if (m_count[index] == 0 || abs(other.m_maxMagnitude[otherIndex]) > abs(m_maxMagnitude[index]))
+            {
+                m_maxMagnitude[index] = other.m_maxMagnitude[otherIndex];
+            }
+            m_count[index] += other.m_count[otherIndex];
+        }
+        float getValue(const int64_t& index, const CiftiMatrixPyramid::PoolingMode& mode) const
+        {
+            if (m_count[index] == 0) return numeric_limits<float>::quiet_NaN();//same as the cells it covers, rather than a value the palette would color
+            switch (mode)
+            {
+                case CiftiMatrixPyramid::MEAN:
+                    return m_sum[index] / m_count[index];
+                case CiftiMatrixPyramid::MAXIMUM_MAGNITUDE:
+                    return m_maxMagnitude[index];
+            }
+            CaretAssert(false);
+            return 0.0f;
+        }
+    };
+
+    void getSourceFileInfo(const AString& ciftiFileName, qint64& sizeOut, qint64& modifiedOut)
+    {
+        QFileInfo myInfo(ciftiFileName);
+        sizeOut = myInfo.size();
+        modifiedOut = myInfo.lastModified().toMSecsSinceEpoch();
+    }
+}
+
+CiftiMatrixPyramid::CiftiMatrixPyramid()
+{
+    m_rows = 0;
+    m_cols = 0;
+    m_numLevels = 0;
+    m_firstStoredLevel = 0;
+}
+
+void CiftiMatrixPyramid::build(const CiftiFile* ciftiFile, const vector<int32_t>& rowIndices, const int64_t& maximumStoredCells)
+{
+    CaretAssert(ciftiFile != NULL);
+    m_storedLevels.clear();
+    m_fileRowForDisplayRow.clear();
+    m_numLevels = 0;
+    m_rows = ciftiFile->getNumberOfRows();
+    m_cols = ciftiFile->getNumberOfColumns();
+    if (m_rows < 1 || m_cols < 1) return;
+    if (!rowIndices.empty())
+    {
+        if ((int32_t)rowIndices.size() != m_rows) throw CaretException("row ordering has " + AString::number(rowIndices.size()) +
+                                                                       " indices, but the matrix has " + AString::number(m_rows) + " rows");
+        m_fileRowForDisplayRow.assign(m_rows, -1);
+        for (int32_t i = 0; i < m_rows; ++i)
+        {
+            if (rowIndices[i] < 0 || rowIndices[i] >= m_rows || m_fileRowForDisplayRow[rowIndices[i]] != -1)
+            {
+                throw CaretException("row ordering is not a permutation of the matrix rows");
+            }
+            m_fileRowForDisplayRow[rowIndices[i]] = i;
+        }
+    }
+    int32_t topLevel = 0;
+    while (getPoolSize(topLevel) < m_rows || getPoolSize(topLevel) < m_cols) ++topLevel;
+    m_numLevels = topLevel + 1;
+    m_firstStoredLevel = m_numLevels;//in case the matrix is a single cell, then nothing needs to be stored
+    for (int32_t level = 1; level < m_numLevels; ++level)
+    {
+        int32_t levelRows, levelCols;
+        getLevelDimensions(level, levelRows, levelCols);
+        if (int64_t(levelRows) * levelCols <= maximumStoredCells)
+        {
+            m_firstStoredLevel = level;
+            break;
+        }
+    }
+    if (m_firstStoredLevel >= m_numLevels) return;
+    int32_t levelRows, levelCols;
+    getLevelDimensions(m_firstStoredLevel, levelRows, levelCols);
+    PoolAccumulator current;
+    current.init(int64_t(levelRows) * levelCols);
+    vector<float> rowData(m_cols);
+    for (int32_t fileRow = 0; fileRow < m_rows; ++fileRow)//one pass over the file, in file order so on-disk reads are sequential
+    {
+        ciftiFile->getRow(rowData.data(), fileRow);
+        int32_t displayRow = (rowIndices.empty() ? fileRow : rowIndices[fileRow]);
+        int64_t base = int64_t(displayRow >> m_firstStoredLevel) * levelCols;
+        for (int32_t col = 0; col < m_cols; ++col)
+        {
+            current.add(base + (col >> m_firstStoredLevel), rowData[col]);
+        }
+    }
+    for (int32_t level = m_firstStoredLevel; level < m_numLevels; ++level)
+    {
+        m_storedLevels.push_back(Level());
+        Level& thisLevel = m_storedLevels.back();
+        thisLevel.m_rows = levelRows;
+        thisLevel.m_cols = levelCols;
+        int64_t numCells = int64_t(levelRows) * levelCols;
+        thisLevel.m_mean.resize(numCells);
+        thisLevel.m_maxMagnitude.resize(numCells);
+        for (int64_t i = 0; i < numCells; ++i)
+        {
+            thisLevel.m_mean[i] = current.getValue(i, MEAN);
+            thisLevel.m_maxMagnitude[i] = current.getValue(i, MAXIMUM_MAGNITUDE);
+        }
+        if (level + 1 == m_numLevels) break;
+        int32_t nextRows, nextCols;
+        getLevelDimensions(level + 1, nextRows, nextCols);
+        PoolAccumulator next;
+        next.init(int64_t(nextRows) * nextCols);
+        for (int32_t row = 0; row < levelRows; ++row)
+        {
+            for (int32_t col = 0; col < levelCols; ++col)
+            {
+                next.addPooled(int64_t(row >> 1) * nextCols + (col >> 1), current, int64_t(row) * levelCols + col);
+            }
+        }
+        current = next;
+        levelRows = nextRows;
+        levelCols = nextCols;
+    }
+}
+
+void CiftiMatrixPyramid::getLevelDimensions(const int32_t& level, int32_t& rowsOut, int32_t& colsOut) const
+{
+    CaretAssert(level >= 0 && level < m_numLevels);
+    int32_t poolSize = getPoolSize(level);
+    rowsOut = (m_rows + poolSize - 1) / poolSize;
+    colsOut = (m_cols + poolSize - 1) / poolSize;
+}
+
+int32_t CiftiMatrixPyramid::getLevelForView(const float& cellsPerPixel, const int32_t& visibleRows) const
+{
+    CaretAssert(isValid());
+    int32_t level = 0;
+    while (level + 1 < m_numLevels && getPoolSize(level) < cellsPerPixel) ++level;
+    if (level < m_firstStoredLevel && visibleRows > MAXIMUM_ROWS_POOLED_FROM_FILE)
+    {
+        level = min(m_firstStoredLevel, m_numLevels - 1);
+    }
+    return level;
+}
+
+void CiftiMatrixPyramid::getLevelData(const CiftiFile* ciftiFile, const int32_t& level, const PoolingMode& mode, const int32_t& rowStart, const int32_t& rowEnd,
+                                      const int32_t& colStart, const int32_t& colEnd, vector<float>& dataOut) const
+{
+    int32_t levelRows, levelCols;
+    getLevelDimensions(level, levelRows, levelCols);
+    CaretAssert(rowStart >= 0 && rowStart <= rowEnd && rowEnd <= levelRows);
+    CaretAssert(colStart >= 0 && colStart <= colEnd && colEnd <= levelCols);
+    if (!isLevelStored(level))
+    {
+        poolFromFile(ciftiFile, level, rowStart, rowEnd, colStart, colEnd, mode, dataOut);
+        return;
+    }
+    const Level& thisLevel = m_storedLevels[level - m_firstStoredLevel];
+    const vector<float>& values = (mode == MEAN ? thisLevel.m_mean : thisLevel.m_maxMagnitude);
+    int32_t outCols = colEnd - colStart;
+    dataOut.resize(int64_t(rowEnd - rowStart) * outCols);
+    for (int32_t row = rowStart; row < rowEnd; ++row)
+    {
+        const float* rowStartPtr = values.data() + int64_t(row) * levelCols;
+        std::copy(rowStartPtr + colStart, rowStartPtr + colEnd, dataOut.begin() + int64_t(row - rowStart) * outCols);
+    }
+}
+
+void CiftiMatrixPyramid::poolFromFile(const CiftiFile* ciftiFile, const int32_t& level, const int32_t& rowStart, const int32_t& rowEnd,
+                                      const int32_t& colStart, const int32_t& colEnd, const PoolingMode& mode, vector<float>& dataOut) const
+{
+    CaretAssert(ciftiFile != NULL);
+    CaretAssert(ciftiFile->getNumberOfRows() == m_rows && ciftiFile->getNumberOfColumns() == m_cols);
+    int32_t poolSize = getPoolSize(level);
+    int32_t outCols = colEnd - colStart;
+    int64_t numOut = int64_t(rowEnd - rowStart) * outCols;
+    int32_t firstCol = colStart * poolSize, endCol = min(colEnd * poolSize, m_cols);
+    int32_t endRow = min(rowEnd * poolSize, m_rows);
+    PoolAccumulator region;
+    region.init(numOut);
+    vector<float> rowData(m_cols);
+    for (int32_t displayRow = rowStart * poolSize; displayRow < endRow; ++displayRow)
+    {
+        ciftiFile->getRow(rowData.data(), (m_fileRowForDisplayRow.empty() ? displayRow : m_fileRowForDisplayRow[displayRow]));
+        int64_t base = int64_t(displayRow / poolSize - rowStart) * outCols;
+        for (int32_t col = firstCol; col < endCol; ++col)
+        {
+            region.add(base + col / poolSize - colStart, rowData[col]);
+        }
+    }
+    dataOut.resize(numOut);
+    for (int64_t i = 0; i < numOut; ++i)
+    {
+        dataOut[i] = region.getValue(i, mode);
+    }
+}
+
+AString CiftiMatrixPyramid::getCacheFileName(const AString& ciftiFileName)
+{
+    return ciftiFileName + ".wbpyramid";
+}
+
+void CiftiMatrixPyramid::writeCacheFile(const AString& ciftiFileName) const
+{
+    if (!m_fileRowForDisplayRow.empty()) throw CaretException("matrix pyramids of reordered rows cannot be saved");
+    AString cacheFileName = getCacheFileName(ciftiFileName);
+    QFile myFile(cacheFileName);
+    if (!myFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        throw DataFileException(cacheFileName, "unable to open for writing: " + myFile.errorString());
+    }
+    qint64 sourceSize, sourceModified;
+    getSourceFileInfo(ciftiFileName, sourceSize, sourceModified);
+    QDataStream myStream(&myFile);
+    myStream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    myStream << CACHE_MAGIC << CACHE_VERSION << sourceSize << sourceModified;
+    myStream << qint32(m_rows) << qint32(m_cols) << qint32(m_numLevels) << qint32(m_firstStoredLevel);
+    for (size_t i = 0; i < m_storedLevels.size(); ++i)
+    {
+        const Level& thisLevel = m_storedLevels[i];
+        int64_t numCells = int64_t(thisLevel.m_rows) * thisLevel.m_cols;
+        for (int64_t j = 0; j < numCells; ++j)
+        {
+            myStream << thisLevel.m_mean[j];
+        }
+        for (int64_t j = 0; j < numCells; ++j)
+        {
+            myStream << thisLevel.m_maxMagnitude[j];
+        }
+    }
+    if (myStream.status() != QDataStream::Ok)
+    {
+        throw DataFileException(cacheFileName, "error while writing: " + myFile.errorString());
+    }
+}
+
+bool CiftiMatrixPyramid::readCacheFile(const AString& ciftiFileName)
+{
+    QFile myFile(getCacheFileName(ciftiFileName));
+    if (!myFile.exists() || !myFile.open(QIODevice::ReadOnly)) return false;
+    QDataStream myStream(&myFile);
+    myStream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    quint32 magic;
+    qint32 version;
+    qint64 sourceSize, sourceModified, expectSize, expectModified;
+    myStream >> magic >> version >> sourceSize >> sourceModified;
+    getSourceFileInfo(ciftiFileName, expectSize, expectModified);
+    if (myStream.status() != QDataStream::Ok || magic != CACHE_MAGIC || version != CACHE_VERSION ||
+        sourceSize != expectSize || sourceModified != expectModified)
+    {
+        return false;//stale caches are simply rebuilt
+    }
+    CiftiMatrixPyramid temp;
+    qint32 rows, cols, numLevels, firstStoredLevel;
+    myStream >> rows >> cols >> numLevels >> firstStoredLevel;
+    if (myStream.status() != QDataStream::Ok || rows < 1 || cols < 1 || numLevels < 1 || numLevels > 32 ||
+        firstStoredLevel < 1 || firstStoredLevel > numLevels) return false;
+    temp.m_rows = rows;
+    temp.m_cols = cols;
+    temp.m_numLevels = numLevels;
+    temp.m_firstStoredLevel = firstStoredLevel;
+    for (int32_t level = firstStoredLevel; level < numLevels; ++level)
+    {
+        temp.m_storedLevels.push_back(Level());
+        Level& thisLevel = temp.m_storedLevels.back();
+        temp.getLevelDimensions(level, thisLevel.m_rows, thisLevel.m_cols);
+        int64_t numCells = int64_t(thisLevel.m_rows) * thisLevel.m_cols;
+        thisLevel.m_mean.resize(numCells);
+        thisLevel.m_maxMagnitude.resize(numCells);
+        for (int64_t j = 0; j < numCells; ++j)
+        {
+            myStream >> thisLevel.m_mean[j];
+        }
+        for (int64_t j = 0; j < numCells; ++j)
+        {
+            myStream >> thisLevel.m_maxMagnitude[j];
+        }
+        if (myStream.status() != QDataStream::Ok) return false;
+    }
+    *this = temp;
+    return true;
+}
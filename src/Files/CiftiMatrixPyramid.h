@@ -0,0 +1,98 @@
+#ifndef __CIFTI_MATRIX_PYRAMID_H__
+#define __CIFTI_MATRIX_PYRAMID_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AString.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace caret {
+
+    class CiftiFile;
+
+    ///multi-resolution pooled copies of a cifti matrix, so that a view of a large matrix only needs the level of detail that fits on screen
+    ///level N pools blocks of 2^N by 2^N cells, level 0 is the matrix itself
+    ///only levels that fit in the memory limit are stored, finer levels are pooled from the file on request, for the requested cells only
+    class CiftiMatrixPyramid
+    {
+    public:
+        enum PoolingMode
+        {
+            MEAN,
+            MAXIMUM_MAGNITUDE//value with the largest absolute value, keeping its sign
+        };
+    private:
+        struct Level
+        {
+            int32_t m_rows, m_cols;
+            std::vector<float> m_mean, m_maxMagnitude;
+        };
+        int32_t m_rows, m_cols, m_numLevels, m_firstStoredLevel;
+        std::vector<Level> m_storedLevels;//m_storedLevels[0] is level m_firstStoredLevel
+        std::vector<int32_t> m_fileRowForDisplayRow;//empty means the same order as the file
+        void poolFromFile(const CiftiFile* ciftiFile, const int32_t& level, const int32_t& rowStart, const int32_t& rowEnd,
+                          const int32_t& colStart, const int32_t& colEnd, const PoolingMode& mode, std::vector<float>& dataOut) const;
+    public:
+        static const int64_t DEFAULT_MAXIMUM_STORED_CELLS = 4 * 1024 * 1024;
+
+        CiftiMatrixPyramid();
+
+        ///reads each row of the file once, display row rowIndices[i] is file row i, as for reordered parcel matrices (empty for file order)
+        void build(const CiftiFile* ciftiFile, const std::vector<int32_t>& rowIndices, const int64_t& maximumStoredCells = DEFAULT_MAXIMUM_STORED_CELLS);
+
+        bool isValid() const { return m_numLevels > 0; }
+
+        int32_t getNumberOfRows() const { return m_rows; }
+
+        int32_t getNumberOfColumns() const { return m_cols; }
+
+        int32_t getNumberOfLevels() const { return m_numLevels; }
+
+        static int32_t getPoolSize(const int32_t& level) { return 1 << level; }
+
+        void getLevelDimensions(const int32_t& level, int32_t& rowsOut, int32_t& colsOut) const;
+
+        bool isLevelStored(const int32_t& level) const { return level >= m_firstStoredLevel && level < m_numLevels; }
+
+        ///finest level whose pooled cells each cover at least cellsPerPixel cells, so that drawn cells are not smaller than a pixel
+        ///unstored levels are only chosen when the view covers few enough rows to pool them from the file quickly
+        int32_t getLevelForView(const float& cellsPerPixel, const int32_t& visibleRows) const;
+
+        ///pooled values of cells [rowStart, rowEnd) x [colStart, colEnd) of a level, row-major
+        ///ciftiFile must be the file the pyramid was built from, it is only read for levels that are not stored
+        void getLevelData(const CiftiFile* ciftiFile, const int32_t& level, const PoolingMode& mode, const int32_t& rowStart, const int32_t& rowEnd,
+                          const int32_t& colStart, const int32_t& colEnd, std::vector<float>& dataOut) const;
+
+        ///name of the cache file beside a cifti file
+        static AString getCacheFileName(const AString& ciftiFileName);
+
+        ///saves the stored levels, only pyramids in file row order can be saved
+        void writeCacheFile(const AString& ciftiFileName) const;
+
+        ///returns false if there is no cache file, or it is out of date with respect to the cifti file
+        bool readCacheFile(const AString& ciftiFileName);
+    };
+
+}
+
+#endif //__CIFTI_MATRIX_PYRAMID_H__
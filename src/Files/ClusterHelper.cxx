@@ -0,0 +1,255 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "ClusterHelper.h"
+
+#include "CaretAssert.h"
+#include "CaretException.h"
+#include "SurfaceFile.h"
+#include "TopologyHelper.h"
+
+#include <limits>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    //roots are always the lowest index in the set, which gives the cluster ordering for free
+    template <typename T>
+    T findRoot(vector<T>& parent, T elem)
+    {
+        while (parent[elem] != elem)
+        {
+            parent[elem] = parent[parent[elem]];//path halving
+            elem = parent[elem];
+        }
+        return elem;
+    }
+    
+    template <typename T>
+    void unite(vector<T>& parent, const T& first, const T& second)
+    {
+        T root1 = findRoot(parent, first), root2 = findRoot(parent, second);
+        if (root1 < root2)
+        {
+            parent[root2] = root1;
+        } else {
+            parent[root1] = root2;
+        }
+    }
+    
+    struct VoxelRun
+    {
+        int64_t m_start, m_end;//along i, end is exclusive
+    };
+}
+
+ClusterHelper::ClusterHelper(const SurfaceFile* mySurf)
+{
+    CaretAssert(mySurf != NULL);
+    m_isSurface = true;
+    m_numElements = mySurf->getNumberOfNodes();
+    m_dims[0] = m_numElements; m_dims[1] = 1; m_dims[2] = 1;
+    CaretPointer<TopologyHelper> myTopoHelp = mySurf->getTopologyHelper();
+    m_neighborStart.resize(m_numElements + 1);
+    m_neighborStart[0] = 0;
+    for (int64_t i = 0; i < m_numElements; ++i)
+    {
+        const vector<int32_t>& neighbors = myTopoHelp->getNodeNeighbors(i);
+        for (int n = 0; n < (int)neighbors.size(); ++n)
+        {
+            if (neighbors[n] > i) m_neighbors.push_back(neighbors[n]);
+        }
+        m_neighborStart[i + 1] = (int64_t)m_neighbors.size();
+    }
+}
+
+ClusterHelper::ClusterHelper(const vector<int64_t>& dims)
+{
+    CaretAssert(dims.size() >= 3);
+    m_isSurface = false;
+    m_numElements = dims[0] * dims[1] * dims[2];
+    m_dims[0] = dims[0]; m_dims[1] = dims[1]; m_dims[2] = dims[2];
+    if (m_numElements - 1 > numeric_limits<int32_t>::max())
+    {
+        throw CaretException("volume too large for cluster labeling");
+    }
+}
+
+void ClusterHelper::findClusters(const char* marked, vector<int32_t>& labelsOut, vector<double>& sizesOut, const float* elementSizes) const
+{
+    labelsOut.assign(m_numElements, -1);
+    sizesOut.clear();
+    if (!m_isSurface)
+    {
+        findVoxelClusters(marked, labelsOut, sizesOut, elementSizes);
+        return;
+    }
+    vector<int64_t> parent;
+    findSurfaceClusters(marked, parent);
+    for (int64_t i = 0; i < m_numElements; ++i)
+    {//roots come before the rest of their cluster, so one increasing pass numbers and sums everything
+        if (!marked[i]) continue;
+        int64_t root = parent[i];//fully compressed by findSurfaceClusters
+        int32_t label;
+        if (root == i)
+        {
+            label = (int32_t)sizesOut.size();
+            sizesOut.push_back(0.0);
+        } else {
+            label = labelsOut[root];
+        }
+        labelsOut[i] = label;
+        sizesOut[label] += (elementSizes == NULL ? 1.0 : elementSizes[i]);
+    }
+}
+
+void ClusterHelper::findSurfaceClusters(const char* marked, vector<int64_t>& parent) const
+{
+    parent.resize(m_numElements);
+    for (int64_t i = 0; i < m_numElements; ++i)
+    {
+        parent[i] = i;
+    }
+    for (int64_t i = 0; i < m_numElements; ++i)
+    {
+        if (!marked[i]) continue;
+        for (int64_t n = m_neighborStart[i]; n < m_neighborStart[i + 1]; ++n)
+        {
+            int64_t neighbor = m_neighbors[n];
+            if (marked[neighbor]) unite(parent, i, neighbor);
+        }
+    }
+    for (int64_t i = 0; i < m_numElements; ++i)
+    {//parents always have lower index, so this leaves every element pointing directly at its root
+        parent[i] = parent[parent[i]];
+    }
+}
+
+void ClusterHelper::findVoxelClusters(const char* marked, vector<int32_t>& labelsOut, vector<double>& sizesOut, const float* elementSizes) const
+{//first pass finds runs along i and joins runs that overlap in the previous row and the previous slice, second pass labels voxels by run
+    int64_t numRows = m_dims[1] * m_dims[2];
+    vector<VoxelRun> runs;
+    vector<int64_t> rowStart(numRows + 1, 0);
+    vector<int64_t> parent;
+    for (int64_t k = 0; k < m_dims[2]; ++k)
+    {
+        for (int64_t j = 0; j < m_dims[1]; ++j)
+        {
+            int64_t row = j + m_dims[1] * k;
+            rowStart[row] = (int64_t)runs.size();
+            const char* rowMarked = marked + row * m_dims[0];
+            int64_t i = 0;
+            while (i < m_dims[0])
+            {
+                if (!rowMarked[i])
+                {
+                    ++i;
+                    continue;
+                }
+                VoxelRun newRun;
+                newRun.m_start = i;
+                while (i < m_dims[0] && rowMarked[i]) ++i;
+                newRun.m_end = i;
+                parent.push_back((int64_t)runs.size());
+                runs.push_back(newRun);
+            }
+            int64_t thisStart = rowStart[row], thisEnd = (int64_t)runs.size();
+            for (int whichPrev = 0; whichPrev < 2; ++whichPrev)
+            {
+                int64_t prevRow;
+                if (whichPrev == 0)
+                {
+                    if (j == 0) continue;
+                    prevRow = row - 1;
+                } else {
+                    if (k == 0) continue;
+                    prevRow = row - m_dims[1];
+                }
+                int64_t prev = rowStart[prevRow], prevEnd = rowStart[prevRow + 1];
+                int64_t cur = thisStart;
+                while (prev < prevEnd && cur < thisEnd)
+                {//runs in a row are sorted and disjoint, so step through both lists together
+                    if (runs[prev].m_start < runs[cur].m_end && runs[cur].m_start < runs[prev].m_end)
+                    {
+                        unite(parent, prev, cur);
+                    }
+                    if (runs[prev].m_end < runs[cur].m_end)
+                    {
+                        ++prev;
+                    } else {
+                        ++cur;
+                    }
+                }
+            }
+            rowStart[row + 1] = (int64_t)runs.size();
+        }
+    }
+    int64_t numRuns = (int64_t)runs.size();
+    vector<int32_t> runLabel(numRuns);
+    for (int64_t r = 0; r < numRuns; ++r)
+    {//runs are created in voxel index order, so roots (lowest run of each set) come first, as in the surface case
+        int64_t root = findRoot(parent, r);
+        if (root == r)
+        {
+            runLabel[r] = (int32_t)sizesOut.size();
+            sizesOut.push_back(0.0);
+        } else {
+            runLabel[r] = runLabel[root];
+        }
+    }
+    for (int64_t row = 0; row < numRows; ++row)
+    {
+        int64_t rowOffset = row * m_dims[0];
+        for (int64_t r = rowStart[row]; r < rowStart[row + 1]; ++r)
+        {
+            int32_t label = runLabel[r];
+            for (int64_t i = runs[r].m_start; i < runs[r].m_end; ++i)
+            {
+                labelsOut[rowOffset + i] = label;
+            }
+            if (elementSizes == NULL)
+            {
+                sizesOut[label] += runs[r].m_end - runs[r].m_start;
+            } else {
+                for (int64_t i = runs[r].m_start; i < runs[r].m_end; ++i)
+                {
+                    sizesOut[label] += elementSizes[rowOffset + i];
+                }
+            }
+        }
+    }
+}
+
+void ClusterHelper::getClusterMembers(const vector<int32_t>& labels, const int32_t& numClusters, vector<vector<int64_t> >& membersOut)
+{
+    membersOut.clear();
+    membersOut.resize(numClusters);
+    int64_t numElements = (int64_t)labels.size();
+    for (int64_t i = 0; i < numElements; ++i)
+    {
+        if (labels[i] >= 0)
+        {
+            CaretAssertVectorIndex(membersOut, labels[i]);
+            membersOut[labels[i]].push_back(i);
+        }
+    }
+}
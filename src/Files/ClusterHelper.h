@@ -0,0 +1,62 @@
+#ifndef __CLUSTER_HELPER_H__
+#define __CLUSTER_HELPER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+namespace caret {
+
+    class SurfaceFile;
+    
+    ///connected components of marked elements on a surface or a voxel grid, built once and then used on many maps
+    ///clusters are numbered in order of their lowest-index element, which matches the order of a flood fill started from each element in index order
+    class ClusterHelper
+    {
+        int64_t m_numElements;
+        int64_t m_dims[3];//voxel grid, only used if there are no neighbor lists
+        std::vector<int64_t> m_neighborStart;//compressed lists of only the higher-index neighbors, so each edge is visited once
+        std::vector<int32_t> m_neighbors;
+        bool m_isSurface;
+        void findSurfaceClusters(const char* marked, std::vector<int64_t>& parent) const;
+        void findVoxelClusters(const char* marked, std::vector<int32_t>& labelsOut, std::vector<double>& sizesOut, const float* elementSizes) const;
+    public:
+        explicit ClusterHelper(const SurfaceFile* mySurf);
+        
+        ///voxels touching by face are neighbors
+        explicit ClusterHelper(const std::vector<int64_t>& dims);
+        
+        int64_t getNumberOfElements() const { return m_numElements; }
+        
+        ///labelsOut gets the cluster number of each element, or -1 if not marked
+        ///sizesOut gets the sum of elementSizes for each cluster, or the number of elements if elementSizes is NULL
+        ///can be called from multiple threads at once
+        void findClusters(const char* marked, std::vector<int32_t>& labelsOut, std::vector<double>& sizesOut, const float* elementSizes = NULL) const;
+        
+        ///lists of the elements in each cluster, in increasing order
+        static void getClusterMembers(const std::vector<int32_t>& labels, const int32_t& numClusters, std::vector<std::vector<int64_t> >& membersOut);
+    };
+
+}
+
+#endif //__CLUSTER_HELPER_H__
@@ -114,6 +114,39 @@ FiberOrientationTrajectory::addFiberFractionsForAveraging(const FiberFractions&
     }
 }
 
+/**
+ * Replace the sums for averaging with sums that were accumulated elsewhere,
+ * such as by CaretSparseFile::addFibersRowToSums() for many trajectories
+ * at once.  Same result as adding each of the fiber fractions with
+ * addFiberFractionsForAveraging().
+ *
+ * @param totalCountSum
+ *    Sum of total counts.
+ * @param fiberCountsSum
+ *    Sums of each fiber fraction multiplied by its total count.
+ * @param distanceSum
+ *    Sum of distances.
+ * @param countForAveraging
+ *    Number of fiber fractions in the sums, including those with a zero total count.
+ */
+void
+FiberOrientationTrajectory::setSumsForAveraging(const double totalCountSum,
+                                                const double fiberCountsSum[3],
+                                                const double distanceSum,
+                                                const int64_t countForAveraging)
+{
+    m_totalCountSum = totalCountSum;
+    if (totalCountSum > 0.0) {
+        m_fiberCountsSum.assign(fiberCountsSum,
+                                fiberCountsSum + 3);
+    }
+    else {
+        m_fiberCountsSum.clear();
+    }
+    m_distanceSum = distanceSum;
+    m_countForAveraging = countForAveraging;
+}
+
 /**
  * Set a fiber fraction.
  *
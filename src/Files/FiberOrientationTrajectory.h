@@ -41,6 +41,11 @@ namespace caret {
         
         void addFiberFractionsForAveraging(const FiberFractions& fiberFraction);
         
+        void setSumsForAveraging(const double totalCountSum,
+                                 const double fiberCountsSum[3],
+                                 const double distanceSum,
+                                 const int64_t countForAveraging);
+        
         void setFiberFractions(const FiberFractions& fiberFraction);
         
         /**
@@ -949,6 +949,64 @@ int32_t GeodesicHelper::closest(const int32_t& root, const char* roi, const floa
     return ret;
 }
 
+void GeodesicHelper::closestAll(const char* roi, const float& maxdist, int32_t* closestOut, bool smooth)
+{//distances are symmetric, so the distance from the nearest roi node is the distance to it
+    int32_t i, j, whichnode, whichneigh, numNeigh, numChanged = 0;
+    const int32_t* neighbors;
+    float tempf;
+    m_active.clear();
+    for (i = 0; i < numNodes; ++i)
+    {
+        closestOut[i] = -1;
+        if (roi[i] != 0)
+        {
+            output[i] = 0.0f;
+            closestOut[i] = i;
+            changed[numChanged++] = i;
+            marked[i] |= 4;
+            m_heapIdent[i] = m_active.push(i, 0.0f);
+        }
+    }
+    while (!m_active.isEmpty())
+    {
+        whichnode = m_active.pop();
+        marked[whichnode] |= 1;
+        for (int pass = 0; pass < (smooth ? 2 : 1); ++pass)
+        {
+            const vector<float>& theseDists = (pass == 0 ? distances[whichnode] : distances2[whichnode]);
+            neighbors = (pass == 0 ? nodeNeighbors[whichnode].data() : nodeNeighbors2[whichnode].data());
+            numNeigh = (pass == 0 ? (int32_t)nodeNeighbors[whichnode].size() : (int32_t)nodeNeighbors2[whichnode].size());
+            for (j = 0; j < numNeigh; ++j)
+            {
+                whichneigh = neighbors[j];
+                if (!(marked[whichneigh] & 1))
+                {
+                    tempf = output[whichnode] + theseDists[j];
+                    if (tempf <= maxdist)
+                    {
+                        if (!(marked[whichneigh] & 4))
+                        {
+                            changed[numChanged++] = whichneigh;
+                            marked[whichneigh] |= 4;
+                            output[whichneigh] = tempf;
+                            closestOut[whichneigh] = closestOut[whichnode];
+                            m_heapIdent[whichneigh] = m_active.push(whichneigh, tempf);
+                        } else if (tempf < output[whichneigh]) {
+                            m_active.changekey(m_heapIdent[whichneigh], tempf);
+                            output[whichneigh] = tempf;
+                            closestOut[whichneigh] = closestOut[whichnode];
+                        }
+                    }
+                }
+            }
+        }
+    }
+    for (i = 0; i < numChanged; ++i)
+    {
+        marked[changed[i]] = 0;
+    }
+}
+
 int32_t GeodesicHelper::closest(const int32_t& root, const char* roi, bool smooth)
 {
     int32_t i, j, whichnode, whichneigh, numNeigh, numChanged = 0, ret = -1;
@@ -1499,6 +1557,20 @@ int32_t GeodesicHelper::getClosestNodeInRoi(const int32_t& root, const char* roi
     return closest(root, roi, maxdist, distOut, smoothflag);
 }
 
+void GeodesicHelper::getClosestNodesInRoi(const char* roi, const float& maxdist, vector<int32_t>& closestOut, vector<float>& distsOut, bool smoothflag)
+{
+    CaretAssert(maxdist >= 0.0f);
+    closestOut.assign(numNodes, -1);
+    distsOut.assign(numNodes, -1.0f);
+    if (maxdist < 0.0f) return;
+    CaretMutexLocker locked(&inUse);//let sanity checks fail without locking
+    closestAll(roi, maxdist, closestOut.data(), smoothflag);
+    for (int32_t i = 0; i < numNodes; ++i)
+    {
+        if (closestOut[i] != -1) distsOut[i] = output[i];
+    }
+}
+
 int32_t GeodesicHelper::getClosestNodeInRoi(const int32_t& root, const char* roi, vector<int32_t>& pathNodesOut, vector<float>& pathDistsOut, bool smoothflag)
 {
     CaretAssert(root >= 0 && root < numNodes);
@@ -91,6 +91,7 @@ namespace caret {
         void alltoall(float** out, int32_t** parents, bool smooth);//must be fully allocated
         int32_t closest(const int32_t& root, const char* roi, const float& maxdist, float& distOut, bool smooth);//just closest node
         int32_t closest(const int32_t& root, const char* roi, bool smooth);//just closest node
+        void closestAll(const char* roi, const float& maxdist, int32_t* closestOut, bool smooth);//closest roi node for every node, one sweep from the whole roi
         void aStar(const int32_t root, const int32_t endpoint, bool smooth);//faster method for path
         float linePenalty(const Vector3D& pos, const Vector3D& linep1, const Vector3D& linep2, const bool& segment);
         float lineHeuristic(const Vector3D& pos, const Vector3D& linep1, const Vector3D& linep2, const float& remainEucl, const bool& segment);
@@ -141,6 +142,9 @@ namespace caret {
         ///get just the closest node in the region and max distance given, returns -1 if no such node found - roi value of 0 means not in region, anything else is in region
         int32_t getClosestNodeInRoi(const int32_t& root, const char* roi, const float& maxdist, float& distOut, bool smoothflag = true);
         int32_t getClosestNodeInRoi(const int32_t& root, const char* roi, std::vector<int32_t>& pathNodesOut, std::vector<float>& pathDistsOut, bool smoothflag);
+        
+        ///closest node in the region for every node, by growing from all region nodes at once, -1 and distance -1 where nothing is within max distance - same answers as getClosestNodeInRoi from each node, for the cost of one search
+        void getClosestNodesInRoi(const char* roi, const float& maxdist, std::vector<int32_t>& closestOut, std::vector<float>& distsOut, bool smoothflag = true);
     };
 
 } //namespace caret
@@ -0,0 +1,165 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "LabelProbabilityAccumulator.h"
+
+#include "CaretAssert.h"
+#include "CaretOMP.h"
+#include "GiftiLabelTable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+
+using namespace caret;
+using namespace std;
+
+LabelProbabilityAccumulator::LabelProbabilityAccumulator(const int64_t& numElements, const bool& excludeUnlabeled)
+{
+    m_numElements = numElements;
+    m_numMaps = 0;
+    m_excludeUnlabeled = excludeUnlabeled;
+}
+
+int LabelProbabilityAccumulator::addLabelTable(const GiftiLabelTable* table)
+{
+    CaretAssert(table != NULL);
+    set<int32_t> keys = table->getKeys();
+    int32_t unlabeledKey = -1;//don't request it from the table if we aren't going to skip it, because requesting it can add it to the table
+    if (m_excludeUnlabeled)
+    {
+        unlabeledKey = table->getUnassignedLabelKey();
+    }
+    map<int32_t, int> keyToLabel;
+    for (set<int32_t>::iterator iter = keys.begin(); iter != keys.end(); ++iter)//order by key value
+    {
+        if (m_excludeUnlabeled && *iter == unlabeledKey) continue;
+        const AString thisName = table->getLabelName(*iter);
+        map<AString, int>::iterator search = m_nameToLabel.find(thisName);
+        int label = -1;
+        if (search == m_nameToLabel.end())
+        {
+            label = (int)m_labelNames.size();
+            m_nameToLabel[thisName] = label;
+            m_labelNames.push_back(thisName);
+            m_counts.push_back(vector<int32_t>(m_numElements, 0));
+        } else {
+            label = search->second;
+        }
+        keyToLabel[*iter] = label;
+    }
+    KeyLookup newLookup;
+    newLookup.m_minKey = 0;
+    if (!keyToLabel.empty())
+    {
+        newLookup.m_minKey = keyToLabel.begin()->first;
+        int64_t range = (int64_t)keyToLabel.rbegin()->first - newLookup.m_minKey + 1;
+        if (range <= max((int64_t)65536, 4 * (int64_t)keyToLabel.size()))
+        {//a dense table makes the lookup a subtraction and an index
+            newLookup.m_dense.resize(range, -1);
+            for (map<int32_t, int>::iterator iter = keyToLabel.begin(); iter != keyToLabel.end(); ++iter)
+            {
+                newLookup.m_dense[(int64_t)iter->first - newLookup.m_minKey] = iter->second;
+            }
+        } else {
+            newLookup.m_sparse = keyToLabel;
+        }
+    }
+    m_lookups.push_back(newLookup);
+    return (int)m_lookups.size() - 1;
+}
+
+void LabelProbabilityAccumulator::addMap(const int& tableHandle, const int32_t* keys)
+{
+    CaretAssertVectorIndex(m_lookups, tableHandle);
+    const KeyLookup& myLookup = m_lookups[tableHandle];
+    int64_t numElements = m_numElements;
+#pragma omp CARET_PARFOR schedule(static)
+    for (int64_t i = 0; i < numElements; ++i)
+    {//each element is only touched by one thread, so the counts need no per-thread copies or atomics
+        int label = myLookup.find(keys[i]);
+        if (label >= 0) ++m_counts[label][i];
+    }
+    ++m_numMaps;
+}
+
+void LabelProbabilityAccumulator::addMap(const int& tableHandle, const float* keys)
+{
+    CaretAssertVectorIndex(m_lookups, tableHandle);
+    const KeyLookup& myLookup = m_lookups[tableHandle];
+    int64_t numElements = m_numElements;
+#pragma omp CARET_PARFOR schedule(static)
+    for (int64_t i = 0; i < numElements; ++i)
+    {
+        int label = myLookup.find((int32_t)floor(keys[i] + 0.5f));
+        if (label >= 0) ++m_counts[label][i];
+    }
+    ++m_numMaps;
+}
+
+void LabelProbabilityAccumulator::startRowMajorMaps(const vector<int>& tableHandles)
+{
+    for (size_t i = 0; i < tableHandles.size(); ++i)
+    {
+        CaretAssertVectorIndex(m_lookups, tableHandles[i]);
+    }
+    m_rowMajorTables = tableHandles;
+    m_numMaps += (int64_t)tableHandles.size();
+}
+
+void LabelProbabilityAccumulator::addRows(const int64_t& firstRow, const int64_t& numRows, const float* rowData)
+{
+    CaretAssert(firstRow >= 0 && firstRow + numRows <= m_numElements);
+    const int64_t rowLength = (int64_t)m_rowMajorTables.size();
+#pragma omp CARET_PARFOR schedule(static)
+    for (int64_t r = 0; r < numRows; ++r)
+    {
+        const float* thisRow = rowData + r * rowLength;
+        const int64_t element = firstRow + r;
+        for (int64_t m = 0; m < rowLength; ++m)
+        {
+            int label = m_lookups[m_rowMajorTables[m]].find((int32_t)floor(thisRow[m] + 0.5f));
+            if (label >= 0) ++m_counts[label][element];
+        }
+    }
+}
+
+const AString& LabelProbabilityAccumulator::getLabelName(const int& label) const
+{
+    CaretAssertVectorIndex(m_labelNames, label);
+    return m_labelNames[label];
+}
+
+const vector<int32_t>& LabelProbabilityAccumulator::getCounts(const int& label) const
+{
+    CaretAssertVectorIndex(m_counts, label);
+    return m_counts[label];
+}
+
+void LabelProbabilityAccumulator::getProbabilities(const int& label, float* dataOut) const
+{
+    CaretAssertVectorIndex(m_counts, label);
+    const vector<int32_t>& counts = m_counts[label];
+    const float divisor = (float)max(m_numMaps, (int64_t)1);
+    for (int64_t i = 0; i < m_numElements; ++i)
+    {
+        dataOut[i] = counts[i] / divisor;
+    }
+}
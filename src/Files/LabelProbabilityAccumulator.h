@@ -0,0 +1,95 @@
+#ifndef __LABEL_PROBABILITY_ACCUMULATOR_H__
+#define __LABEL_PROBABILITY_ACCUMULATOR_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AString.h"
+
+#include <map>
+#include <stdint.h>
+#include <vector>
+
+namespace caret {
+    
+    class GiftiLabelTable;
+    
+    ///counts how often each label occurs at each vertex/voxel over any number of maps, which may come from different files, one map or block of rows at a time
+    ///labels are matched by name, each label table is compiled once into a lookup from key to dense label index
+    class LabelProbabilityAccumulator
+    {
+        struct KeyLookup
+        {
+            int32_t m_minKey;
+            std::vector<int> m_dense;//key - m_minKey to label index, -1 for not counted
+            std::map<int32_t, int> m_sparse;//used instead when keys are too spread out for a dense table
+            int find(const int32_t& key) const
+            {
+                if (m_dense.empty())
+                {
+                    std::map<int32_t, int>::const_iterator iter = m_sparse.find(key);
+                    if (iter == m_sparse.end()) return -1;
+                    return iter->second;
+                }
+                int64_t offset = (int64_t)key - m_minKey;
+                if (offset < 0 || offset >= (int64_t)m_dense.size()) return -1;
+                return m_dense[offset];
+            }
+        };
+        int64_t m_numElements, m_numMaps;
+        bool m_excludeUnlabeled;
+        std::vector<KeyLookup> m_lookups;
+        std::map<AString, int> m_nameToLabel;
+        std::vector<AString> m_labelNames;
+        std::vector<std::vector<int32_t> > m_counts;//[label][element]
+        std::vector<int> m_rowMajorTables;
+        LabelProbabilityAccumulator();
+    public:
+        LabelProbabilityAccumulator(const int64_t& numElements, const bool& excludeUnlabeled);
+        
+        ///compile a label table, returns the handle to use for the maps that use it
+        int addLabelTable(const GiftiLabelTable* table);
+        
+        ///count one map stored as keys, for instance from a label file
+        void addMap(const int& tableHandle, const int32_t* keys);
+        
+        ///count one map stored as floats, for instance a column of a dlabel file
+        void addMap(const int& tableHandle, const float* keys);
+        
+        ///for files with elements as rows (dlabel), give the table handle of each map (column), then call addRows until every row is added
+        void startRowMajorMaps(const std::vector<int>& tableHandles);
+        
+        ///numRows consecutive rows, each containing one key per map given to startRowMajorMaps
+        void addRows(const int64_t& firstRow, const int64_t& numRows, const float* rowData);
+        
+        int64_t getNumberOfMaps() const { return m_numMaps; }
+        int getNumberOfLabels() const { return (int)m_labelNames.size(); }
+        ///labels are in order of first appearance, which for a single label table is sorted by key
+        const AString& getLabelName(const int& label) const;
+        
+        const std::vector<int32_t>& getCounts(const int& label) const;
+        
+        ///count divided by number of maps
+        void getProbabilities(const int& label, float* dataOut) const;
+    };
+    
+}
+
+#endif //__LABEL_PROBABILITY_ACCUMULATOR_H__
@@ -35,6 +35,7 @@
 #include "CaretOMP.h"
 #include "GiftiLabel.h"
 #include "GiftiLabelTable.h"
+#include "GiftiLabelTableLookup.h"
 #include "GroupAndNameHierarchyItem.h"
 #include "Palette.h"
 #include "PaletteColorMapping.h"
@@ -728,60 +729,91 @@ NodeAndVoxelColoring::colorIndicesWithLabelTableForDisplayGroupTabPrivate(const
             break;
     }
     
+    /*
+     * Label selection is resolved once per label, so that each
+     * node or voxel only needs its key mapped to a label index
+     */
+    const CaretPointer<const GiftiLabelTableLookup> labelLookup = labelTable->getLookup();
+    std::vector<char> labelDisplayed;
+    getLabelDisplayedStatus(labelLookup,
+                            displayGroup,
+                            tabIndex,
+                            labelDisplayed);
+    
     /*
      * Assign colors from labels to nodes
      */
-    float labelRGBA[4];
 	for (int64_t i = 0; i < numberOfIndices; i++) {
-        const int64_t labelKey = static_cast<int64_t>(labelIndices[i]);
-        const GiftiLabel* gl = labelTable->getLabel(labelKey);
-        if (gl != NULL) {
-            const GroupAndNameHierarchyItem* item = gl->getGroupNameSelectionItem();
-            bool colorDataFlag = false;
-            if (item != NULL) {
-                if (tabIndex == NodeAndVoxelColoring::INVALID_TAB_INDEX) {
-                    colorDataFlag = true;
-                }
-                else if (item->isSelected(displayGroup, tabIndex)) {
-                    colorDataFlag = true;
-                }
-            }
-            else {
-                colorDataFlag = true;
-            }
+        const int32_t labelIndex = labelLookup->find(static_cast<int32_t>(static_cast<int64_t>(labelIndices[i])));
+        if (labelIndex < 0) {
+            continue;
+        }
+        if ( ! labelDisplayed[labelIndex]) {
+            continue;
+        }
+        const float* labelRGBA = labelLookup->getColor(labelIndex);
+        if (labelRGBA[3] > 0.0) {
+            const int64_t i4 = i * 4;
             
-            if (colorDataFlag) {
-                gl->getColor(labelRGBA);
-                if (labelRGBA[3] > 0.0) {
-                    const int64_t i4 = i * 4;
-                    
-                    switch (colorDataType) {
-                        case COLOR_TYPE_FLOAT:
-                            CaretAssertArrayIndex(rgbaFloat, numberOfIndices * 4, i*4+3);
-                            rgbaFloat[i*4] = labelRGBA[0];
-                            rgbaFloat[i*4+1] = labelRGBA[1];
-                            rgbaFloat[i*4+2] = labelRGBA[2];
-                            rgbaFloat[i*4+3] = labelRGBA[3];
-                            break;
-                        case COLOR_TYPE_UNSIGNED_BTYE:
-                            CaretAssertArrayIndex(rgbaUnsignedByte, numberOfIndices * 4, i*4+3);
-                            rgbaUnsignedByte[i4]   = labelRGBA[0] * 255.0;
-                            rgbaUnsignedByte[i4+1] = labelRGBA[1] * 255.0;
-                            rgbaUnsignedByte[i4+2] = labelRGBA[2] * 255.0;
-                            if (labelRGBA[3] > 0.0) {
-                                rgbaUnsignedByte[i4+3] = labelRGBA[3] * 255.0;
-                            }
-                            else {
-                                rgbaUnsignedByte[i4+3] = 0;
-                            }
-                            break;
-                    }
+            switch (colorDataType) {
+                case COLOR_TYPE_FLOAT:
+                    CaretAssertArrayIndex(rgbaFloat, numberOfIndices * 4, i*4+3);
+                    rgbaFloat[i4]   = labelRGBA[0];
+                    rgbaFloat[i4+1] = labelRGBA[1];
+                    rgbaFloat[i4+2] = labelRGBA[2];
+                    rgbaFloat[i4+3] = labelRGBA[3];
+                    break;
+                case COLOR_TYPE_UNSIGNED_BTYE:
+                {
+                    CaretAssertArrayIndex(rgbaUnsignedByte, numberOfIndices * 4, i*4+3);
+                    const uint8_t* labelRGBAByte = labelLookup->getColorByte(labelIndex);
+                    rgbaUnsignedByte[i4]   = labelRGBAByte[0];
+                    rgbaUnsignedByte[i4+1] = labelRGBAByte[1];
+                    rgbaUnsignedByte[i4+2] = labelRGBAByte[2];
+                    rgbaUnsignedByte[i4+3] = labelRGBAByte[3];
+                    break;
                 }
             }
         }
     }
 }
 
+/**
+ * Get the display status of each label in a compiled label table, for
+ * the selected display group and tab.  A label is displayed if it is not
+ * in the group and name hierarchy, if there is no tab, or if its item in
+ * the hierarchy is selected.
+ *
+ * @param labelLookup
+ *    Compiled label table from GiftiLabelTable::getLookup().
+ * @param displayGroup
+ *    The selected display group.
+ * @param tabIndex
+ *    Index of selected tab.
+ * @param displayedOut
+ *    Output with nonzero for each label index that is displayed.
+ */
+void
+NodeAndVoxelColoring::getLabelDisplayedStatus(const GiftiLabelTableLookup* labelLookup,
+                                              const DisplayGroupEnum::Enum displayGroup,
+                                              const int32_t tabIndex,
+                                              std::vector<char>& displayedOut)
+{
+    CaretAssert(labelLookup);
+    const int32_t numberOfLabels = labelLookup->getNumberOfLabels();
+    displayedOut.resize(numberOfLabels);
+    for (int32_t i = 0; i < numberOfLabels; i++) {
+        const GroupAndNameHierarchyItem* item = labelLookup->getLabel(i)->getGroupNameSelectionItem();
+        bool displayedFlag = true;
+        if (item != NULL) {
+            if (tabIndex != NodeAndVoxelColoring::INVALID_TAB_INDEX) {
+                displayedFlag = item->isSelected(displayGroup, tabIndex);
+            }
+        }
+        displayedOut[i] = (displayedFlag ? 1 : 0);
+    }
+}
+
 /**
  * Assign colors to label indices using a GIFTI label table.
  *
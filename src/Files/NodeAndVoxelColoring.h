@@ -22,6 +22,7 @@
 /*LICENSE_END*/
 
 #include <stdint.h>
+#include <vector>
 
 #include "CaretColorEnum.h"
 #include "DisplayGroupEnum.h"
@@ -30,6 +31,7 @@
 namespace caret {
     class FastStatistics;
     class GiftiLabelTable;
+    class GiftiLabelTableLookup;
     class Palette;
     class PaletteColorMapping;
     
@@ -89,6 +91,11 @@ namespace caret {
                                                const int64_t numberOfIndices,
                                                uint8_t* rgbv);
         
+        static void getLabelDisplayedStatus(const GiftiLabelTableLookup* labelLookup,
+                                            const DisplayGroupEnum::Enum displayGroup,
+                                            const int32_t tabIndex,
+                                            std::vector<char>& displayedOut);
+        
         static void convertSliceColoringToOutlineMode(uint8_t* rgbaInOut,
                                                       const LabelDrawingTypeEnum::Enum labelDrawingType,
                                                       const CaretColorEnum::Enum labelOutlineColor,
@@ -43,12 +43,15 @@
 #include "SceneClassArray.h"
 #include "SceneFileSaxReader.h"
 #include "SceneInfo.h"
+#include "SceneInfoSaxReader.h"
 #include "ScenePathName.h"
 #include "SceneXmlElements.h"
+#include "SceneXmlIndex.h"
 #include "SceneWriterXml.h"
 #include "SpecFile.h"
 #include "SystemUtilities.h"
 #include "XmlSaxParser.h"
+#include "XmlUtilities.h"
 #include "XmlWriter.h"
 
 using namespace caret;
@@ -595,7 +598,18 @@ SceneFile::readFile(const AString& filenameIn)
                                  filename);
     std::auto_ptr<XmlSaxParser> parser(XmlSaxParser::createXmlParser());
     try {
-        parser->parseFile(filename, &saxReader);
+        /*
+         * Files with many scenes open much faster when the scenes and
+         * thumbnails are only parsed when they are used
+         */
+        CaretPointer<SceneXmlIndex> xmlIndex(new SceneXmlIndex());
+        if (( ! DataFile::isFileOnNetwork(filename))
+            && xmlIndex->indexFile(filename)) {
+            readIndexedFile(xmlIndex);
+        }
+        else {
+            parser->parseFile(filename, &saxReader);
+        }
     }
     catch (const XmlSaxParserException& e) {
         clear();
@@ -627,6 +641,72 @@ SceneFile::readFile(const AString& filenameIn)
     this->clearModified();
 }
 
+/**
+ * Read the scene file using an index of the file.  The scene infos
+ * are read but their thumbnail images and the scenes' classes are left in
+ * the file until they are used.
+ *
+ * @param xmlIndex
+ *    Index of the scene file.
+ * @throws XmlSaxParserException
+ *    If there is an error reading the file.
+ */
+void
+SceneFile::readIndexedFile(const CaretPointer<const SceneXmlIndex>& xmlIndex)
+{
+    std::unique_ptr<XmlSaxParser> parser(XmlSaxParser::createXmlParser());
+    
+    /*
+     * Metadata and the rest of the scene info directory
+     */
+    QByteArray xmlBytes;
+    xmlIndex->readFileWithoutScenes(xmlBytes);
+    SceneFileSaxReader saxReader(this,
+                                 getFileName());
+    parser->parseString(QString::fromUtf8(xmlBytes),
+                        &saxReader);
+    
+    const int32_t numberOfScenes = xmlIndex->getNumberOfScenes();
+    for (int32_t i = 0; i < numberOfScenes; i++) {
+        const SceneXmlIndex::SceneEntry& sceneEntry = xmlIndex->getScene(i);
+        bool validName = false;
+        const SceneTypeEnum::Enum sceneType = SceneTypeEnum::fromName(sceneEntry.m_sceneTypeName,
+                                                                      &validName);
+        if ( ! validName) {
+            const AString msg = XmlUtilities::createInvalidAttributeMessage(SceneXmlElements::SCENE_TAG,
+                                                                            SceneXmlElements::SCENE_TYPE_ATTRIBUTE,
+                                                                            sceneEntry.m_sceneTypeName);
+            XmlSaxParserException e(msg);
+            CaretLogThrowing(e);
+            throw e;
+        }
+        Scene* scene = new Scene(sceneType);
+        scene->setLazyContent(xmlIndex,
+                              i);
+        addScene(scene);
+    }
+    
+    /*
+     * The index has verified that there is one scene info for each scene
+     */
+    const int32_t numberOfSceneInfos = xmlIndex->getNumberOfSceneInfos();
+    for (int32_t i = 0; i < numberOfSceneInfos; i++) {
+        const SceneXmlIndex::SceneInfoEntry& sceneInfoEntry = xmlIndex->getSceneInfo(i);
+        xmlIndex->readSceneInfoWithoutImage(i,
+                                            xmlBytes);
+        std::unique_ptr<SceneInfo> sceneInfo(new SceneInfo());
+        SceneInfoSaxReader sceneInfoSaxReader(getFileName(),
+                                              sceneInfo.get());
+        parser->parseString(QString::fromUtf8(xmlBytes),
+                            &sceneInfoSaxReader);
+        if (sceneInfoEntry.m_imageRange.m_length > 0) {
+            sceneInfo->setLazyImage(xmlIndex,
+                                    i);
+        }
+        getSceneAtIndex(sceneInfoEntry.m_sceneIndex)->setSceneInfo(sceneInfo.release());
+    }
+}
+
 /**
  * Write the scene file.
  * @param filename
@@ -643,6 +723,15 @@ SceneFile::writeFile(const AString& filename)
     }
     checkFileWritability(filename);
     
+    /*
+     * Scenes may still be reading from this file
+     */
+    for (std::vector<Scene*>::iterator iter = m_scenes.begin();
+         iter != m_scenes.end();
+         iter++) {
+        (*iter)->loadAllContent();
+    }
+    
     this->setFileName(filename);
     
     try {
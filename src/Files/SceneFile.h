@@ -23,11 +23,13 @@
 
 
 #include "CaretDataFile.h"
+#include "CaretPointer.h"
 #include "SceneFileBasePathTypeEnum.h"
 
 namespace caret {
 
     class Scene;
+    class SceneXmlIndex;
     
     class SceneFile : public CaretDataFile {
         
@@ -141,6 +143,7 @@ namespace caret {
         static const AString XML_ATTRIBUTE_VERSION;
         
     private:
+        void readIndexedFile(const CaretPointer<const SceneXmlIndex>& xmlIndex);
 
         /** the scenes*/
         std::vector<Scene*> m_scenes;
@@ -45,6 +45,7 @@
 #include "GeodesicHelper.h"
 #include "PlainTextStringBuilder.h"
 #include "SignedDistanceHelper.h"
+#include "SurfaceTriangleBVH.h"
 #include "TopologyHelper.h"
 
 using namespace caret;
@@ -537,6 +538,7 @@ void
 SurfaceFile::copyHelperSurfaceFile(const SurfaceFile& /*sf*/)
 {
     this->validateDataArraysAfterReading();
+    invalidateHelpers();//operator= replaces the coordinates and triangles, so helpers made for the old ones are wrong
 }
 
 /**
@@ -884,6 +886,11 @@ void SurfaceFile::invalidateHelpers()
         CaretMutexLocker myLock3(&m_locatorMutex);
         m_locator.grabNew(NULL);
     }
+    if (m_triangleBVH != NULL)
+    {
+        CaretMutexLocker myLock5(&m_triangleBVHMutex);
+        m_triangleBVH.grabNew(NULL);
+    }
 }
 
 /**
@@ -988,6 +995,7 @@ SurfaceFile::applyMatrix(const Matrix4x4& matrix)
             matrix.multiplyPoint3(&coordinatePointer[i*3]);
         }
     }
+    invalidateHelpers();//geodesic, locator and triangle BVH helpers depend on coordinates
     
     computeNormals();
     
@@ -1188,6 +1196,20 @@ CaretPointer<const CaretPointLocator> SurfaceFile::getPointLocator() const
     return m_locator;
 }
 
+CaretPointer<const SurfaceTriangleBVH> SurfaceFile::getTriangleBVH() const
+{
+    if (m_triangleBVH == NULL)
+    {
+        CaretMutexLocker myLock(&m_triangleBVHMutex);
+        if (m_triangleBVH == NULL)
+        {
+            const int32_t numTriangles = getNumberOfTriangles();
+            m_triangleBVH.grabNew(new SurfaceTriangleBVH(getCoordinateData(), getNumberOfNodes(), (numTriangles > 0 ? getTriangle(0) : NULL), numTriangles));
+        }
+    }
+    return m_triangleBVH;
+}
+
 void SurfaceFile::clearCachedHelpers() const
 {
     {
@@ -1212,6 +1234,10 @@ void SurfaceFile::clearCachedHelpers() const
         CaretMutexLocker locked(&m_locatorMutex);
         m_locator.grabNew(NULL);
     }
+    {
+        CaretMutexLocker locked(&m_triangleBVHMutex);
+        m_triangleBVH.grabNew(NULL);
+    }
 }
 
 /**
@@ -204,6 +204,17 @@ void SurfaceResamplingHelper::getResampleValidROI(float* output) const
     }
 }
 
+void SurfaceResamplingHelper::getWeights(const int& newNode, vector<pair<int, float> >& weightsOut) const
+{
+    CaretAssert(newNode >= 0 && newNode < (int)m_weights.size() - 1);
+    weightsOut.clear();
+    WeightElem* end = m_weights[newNode + 1];
+    for (WeightElem* elem = m_weights[newNode]; elem != end; ++elem)
+    {
+        weightsOut.push_back(make_pair(elem->node, elem->weight));
+    }
+}
+
 void SurfaceResamplingHelper::resampleCutSurface(const SurfaceFile* cutSurfaceIn, const SurfaceFile* currentSphere, const SurfaceFile* newSphere, SurfaceFile* surfaceOut)
 {
     if (cutSurfaceIn->getNumberOfNodes() != currentSphere->getNumberOfNodes()) throw CaretException("input surface has different number of nodes than input sphere");
@@ -25,6 +25,7 @@
 #include "SurfaceResamplingMethodEnum.h"
 
 #include <map>
+#include <utility>
 #include <vector>
 
 namespace caret {
@@ -64,6 +65,8 @@ namespace caret {
         void resampleLargest(const int32_t* input, int32_t* output, const int32_t& invalidVal = 0) const;
         ///get the ROI of nodes that have data within the input ROI
         void getResampleValidROI(float* output) const;
+        ///get the current nodes and weights that make up one new node, empty if the new node has no data within the input ROI
+        void getWeights(const int& newNode, std::vector<std::pair<int, float> >& weightsOut) const;
         
         ///resample a cut surface - not something you will apply multiple times, so static method
         static void resampleCutSurface(const SurfaceFile* cutSurfaceIn, const SurfaceFile* curSphere, const SurfaceFile* newSphere, SurfaceFile* surfaceOut);
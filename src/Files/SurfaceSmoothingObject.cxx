@@ -0,0 +1,148 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "SurfaceSmoothingObject.h"
+
+#include "CaretAssert.h"
+#include "CaretOMP.h"
+#include "MathFunctions.h"
+#include "ProgressObject.h"
+#include "SurfaceFile.h"
+#include "TopologyHelper.h"
+
+#include <cmath>
+
+using namespace std;
+using namespace caret;
+
+SurfaceSmoothingObject::SurfaceSmoothingObject(const SurfaceFile* mySurf)
+{
+    m_numNodes = mySurf->getNumberOfNodes();
+    CaretPointer<TopologyHelper> myTopoHelp = mySurf->getTopologyHelper(true);//sorted, so consecutive neighbors form triangles with the center
+    m_neighborStart.resize(m_numNodes + 1);
+    m_neighborStart[0] = 0;
+    m_maxNeighbors = 0;
+    for (int32_t i = 0; i < m_numNodes; ++i)
+    {
+        int32_t numNeighbors = 0;
+        myTopoHelp->getNodeNeighbors(i, numNeighbors);
+        m_neighborStart[i + 1] = m_neighborStart[i] + numNeighbors;
+        if (numNeighbors > m_maxNeighbors) m_maxNeighbors = numNeighbors;
+    }
+    m_neighbors.resize(m_neighborStart[m_numNodes]);
+    for (int32_t i = 0; i < m_numNodes; ++i)
+    {
+        int32_t numNeighbors = 0;
+        const int32_t* neighbors = myTopoHelp->getNodeNeighbors(i, numNeighbors);
+        for (int32_t j = 0; j < numNeighbors; ++j)
+        {
+            m_neighbors[m_neighborStart[i] + j] = neighbors[j];
+        }
+    }
+    const float* coordData = mySurf->getCoordinateData();
+    m_coords.assign(coordData, coordData + m_numNodes * 3);
+    m_scratchCoords.resize(m_numNodes * 3);
+}
+
+void SurfaceSmoothingObject::smooth(const float& strength, const int32_t& iterations, LevelProgress* myProgress, const float& progressStart, const float& progressEnd)
+{
+    const float inverseStrength = 1.0f - strength;
+    const int32_t numNodes = m_numNodes;
+    for (int32_t iter = 1; iter <= iterations; ++iter)
+    {
+        const float* coordsIn = m_coords.data();
+        float* coordsOut = m_scratchCoords.data();
+#pragma omp CARET_PAR
+        {
+            vector<float> triangleAreas(m_maxNeighbors), triangleCenters(m_maxNeighbors * 3);
+#pragma omp CARET_FOR schedule(static)
+            for (int32_t iNode = 0; iNode < numNodes; ++iNode)
+            {
+                const int32_t numNeighbors = (int32_t)(m_neighborStart[iNode + 1] - m_neighborStart[iNode]);
+                const int32_t* neighbors = m_neighbors.data() + m_neighborStart[iNode];
+                const float* c1 = coordsIn + iNode * 3;
+                if (numNeighbors < 2)
+                {
+                    coordsOut[iNode * 3] = c1[0];
+                    coordsOut[iNode * 3 + 1] = c1[1];
+                    coordsOut[iNode * 3 + 2] = c1[2];
+                    continue;
+                }
+                double totalArea = 0.0;
+                for (int32_t jn = 0; jn < numNeighbors; ++jn)
+                {//area and center of the triangle formed with each pair of consecutive neighbors
+                    const float* c2 = coordsIn + neighbors[jn] * 3;
+                    const float* c3 = coordsIn + neighbors[(jn + 1 == numNeighbors) ? 0 : jn + 1] * 3;
+                    const float area = MathFunctions::triangleArea(c1, c2, c3);
+                    triangleAreas[jn] = area;
+                    totalArea += area;
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        triangleCenters[jn * 3 + k] = (c1[k] + c2[k] + c3[k]) / 3.0;
+                    }
+                }
+                float neighborAverageX = 0.0f, neighborAverageY = 0.0f, neighborAverageZ = 0.0f;
+                for (int32_t j = 0; j < numNeighbors; ++j)
+                {
+                    if (triangleAreas[j] > 0.0f)
+                    {
+                        const float weight = triangleAreas[j] / totalArea;
+                        neighborAverageX += weight * triangleCenters[j * 3];
+                        neighborAverageY += weight * triangleCenters[j * 3 + 1];
+                        neighborAverageZ += weight * triangleCenters[j * 3 + 2];
+                    }
+                }
+                coordsOut[iNode * 3] = c1[0] * inverseStrength + neighborAverageX * strength;
+                coordsOut[iNode * 3 + 1] = c1[1] * inverseStrength + neighborAverageY * strength;
+                coordsOut[iNode * 3 + 2] = c1[2] * inverseStrength + neighborAverageZ * strength;
+            }
+        }
+        m_coords.swap(m_scratchCoords);//the output of this iteration is the input of the next
+        if (myProgress != NULL)
+        {
+            myProgress->reportProgress(progressStart + (progressEnd - progressStart) * iter / iterations);
+        }
+    }
+}
+
+void SurfaceSmoothingObject::inflate(const float& rangeX, const float& rangeY, const float& rangeZ, const float& inflationFactor)
+{
+    const int32_t numNodes = m_numNodes;
+    float* coords = m_coords.data();
+#pragma omp CARET_PARFOR schedule(static)
+    for (int32_t iNode = 0; iNode < numNodes; ++iNode)
+    {
+        float* xyz = coords + iNode * 3;
+        const float x = xyz[0] / rangeX;
+        const float y = xyz[1] / rangeY;
+        const float z = xyz[2] / rangeZ;
+        const float radius = sqrt(x * x + y * y + z * z);
+        const float scale = 1.0 + inflationFactor * (1.0 - radius);
+        xyz[0] *= scale;
+        xyz[1] *= scale;
+        xyz[2] *= scale;
+    }
+}
+
+void SurfaceSmoothingObject::copyCoordinatesTo(SurfaceFile* surfOut) const
+{
+    CaretAssert(surfOut->getNumberOfNodes() == m_numNodes);
+    surfOut->setCoordinates(m_coords.data());
+}
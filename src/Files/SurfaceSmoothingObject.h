@@ -0,0 +1,61 @@
+#ifndef __SURFACE_SMOOTHING_OBJECT_H__
+#define __SURFACE_SMOOTHING_OBJECT_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+//NOTE: this holds a flat copy of the sorted neighbor lists and the coordinates, so that repeated smoothing and inflation cycles
+//      don't go through TopologyHelper or SurfaceFile for every vertex of every iteration.  Iterations alternate between two coordinate
+//      buffers, and each iteration is parallel across vertices.
+
+#include "stdint.h"
+#include "stddef.h"
+#include <vector>
+
+namespace caret {
+    
+    class LevelProgress;
+    class SurfaceFile;
+    
+    class SurfaceSmoothingObject
+    {
+    public:
+        SurfaceSmoothingObject(const SurfaceFile* mySurf);
+        
+        ///same method as -surface-smoothing: move each vertex toward the area-weighted average of the centers of the triangles formed with consecutive neighbors
+        ///reports progress from progressStart to progressEnd, if myProgress is not NULL
+        void smooth(const float& strength, const int32_t& iterations, LevelProgress* myProgress = NULL, const float& progressStart = 0.0f, const float& progressEnd = 1.0f);
+        
+        ///same method as -surface-inflation: scale each coordinate by 1 + factor * (1 - radius), where radius is measured with the coordinates divided by the ranges
+        void inflate(const float& rangeX, const float& rangeY, const float& rangeZ, const float& inflationFactor);
+        
+        const float* getCoordinates() const { return m_coords.data(); }
+        void copyCoordinatesTo(SurfaceFile* surfOut) const;
+    private:
+        int32_t m_numNodes, m_maxNeighbors;
+        std::vector<int64_t> m_neighborStart;//m_numNodes + 1 offsets into m_neighbors
+        std::vector<int32_t> m_neighbors;
+        std::vector<float> m_coords, m_scratchCoords;//xyz interleaved, because neighbor lookups need all three of a vertex at once
+        SurfaceSmoothingObject();
+    };
+    
+}
+
+#endif //__SURFACE_SMOOTHING_OBJECT_H__
@@ -0,0 +1,195 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "SurfaceTriangleBVH.h"
+
+#include "CaretAssert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    const int32_t LEAF_SIZE = 4;
+    
+    struct CenterLess
+    {
+        const vector<float>& m_centers;
+        int m_axis;
+        CenterLess(const vector<float>& centers, const int& axis) : m_centers(centers), m_axis(axis) { }
+        bool operator()(const int32_t& lhs, const int32_t& rhs) const { return m_centers[lhs * 3 + m_axis] < m_centers[rhs * 3 + m_axis]; }
+    };
+}
+
+SurfaceTriangleBVH::SurfaceTriangleBVH(const float* coords, const int32_t& numNodes, const int32_t* triangles, const int32_t& numTriangles)
+{
+    m_coords.assign(coords, coords + numNodes * 3);//copy, so that we can't be left pointing to freed memory
+    m_triangles.assign(triangles, triangles + numTriangles * 3);
+    vector<float> centers(numTriangles * 3);
+    m_order.resize(numTriangles);
+    for (int32_t i = 0; i < numTriangles; ++i)
+    {
+        m_order[i] = i;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            centers[i * 3 + axis] = (m_coords[m_triangles[i * 3] * 3 + axis] + m_coords[m_triangles[i * 3 + 1] * 3 + axis] + m_coords[m_triangles[i * 3 + 2] * 3 + axis]) / 3.0f;
+        }
+    }
+    if (numTriangles > 0)
+    {
+        m_nodes.reserve(2 * (numTriangles / LEAF_SIZE + 1));
+        buildNode(centers, 0, numTriangles);
+    }
+}
+
+int32_t SurfaceTriangleBVH::buildNode(const vector<float>& centers, const int32_t& first, const int32_t& count)
+{//split at the median center along the longest axis of the centers' extent
+    int32_t myIndex = (int32_t)m_nodes.size();
+    m_nodes.push_back(Node());
+    float boxMin[3], boxMax[3], centerMin[3], centerMax[3];
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        boxMin[axis] = centerMin[axis] = numeric_limits<float>::max();
+        boxMax[axis] = centerMax[axis] = -numeric_limits<float>::max();
+    }
+    for (int32_t i = first; i < first + count; ++i)
+    {
+        int32_t tri = m_order[i];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            for (int v = 0; v < 3; ++v)
+            {
+                float coord = m_coords[m_triangles[tri * 3 + v] * 3 + axis];
+                boxMin[axis] = min(boxMin[axis], coord);
+                boxMax[axis] = max(boxMax[axis], coord);
+            }
+            centerMin[axis] = min(centerMin[axis], centers[tri * 3 + axis]);
+            centerMax[axis] = max(centerMax[axis], centers[tri * 3 + axis]);
+        }
+    }
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        m_nodes[myIndex].m_min[axis] = boxMin[axis];
+        m_nodes[myIndex].m_max[axis] = boxMax[axis];
+    }
+    if (count <= LEAF_SIZE)
+    {
+        m_nodes[myIndex].m_first = first;
+        m_nodes[myIndex].m_count = count;
+        return myIndex;
+    }
+    int splitAxis = 0;
+    for (int axis = 1; axis < 3; ++axis)
+    {
+        if (centerMax[axis] - centerMin[axis] > centerMax[splitAxis] - centerMin[splitAxis]) splitAxis = axis;
+    }
+    int32_t half = count / 2;
+    nth_element(m_order.begin() + first, m_order.begin() + first + half, m_order.begin() + first + count, CenterLess(centers, splitAxis));
+    buildNode(centers, first, half);//first child is always next in the array
+    int32_t secondChild = buildNode(centers, first + half, count - half);
+    m_nodes[myIndex].m_first = secondChild;//don't hold a reference across the recursion, the vector may have reallocated
+    m_nodes[myIndex].m_count = 0;
+    return myIndex;
+}
+
+bool SurfaceTriangleBVH::rayHitsBox(const Node& node, const float origin[3], const float inverseDir[3], const float& maxDistance) const
+{
+    float tmin = 0.0f, tmax = maxDistance;
+    for (int axis = 0; axis < 3; ++axis)
+    {//infinite inverse direction works out, except when the origin is exactly on the slab boundary, which just gives a false positive
+        float t1 = (node.m_min[axis] - origin[axis]) * inverseDir[axis];
+        float t2 = (node.m_max[axis] - origin[axis]) * inverseDir[axis];
+        if (t1 > t2) swap(t1, t2);
+        if (t1 > tmin) tmin = t1;
+        if (t2 < tmax) tmax = t2;
+        if (tmin > tmax) return false;
+    }
+    return true;
+}
+
+void SurfaceTriangleBVH::getRayIntersections(const float origin[3], const float direction[3], const float& maxDistance, vector<Hit>& hitsOut) const
+{
+    hitsOut.clear();
+    if (m_nodes.empty()) return;
+    float inverseDir[3];
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        inverseDir[axis] = 1.0f / direction[axis];//may be infinite
+    }
+    vector<int32_t> stack(1, 0);
+    while (!stack.empty())
+    {
+        const Node& thisNode = m_nodes[stack.back()];
+        int32_t thisIndex = stack.back();
+        stack.pop_back();
+        if (!rayHitsBox(thisNode, origin, inverseDir, maxDistance)) continue;
+        if (thisNode.m_count == 0)
+        {
+            stack.push_back(thisNode.m_first);
+            stack.push_back(thisIndex + 1);
+            continue;
+        }
+        for (int32_t i = thisNode.m_first; i < thisNode.m_first + thisNode.m_count; ++i)
+        {//Moller-Trumbore
+            int32_t tri = m_order[i];
+            const float* v0 = m_coords.data() + m_triangles[tri * 3] * 3;
+            const float* v1 = m_coords.data() + m_triangles[tri * 3 + 1] * 3;
+            const float* v2 = m_coords.data() + m_triangles[tri * 3 + 2] * 3;
+            double edge1[3], edge2[3], pvec[3], tvec[3], qvec[3];
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                edge1[axis] = v1[axis] - v0[axis];
+                edge2[axis] = v2[axis] - v0[axis];
+                tvec[axis] = origin[axis] - v0[axis];
+            }
+            pvec[0] = direction[1] * edge2[2] - direction[2] * edge2[1];
+            pvec[1] = direction[2] * edge2[0] - direction[0] * edge2[2];
+            pvec[2] = direction[0] * edge2[1] - direction[1] * edge2[0];
+            double det = edge1[0] * pvec[0] + edge1[1] * pvec[1] + edge1[2] * pvec[2];
+            if (det == 0.0) continue;//parallel or degenerate
+            double invDet = 1.0 / det;
+            double u = (tvec[0] * pvec[0] + tvec[1] * pvec[1] + tvec[2] * pvec[2]) * invDet;
+            if (u < 0.0 || u > 1.0) continue;
+            qvec[0] = tvec[1] * edge1[2] - tvec[2] * edge1[1];
+            qvec[1] = tvec[2] * edge1[0] - tvec[0] * edge1[2];
+            qvec[2] = tvec[0] * edge1[1] - tvec[1] * edge1[0];
+            double v = (direction[0] * qvec[0] + direction[1] * qvec[1] + direction[2] * qvec[2]) * invDet;
+            if (v < 0.0 || u + v > 1.0) continue;
+            double t = (edge2[0] * qvec[0] + edge2[1] * qvec[1] + edge2[2] * qvec[2]) * invDet;
+            if (t < 0.0 || t > maxDistance) continue;
+            Hit myHit;
+            myHit.m_triangle = tri;
+            myHit.m_distance = (float)t;
+            myHit.m_barycentric[0] = (float)(1.0 - u - v);
+            myHit.m_barycentric[1] = (float)u;
+            myHit.m_barycentric[2] = (float)v;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                myHit.m_xyz[axis] = (float)(origin[axis] + t * direction[axis]);
+            }
+            hitsOut.push_back(myHit);
+        }
+    }
+    sort(hitsOut.begin(), hitsOut.end());
+}
@@ -0,0 +1,61 @@
+#ifndef __SURFACE_TRIANGLE_BVH_H__
+#define __SURFACE_TRIANGLE_BVH_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <stdint.h>
+#include <vector>
+
+namespace caret {
+
+    ///bounding volume hierarchy over the triangles of a surface, for finding what a ray hits without drawing anything
+    class SurfaceTriangleBVH
+    {
+        struct Node
+        {
+            float m_min[3], m_max[3];
+            int32_t m_first, m_count;//leaf: range in m_order, internal: m_first is the second child (first child is next in the array), m_count is 0
+        };
+        std::vector<Node> m_nodes;
+        std::vector<int32_t> m_order;//triangle indices, grouped by leaf
+        std::vector<float> m_coords;
+        std::vector<int32_t> m_triangles;
+        int32_t buildNode(const std::vector<float>& centers, const int32_t& first, const int32_t& count);
+        bool rayHitsBox(const Node& node, const float origin[3], const float inverseDir[3], const float& maxDistance) const;
+    public:
+        struct Hit
+        {
+            int32_t m_triangle;
+            float m_distance;//in units of the direction vector's length
+            float m_barycentric[3];//weights of the triangle's vertices, in order
+            float m_xyz[3];
+            bool operator<(const Hit& rhs) const { return m_distance < rhs.m_distance; }
+        };
+        
+        SurfaceTriangleBVH(const float* coords, const int32_t& numNodes, const int32_t* triangles, const int32_t& numTriangles);
+        
+        ///all triangles hit by the ray between 0 and maxDistance, sorted by increasing distance, triangles are hit from either side
+        void getRayIntersections(const float origin[3], const float direction[3], const float& maxDistance, std::vector<Hit>& hitsOut) const;
+    };
+
+}
+
+#endif //__SURFACE_TRIANGLE_BVH_H__
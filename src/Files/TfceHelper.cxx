@@ -0,0 +1,268 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "TfceHelper.h"
+
+#include "CaretAssert.h"
+#include "CaretException.h"
+#include "SurfaceFile.h"
+#include "TopologyHelper.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    //union-find with path compression, offsets are kept relative to the parent, so compressing accumulates them
+    int32_t findRoot(const int32_t& elem, vector<int32_t>& parent, vector<double>& offset)
+    {
+        int32_t myParent = parent[elem];
+        if (myParent == elem) return elem;
+        int32_t root = findRoot(myParent, parent, offset);
+        if (myParent != root)
+        {
+            offset[elem] += offset[myParent];//parent's offset is now relative to root
+            parent[elem] = root;
+        }
+        return root;
+    }
+    
+    //integrate the slice of the cluster between its last value and the new bottom value
+    void integrateTo(const int32_t& root, const float& bottomVal, const double& param_e, const double& integrated_h, vector<double>& accum, vector<double>& area, vector<float>& lastVal)
+    {
+        if (bottomVal != lastVal[root])//skip computing if there is no difference
+        {
+            CaretAssert(bottomVal < lastVal[root]);
+            accum[root] += pow(area[root], param_e) * (pow((double)lastVal[root], integrated_h) - pow((double)bottomVal, integrated_h)) / integrated_h;
+            lastVal[root] = bottomVal;//computing in double precision, with float for inputs, puts the smallest difference between values far greater than the instability of the computation
+        }
+    }
+    
+    bool greaterValue(const pair<float, int32_t>& left, const pair<float, int32_t>& right)
+    {
+        return left.first > right.first;
+    }
+}
+
+TfceHelper::TfceHelper(const int64_t& dataSize)
+{
+    m_dataSize = dataSize;
+    m_neighborStart.push_back(0);
+}
+
+void TfceHelper::checkElementCount(const int64_t& numNew) const
+{
+    if ((int64_t)m_dataIndex.size() + numNew > (int64_t)numeric_limits<int32_t>::max())
+    {
+        throw CaretException("too many elements for TFCE");
+    }
+}
+
+void TfceHelper::addSurface(const SurfaceFile* mySurf, const float* areaData, const vector<int64_t>& nodeToData)
+{
+    int32_t numNodes = mySurf->getNumberOfNodes();
+    CaretAssert((int64_t)nodeToData.size() == numNodes);
+    vector<int32_t> nodeToElem(numNodes, -1);
+    int64_t numUsed = 0;
+    for (int32_t i = 0; i < numNodes; ++i)
+    {
+        if (nodeToData[i] >= 0) ++numUsed;
+    }
+    checkElementCount(numUsed);
+    int32_t nextElem = (int32_t)m_dataIndex.size();
+    for (int32_t i = 0; i < numNodes; ++i)
+    {
+        if (nodeToData[i] >= 0)
+        {
+            CaretAssert(nodeToData[i] < m_dataSize);
+            nodeToElem[i] = nextElem;
+            ++nextElem;
+            m_dataIndex.push_back(nodeToData[i]);
+            m_areas.push_back(areaData[i]);
+        }
+    }
+    CaretPointer<TopologyHelper> myTopoHelp = mySurf->getTopologyHelper();
+    for (int32_t i = 0; i < numNodes; ++i)
+    {
+        if (nodeToElem[i] < 0) continue;
+        const vector<int32_t>& neighbors = myTopoHelp->getNodeNeighbors(i);
+        int numNeigh = (int)neighbors.size();
+        for (int j = 0; j < numNeigh; ++j)
+        {
+            int32_t neighElem = nodeToElem[neighbors[j]];
+            if (neighElem >= 0) m_neighbors.push_back(neighElem);
+        }
+        m_neighborStart.push_back((int64_t)m_neighbors.size());
+    }
+}
+
+void TfceHelper::addVoxels(const vector<int64_t>& voxelIJK, const vector<int64_t>& dataIndices, const float& voxelVolume)
+{
+    int64_t numVoxels = (int64_t)dataIndices.size();
+    CaretAssert((int64_t)voxelIJK.size() == numVoxels * 3);
+    if (numVoxels == 0) return;
+    checkElementCount(numVoxels);
+    int64_t minIJK[3], maxIJK[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        minIJK[i] = voxelIJK[i];
+        maxIJK[i] = voxelIJK[i];
+    }
+    for (int64_t v = 1; v < numVoxels; ++v)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            minIJK[i] = min(minIJK[i], voxelIJK[v * 3 + i]);
+            maxIJK[i] = max(maxIJK[i], voxelIJK[v * 3 + i]);
+        }
+    }
+    int64_t boxDims[3] = { maxIJK[0] - minIJK[0] + 1, maxIJK[1] - minIJK[1] + 1, maxIJK[2] - minIJK[2] + 1 };
+    vector<int32_t> boxToElem(boxDims[0] * boxDims[1] * boxDims[2], -1);//bounding box lookup, to find neighbors
+    int32_t firstElem = (int32_t)m_dataIndex.size();
+    for (int64_t v = 0; v < numVoxels; ++v)
+    {
+        CaretAssert(dataIndices[v] >= 0 && dataIndices[v] < m_dataSize);
+        const int64_t* ijk = voxelIJK.data() + v * 3;
+        boxToElem[(ijk[0] - minIJK[0]) + boxDims[0] * ((ijk[1] - minIJK[1]) + boxDims[1] * (ijk[2] - minIJK[2]))] = firstElem + (int32_t)v;
+        m_dataIndex.push_back(dataIndices[v]);
+        m_areas.push_back(voxelVolume);
+    }
+    const int STENCIL_SIZE = 18;
+    const int64_t stencil[STENCIL_SIZE] = { 0, 0, -1,
+                                            0, -1, 0,
+                                            -1, 0, 0,
+                                            1, 0, 0,
+                                            0, 1, 0,
+                                            0, 0, 1 };
+    for (int64_t v = 0; v < numVoxels; ++v)
+    {
+        const int64_t* ijk = voxelIJK.data() + v * 3;
+        for (int s = 0; s < STENCIL_SIZE; s += 3)
+        {
+            int64_t boxIJK[3] = { ijk[0] - minIJK[0] + stencil[s], ijk[1] - minIJK[1] + stencil[s + 1], ijk[2] - minIJK[2] + stencil[s + 2] };
+            if (boxIJK[0] < 0 || boxIJK[0] >= boxDims[0] ||
+                boxIJK[1] < 0 || boxIJK[1] >= boxDims[1] ||
+                boxIJK[2] < 0 || boxIJK[2] >= boxDims[2]) continue;
+            int32_t neighElem = boxToElem[boxIJK[0] + boxDims[0] * (boxIJK[1] + boxDims[1] * boxIJK[2])];
+            if (neighElem >= 0) m_neighbors.push_back(neighElem);
+        }
+        m_neighborStart.push_back((int64_t)m_neighbors.size());
+    }
+}
+
+void TfceHelper::compute(const float* data, float* outData, const float& param_e, const float& param_h, Workspace& scratch) const
+{
+    int32_t numElems = (int32_t)m_dataIndex.size();
+    for (int64_t i = 0; i < m_dataSize; ++i)
+    {
+        outData[i] = 0.0f;
+    }
+    scratch.m_order.clear();
+    for (int32_t i = 0; i < numElems; ++i)
+    {
+        float value = data[m_dataIndex[i]];
+        if (value > 0.0f)
+        {
+            scratch.m_order.push_back(pair<float, int32_t>(value, i));
+        } else if (value < 0.0f) {//NaN is neither
+            scratch.m_order.push_back(pair<float, int32_t>(-value, i));
+        }
+    }
+    //positive and negative clusters never merge, so do both in one sweep from the largest magnitude down
+    sort(scratch.m_order.begin(), scratch.m_order.end(), greaterValue);
+    vector<int32_t>& parent = scratch.m_parent, &clusterSize = scratch.m_size, &roots = scratch.m_roots;
+    vector<double>& offset = scratch.m_offset, &accum = scratch.m_accum, &area = scratch.m_area;
+    vector<float>& lastVal = scratch.m_lastVal;
+    parent.assign(numElems, -1);//-1 means not reached yet
+    clusterSize.resize(numElems);
+    offset.resize(numElems);
+    accum.resize(numElems);
+    area.resize(numElems);
+    lastVal.resize(numElems);
+    const double param_e_d = param_e, integrated_h = param_h + 1.0;//integral(x^h) = (x^(h + 1))/(h + 1) + C
+    int64_t numSorted = (int64_t)scratch.m_order.size();
+    for (int64_t s = 0; s < numSorted; ++s)
+    {
+        const float value = scratch.m_order[s].first;
+        const int32_t elem = scratch.m_order[s].second;
+        const bool positive = data[m_dataIndex[elem]] > 0.0f;
+        roots.clear();
+        for (int64_t n = m_neighborStart[elem]; n < m_neighborStart[elem + 1]; ++n)
+        {
+            int32_t neigh = m_neighbors[n];
+            if (parent[neigh] == -1) continue;
+            if ((data[m_dataIndex[neigh]] > 0.0f) != positive) continue;
+            int32_t root = findRoot(neigh, parent, offset);
+            if (find(roots.begin(), roots.end(), root) == roots.end()) roots.push_back(root);
+        }
+        if (roots.empty())
+        {//new cluster
+            parent[elem] = elem;
+            clusterSize[elem] = 1;
+            offset[elem] = 0.0;
+            accum[elem] = 0.0;
+            area[elem] = m_areas[elem];
+            lastVal[elem] = value;
+            continue;
+        }
+        int32_t merged = roots[0];
+        for (int i = 0; i < (int)roots.size(); ++i)
+        {
+            integrateTo(roots[i], value, param_e_d, integrated_h, accum, area, lastVal);//recalculate to align cluster bottoms
+            if (clusterSize[roots[i]] > clusterSize[merged]) merged = roots[i];//merge into the biggest, to keep trees shallow
+        }
+        for (int i = 0; i < (int)roots.size(); ++i)
+        {
+            int32_t other = roots[i];
+            if (other == merged) continue;
+            parent[other] = merged;
+            offset[other] = accum[other] - accum[merged];//the side cluster's members have its accum, but will get the merged cluster's accum at the end
+            clusterSize[merged] += clusterSize[other];
+            area[merged] += area[other];
+        }
+        parent[elem] = merged;
+        offset[elem] = -accum[merged];//this element is on the edge, and must not get the part of the integral above its value
+        clusterSize[merged] += 1;
+        area[merged] += m_areas[elem];
+    }
+    for (int64_t s = 0; s < numSorted; ++s)
+    {//include the to-zero slice
+        const int32_t elem = scratch.m_order[s].second;
+        if (parent[elem] == elem) integrateTo(elem, 0.0f, param_e_d, integrated_h, accum, area, lastVal);
+    }
+    for (int64_t s = 0; s < numSorted; ++s)
+    {
+        const int32_t elem = scratch.m_order[s].second;
+        int32_t root = findRoot(elem, parent, offset);
+        double result = accum[root];
+        if (root != elem) result += offset[elem];
+        int64_t dataIndex = m_dataIndex[elem];
+        if (data[dataIndex] > 0.0f)
+        {
+            outData[dataIndex] = (float)result;
+        } else {
+            outData[dataIndex] = (float)-result;
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef __TFCE_HELPER_H__
+#define __TFCE_HELPER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace caret {
+
+    class SurfaceFile;
+    
+    ///threshold-free cluster enhancement on a fixed set of elements and neighbors, built once and then used on many maps
+    ///elements are added by structure, and never connect to elements of other structures
+    class TfceHelper
+    {
+        int64_t m_dataSize;
+        std::vector<int64_t> m_dataIndex;//for each element, where it is in the data arrays
+        std::vector<float> m_areas;
+        std::vector<int64_t> m_neighborStart;//compressed neighbor lists, element i's neighbors are m_neighbors[m_neighborStart[i]] to before m_neighbors[m_neighborStart[i + 1]]
+        std::vector<int32_t> m_neighbors;
+        void checkElementCount(const int64_t& numNew) const;
+    public:
+        ///per-thread scratch memory, reused between calls to avoid reallocation
+        class Workspace
+        {
+            std::vector<std::pair<float, int32_t> > m_order;
+            std::vector<int32_t> m_parent, m_size, m_roots;
+            std::vector<double> m_offset, m_accum, m_area;
+            std::vector<float> m_lastVal;
+            friend class TfceHelper;
+        };
+        
+        ///dataSize is the length of the data arrays, anything not added as an element gets zero output
+        explicit TfceHelper(const int64_t& dataSize);
+        
+        ///nodeToData gives the data index of each vertex, or -1 to exclude it
+        void addSurface(const SurfaceFile* mySurf, const float* areaData, const std::vector<int64_t>& nodeToData);
+        
+        ///ijk triples of voxels and their data indexes, voxels touching by face are neighbors
+        void addVoxels(const std::vector<int64_t>& voxelIJK, const std::vector<int64_t>& dataIndices, const float& voxelVolume);
+        
+        int64_t getNumberOfElements() const { return (int64_t)m_dataIndex.size(); }
+        
+        ///both positive and negative values are enhanced, negative results are negated, may be called from multiple threads with different workspaces
+        void compute(const float* data, float* outData, const float& param_e, const float& param_h, Workspace& scratch) const;
+    };
+
+}
+
+#endif //__TFCE_HELPER_H__
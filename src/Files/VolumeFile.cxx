@@ -17,11 +17,13 @@
  *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 /*LICENSE_END*/
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <sstream>
 #include <string>
 
+#include <QFileInfo>
 #include <QTemporaryFile>
 
 #include "CaretHttpManager.h"
@@ -53,6 +55,51 @@ using namespace std;
 
 const float VolumeFile::INVALID_INTERP_VALUE = 0.0f;//we may want NaN or something more obvious
 bool VolumeFile::s_voxelColoringEnabled = true;
+bool VolumeFile::s_nativeStorageEnabled = true;
+bool VolumeFile::s_onDiskEnabled = true;
+int16_t VolumeFile::s_writingDataType = NIFTI_TYPE_FLOAT32;
+
+namespace
+{
+    const int64_t ON_DISK_RESIDENT_BYTES = ((int64_t)256) << 20;//files larger than this stay on disk, and this much of them is kept in memory
+    
+    class VolumeFileOnDiskReader : public VolumeFrameCache::FrameReader
+    {
+        NiftiIO m_io;//NiftiIO locks its own reads, so the prefetch thread can use it too
+        vector<int64_t> m_extraDims;
+        int m_fullDims;
+        bool m_rawRead;
+    public:
+        VolumeFileOnDiskReader(const AString& filename, const bool& rawRead)
+        {
+            m_io.openRead(filename);
+            const vector<int64_t>& dims = m_io.getDimensions();
+            m_fullDims = min(3, (int)dims.size());
+            if (dims.size() > 3)
+            {
+                m_extraDims = vector<int64_t>(dims.begin() + 3, dims.end());
+            }
+            m_rawRead = rawRead;
+        }
+        
+        void readFrame(void* frameOut, const int64_t& frameIndex)
+        {
+            vector<int64_t> indexSelect(m_extraDims.size());
+            int64_t remaining = frameIndex;
+            for (int i = 0; i < (int)m_extraDims.size(); ++i)//same order as getNonSpatialIndexesFromBrickIndex
+            {
+                indexSelect[i] = remaining % m_extraDims[i];
+                remaining /= m_extraDims[i];
+            }
+            if (m_rawRead)
+            {
+                m_io.readRawData(frameOut, m_fullDims, indexSelect);
+            } else {
+                m_io.readData((float*)frameOut, m_fullDims, indexSelect);
+            }
+        }
+    };
+}
 
 /**
  * Static method that sets the status of voxel coloring.  Coloring may take
@@ -74,6 +121,59 @@ VolumeFile::setVoxelColoringEnabled(const bool enabled)
                            : "Volume coloring is disabled."));
 }
 
+/**
+ * Static method that sets whether volumes read from 8 and 16 bit integer
+ * files keep that type in memory, with any scaling applied when values are
+ * read out.  This halves to quarters the memory of such volumes, but frames
+ * requested as pointers are converted and kept, so command line operations,
+ * which mostly work on whole frames, are better off with float.
+ *
+ * Only affects files read after it is called.
+ *
+ * @param enabled
+ *    New status for native storage.
+ */
+void
+VolumeFile::setNativeStorageEnabled(const bool enabled)
+{
+    s_nativeStorageEnabled = enabled;
+}
+
+/**
+ * Static method that sets whether large, uncompressed, single component
+ * files with more than one frame are left on disk when read.  Frames are
+ * then read as they are needed, with a bounded number of them kept in
+ * memory, so that opening a long time series doesn't read all of it.
+ * Any modification of such a volume reads all of it into memory.
+ *
+ * Only affects files read after it is called.
+ *
+ * @param enabled
+ *    New status for on-disk reading.
+ */
+void
+VolumeFile::setOnDiskEnabled(const bool enabled)
+{
+    s_onDiskEnabled = enabled;
+}
+
+/**
+ * Static method that sets the datatype of written files.  Besides
+ * FLOAT32, NiftiHalfFloat::DTYPE_FLOAT16 and DTYPE_BFLOAT16 halve the
+ * size of the file, at the cost of precision, and the result can only be
+ * read as floats by workbench.  Label volumes are always written as FLOAT32,
+ * because 16-bit floats can't hold every label key.
+ *
+ * @param type
+ *    New datatype for writing.
+ */
+void
+VolumeFile::setWritingDataType(const int16_t type)
+{
+    CaretAssert(type == NIFTI_TYPE_FLOAT32 || NiftiHalfFloat::fromDataType(type) != NiftiHalfFloat::NONE);
+    s_writingDataType = type;
+}
+
 
 VolumeFile::VolumeFile()
 : VolumeBase(), CaretMappableDataFile(DataFileTypeEnum::VOLUME)
@@ -256,8 +356,52 @@ void VolumeFile::readFile(const AString& filename)
         reinitialize(myDims, inHeader.getSForm(), numComponents);
         setFileName(filename);  // must be done after reinitialize() since it calls clear() which clears the name of the file
         int64_t frameSize = myDims[0] * myDims[1] * myDims[2];
-        if (numComponents != 1)
+        StorageType nativeType = STORAGE_FLOAT32;
+        if (s_nativeStorageEnabled && numComponents == 1 && myIO.getHalfFormat() == NiftiHalfFloat::NONE)
+        {//16-bit floats are stored as UINT16, and must be converted
+            switch (inHeader.getDataType())
+            {
+                case NIFTI_TYPE_INT8:
+                    nativeType = STORAGE_INT8;
+                    break;
+                case NIFTI_TYPE_UINT8:
+                    nativeType = STORAGE_UINT8;
+                    break;
+                case NIFTI_TYPE_INT16:
+                    nativeType = STORAGE_INT16;
+                    break;
+                case NIFTI_TYPE_UINT16:
+                    nativeType = STORAGE_UINT16;
+                    break;
+                default:
+                    break;
+            }
+        }
+        int64_t numFrames = 1;
+        for (int i = 0; i < (int)extraDims.size(); ++i)
         {
+            numFrames *= extraDims[i];
+        }
+        const bool onDisk = (s_onDiskEnabled && numComponents == 1 && numFrames > 1 && fileToRead == filename && !filename.endsWith(".gz")
+                             && frameSize * numFrames * myIO.getNumBytesPerElement() > ON_DISK_RESIDENT_BYTES);//seeking backwards in gzip means decompressing from the start
+        if (onDisk)
+        {//header now, frames when something asks for them
+            double mult = 1.0, offset = 0.0;
+            if (nativeType != STORAGE_FLOAT32) inHeader.getDataScaling(mult, offset);//otherwise, readData applies it
+            CaretPointer<VolumeFrameCache::FrameReader> myReader(new VolumeFileOnDiskReader(fileToRead, nativeType != STORAGE_FLOAT32));
+            setOnDisk(myReader, nativeType, ON_DISK_RESIDENT_BYTES, mult, offset);
+            CaretLogFine("Leaving volume data of " + filename + " on disk");
+        } else if (nativeType != STORAGE_FLOAT32) {//keep small integer types as they are in the file, scaling is applied when values are read out
+            double mult, offset;
+            inHeader.getDataScaling(mult, offset);//returns 1 and 0 when there is no scaling
+            setStorageType(nativeType, mult, offset);
+            vector<char> rawFrame(frameSize * myIO.getNumBytesPerElement());
+            for (MultiDimIterator<int64_t> myiter(extraDims); !myiter.atEnd(); ++myiter)
+            {
+                myIO.readRawData(rawFrame.data(), fullDims, *myiter);
+                setFrameNative(rawFrame.data(), getBrickIndexFromNonSpatialIndexes(*myiter));
+            }
+        } else if (numComponents != 1) {
             vector<float> tempFrame(frameSize), readBuffer(frameSize * numComponents);
             for (MultiDimIterator<int64_t> myiter(extraDims); !myiter.atEnd(); ++myiter)
             {
@@ -331,6 +475,10 @@ VolumeFile::writeFile(const AString& filename)
                                 "writing multi-component volumes is not currently supported");//its a hassle, and uncommon, and there is only one 3-component type, restricted to 0-255
     }
     updateCaretExtension();
+    if (isOnDisk() && QFileInfo(filename).canonicalFilePath() == QFileInfo(getFileName()).canonicalFilePath())
+    {//frames not yet read would come from the file we are truncating
+        convertStorageToFloat();
+    }
     
     NiftiHeader outHeader;//begin nifti-specific code
     if (m_header != NULL && (m_header->getType() == AbstractHeader::NIFTI))
@@ -341,6 +489,10 @@ VolumeFile::writeFile(const AString& filename)
     outHeader.setSForm(getVolumeSpace().getSform());
     outHeader.setDimensions(getOriginalDimensions());
     outHeader.setDataType(NIFTI_TYPE_FLOAT32);
+    if (getType() != SubvolumeAttributes::LABEL)
+    {
+        NiftiHalfFloat::setHeaderFormat(outHeader, NiftiHalfFloat::fromDataType(s_writingDataType));
+    }
     NiftiIO myIO;
     int outVersion = 1;
     if (!outHeader.canWriteVersion(1)) outVersion = 2;
@@ -351,9 +503,12 @@ VolumeFile::writeFile(const AString& filename)
     {
         extraDims = vector<int64_t>(origDims.begin() + 3, origDims.end());
     }
+    const int64_t* dims = getDimensionsPtr();
+    vector<float> frameScratch(dims[0] * dims[1] * dims[2]);
     for (MultiDimIterator<int64_t> myiter(extraDims); !myiter.atEnd(); ++myiter)
     {
-        myIO.writeData(getFrame(getBrickIndexFromNonSpatialIndexes(*myiter)), 3, *myiter);//NOTE: does not deal with multi-component volumes
+        copyFrame(frameScratch.data(), getBrickIndexFromNonSpatialIndexes(*myiter));//copy, so integer storage doesn't keep every converted frame
+        myIO.writeData(frameScratch.data(), 3, *myiter);//NOTE: does not deal with multi-component volumes
     }
     myIO.close();//call close explicitly to get a throw rather than a severe log when there is a problem
     m_header.grabNew(new NiftiHeader(outHeader));//update header to last written version, end nifti-specific code
@@ -485,7 +640,9 @@ void VolumeFile::validateSpline(const int64_t brickIndex, const int64_t componen
         CaretMutexLocker locked(&m_splineMutex);//prevent concurrent modify access to spline state
         if (!m_frameSplineValid[whichFrame])//double check
         {
-            m_frameSplines[whichFrame] = VolumeSpline(getFrame(brickIndex, component), dimensions);
+            vector<float> frame(dimensions[0] * dimensions[1] * dimensions[2]);
+            copyFrame(frame.data(), brickIndex, component);//the spline has its own copy, don't make integer storage keep one too
+            m_frameSplines[whichFrame] = VolumeSpline(frame.data(), dimensions);
             if (m_frameSplines[whichFrame].ignoredNonNumeric())
             {
                 CaretLogWarning("ignored non-numeric input value when calculating cubic splines in volume '" + getFileName() + "', frame #" + AString::number(brickIndex + 1));
@@ -879,7 +1036,9 @@ const FastStatistics* VolumeFile::getMapFastStatistics(const int32_t mapIndex)
     const int64_t* dimensions = getDimensionsPtr();
     if (m_brickAttributes[mapIndex].m_fastStatistics == NULL)
     {
-        m_brickAttributes[mapIndex].m_fastStatistics.grabNew(new FastStatistics(getFrame(mapIndex), dimensions[0] * dimensions[1] * dimensions[2]));
+        vector<float> frame(dimensions[0] * dimensions[1] * dimensions[2]);
+        copyFrame(frame.data(), mapIndex);//copy, so integer storage doesn't keep converted frames for statistics
+        m_brickAttributes[mapIndex].m_fastStatistics.grabNew(new FastStatistics(frame.data(), frame.size()));
     }
     return m_brickAttributes[mapIndex].m_fastStatistics;
 }
@@ -912,7 +1071,9 @@ const Histogram* VolumeFile::getMapHistogram(const int32_t mapIndex)
     
     if (updateHistogramFlag)
     {
-        m_brickAttributes[mapIndex].m_histogram->update(numberOfBuckets, getFrame(mapIndex), dimensions[0] * dimensions[1] * dimensions[2]);
+        vector<float> frame(dimensions[0] * dimensions[1] * dimensions[2]);
+        copyFrame(frame.data(), mapIndex);
+        m_brickAttributes[mapIndex].m_histogram->update(numberOfBuckets, frame.data(), frame.size());
         m_brickAttributes[mapIndex].m_histogramNumberOfBuckets = numberOfBuckets;
     }
     return m_brickAttributes[mapIndex].m_histogram;
@@ -972,9 +1133,11 @@ VolumeFile::getMapHistogram(const int32_t mapIndex,
     }
     
     if (updateHistogramFlag) {
+        vector<float> frame(dimensions[0] * dimensions[1] * dimensions[2]);
+        copyFrame(frame.data(), mapIndex);
         m_brickAttributes[mapIndex].m_histogramLimitedValues->update(numberOfBuckets,
-                                                                     getFrame(mapIndex),
-                                                                     dimensions[0] * dimensions[1] * dimensions[2],
+                                                                     frame.data(),
+                                                                     frame.size(),
                                                                      mostPositiveValueInclusive,
                                                                      leastPositiveValueInclusive,
                                                                      leastNegativeValueInclusive,
@@ -1192,12 +1355,10 @@ VolumeFile::getFileData(std::vector<float>& dataOut) const
     int64_t dataOffset = 0;
     
     for (int iMap = 0; iMap < numMaps; iMap++) {
-        const float* mapData = getFrame(iMap);
-        
-        for (int64_t i = 0; i < mapSize; i++) {
-            CaretAssertVectorIndex(dataOut, dataOffset);
-            dataOut[dataOffset] = mapData[i];
-            ++dataOffset;
+        for (int64_t iComp = 0; iComp < dimComp; iComp++) {
+            CaretAssertVectorIndex(dataOut, dataOffset + dimI * dimJ * dimK - 1);
+            copyFrame(dataOut.data() + dataOffset, iMap, iComp);
+            dataOffset += dimI * dimJ * dimK;
         }
     }
     
@@ -1801,14 +1962,19 @@ VolumeFile::getDataRangeFromAllMaps(float& dataRangeMinimumOut,
     m_dataRangeMinimum = std::numeric_limits<float>::max();
     
     const int64_t* dimensions = getDimensionsPtr();
-    int64_t m_dataSize = dimensions[0] * dimensions[1] * dimensions[2] * dimensions[3] * dimensions[4];
-    const float* data = getFrame();//HACK: use first frame knowing all data is contiguous after it
-    for (int64_t i = 0; i < m_dataSize; i++) {
-        if (data[i] > m_dataRangeMaximum) {
-            m_dataRangeMaximum = data[i];
-        }
-        if (data[i] < m_dataRangeMinimum) {
-            m_dataRangeMinimum = data[i];
+    const int64_t frameSize = dimensions[0] * dimensions[1] * dimensions[2];
+    std::vector<float> data(frameSize);
+    for (int64_t iComp = 0; iComp < dimensions[4]; iComp++) {
+        for (int64_t iMap = 0; iMap < dimensions[3]; iMap++) {
+            copyFrame(data.data(), iMap, iComp);//frames aren't contiguous with integer storage
+            for (int64_t i = 0; i < frameSize; i++) {
+                if (data[i] > m_dataRangeMaximum) {
+                    m_dataRangeMaximum = data[i];
+                }
+                if (data[i] < m_dataRangeMinimum) {
+                    m_dataRangeMinimum = data[i];
+                }
+            }
         }
     }
     
@@ -147,6 +147,21 @@ namespace caret {
         
         static void setVoxelColoringEnabled(const bool enabled);
         
+        /** Keeps 8 and 16 bit integer files in their own type in memory, rather than converting to float */
+        static bool s_nativeStorageEnabled;
+        
+        static void setNativeStorageEnabled(const bool enabled);
+        
+        /** Leaves large uncompressed multi-frame files on disk, reading frames as they are needed */
+        static bool s_onDiskEnabled;
+        
+        static void setOnDiskEnabled(const bool enabled);
+        
+        /** Datatype of written files, FLOAT32 or one of the NiftiHalfFloat types */
+        static int16_t s_writingDataType;
+        
+        static void setWritingDataType(const int16_t type);
+        
         VolumeFile();
         VolumeFile(const std::vector<int64_t>& dimensionsIn, const std::vector<std::vector<float> >& indexToSpace, const int64_t numComponents = 1, SubvolumeAttributes::VolumeType whatType = SubvolumeAttributes::ANATOMY);
         ~VolumeFile();
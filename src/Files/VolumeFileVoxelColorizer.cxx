@@ -27,6 +27,7 @@
 #include "CaretLogger.h"
 #include "ElapsedTimer.h"
 #include "GiftiLabel.h"
+#include "GiftiLabelTableLookup.h"
 #include "GroupAndNameHierarchyItem.h"
 #include "NodeAndVoxelColoring.h"
 #include "VolumeFile.h"
@@ -107,9 +108,13 @@ VolumeFileVoxelColorizer::assignVoxelColorsForMap(const int32_t mapIndex,
     timer.start();
     
     /*
-     * Pointer to map's data 
+     * Copy of map's data, so that volumes with integer
+     * storage don't keep a converted copy of every map
+     * that has been colored
      */
-    const float* mapDataPointer = m_volumeFile->getFrame(mapIndex);
+    std::vector<float> mapData(m_voxelCountPerMap);
+    m_volumeFile->copyFrame(mapData.data(), mapIndex);
+    const float* mapDataPointer = mapData.data();
     
     /*
      * Get access to threshold data
@@ -299,6 +304,15 @@ VolumeFileVoxelColorizer::getVoxelColorsForSliceInMap(const int32_t mapIndex,
     if (m_volumeFile->isMappedWithLabelTable()) {
         CaretAssert(labelTable);
     }
+    CaretPointer<const GiftiLabelTableLookup> labelLookup;
+    std::vector<char> labelDisplayed;
+    if (labelTable != NULL) {
+        labelLookup = labelTable->getLookup();
+        NodeAndVoxelColoring::getLabelDisplayedStatus(labelLookup,
+                                                      displayGroup,
+                                                      tabIndex,
+                                                      labelDisplayed);
+    }
     
     int64_t validVoxelCount = 0;
     
@@ -327,13 +341,10 @@ VolumeFileVoxelColorizer::getVoxelColorsForSliceInMap(const int32_t mapIndex,
                                                                                               j,
                                                                                               k,
                                                                                               mapIndex));
-                        const GiftiLabel* label = labelTable->getLabel(dataValue);
-                        if (label != NULL) {
-                            const GroupAndNameHierarchyItem* item = label->getGroupNameSelectionItem();
-                            if (item != NULL) {
-                                if (item->isSelected(displayGroup, tabIndex) == false) {
-                                    alpha = 0;
-                                }
+                        const int32_t labelIndex = labelLookup->find(dataValue);
+                        if (labelIndex >= 0) {
+                            if ( ! labelDisplayed[labelIndex]) {
+                                alpha = 0;
                             }
                         }
                     }
@@ -397,6 +408,15 @@ VolumeFileVoxelColorizer::getVoxelColorsForSliceInMap(const int32_t mapIndex,
     if (m_volumeFile->isMappedWithLabelTable()) {
         CaretAssert(labelTable);
     }
+    CaretPointer<const GiftiLabelTableLookup> labelLookup;
+    std::vector<char> labelDisplayed;
+    if (labelTable != NULL) {
+        labelLookup = labelTable->getLookup();
+        NodeAndVoxelColoring::getLabelDisplayedStatus(labelLookup,
+                                                      displayGroup,
+                                                      tabIndex,
+                                                      labelDisplayed);
+    }
     
     int64_t validVoxelCount = 0;
     int64_t rgbaOutIndex = 0;
@@ -423,13 +443,10 @@ VolumeFileVoxelColorizer::getVoxelColorsForSliceInMap(const int32_t mapIndex,
                      */
                     const int32_t dataValue = static_cast<int32_t>(m_volumeFile->getValue(ijk,
                                                                                           mapIndex));
-                    const GiftiLabel* label = labelTable->getLabel(dataValue);
-                    if (label != NULL) {
-                        const GroupAndNameHierarchyItem* item = label->getGroupNameSelectionItem();
-                        if (item != NULL) {
-                            if (item->isSelected(displayGroup, tabIndex) == false) {
-                                alpha = 0;
-                            }
+                    const int32_t labelIndex = labelLookup->find(dataValue);
+                    if (labelIndex >= 0) {
+                        if ( ! labelDisplayed[labelIndex]) {
+                            alpha = 0;
                         }
                     }
                 }
@@ -558,6 +575,15 @@ VolumeFileVoxelColorizer::getVoxelColorsForSubSliceInMap(const int32_t mapIndex,
     if (m_volumeFile->isMappedWithLabelTable()) {
         CaretAssert(labelTable);
     }
+    CaretPointer<const GiftiLabelTableLookup> labelLookup;
+    std::vector<char> labelDisplayed;
+    if (labelTable != NULL) {
+        labelLookup = labelTable->getLookup();
+        NodeAndVoxelColoring::getLabelDisplayedStatus(labelLookup,
+                                                      displayGroup,
+                                                      tabIndex,
+                                                      labelDisplayed);
+    }
     
     int64_t validVoxelCount = 0;
     
@@ -593,16 +619,12 @@ VolumeFileVoxelColorizer::getVoxelColorsForSubSliceInMap(const int32_t mapIndex,
                     //prevent display of the data.
                     
                     const int32_t dataValue = static_cast<int32_t>(m_volumeFile->getValue(iterijk, mapIndex));
-                    const GiftiLabel* label = labelTable->getLabel(dataValue);
-                    if (label != NULL)
+                    const int32_t labelIndex = labelLookup->find(dataValue);
+                    if (labelIndex >= 0)
                     {
-                        const GroupAndNameHierarchyItem* item = label->getGroupNameSelectionItem();
-                        if (item != NULL)
+                        if ( ! labelDisplayed[labelIndex])
                         {
-                            if (item->isSelected(displayGroup, tabIndex) == false)
-                            {
-                                alpha = 0;
-                            }
+                            alpha = 0;
                         }
                     }
                 }
@@ -25,6 +25,7 @@
 #undef __GIFTI_LABEL_DECLARE__
 
 #include "CaretLogger.h"
+#include "GiftiLabelTable.h"
 
 using namespace caret;
 
@@ -271,8 +272,11 @@ GiftiLabel&
 GiftiLabel::operator=(const GiftiLabel& o)
 {
     if (this != &o) {
+        GiftiLabelTable* owningTable = m_owningTable;//assigning to a label in a table leaves it in that table
         CaretObject::operator=(o);
         this->copyHelper(o);
+        m_owningTable = owningTable;
+        keyOrColorChanged();
     };
     return *this;
 }
@@ -318,6 +322,7 @@ GiftiLabel::initializeMembersGiftiLabel()
     this->z = 0.0;
     this->count = 0;
     m_groupNameSelectionItem = NULL;
+    m_owningTable = NULL;
 }
 
 /**
@@ -369,6 +374,7 @@ GiftiLabel::setKey(const int32_t key)
 {
     this->key = key;
     this->setModified();
+    keyOrColorChanged();
 }
 
 /**
@@ -491,6 +497,7 @@ GiftiLabel::setColor(const float rgba[4])
     this->blue = colorClamp(rgba[2]);
     this->alpha = colorClamp(rgba[3]);
     this->setModified();
+    keyOrColorChanged();
 }
 
 /**
@@ -648,6 +655,18 @@ GiftiLabel::setXYZ(const float xyz[3])
     this->setModified();
 }
 
+/**
+ * Tell the label table holding this label, if any, that its compiled
+ * view (GiftiLabelTableLookup) is out of date.
+ */
+void
+GiftiLabel::keyOrColorChanged()
+{
+    if (m_owningTable != NULL) {
+        m_owningTable->invalidateLookup();
+    }
+}
+
 /**
  * Set this object has been modified.
  *
@@ -32,6 +32,7 @@
 
 namespace caret {
     
+    class GiftiLabelTable;
     class GroupAndNameHierarchyItem;
     
     /**
@@ -192,6 +193,8 @@ namespace caret {
     private:
         void setNamePrivate(const AString& name);
         
+        void keyOrColorChanged();
+        
         /**tracks modification status (DO NOT CLONE) */
         bool modifiedFlag;
         
@@ -229,6 +232,11 @@ namespace caret {
         /** Selection status of this label in the map/label hierarchy */
         mutable GroupAndNameHierarchyItem* m_groupNameSelectionItem;
         
+        /** Label table that holds this label, so it can drop its lookup when the key or color changes (DO NOT CLONE) */
+        GiftiLabelTable* m_owningTable;
+        
+        friend class GiftiLabelTable;
+        
         /** The invalid label key */
         const static int32_t s_invalidLabelKey;
     };
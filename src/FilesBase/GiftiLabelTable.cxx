@@ -129,6 +129,7 @@ GiftiLabelTable::clear()
         delete iter->second;
     }
     this->labelsMap.clear();
+    invalidateLookup();
     
     GiftiLabel gl(0, "???", 1.0, 1.0, 1.0, 0.0);
     this->addLabel(&gl);
@@ -292,7 +293,9 @@ GiftiLabelTable::addLabel(const GiftiLabel* glIn)
         
         GiftiLabel* gl = new GiftiLabel(*glIn);
         gl->setKey(key);
+        gl->m_owningTable = this;
         this->labelsMap.insert(std::make_pair(key, gl));
+        invalidateLookup();
         return key;
     }
     
@@ -320,7 +323,10 @@ GiftiLabelTable::addLabel(const GiftiLabel* glIn)
         /*
          * Insert a new label
          */
-        this->labelsMap.insert(std::make_pair(key, new GiftiLabel(*glIn)));
+        GiftiLabel* gl = new GiftiLabel(*glIn);
+        gl->m_owningTable = this;
+        this->labelsMap.insert(std::make_pair(key, gl));
+        invalidateLookup();
     }
     return key;
 }
@@ -519,6 +525,7 @@ GiftiLabelTable::insertLabel(const GiftiLabel* labelIn)
         delete gl;
     }
         
+    label->m_owningTable = this;
     this->labelsMap.insert(std::make_pair(label->getKey(), label));
     this->setModified();
 }
@@ -1511,6 +1518,7 @@ void
 GiftiLabelTable::setModified()
 {
     this->modifiedFlag = true;
+    invalidateLookup();
 }
 
 /**
@@ -1649,8 +1657,37 @@ GiftiLabelTable::changeLabelKey(const int32_t currentKey,
     label->setKey(newKey);
     this->labelsMap.insert(std::make_pair(newKey,
                                           label));
+    invalidateLookup();
+}
+
+/**
+ * Get a compiled view of this label table, for looking up the label
+ * index and color of every vertex or voxel without searching the label
+ * map.  The view is only rebuilt after labels are added, removed, or
+ * have their key or color changed, and may be used by several threads.
+ *
+ * @return The lookup for the current labels.
+ */
+CaretPointer<const GiftiLabelTableLookup>
+GiftiLabelTable::getLookup() const
+{
+    CaretMutexLocker locked(&m_lookupMutex);
+    if (m_lookup == NULL)
+    {//labels in this table drop it when their key or color changes
+        m_lookup.grabNew(new GiftiLabelTableLookup(this));
+    }
+    return m_lookup;
 }
 
+/**
+ * Discard the compiled view after the label map changes.
+ */
+void
+GiftiLabelTable::invalidateLookup()
+{
+    CaretMutexLocker locked(&m_lookupMutex);
+    m_lookup.grabNew(NULL);
+}
 
 bool GiftiLabelTable::matches(const GiftiLabelTable& rhs, const bool checkColors, const bool checkCoords) const
 {
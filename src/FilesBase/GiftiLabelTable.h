@@ -22,7 +22,10 @@
 /*LICENSE_END*/
 
 #include "AString.h"
+#include "CaretMutex.h"
 #include "CaretObject.h"
+#include "CaretPointer.h"
+#include "GiftiLabelTableLookup.h"
 #include "TracksModificationInterface.h"
 
 #include "GiftiException.h"
@@ -211,9 +214,15 @@ public:
     
     void exportToCaret5ColorFile(const AString& filename) const;
 
+    CaretPointer<const GiftiLabelTableLookup> getLookup() const;
+    
 private:
     void issueLabelKeyZeroWarning(const AString& name) const;
     
+    void invalidateLookup();
+    
+    friend class GiftiLabel;//so labels can call invalidateLookup() when their key or color changes
+    
     /** The label table storage.  Use a TreeMap since label keys
  may be sparse.
 */
@@ -225,6 +234,12 @@ private:
 
     /**tracks modification status */
     bool modifiedFlag;
+    
+    /** Compiled view of the labels, NULL until requested or after the labels change */
+    mutable CaretPointer<const GiftiLabelTableLookup> m_lookup;
+    
+    /** Protects m_lookup, so that threads drawing the same table can share it */
+    mutable CaretMutex m_lookupMutex;
 
     int32_t m_tableModelColumnIndexKey;
     int32_t m_tableModelColumnIndexName;
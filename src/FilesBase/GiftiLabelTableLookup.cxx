@@ -0,0 +1,66 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "GiftiLabelTableLookup.h"
+
+#include "GiftiLabel.h"
+#include "GiftiLabelTable.h"
+
+#include <algorithm>
+
+using namespace caret;
+using namespace std;
+
+GiftiLabelTableLookup::GiftiLabelTableLookup(const GiftiLabelTable* table)
+{
+    CaretAssert(table != NULL);
+    table->getKeys(m_keys);//ascending, so label indices are in key order
+    const int32_t numLabels = (int32_t)m_keys.size();
+    m_labels.resize(numLabels);
+    m_rgba.resize(4 * numLabels);
+    m_rgbaByte.resize(4 * numLabels);
+    for (int32_t i = 0; i < numLabels; ++i)
+    {
+        m_labels[i] = table->getLabel(m_keys[i]);
+        CaretAssert(m_labels[i] != NULL);
+        m_labels[i]->getColor(m_rgba.data() + 4 * i);
+        for (int c = 0; c < 4; ++c)
+        {
+            m_rgbaByte[4 * i + c] = (uint8_t)(m_rgba[4 * i + c] * 255.0);//same conversion the coloring code always used
+        }
+    }
+    m_minKey = 0;
+    if (numLabels == 0) return;
+    m_minKey = m_keys[0];
+    int64_t range = (int64_t)m_keys.back() - m_minKey + 1;
+    if (range <= max((int64_t)65536, 4 * (int64_t)numLabels))
+    {
+        m_dense.resize(range, -1);
+        for (int32_t i = 0; i < numLabels; ++i)
+        {
+            m_dense[(int64_t)m_keys[i] - m_minKey] = i;
+        }
+    } else {
+        for (int32_t i = 0; i < numLabels; ++i)
+        {
+            m_sparse[m_keys[i]] = i;
+        }
+    }
+}
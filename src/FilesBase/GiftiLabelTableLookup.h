@@ -0,0 +1,82 @@
+#ifndef __GIFTI_LABEL_TABLE_LOOKUP_H__
+#define __GIFTI_LABEL_TABLE_LOOKUP_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CaretAssert.h"
+
+#include <map>
+#include <vector>
+
+#include "stdint.h"
+
+namespace caret {
+
+    class GiftiLabel;
+    class GiftiLabelTable;
+
+    ///read-only snapshot of a label table for per-vertex or per-voxel use: keys map to label indices (ascending key order) through
+    ///a subtraction and an index when the keys are compact enough, and each label's color is packed into arrays
+    ///get one from GiftiLabelTable::getLookup(), which rebuilds it only when the table or its labels change
+    ///the label pointers belong to the table, so don't keep a lookup around after modifying or deleting the table
+    class GiftiLabelTableLookup
+    {
+        int32_t m_minKey;
+        std::vector<int32_t> m_dense;//key - m_minKey to label index, -1 for keys not in the table
+        std::map<int32_t, int32_t> m_sparse;//used instead when keys are too spread out for a dense table
+        std::vector<int32_t> m_keys;
+        std::vector<const GiftiLabel*> m_labels;
+        std::vector<float> m_rgba;
+        std::vector<uint8_t> m_rgbaByte;
+    public:
+        explicit GiftiLabelTableLookup(const GiftiLabelTable* table);
+
+        int32_t getNumberOfLabels() const { return (int32_t)m_keys.size(); }
+
+        ///label index of a key, -1 if the table doesn't contain it
+        int32_t find(const int32_t& key) const
+        {
+            if (m_dense.empty())
+            {
+                if (m_sparse.empty()) return -1;
+                std::map<int32_t, int32_t>::const_iterator iter = m_sparse.find(key);
+                if (iter == m_sparse.end()) return -1;
+                return iter->second;
+            }
+            int64_t offset = (int64_t)key - m_minKey;
+            if (offset < 0 || offset >= (int64_t)m_dense.size()) return -1;
+            return m_dense[offset];
+        }
+
+        int32_t getKey(const int32_t& index) const { CaretAssertVectorIndex(m_keys, index); return m_keys[index]; }
+
+        const GiftiLabel* getLabel(const int32_t& index) const { CaretAssertVectorIndex(m_labels, index); return m_labels[index]; }
+
+        ///4 floats, the same as GiftiLabel::getColor()
+        const float* getColor(const int32_t& index) const { CaretAssertVectorIndex(m_keys, index); return m_rgba.data() + 4 * index; }
+
+        ///4 bytes, each float component times 255, truncated
+        const uint8_t* getColorByte(const int32_t& index) const { CaretAssertVectorIndex(m_keys, index); return m_rgbaByte.data() + 4 * index; }
+    };
+
+}
+
+#endif //__GIFTI_LABEL_TABLE_LOOKUP_H__
@@ -28,7 +28,9 @@
 #include "PaletteColorMapping.h"
 #include "Vector3D.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 
 using namespace caret;
 using namespace std;
@@ -81,11 +83,13 @@ void VolumeBase::addSubvolumes(const int64_t& numToAdd)
     VolumeStorage newStorage(newdims.data());
     newdims.resize(4);//drop the number of components from the dimensions array
     m_origDims = newdims;//and reset our original dimensions
+    vector<float> scratchFrame(olddims[0] * olddims[1] * olddims[2]);
     for (int64_t c = 0; c < olddims[4]; ++c)
     {
         for (int64_t b = 0; b < olddims[3]; ++b)
         {
-            newStorage.setFrame(m_storage.getFrame(b, c), b, c);
+            m_storage.copyFrame(scratchFrame.data(), b, c);//don't make integer storage keep converted frames
+            newStorage.setFrame(scratchFrame.data(), b, c);
         }
     }
     m_storage.swap(newStorage);
@@ -147,14 +151,14 @@ void VolumeBase::reorient(const VolumeSpace::OrientTypes newOrient[3])
     int64_t rowSize = dims[0];
     int64_t sliceSize = rowSize * dims[1];
     int64_t frameSize = sliceSize * dims[2];
-    vector<float> scratchFrame(frameSize);
+    vector<float> scratchFrame(frameSize), oldFrame(frameSize);
     int64_t newDims[5] = {dims[fetchFrom[0]], dims[fetchFrom[1]], dims[fetchFrom[2]], dims[3], dims[4]};
     VolumeStorage newStorage(newDims);
     for (int c = 0; c < dims[4]; ++c)
     {
         for (int b = 0; b < dims[3]; ++b)
         {
-            const float* oldFrame = m_storage.getFrame(b, c);
+            m_storage.copyFrame(oldFrame.data(), b, c);
             int64_t newIndices[3], oldIndices[3];
             for (newIndices[2] = 0; newIndices[2] < newDims[2]; ++newIndices[2])
             {
@@ -349,6 +353,10 @@ VolumeBase::isEmpty() const
 
 VolumeBase::VolumeStorage::VolumeStorage()
 {
+    m_storageType = STORAGE_FLOAT32;
+    m_floatInMemory = true;
+    m_nativeScale = 1.0;
+    m_nativeOffset = 0.0;
     for (int i = 0; i < 5; ++i)
     {
         m_dimensions[i] = 0;
@@ -369,21 +377,243 @@ void VolumeBase::VolumeStorage::reinitialize(int64_t dims[5])
     {
         m_mult[i] = m_mult[i - 1] * m_dimensions[i];
     }
-    m_data.resize(m_mult[4]);
+    setStorageType(STORAGE_FLOAT32);
 }
 
 VolumeBase::VolumeStorage::VolumeStorage(int64_t dims[5])
 {
+    m_storageType = STORAGE_FLOAT32;
+    m_floatInMemory = true;
+    m_nativeScale = 1.0;
+    m_nativeOffset = 0.0;
     reinitialize(dims);
 }
 
+int64_t VolumeBase::VolumeStorage::getBytesPerElement(const StorageType& type)
+{
+    switch (type)
+    {
+        case STORAGE_FLOAT32:
+            return sizeof(float);
+        case STORAGE_INT8:
+            return sizeof(int8_t);
+        case STORAGE_UINT8:
+            return sizeof(uint8_t);
+        case STORAGE_INT16:
+            return sizeof(int16_t);
+        case STORAGE_UINT16:
+            return sizeof(uint16_t);
+    }
+    CaretAssert(false);
+    return sizeof(float);
+}
+
+void VolumeBase::VolumeStorage::setStorageType(const StorageType& type, const double& scale, const double& offset)
+{
+    m_frameCache.clear();
+    m_onDisk.grabNew(NULL);
+    m_onDiskConverted.grabNew(NULL);
+    m_storageType = type;
+    m_floatInMemory = (type == STORAGE_FLOAT32);
+    m_nativeScale = scale;
+    m_nativeOffset = offset;
+    if (type == STORAGE_FLOAT32)
+    {
+        CaretAssert(scale == 1.0 && offset == 0.0);//float storage has scaling applied already
+        vector<char>().swap(m_nativeData);//actually release the memory
+        m_data.resize(m_mult[4]);
+    } else {
+        vector<float>().swap(m_data);
+        m_nativeData.resize(m_mult[4] * getBytesPerElement(type));
+    }
+}
+
+namespace
+{
+    template<typename T>
+    void convertNative(const char* nativeData, const int64_t& start, const int64_t& count, const double& scale, const double& offset, float* dataOut)
+    {
+        const T* typedData = ((const T*)nativeData) + start;
+        for (int64_t i = 0; i < count; ++i)
+        {
+            dataOut[i] = (float)(offset + scale * typedData[i]);
+        }
+    }
+    
+    void convertTypedData(const char* typedData, const VolumeBase::StorageType& type, const double& scale, const double& offset,
+                          const int64_t& start, const int64_t& count, float* dataOut)
+    {
+        switch (type)
+        {
+            case VolumeBase::STORAGE_FLOAT32:
+            {
+                const float* floatData = ((const float*)typedData) + start;
+                for (int64_t i = 0; i < count; ++i)
+                {
+                    dataOut[i] = floatData[i];
+                }
+                break;
+            }
+            case VolumeBase::STORAGE_INT8:
+                convertNative<int8_t>(typedData, start, count, scale, offset, dataOut);
+                break;
+            case VolumeBase::STORAGE_UINT8:
+                convertNative<uint8_t>(typedData, start, count, scale, offset, dataOut);
+                break;
+            case VolumeBase::STORAGE_INT16:
+                convertNative<int16_t>(typedData, start, count, scale, offset, dataOut);
+                break;
+            case VolumeBase::STORAGE_UINT16:
+                convertNative<uint16_t>(typedData, start, count, scale, offset, dataOut);
+                break;
+        }
+    }
+    
+    //converts whole frames from the on-disk cache, so that the float frames handed out by getFrame are also limited and evicted
+    class ConvertingFrameReader : public VolumeFrameCache::FrameReader
+    {
+        CaretPointer<VolumeFrameCache> m_native;
+        VolumeBase::StorageType m_type;
+        double m_scale, m_offset;
+        int64_t m_frameSize;
+    public:
+        ConvertingFrameReader(const CaretPointer<VolumeFrameCache>& native, const VolumeBase::StorageType& type, const double& scale, const double& offset,
+                              const int64_t& frameSize)
+        {
+            m_native = native;
+            m_type = type;
+            m_scale = scale;
+            m_offset = offset;
+            m_frameSize = frameSize;
+        }
+        void readFrame(void* frameOut, const int64_t& frameIndex)
+        {
+            CaretPointer<const vector<char> > frame = m_native->getFrame(frameIndex);
+            convertTypedData(frame->data(), m_type, m_scale, m_offset, 0, m_frameSize, (float*)frameOut);
+        }
+    };
+}
+
+void VolumeBase::VolumeStorage::setOnDisk(const CaretPointer<VolumeFrameCache::FrameReader>& reader, const StorageType& type, const int64_t& maxResidentBytes,
+                                          const double& scale, const double& offset)
+{
+    CaretAssert(m_dimensions[4] == 1);//frame index in the cache is the brick index
+    m_frameCache.clear();
+    vector<float>().swap(m_data);
+    vector<char>().swap(m_nativeData);
+    m_storageType = type;
+    m_nativeScale = scale;
+    m_nativeOffset = offset;
+    m_floatInMemory = false;
+    const int64_t numFrames = m_dimensions[3] * m_dimensions[4];
+    m_onDiskConverted.grabNew(NULL);
+    if (type == STORAGE_FLOAT32)
+    {//getFrame can hand out the cached frames directly
+        m_onDisk.grabNew(new VolumeFrameCache(reader, numFrames, m_mult[2] * getBytesPerElement(type), maxResidentBytes));
+    } else {//split the limit between the file's frames and their float conversions, the conversions don't need their own prefetch
+        m_onDisk.grabNew(new VolumeFrameCache(reader, numFrames, m_mult[2] * getBytesPerElement(type), maxResidentBytes / 2));
+        CaretPointer<VolumeFrameCache::FrameReader> converter(new ConvertingFrameReader(m_onDisk, type, scale, offset, m_mult[2]));
+        m_onDiskConverted.grabNew(new VolumeFrameCache(converter, numFrames, m_mult[2] * sizeof(float), maxResidentBytes / 2, false));
+    }
+}
+
+float VolumeBase::VolumeStorage::getNativeValue(const int64_t& index) const
+{
+    float ret;
+    convertRange(&ret, index, 1);
+    return ret;
+}
+
+void VolumeBase::VolumeStorage::convertTyped(const char* typedData, const int64_t& start, const int64_t& count, float* dataOut) const
+{
+    convertTypedData(typedData, m_storageType, m_nativeScale, m_nativeOffset, start, count, dataOut);
+}
+
+void VolumeBase::VolumeStorage::convertRange(float* dataOut, const int64_t& start, const int64_t& count) const
+{
+    if (m_onDisk != NULL)
+    {
+        int64_t done = 0;
+        while (done < count)
+        {
+            const int64_t position = start + done, frameIndex = position / m_mult[2], frameStart = position % m_mult[2];
+            const int64_t toConvert = min(count - done, m_mult[2] - frameStart);
+            if (toConvert == m_mult[2])
+            {//whole frame, also moves the prefetch to this frame's neighbors
+                CaretPointer<const vector<char> > frame = m_onDisk->getFrame(frameIndex);//keeps the frame alive even if another thread makes the cache drop it
+                convertTyped(frame->data(), 0, toConvert, dataOut + done);
+            } else {//single values from getValue, copy just those bytes and leave the prefetch alone
+                const int64_t elemBytes = getBytesPerElement(m_storageType);
+                char scratch[1024];
+                const int64_t scratchElems = sizeof(scratch) / elemBytes;
+                for (int64_t piece = 0; piece < toConvert; piece += scratchElems)
+                {
+                    const int64_t pieceCount = min(scratchElems, toConvert - piece);
+                    m_onDisk->copyBytes(scratch, frameIndex, (frameStart + piece) * elemBytes, pieceCount * elemBytes);
+                    convertTyped(scratch, 0, pieceCount, dataOut + done + piece);
+                }
+            }
+            done += toConvert;
+        }
+    } else {
+        if (m_storageType == STORAGE_FLOAT32)
+        {
+            convertTyped((const char*)m_data.data(), start, count, dataOut);
+        } else {
+            convertTyped(m_nativeData.data(), start, count, dataOut);
+        }
+    }
+}
+
+void VolumeBase::VolumeStorage::convertToFloat()
+{
+    if (m_floatInMemory) return;
+    vector<float> newData(m_mult[4]);
+    convertRange(newData.data(), 0, m_mult[4]);
+    m_data.swap(newData);
+    vector<char>().swap(m_nativeData);
+    m_onDisk.grabNew(NULL);
+    m_onDiskConverted.grabNew(NULL);
+    m_storageType = STORAGE_FLOAT32;
+    m_floatInMemory = true;
+    m_nativeScale = 1.0;
+    m_nativeOffset = 0.0;
+    m_frameCache.clear();//NOTE: invalidates pointers from getFrame, but modifying a volume while holding its frame pointers is already questionable
+}
+
 const float* VolumeBase::VolumeStorage::getFrame(const int64_t brickIndex, const int64_t component) const
 {
-    return m_data.data() + brickIndex * m_mult[2] + component * m_mult[3];//NOTE: do not use [4]
+    if (m_floatInMemory)
+    {
+        return m_data.data() + brickIndex * m_mult[2] + component * m_mult[3];//NOTE: do not use [4]
+    }
+    const int64_t cacheIndex = brickIndex + component * m_dimensions[3];
+    if (m_onDisk != NULL)
+    {//the caches keep the frame alive until it is pushed out by other frames
+        if (m_onDiskConverted == NULL) return (const float*)(m_onDisk->getFrame(cacheIndex)->data());
+        return (const float*)(m_onDiskConverted->getFrame(cacheIndex)->data());
+    }
+    {
+        CaretMutexLocker locked(&m_frameCacheMutex);
+        if (m_frameCache.empty()) m_frameCache.resize(m_dimensions[3] * m_dimensions[4]);
+        CaretAssertVectorIndex(m_frameCache, cacheIndex);
+        if (m_frameCache[cacheIndex] != NULL) return m_frameCache[cacheIndex]->data();
+    }
+    CaretPointer<vector<float> > newFrame(new vector<float>(m_mult[2]));//convert outside the lock, so different frames can be converted in parallel
+    copyFrame(newFrame->data(), brickIndex, component);
+    CaretMutexLocker locked(&m_frameCacheMutex);
+    if (m_frameCache[cacheIndex] == NULL) m_frameCache[cacheIndex] = newFrame;//another thread may have converted it already, keep the first
+    return m_frameCache[cacheIndex]->data();
+}
+
+void VolumeBase::VolumeStorage::copyFrame(float* frameOut, const int64_t brickIndex, const int64_t component) const
+{
+    convertRange(frameOut, brickIndex * m_mult[2] + component * m_mult[3], m_mult[2]);
 }
 
 void VolumeBase::VolumeStorage::setFrame(const float* frameIn, const int64_t brickIndex, const int64_t component)
 {
+    if (!m_floatInMemory) convertToFloat();
     int64_t start = brickIndex * m_mult[2] + component * m_mult[3];
     for (int64_t i = 0; i < m_mult[2]; ++i)
     {
@@ -391,8 +621,23 @@ void VolumeBase::VolumeStorage::setFrame(const float* frameIn, const int64_t bri
     }
 }
 
+void VolumeBase::VolumeStorage::setFrameNative(const void* frameIn, const int64_t brickIndex, const int64_t component)
+{
+    if (m_onDisk != NULL) convertToFloat();
+    if (m_storageType == STORAGE_FLOAT32)
+    {
+        setFrame((const float*)frameIn, brickIndex, component);
+        return;
+    }
+    const int64_t elemSize = getBytesPerElement(m_storageType);
+    const int64_t start = (brickIndex * m_mult[2] + component * m_mult[3]) * elemSize;
+    memcpy(m_nativeData.data() + start, frameIn, m_mult[2] * elemSize);
+    m_frameCache.clear();
+}
+
 void VolumeBase::VolumeStorage::setValueAllVoxels(const float value)
 {
+    if (!m_floatInMemory) setStorageType(STORAGE_FLOAT32);//all old values are being replaced, so don't convert them
     for (int64_t i = 0; i < m_mult[4]; ++i)
     {
         m_data[i] = value;
@@ -402,6 +647,14 @@ void VolumeBase::VolumeStorage::setValueAllVoxels(const float value)
 void VolumeBase::VolumeStorage::swap(VolumeStorage& rhs)
 {
     m_data.swap(rhs.m_data);
+    m_nativeData.swap(rhs.m_nativeData);
+    std::swap(m_onDisk, rhs.m_onDisk);
+    std::swap(m_onDiskConverted, rhs.m_onDiskConverted);
+    std::swap(m_storageType, rhs.m_storageType);
+    std::swap(m_floatInMemory, rhs.m_floatInMemory);
+    std::swap(m_nativeScale, rhs.m_nativeScale);
+    std::swap(m_nativeOffset, rhs.m_nativeOffset);
+    m_frameCache.swap(rhs.m_frameCache);
     for (int i = 0; i < 5; ++i)
     {
         std::swap(m_dimensions[i], rhs.m_dimensions[i]);
@@ -437,6 +690,14 @@ vector<int64_t> VolumeBase::VolumeStorage::getDimensions() const
 void VolumeBase::VolumeStorage::clear()
 {
     m_data.clear();
+    vector<char>().swap(m_nativeData);
+    m_frameCache.clear();
+    m_onDisk.grabNew(NULL);
+    m_onDiskConverted.grabNew(NULL);
+    m_storageType = STORAGE_FLOAT32;
+    m_floatInMemory = true;
+    m_nativeScale = 1.0;
+    m_nativeOffset = 0.0;
     for (int i = 0; i < 5; ++i)
     {
         m_dimensions[i] = 0;
@@ -25,7 +25,9 @@
 #include "stdint.h"
 #include <vector>
 #include "CaretAssert.h"
+#include "CaretMutex.h"
 #include "CaretPointer.h"
+#include "VolumeFrameCache.h"
 #include "VolumeMappableInterface.h"
 #include "VolumeSpace.h"
 
@@ -46,19 +48,54 @@ namespace caret {
     
     class VolumeBase : public VolumeMappableInterface
     {
+    public:
+        ///in-memory data types - the integer types hold values as they were in the file, with scaling applied when values are read out
+        enum StorageType
+        {
+            STORAGE_FLOAT32,
+            STORAGE_INT8,
+            STORAGE_UINT8,
+            STORAGE_INT16,
+            STORAGE_UINT16
+        };
+    private:
         class VolumeStorage
         {
             std::vector<float> m_data;
+            std::vector<char> m_nativeData;//used instead of m_data when m_storageType isn't float
+            CaretPointer<VolumeFrameCache> m_onDisk;//used instead of both when the file is left on disk
+            CaretPointer<VolumeFrameCache> m_onDiskConverted;//float frames for the pointer version of getFrame when on disk and not float, under the same residency limit
+            StorageType m_storageType;
+            bool m_floatInMemory;//the fast path for getValue, m_data is valid
+            double m_nativeScale, m_nativeOffset;
+            mutable std::vector<CaretPointer<std::vector<float> > > m_frameCache;//frames converted for the pointer version of getFrame, dropped on modification
+            mutable CaretMutex m_frameCacheMutex;
             int64_t m_dimensions[5];//store internally as 4d+component
             int64_t m_mult[5];//precalculated multipliers for getIndex/getValue/setValue - NOTE: [0] is for index[1], [4] is the entire size of the data
             VolumeStorage(const VolumeStorage& rhs);//deny copy, assignment for now
             VolumeStorage& operator=(const VolumeStorage& rhs);
+            float getNativeValue(const int64_t& index) const;
+            void convertTyped(const char* typedData, const int64_t& start, const int64_t& count, float* dataOut) const;//typedData is in m_storageType
+            void convertRange(float* dataOut, const int64_t& start, const int64_t& count) const;
         public:
             VolumeStorage();
             VolumeStorage(int64_t dims[5]);
             void reinitialize(int64_t dims[5]);
             void clear();
             
+            ///discards the data and switches the in-memory type, use setFrameNative to fill it
+            void setStorageType(const StorageType& type, const double& scale = 1.0, const double& offset = 0.0);
+            const StorageType& getStorageType() const { return m_storageType; }
+            
+            ///discards the data and reads frames through the reader as needed, frames are read in the given type
+            void setOnDisk(const CaretPointer<VolumeFrameCache::FrameReader>& reader, const StorageType& type, const int64_t& maxResidentBytes,
+                           const double& scale = 1.0, const double& offset = 0.0);
+            bool isOnDisk() const { return m_onDisk != NULL; }
+            
+            ///integer storage can't hold arbitrary values and on-disk storage can't be written to, so any modification switches to in-memory float
+            void convertToFloat();
+            static int64_t getBytesPerElement(const StorageType& type);
+            
             void getDimensions(std::vector<int64_t>& dimOut) const;//NOTE: always returns a vector of 5 elements
             void getDimensions(int64_t& dimOut1, int64_t& dimOut2, int64_t& dimOut3, int64_t& dimTimeOut, int64_t& numComponents) const;
             std::vector<int64_t> getDimensions() const;
@@ -70,12 +107,13 @@ namespace caret {
             void swap(VolumeStorage& rhs);
             
             ///get a value at three indexes and optionally timepoint
-            inline const float& getValue(const int64_t& indexIn1, const int64_t& indexIn2, const int64_t& indexIn3, const int64_t brickIndex, const int64_t component) const
+            inline float getValue(const int64_t& indexIn1, const int64_t& indexIn2, const int64_t& indexIn3, const int64_t brickIndex, const int64_t component) const
             {
                 CaretAssert(indexValid(indexIn1, indexIn2, indexIn3, brickIndex, component));//assert so release version isn't slowed by checking
-                return m_data[getIndex(indexIn1, indexIn2, indexIn3, brickIndex, component)];
+                if (m_floatInMemory) return m_data[getIndex(indexIn1, indexIn2, indexIn3, brickIndex, component)];
+                return getNativeValue(getIndex(indexIn1, indexIn2, indexIn3, brickIndex, component));
             }
-            inline const float& getValue(const int64_t indexIn[3], const int64_t brickIndex, const int64_t component) const
+            inline float getValue(const int64_t indexIn[3], const int64_t brickIndex, const int64_t component) const
             {
                 return getValue(indexIn[0], indexIn[1], indexIn[2], brickIndex, component);
             }
@@ -110,6 +148,7 @@ namespace caret {
             inline void setValue(const float& valueIn, const int64_t& indexIn1, const int64_t& indexIn2, const int64_t& indexIn3, const int64_t brickIndex, const int64_t component)
             {
                 CaretAssert(indexValid(indexIn1, indexIn2, indexIn3, brickIndex, component));//assert so release version isn't slowed by checking
+                if (!m_floatInMemory) convertToFloat();
                 m_data[getIndex(indexIn1, indexIn2, indexIn3, brickIndex, component)] = valueIn;
             }
             inline void setValue(const float& valueIn, const int64_t indexIn[3], const int64_t brickIndex, const int64_t component)
@@ -120,11 +159,18 @@ namespace caret {
             /// set every voxel to the given value
             void setValueAllVoxels(const float value);
             
-            ///get a frame (const)
+            ///get a frame (const) - with integer storage, the converted frame is kept until the storage is modified
+            ///with on-disk storage, the pointer is only good until enough other frames have been requested to push it out of the cache
             const float* getFrame(const int64_t brickIndex = 0, const int64_t component = 0) const;
             
+            ///copy a frame as float, does not keep a converted copy
+            void copyFrame(float* frameOut, const int64_t brickIndex = 0, const int64_t component = 0) const;
+            
             ///set a frame
             void setFrame(const float* frameIn, const int64_t brickIndex = 0, const int64_t component = 0);
+            
+            ///set a frame from unscaled data of the current storage type
+            void setFrameNative(const void* frameIn, const int64_t brickIndex = 0, const int64_t component = 0);
         };
         
         VolumeStorage m_storage;
@@ -140,6 +186,20 @@ namespace caret {
         
         void addSubvolumes(const int64_t& numToAdd);
         
+        ///discards the data and switches the in-memory type, for keeping small integer files small
+        void setStorageType(const StorageType& type, const double& scale = 1.0, const double& offset = 0.0) { m_storage.setStorageType(type, scale, offset); }
+        
+        ///set a frame from unscaled data of the current storage type, as read from a file
+        void setFrameNative(const void* frameIn, const int64_t brickIndex = 0, const int64_t component = 0) { m_storage.setFrameNative(frameIn, brickIndex, component); setModified(); }
+        
+        ///discards the data and leaves the file on disk, reading frames through the reader as they are needed
+        void setOnDisk(const CaretPointer<VolumeFrameCache::FrameReader>& reader, const StorageType& type, const int64_t& maxResidentBytes,
+                       const double& scale = 1.0, const double& offset = 0.0)
+        { m_storage.setOnDisk(reader, type, maxResidentBytes, scale, offset); }
+        
+        ///reads all frames of an on-disk volume into memory as float, for instance before overwriting its file
+        void convertStorageToFloat() { m_storage.convertToFloat(); }
+        
     public:
         void clear();
         virtual ~VolumeBase();
@@ -218,13 +278,13 @@ namespace caret {
         inline const VolumeSpace& getVolumeSpace() const { return m_volSpace; }
 
         ///get a value at an index triplet and optionally timepoint
-        inline const float& getValue(const int64_t* indexIn, const int64_t brickIndex = 0, const int64_t component = 0) const
+        inline float getValue(const int64_t* indexIn, const int64_t brickIndex = 0, const int64_t component = 0) const
         {
             return m_storage.getValue(indexIn[0], indexIn[1], indexIn[2], brickIndex, component);
         }
         
         ///get a value at three indexes and optionally timepoint
-        inline const float& getValue(const int64_t& indexIn1, const int64_t& indexIn2, const int64_t& indexIn3, const int64_t brickIndex = 0, const int64_t component = 0) const
+        inline float getValue(const int64_t& indexIn1, const int64_t& indexIn2, const int64_t& indexIn3, const int64_t brickIndex = 0, const int64_t component = 0) const
         {
             return m_storage.getValue(indexIn1, indexIn2, indexIn3, brickIndex, component);
         }
@@ -308,9 +368,17 @@ namespace caret {
             return 0.0;
         }
         
-        ///get a frame (const)
+        ///get a frame (const) - for integer storage, this keeps a converted copy of the frame until the volume is modified
         const float* getFrame(const int64_t brickIndex = 0, const int64_t component = 0) const { return m_storage.getFrame(brickIndex, component); }
         
+        ///copy a frame, without keeping a converted copy for integer storage
+        void copyFrame(float* frameOut, const int64_t brickIndex = 0, const int64_t component = 0) const { m_storage.copyFrame(frameOut, brickIndex, component); }
+        
+        const StorageType& getStorageType() const { return m_storage.getStorageType(); }
+        
+        ///whether frames are read from the file as needed
+        bool isOnDisk() const { return m_storage.isOnDisk(); }
+        
         ///set a value at an index triplet and optionally timepoint
         inline void setValue(const float& valueIn, const int64_t* indexIn, const int64_t brickIndex = 0, const int64_t component = 0)
         {
@@ -0,0 +1,151 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "VolumeFrameCache.h"
+
+#include "CaretAssert.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace caret;
+using namespace std;
+
+VolumeFrameCache::FrameReader::~FrameReader()
+{
+}
+
+VolumeFrameCache::VolumeFrameCache(const CaretPointer<FrameReader>& reader, const int64_t& numFrames, const int64_t& frameBytes, const int64_t& maxResidentBytes,
+                                   const bool& prefetch)
+{
+    CaretAssert(reader != NULL && numFrames > 0 && frameBytes > 0);
+    m_reader = reader;
+    m_frames.resize(numFrames);
+    m_lastUse.resize(numFrames, -1);
+    m_frameBytes = frameBytes;
+    m_maxResident = max((int64_t)3, maxResidentBytes / frameBytes);//always allow the requested frame and both neighbors
+    m_numResident = 0;
+    m_useCounter = 0;
+    m_stopPrefetch = false;
+    m_prefetch = prefetch;
+    if (m_prefetch) m_prefetchThread = thread(&VolumeFrameCache::prefetchLoop, this);
+}
+
+VolumeFrameCache::~VolumeFrameCache()
+{
+    {
+        lock_guard<mutex> locked(m_mutex);
+        m_stopPrefetch = true;
+    }
+    m_prefetchCondition.notify_all();
+    if (m_prefetchThread.joinable()) m_prefetchThread.join();
+}
+
+void VolumeFrameCache::insertFrame(const int64_t& frameIndex, const CaretPointer<vector<char> >& frame)
+{
+    if (m_frames[frameIndex] != NULL) return;//another thread read it first
+    if (m_numResident >= m_maxResident)
+    {//linear search for the oldest, frame counts are small compared to the reading we just did
+        int64_t oldest = -1;
+        for (int64_t i = 0; i < (int64_t)m_frames.size(); ++i)
+        {
+            if (m_frames[i] != NULL && (oldest == -1 || m_lastUse[i] < m_lastUse[oldest])) oldest = i;
+        }
+        CaretAssert(oldest != -1);
+        m_frames[oldest] = CaretPointer<vector<char> >();//anyone still using it holds their own reference
+        --m_numResident;
+    }
+    m_frames[frameIndex] = frame;
+    m_lastUse[frameIndex] = m_useCounter++;
+    ++m_numResident;
+}
+
+CaretPointer<const vector<char> > VolumeFrameCache::getFrame(const int64_t& frameIndex)
+{
+    CaretAssert(frameIndex >= 0 && frameIndex < (int64_t)m_frames.size());
+    if (m_prefetch)
+    {
+        lock_guard<mutex> locked(m_mutex);
+        m_prefetchQueue.clear();//anything not yet read is for a frame the user has moved on from
+        if (frameIndex + 1 < (int64_t)m_frames.size() && m_frames[frameIndex + 1] == NULL) m_prefetchQueue.push_back(frameIndex + 1);
+        if (frameIndex > 0 && m_frames[frameIndex - 1] == NULL) m_prefetchQueue.push_back(frameIndex - 1);
+        if (!m_prefetchQueue.empty()) m_prefetchCondition.notify_one();
+    }
+    return fetchFrame(frameIndex);
+}
+
+void VolumeFrameCache::copyBytes(void* dataOut, const int64_t& frameIndex, const int64_t& byteStart, const int64_t& numBytes)
+{
+    CaretAssert(frameIndex >= 0 && frameIndex < (int64_t)m_frames.size());
+    CaretAssert(byteStart >= 0 && numBytes >= 0 && byteStart + numBytes <= m_frameBytes);
+    {
+        lock_guard<mutex> locked(m_mutex);
+        if (m_frames[frameIndex] != NULL)
+        {//don't copy the frame pointer, slice drawing does this once per voxel
+            m_lastUse[frameIndex] = m_useCounter++;
+            memcpy(dataOut, m_frames[frameIndex]->data() + byteStart, numBytes);
+            return;
+        }
+    }
+    CaretPointer<const vector<char> > frame = fetchFrame(frameIndex);
+    memcpy(dataOut, frame->data() + byteStart, numBytes);
+}
+
+CaretPointer<const vector<char> > VolumeFrameCache::fetchFrame(const int64_t& frameIndex)
+{
+    {
+        lock_guard<mutex> locked(m_mutex);
+        if (m_frames[frameIndex] != NULL)
+        {
+            m_lastUse[frameIndex] = m_useCounter++;
+            return m_frames[frameIndex];
+        }
+    }
+    CaretPointer<vector<char> > ret(new vector<char>(m_frameBytes));
+    m_reader->readFrame(ret->data(), frameIndex);//read outside the lock, so that other frames can still be served
+    lock_guard<mutex> locked(m_mutex);
+    insertFrame(frameIndex, ret);
+    if (m_frames[frameIndex] != ret) return m_frames[frameIndex];//the prefetch thread beat us to it, use the same copy
+    return ret;
+}
+
+void VolumeFrameCache::prefetchLoop()
+{
+    unique_lock<mutex> locked(m_mutex);
+    while (true)
+    {
+        m_prefetchCondition.wait(locked, [this] { return m_stopPrefetch || !m_prefetchQueue.empty(); });
+        if (m_stopPrefetch) return;
+        int64_t frameIndex = m_prefetchQueue.back();
+        m_prefetchQueue.pop_back();
+        if (m_frames[frameIndex] != NULL) continue;
+        locked.unlock();
+        CaretPointer<vector<char> > frame(new vector<char>(m_frameBytes));
+        bool success = true;
+        try
+        {
+            m_reader->readFrame(frame->data(), frameIndex);
+        } catch (...) {
+            success = false;//a real request for this frame will throw the error
+        }
+        locked.lock();
+        if (success) insertFrame(frameIndex, frame);
+    }
+}
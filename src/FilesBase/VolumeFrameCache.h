@@ -0,0 +1,80 @@
+#ifndef __VOLUME_FRAME_CACHE_H__
+#define __VOLUME_FRAME_CACHE_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CaretPointer.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "stdint.h"
+
+namespace caret {
+    
+    ///frames of a volume that stays on disk, with a bounded number of them resident - least recently used frames are dropped first,
+    ///and the neighbors of each frame requested with getFrame are read in the background, for scrubbing through a time series
+    class VolumeFrameCache
+    {
+    public:
+        class FrameReader
+        {
+        public:
+            ///read a frame in the storage type of the volume, gets called from the prefetch thread too
+            virtual void readFrame(void* frameOut, const int64_t& frameIndex) = 0;
+            virtual ~FrameReader();
+        };
+    private:
+        CaretPointer<FrameReader> m_reader;
+        std::vector<CaretPointer<std::vector<char> > > m_frames;//NULL when not resident
+        std::vector<int64_t> m_lastUse;
+        int64_t m_frameBytes, m_maxResident, m_numResident, m_useCounter;
+        std::mutex m_mutex;//protects everything except m_reader, which must handle concurrent calls itself
+        std::condition_variable m_prefetchCondition;
+        std::vector<int64_t> m_prefetchQueue;
+        bool m_stopPrefetch, m_prefetch;
+        std::thread m_prefetchThread;
+        
+        VolumeFrameCache(const VolumeFrameCache&);
+        VolumeFrameCache& operator=(const VolumeFrameCache&);
+        void insertFrame(const int64_t& frameIndex, const CaretPointer<std::vector<char> >& frame);//call with m_mutex held
+        CaretPointer<const std::vector<char> > fetchFrame(const int64_t& frameIndex);//doesn't change what gets prefetched
+        void prefetchLoop();
+    public:
+        ///without prefetch, no background thread is started
+        VolumeFrameCache(const CaretPointer<FrameReader>& reader, const int64_t& numFrames, const int64_t& frameBytes, const int64_t& maxResidentBytes,
+                         const bool& prefetch = true);
+        ~VolumeFrameCache();
+        
+        ///the returned pointer keeps the frame alive even if it gets dropped from the cache, also moves the prefetch to this frame's neighbors
+        CaretPointer<const std::vector<char> > getFrame(const int64_t& frameIndex);
+        
+        ///for reading single values or rows: copies bytes out of a frame under the lock, and leaves the prefetch alone
+        void copyBytes(void* dataOut, const int64_t& frameIndex, const int64_t& byteStart, const int64_t& numBytes);
+        
+        int64_t getNumberOfFrames() const { return (int64_t)m_frames.size(); }
+    };
+    
+}
+
+#endif //__VOLUME_FRAME_CACHE_H__
@@ -0,0 +1,349 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "NiftiBlockPayload.h"
+
+#include "ByteSwapping.h"
+#include "CaretAssert.h"
+#include "CaretBinaryFile.h"
+#include "CaretOMP.h"
+#include "DataFileException.h"
+
+#include "zlib.h"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+
+using namespace std;
+using namespace caret;
+
+const int32_t NiftiBlockPayload::ECODE = 0x57424B31;//"WBK1", far from the registered codes
+
+namespace
+{
+    const char MAGIC[8] = { 'W', 'B', 'B', 'L', 'O', 'C', 'K', '1' };
+    const int32_t CODEC_ZLIB_SHUFFLE = 1;
+    const int HEADER_BYTES = 8 + 4 + 4 + 8 + 8 + 8;
+    const int DECODED_CACHE_SIZE = 4;//enough for sequential rows that straddle a block boundary
+
+    //the index is always little endian, independent of the nifti header's byte order
+    template<typename T>
+    void putLE(vector<char>& bytes, int64_t& pos, T value)
+    {
+        if (ByteSwapping::isBigEndian()) ByteSwapping::swap(value);
+        memcpy(bytes.data() + pos, &value, sizeof(T));
+        pos += sizeof(T);
+    }
+
+    template<typename T>
+    T getLE(const vector<char>& bytes, int64_t& pos)
+    {
+        T ret;
+        memcpy(&ret, bytes.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        if (ByteSwapping::isBigEndian()) ByteSwapping::swap(ret);
+        return ret;
+    }
+
+    //group the nth byte of every element together, floats of similar magnitude then share long runs of exponent bytes
+    void shuffle(const char* in, char* out, const int64_t& count, const int& elemSize)
+    {
+        int64_t numElems = count / elemSize;
+        for (int b = 0; b < elemSize; ++b)
+        {
+            char* plane = out + b * numElems;
+            for (int64_t i = 0; i < numElems; ++i)
+            {
+                plane[i] = in[i * elemSize + b];
+            }
+        }
+        memcpy(out + numElems * elemSize, in + numElems * elemSize, count - numElems * elemSize);//a block boundary inside an element leaves a remainder
+    }
+
+    void unshuffle(const char* in, char* out, const int64_t& count, const int& elemSize)
+    {
+        int64_t numElems = count / elemSize;
+        for (int b = 0; b < elemSize; ++b)
+        {
+            const char* plane = in + b * numElems;
+            for (int64_t i = 0; i < numElems; ++i)
+            {
+                out[i * elemSize + b] = plane[i];
+            }
+        }
+        memcpy(out + numElems * elemSize, in + numElems * elemSize, count - numElems * elemSize);
+    }
+}
+
+NiftiBlockPayload::NiftiBlockPayload()
+{
+    m_totalBytes = 0;
+    m_blockBytes = 1;
+    m_dataOffset = 0;
+    m_appendPos = 0;
+    m_elemSize = 1;
+    m_writing = false;
+}
+
+void NiftiBlockPayload::initWrite(const int64_t& totalBytes, const int64_t& blockBytes, const int& elemSize)
+{
+    CaretAssert(blockBytes > 0 && elemSize > 0);
+    m_totalBytes = totalBytes;
+    m_blockBytes = blockBytes;
+    m_elemSize = elemSize;
+    m_writing = true;
+    m_appendPos = 0;
+    m_index.clear();
+    m_index.resize((totalBytes + blockBytes - 1) / blockBytes);
+    m_pending.clear();
+    m_decoded.clear();
+}
+
+void NiftiBlockPayload::initRead(const vector<char>& extensionBytes)
+{
+    if ((int64_t)extensionBytes.size() < HEADER_BYTES || memcmp(extensionBytes.data(), MAGIC, 8) != 0)
+    {
+        throw DataFileException("unrecognized block compression extension in nifti file");
+    }
+    m_writing = false;
+    int64_t pos = 8;
+    int32_t codec = getLE<int32_t>(extensionBytes, pos);
+    if (codec != CODEC_ZLIB_SHUFFLE) throw DataFileException("nifti file uses an unknown block compression codec, it may need a newer version of workbench");
+    m_elemSize = getLE<int32_t>(extensionBytes, pos);
+    m_totalBytes = getLE<int64_t>(extensionBytes, pos);
+    m_blockBytes = getLE<int64_t>(extensionBytes, pos);
+    m_appendPos = getLE<int64_t>(extensionBytes, pos);
+    if (m_elemSize < 1 || m_blockBytes < 1 || m_totalBytes < 0 || m_appendPos < 0) throw DataFileException("invalid block compression extension in nifti file");
+    int64_t numBlocks = (m_totalBytes + m_blockBytes - 1) / m_blockBytes;
+    if ((int64_t)extensionBytes.size() < HEADER_BYTES + numBlocks * 16) throw DataFileException("block compression index in nifti file is truncated");
+    m_index.resize(numBlocks);
+    for (int64_t i = 0; i < numBlocks; ++i)
+    {
+        m_index[i].m_offset = getLE<int64_t>(extensionBytes, pos);
+        m_index[i].m_storedSize = getLE<int64_t>(extensionBytes, pos);
+        if (m_index[i].m_offset < 0 || m_index[i].m_storedSize < 0 || m_index[i].m_storedSize > blockSize(i) ||
+            m_index[i].m_offset + m_index[i].m_storedSize > m_appendPos)
+        {
+            throw DataFileException("invalid entry in block compression index of nifti file");
+        }
+    }
+    m_pending.clear();
+    m_decoded.clear();
+}
+
+void NiftiBlockPayload::getExtensionBytes(vector<char>& bytesOut) const
+{
+    bytesOut.resize(HEADER_BYTES + m_index.size() * 16);
+    memcpy(bytesOut.data(), MAGIC, 8);
+    int64_t pos = 8;
+    putLE<int32_t>(bytesOut, pos, CODEC_ZLIB_SHUFFLE);
+    putLE<int32_t>(bytesOut, pos, m_elemSize);
+    putLE<int64_t>(bytesOut, pos, m_totalBytes);
+    putLE<int64_t>(bytesOut, pos, m_blockBytes);
+    putLE<int64_t>(bytesOut, pos, m_appendPos);
+    for (size_t i = 0; i < m_index.size(); ++i)
+    {
+        putLE<int64_t>(bytesOut, pos, m_index[i].m_offset);
+        putLE<int64_t>(bytesOut, pos, m_index[i].m_storedSize);
+    }
+}
+
+int64_t NiftiBlockPayload::blockSize(const int64_t& block) const
+{
+    return min(m_blockBytes, m_totalBytes - block * m_blockBytes);
+}
+
+void NiftiBlockPayload::readStored(CaretBinaryFile& file, const int64_t& block, vector<char>& storedOut) const
+{
+    storedOut.resize(m_index[block].m_storedSize);
+    if (storedOut.empty()) return;
+    file.seek(m_dataOffset + m_index[block].m_offset);
+    file.read(storedOut.data(), storedOut.size());
+}
+
+void NiftiBlockPayload::decodeBlock(const char* stored, const int64_t& block, char* out) const
+{//const and no members modified, so it can run on several blocks at once
+    int64_t thisSize = blockSize(block), storedSize = m_index[block].m_storedSize;
+    if (storedSize == 0)
+    {
+        memset(out, 0, thisSize);
+        return;
+    }
+    if (storedSize == thisSize)
+    {
+        memcpy(out, stored, thisSize);//didn't compress, stored as-is
+        return;
+    }
+    vector<char> shuffled(thisSize);
+    uLongf decSize = thisSize;
+    if (uncompress((Bytef*)shuffled.data(), &decSize, (const Bytef*)stored, storedSize) != Z_OK || (int64_t)decSize != thisSize)
+    {
+        throw DataFileException("corrupt compressed block in nifti file");
+    }
+    unshuffle(shuffled.data(), out, thisSize, m_elemSize);
+}
+
+void NiftiBlockPayload::storeBlock(CaretBinaryFile& file, const int64_t& block, const vector<char>& data)
+{
+    int64_t thisSize = blockSize(block);
+    CaretAssert((int64_t)data.size() == thisSize);
+    vector<char> shuffled(thisSize), compressed(compressBound(thisSize));
+    shuffle(data.data(), shuffled.data(), thisSize, m_elemSize);
+    uLongf compSize = compressed.size();
+    const char* toWrite = data.data();
+    int64_t writeSize = thisSize;
+    if (compress2((Bytef*)compressed.data(), &compSize, (const Bytef*)shuffled.data(), thisSize, Z_BEST_SPEED) == Z_OK && (int64_t)compSize < thisSize)
+    {
+        toWrite = compressed.data();
+        writeSize = compSize;
+    }//otherwise, store it uncompressed, a stored size equal to the block size marks that
+    BlockEntry& myEntry = m_index[block];
+    if (myEntry.m_storedSize >= writeSize && myEntry.m_storedSize != 0)
+    {//rewriting a block, reuse its space if it fits
+        file.seek(m_dataOffset + myEntry.m_offset);
+    } else {
+        myEntry.m_offset = m_appendPos;
+        file.seek(m_dataOffset + m_appendPos);
+        m_appendPos += writeSize;
+    }
+    file.write(toWrite, writeSize);
+    myEntry.m_storedSize = writeSize;
+}
+
+const vector<char>& NiftiBlockPayload::getDecoded(CaretBinaryFile& file, const int64_t& block)
+{
+    for (size_t i = 0; i < m_decoded.size(); ++i)
+    {
+        if (m_decoded[i].first == block)
+        {
+            if (i != 0) rotate(m_decoded.begin(), m_decoded.begin() + i, m_decoded.begin() + i + 1);
+            return m_decoded[0].second;
+        }
+    }
+    vector<char> stored;
+    readStored(file, block, stored);
+    if ((int)m_decoded.size() < DECODED_CACHE_SIZE)
+    {
+        m_decoded.push_back(make_pair(block, vector<char>()));
+    }
+    rotate(m_decoded.begin(), m_decoded.end() - 1, m_decoded.end());//reuse the oldest entry as the newest
+    m_decoded[0].first = block;
+    m_decoded[0].second.resize(blockSize(block));
+    decodeBlock(stored.data(), block, m_decoded[0].second.data());
+    return m_decoded[0].second;
+}
+
+void NiftiBlockPayload::read(CaretBinaryFile& file, const int64_t& position, char* dataOut, const int64_t& count)
+{
+    if (count <= 0) return;
+    CaretAssert(position >= 0 && position + count <= m_totalBytes);
+    int64_t firstBlock = position / m_blockBytes, lastBlock = (position + count - 1) / m_blockBytes;
+    vector<int64_t> toDecode;//blocks that are entirely inside the request go straight to the output, in parallel
+    for (int64_t block = firstBlock; block <= lastBlock; ++block)
+    {
+        int64_t blockStart = block * m_blockBytes, blockEnd = blockStart + blockSize(block);
+        int64_t copyStart = max(position, blockStart), copyEnd = min(position + count, blockEnd);
+        char* outPtr = dataOut + (copyStart - position);
+        map<int64_t, PendingBlock>::const_iterator iter = m_pending.find(block);
+        if (iter != m_pending.end())
+        {
+            memcpy(outPtr, iter->second.m_data.data() + (copyStart - blockStart), copyEnd - copyStart);
+        } else if (copyStart == blockStart && copyEnd == blockEnd && lastBlock > firstBlock) {
+            toDecode.push_back(block);
+        } else {
+            const vector<char>& decoded = getDecoded(file, block);
+            memcpy(outPtr, decoded.data() + (copyStart - blockStart), copyEnd - copyStart);
+        }
+    }
+    if (toDecode.empty()) return;
+    int64_t numDecode = (int64_t)toDecode.size();
+    vector<vector<char> > stored(numDecode);
+    for (int64_t i = 0; i < numDecode; ++i)
+    {//file reads stay sequential
+        readStored(file, toDecode[i], stored[i]);
+    }
+    vector<exception_ptr> errors(numDecode);
+#pragma omp CARET_PARFOR schedule(dynamic)
+    for (int64_t i = 0; i < numDecode; ++i)
+    {
+        try
+        {
+            decodeBlock(stored[i].data(), toDecode[i], dataOut + (toDecode[i] * m_blockBytes - position));
+        } catch (...) {//exceptions can't leave an openmp loop, including bad_alloc from the decoder
+            errors[i] = current_exception();
+        }
+    }
+    for (int64_t i = 0; i < numDecode; ++i)
+    {//the first block in file order, like a serial read would report
+        if (errors[i]) rethrow_exception(errors[i]);
+    }
+}
+
+void NiftiBlockPayload::write(CaretBinaryFile& file, const int64_t& position, const char* dataIn, const int64_t& count)
+{
+    if (count <= 0) return;
+    CaretAssert(position >= 0 && position + count <= m_totalBytes);
+    int64_t firstBlock = position / m_blockBytes, lastBlock = (position + count - 1) / m_blockBytes;
+    for (int64_t block = firstBlock; block <= lastBlock; ++block)
+    {
+        int64_t blockStart = block * m_blockBytes, thisSize = blockSize(block);
+        int64_t copyStart = max(position, blockStart), copyEnd = min(position + count, blockStart + thisSize);
+        for (size_t i = 0; i < m_decoded.size(); ++i)
+        {
+            if (m_decoded[i].first == block)
+            {
+                m_decoded.erase(m_decoded.begin() + i);
+                break;
+            }
+        }
+        map<int64_t, PendingBlock>::iterator iter = m_pending.find(block);
+        if (iter == m_pending.end())
+        {
+            PendingBlock& newBlock = m_pending[block];
+            newBlock.m_data.resize(thisSize);
+            if (m_index[block].m_storedSize != 0)
+            {//read-modify-write of a block that was already stored
+                vector<char> stored;
+                readStored(file, block, stored);
+                decodeBlock(stored.data(), block, newBlock.m_data.data());
+                newBlock.m_rewrite = true;
+            }//otherwise, vector resize already zeroed it
+            iter = m_pending.find(block);
+        }
+        PendingBlock& myBlock = iter->second;
+        memcpy(myBlock.m_data.data() + (copyStart - blockStart), dataIn + (copyStart - position), copyEnd - copyStart);
+        myBlock.m_bytesWritten += copyEnd - copyStart;
+        if (!myBlock.m_rewrite && myBlock.m_bytesWritten >= thisSize)
+        {//the usual case of each byte being written once, in any order, stores a block as soon as it is complete
+            storeBlock(file, block, myBlock.m_data);
+            m_pending.erase(iter);
+        }
+    }
+}
+
+void NiftiBlockPayload::flush(CaretBinaryFile& file)
+{
+    for (map<int64_t, PendingBlock>::iterator iter = m_pending.begin(); iter != m_pending.end(); ++iter)
+    {
+        storeBlock(file, iter->first, iter->second.m_data);
+    }
+    m_pending.clear();
+}
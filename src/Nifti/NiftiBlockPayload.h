@@ -0,0 +1,89 @@
+#ifndef __NIFTI_BLOCK_PAYLOAD_H__
+#define __NIFTI_BLOCK_PAYLOAD_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <map>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace caret
+{
+
+    class CaretBinaryFile;
+
+    ///workbench-specific nifti payload layout: the bytes after vox_offset are fixed-size blocks of the normal payload, each byte-shuffled and zlib
+    ///compressed on its own, with the block index in a nifti extension, so any range can be read by decompressing only the blocks it touches
+    ///other nifti readers will see a file that is too short for its dimensions
+    ///positions are byte offsets into the uncompressed payload, not counting vox_offset, NiftiIO calls everything with its mutex held
+    class NiftiBlockPayload
+    {
+        struct BlockEntry
+        {
+            int64_t m_offset, m_storedSize;//stored size equal to the block size means stored uncompressed, 0 means never written (all zeros)
+            BlockEntry() : m_offset(0), m_storedSize(0) { }
+        };
+        struct PendingBlock
+        {
+            std::vector<char> m_data;
+            int64_t m_bytesWritten;
+            bool m_rewrite;//was already in the file, so don't assume it is finished when the byte count is reached
+            PendingBlock() : m_bytesWritten(0), m_rewrite(false) { }
+        };
+        int64_t m_totalBytes, m_blockBytes, m_dataOffset, m_appendPos;
+        int m_elemSize;
+        bool m_writing;
+        std::vector<BlockEntry> m_index;
+        std::map<int64_t, PendingBlock> m_pending;
+        std::vector<std::pair<int64_t, std::vector<char> > > m_decoded;//small most-recently-used cache, front is newest
+
+        int64_t blockSize(const int64_t& block) const;
+        void decodeBlock(const char* stored, const int64_t& block, char* out) const;
+        void readStored(CaretBinaryFile& file, const int64_t& block, std::vector<char>& storedOut) const;
+        void storeBlock(CaretBinaryFile& file, const int64_t& block, const std::vector<char>& data);
+        const std::vector<char>& getDecoded(CaretBinaryFile& file, const int64_t& block);
+    public:
+        static const int32_t ECODE;//not a registered nifti extension code, other readers should ignore it
+
+        NiftiBlockPayload();
+        ///empty payload for a new file, the index starts all zeros
+        void initWrite(const int64_t& totalBytes, const int64_t& blockBytes, const int& elemSize);
+        ///payload of an existing file, from the bytes of its extension
+        void initRead(const std::vector<char>& extensionBytes);
+        ///vox_offset, for a new file it is only known after the header (including this extension) is written
+        void setDataOffset(const int64_t& dataOffset) { m_dataOffset = dataOffset; }
+        int64_t getTotalBytes() const { return m_totalBytes; }
+        bool isWriting() const { return m_writing; }
+        ///the extension has the same size for the whole life of the file, so the header doesn't move when the final index is written
+        void getExtensionBytes(std::vector<char>& bytesOut) const;
+        ///size of the file that the stored blocks need, for truncation checks
+        int64_t getStoredExtent() const { return m_dataOffset + m_appendPos; }
+
+        void read(CaretBinaryFile& file, const int64_t& position, char* dataOut, const int64_t& count);
+        void write(CaretBinaryFile& file, const int64_t& position, const char* dataIn, const int64_t& count);
+        ///stores all pending blocks, any part of them that was never written is zeros
+        void flush(CaretBinaryFile& file);
+    };
+
+}
+
+#endif //__NIFTI_BLOCK_PAYLOAD_H__
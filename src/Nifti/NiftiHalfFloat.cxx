@@ -0,0 +1,259 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "NiftiHalfFloat.h"
+
+#include "ByteSwapping.h"
+#include "CaretAssert.h"
+#include "DataFileException.h"
+#include "NiftiHeader.h"
+
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CARET_HALF_F16C
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+using namespace std;
+using namespace caret;
+
+const int32_t NiftiHalfFloat::ECODE = 0x57424831;//"WBH1"
+const int16_t NiftiHalfFloat::DTYPE_FLOAT16 = 0x7F01;//far from the nifti codes
+const int16_t NiftiHalfFloat::DTYPE_BFLOAT16 = 0x7F02;
+
+namespace
+{
+    const char MAGIC[8] = { 'W', 'B', 'H', 'A', 'L', 'F', '0', '1' };
+
+    uint16_t floatToHalf(const float& in)
+    {
+        uint32_t bits;
+        memcpy(&bits, &in, 4);
+        uint16_t sign = (bits >> 16) & 0x8000;
+        uint32_t absBits = bits & 0x7FFFFFFF;
+        if (absBits >= 0x7F800000)
+        {//keep NaN as NaN, even when the payload bits that survive are all zero
+            return sign | 0x7C00 | (absBits > 0x7F800000 ? 0x200 | ((absBits >> 13) & 0x3FF) : 0);
+        }
+        if (absBits >= 0x477FF000) return sign | 0x7C00;//65520 and up round to infinity
+        if (absBits < 0x38800000)
+        {//subnormal in half precision
+            if (absBits <= 0x33000000) return sign;//half of the smallest subnormal or less, ties go to even (zero)
+            uint32_t mantissa = (absBits & 0x7FFFFF) | 0x800000;
+            int shift = 126 - (int)(absBits >> 23);
+            uint32_t result = mantissa >> shift, remainder = mantissa & ((1u << shift) - 1), halfway = 1u << (shift - 1);
+            if (remainder > halfway || (remainder == halfway && (result & 1))) ++result;
+            return sign | result;
+        }
+        uint32_t result = (absBits - 0x38000000) >> 13, remainder = absBits & 0x1FFF;
+        if (remainder > 0x1000 || (remainder == 0x1000 && (result & 1))) ++result;//a carry into the exponent is still correct
+        return sign | result;
+    }
+
+    float halfToFloat(const uint16_t& in)
+    {
+        uint32_t sign = ((uint32_t)(in & 0x8000)) << 16, exponent = (in >> 10) & 0x1F, mantissa = in & 0x3FF, bits;
+        if (exponent == 0)
+        {
+            float ret = mantissa * 5.9604644775390625e-8f;//2^-24, exact
+            return sign ? -ret : ret;
+        }
+        if (exponent == 31)
+        {
+            bits = sign | 0x7F800000 | (mantissa << 13);
+        } else {
+            bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+        }
+        float ret;
+        memcpy(&ret, &bits, 4);
+        return ret;
+    }
+
+    uint16_t floatToBFloat(const float& in)
+    {
+        uint32_t bits;
+        memcpy(&bits, &in, 4);
+        if ((bits & 0x7FFFFFFF) > 0x7F800000) return (bits >> 16) | 0x40;//quiet NaN, rounding could turn it into infinity
+        return (bits + 0x7FFF + ((bits >> 16) & 1)) >> 16;
+    }
+
+    float bfloatToFloat(const uint16_t& in)
+    {
+        uint32_t bits = ((uint32_t)in) << 16;
+        float ret;
+        memcpy(&ret, &bits, 4);
+        return ret;
+    }
+
+#ifdef CARET_HALF_F16C
+    bool haveF16C()
+    {
+        unsigned int eax, ebx, ecx, edx;
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+        __builtin_cpu_init();//this runs during static initialization, possibly before libgcc has filled in what __builtin_cpu_supports checks
+        const unsigned int F16C_BIT = 1u << 29;
+        return (ecx & F16C_BIT) && __builtin_cpu_supports("avx");//the avx check includes whether the OS saves ymm registers
+    }
+
+    const bool s_haveF16C = haveF16C();
+
+    __attribute__((target("avx,f16c")))
+    int64_t halfToFloatF16C(const uint16_t* in, float* out, const int64_t& count)
+    {//returns how many it converted, the remainder is done with scalar code
+        int64_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            _mm256_storeu_ps(out + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(in + i))));
+        }
+        return i;
+    }
+
+    __attribute__((target("avx,f16c")))
+    int64_t floatToHalfF16C(const float* in, uint16_t* out, const int64_t& count)
+    {
+        int64_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            _mm_storeu_si128((__m128i*)(out + i), _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT));
+        }
+        return i;
+    }
+#endif
+}
+
+NiftiHalfFloat::Format NiftiHalfFloat::fromDataType(const int16_t& type)
+{
+    if (type == DTYPE_FLOAT16) return FLOAT16;
+    if (type == DTYPE_BFLOAT16) return BFLOAT16;
+    return NONE;
+}
+
+void NiftiHalfFloat::setHeaderFormat(NiftiHeader& header, const Format& format)
+{
+    for (size_t i = 0; i < header.m_extensions.size(); ++i)
+    {
+        if (header.m_extensions[i]->m_ecode == ECODE)
+        {
+            header.m_extensions.erase(header.m_extensions.begin() + i);
+            --i;
+        }
+    }
+    if (format == NONE) return;
+    header.setDataType(NIFTI_TYPE_UINT16);
+    header.clearDataScaling();
+    CaretPointer<NiftiExtension> formatExtension(new NiftiExtension());
+    formatExtension->m_ecode = ECODE;
+    formatExtension->m_bytes.resize(12);
+    memcpy(formatExtension->m_bytes.data(), MAGIC, 8);
+    int32_t formatCode = format;
+    if (ByteSwapping::isBigEndian()) ByteSwapping::swap(formatCode);//always little endian, like the header of a block compressed payload
+    memcpy(formatExtension->m_bytes.data() + 8, &formatCode, 4);
+    header.m_extensions.push_back(formatExtension);
+}
+
+NiftiHalfFloat::Format NiftiHalfFloat::getHeaderFormat(const NiftiHeader& header)
+{
+    if (header.getDataType() != NIFTI_TYPE_UINT16) return NONE;
+    for (size_t i = 0; i < header.m_extensions.size(); ++i)
+    {
+        const NiftiExtension& thisExt = *(header.m_extensions[i]);
+        if (thisExt.m_ecode == ECODE)
+        {
+            if (thisExt.m_bytes.size() < 12 || memcmp(thisExt.m_bytes.data(), MAGIC, 8) != 0)
+            {
+                throw DataFileException("unrecognized half precision extension in nifti file");
+            }
+            int32_t formatCode;
+            memcpy(&formatCode, thisExt.m_bytes.data() + 8, 4);
+            if (ByteSwapping::isBigEndian()) ByteSwapping::swap(formatCode);
+            switch (formatCode)
+            {
+                case FLOAT16:
+                    return FLOAT16;
+                case BFLOAT16:
+                    return BFLOAT16;
+                default:
+                    throw DataFileException("nifti file uses an unknown half precision format, it may need a newer version of workbench");
+            }
+        }
+    }
+    return NONE;
+}
+
+void NiftiHalfFloat::toFloat(const uint16_t* in, float* out, const int64_t& count, const Format& format)
+{
+    CaretAssert(format != NONE);
+    if (format == BFLOAT16)
+    {
+        for (int64_t i = 0; i < count; ++i)
+        {
+            out[i] = bfloatToFloat(in[i]);
+        }
+        return;
+    }
+    int64_t i = 0;
+#ifdef CARET_HALF_F16C
+    if (s_haveF16C) i = halfToFloatF16C(in, out, count);
+#endif
+    for (; i < count; ++i)
+    {
+        out[i] = halfToFloat(in[i]);
+    }
+}
+
+void NiftiHalfFloat::fromFloat(const float* in, uint16_t* out, const int64_t& count, const Format& format)
+{
+    CaretAssert(format != NONE);
+    if (format == BFLOAT16)
+    {
+        for (int64_t i = 0; i < count; ++i)
+        {
+            out[i] = floatToBFloat(in[i]);
+        }
+        return;
+    }
+    int64_t i = 0;
+#ifdef CARET_HALF_F16C
+    if (s_haveF16C) i = floatToHalfF16C(in, out, count);
+#endif
+    for (; i < count; ++i)
+    {
+        out[i] = floatToHalf(in[i]);
+    }
+}
+
+int64_t NiftiHalfFloat::countSaturated(const float* in, const uint16_t* converted, const int64_t& count, const Format& format)
+{
+    CaretAssert(format != NONE);
+    const uint16_t infBits = (format == BFLOAT16 ? 0x7F80 : 0x7C00);
+    int64_t ret = 0;
+    for (int64_t i = 0; i < count; ++i)
+    {
+        if ((converted[i] & 0x7FFF) == infBits)
+        {
+            uint32_t bits;
+            memcpy(&bits, in + i, 4);
+            if ((bits & 0x7FFFFFFF) < 0x7F800000) ++ret;
+        }
+    }
+    return ret;
+}
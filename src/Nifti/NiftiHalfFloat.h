@@ -0,0 +1,63 @@
+#ifndef __NIFTI_HALF_FLOAT_H__
+#define __NIFTI_HALF_FLOAT_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <stdint.h>
+
+namespace caret
+{
+
+    struct NiftiHeader;
+
+    ///nifti has no 16-bit float datatype, so workbench stores them with the UINT16 datatype and a nifti extension naming the real format
+    ///other nifti readers will see the raw bit patterns as integers
+    class NiftiHalfFloat
+    {
+        NiftiHalfFloat();
+    public:
+        enum Format
+        {
+            NONE = 0,
+            FLOAT16 = 1,//IEEE binary16: 11 bits of precision, range +/-65504
+            BFLOAT16 = 2//upper half of a float32: 8 bits of precision, float32 range
+        };
+        static const int32_t ECODE;//not a registered nifti extension code, other readers should ignore it
+        ///datatype codes for setWritingDataType...() and similar, never written into a header
+        static const int16_t DTYPE_FLOAT16, DTYPE_BFLOAT16;
+
+        ///NONE for any real nifti datatype
+        static Format fromDataType(const int16_t& type);
+        ///sets the UINT16 datatype and the extension, removes scaling, NONE only removes the extension
+        static void setHeaderFormat(NiftiHeader& header, const Format& format);
+        ///ignores the extension when the datatype isn't UINT16, as it would be left over from a file that was converted by something else
+        static Format getHeaderFormat(const NiftiHeader& header);
+
+        ///uses F16C instructions when the cpu has them, rounds to nearest even
+        static void toFloat(const uint16_t* in, float* out, const int64_t& count, const Format& format);
+        static void fromFloat(const float* in, uint16_t* out, const int64_t& count, const Format& format);
+        ///how many finite inputs were too large for the format, and so were converted to +/-inf
+        static int64_t countSaturated(const float* in, const uint16_t* converted, const int64_t& count, const Format& format);
+    };
+
+}
+
+#endif //__NIFTI_HALF_FLOAT_H__
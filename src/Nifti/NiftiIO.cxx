@@ -20,6 +20,7 @@
 
 #include "NiftiIO.h"
 
+#include "CaretLogger.h"
 #include "DataFileException.h"
 
 using namespace std;
@@ -34,46 +35,215 @@ void NiftiIO::openRead(const QString& filename)
         throw DataFileException("file uses the binary datatype, which is unsupported: " + filename);
     }
     m_dims = m_header.getDimensions();
+    m_halfFormat = NiftiHalfFloat::getHeaderFormat(m_header);
     int64_t filesize = m_file.size();//returns -1 if it can't efficiently determine size
     int64_t elemCount = getNumComponents();
     for (int i = 0; i < (int)m_dims.size(); ++i)
     {
         elemCount *= m_dims[i];
     }
-    if (filesize >= 0 && filesize < m_header.getDataOffset() + numBytesPerElem() * elemCount)
+    m_blockPayload.grabNew(NULL);
+    for (size_t i = 0; i < m_header.m_extensions.size(); ++i)
+    {
+        if (m_header.m_extensions[i]->m_ecode == NiftiBlockPayload::ECODE)
+        {
+            m_blockPayload.grabNew(new NiftiBlockPayload());
+            m_blockPayload->initRead(m_header.m_extensions[i]->m_bytes);
+            m_blockPayload->setDataOffset(m_header.getDataOffset());
+            if (m_blockPayload->getTotalBytes() != numBytesPerElem() * elemCount)
+            {
+                throw DataFileException("block compression index doesn't match the dimensions of nifti file: " + filename);
+            }
+            break;
+        }
+    }
+    int64_t neededSize = m_header.getDataOffset() + numBytesPerElem() * elemCount;
+    if (m_blockPayload != NULL) neededSize = m_blockPayload->getStoredExtent();
+    if (filesize >= 0 && filesize < neededSize)
     {
         throw DataFileException("nifti file is truncated: " + filename);
     }
 }
 
-void NiftiIO::writeNew(const QString& filename, const NiftiHeader& header, const int& version, const bool& withRead, const bool& swapEndian)
+void NiftiIO::writeNew(const QString& filename, const NiftiHeader& header, const int& version, const bool& withRead, const bool& swapEndian,
+                       const int64_t& compressBlockElements)
 {
     if (header.getDataType() == DT_BINARY)
     {
         throw DataFileException("writing NIFTI with binary datatype is unsupported");
     }
-    if (withRead)
+    if (withRead || compressBlockElements > 0)
     {
-        m_file.open(filename, CaretBinaryFile::READ_WRITE_TRUNCATE);//for cifti on-disk writing, replace structure with along row needs to RMW
+        m_file.open(filename, CaretBinaryFile::READ_WRITE_TRUNCATE);//for cifti on-disk writing, replace structure with along row needs to RMW, as does rewriting part of a compressed block
     } else {
         m_file.open(filename, CaretBinaryFile::WRITE_TRUNCATE);
     }
     m_header = header;
-    m_header.write(m_file, version, swapEndian);
     m_dims = m_header.getDimensions();
+    for (size_t i = 0; i < m_header.m_extensions.size(); ++i)
+    {//a header from a file that was read keeps its extensions, and an old block index doesn't describe the new payload
+        if (m_header.m_extensions[i]->m_ecode == NiftiBlockPayload::ECODE)
+        {
+            m_header.m_extensions.erase(m_header.m_extensions.begin() + i);
+            --i;
+        }
+    }
+    m_halfFormat = NiftiHalfFloat::getHeaderFormat(m_header);
+    m_warnedSaturation = false;
+    if (m_halfFormat == NiftiHalfFloat::NONE) NiftiHalfFloat::setHeaderFormat(m_header, NiftiHalfFloat::NONE);//also drop a leftover extension when the datatype was changed
+    m_blockPayload.grabNew(NULL);
+    if (compressBlockElements > 0)
+    {
+        int64_t totalBytes = getNumComponents() * numBytesPerElem();
+        for (int i = 0; i < (int)m_dims.size(); ++i)
+        {
+            totalBytes *= m_dims[i];
+        }
+        m_blockPayload.grabNew(new NiftiBlockPayload());
+        m_blockPayload->initWrite(totalBytes, compressBlockElements * numBytesPerElem(), numBytesPerElem());
+        CaretPointer<NiftiExtension> indexExtension(new NiftiExtension());
+        indexExtension->m_ecode = NiftiBlockPayload::ECODE;
+        m_blockPayload->getExtensionBytes(indexExtension->m_bytes);//same size as the final index, which is written on close
+        m_header.m_extensions.push_back(indexExtension);
+    }
+    m_header.write(m_file, version, swapEndian);
+    if (m_blockPayload != NULL) m_blockPayload->setDataOffset(m_header.getDataOffset());
+}
+
+void NiftiIO::finishBlockPayload()
+{//stores the partial blocks and rewrites the header with the final index, the header size doesn't change
+    CaretAssert(m_blockPayload != NULL);
+    m_blockPayload->flush(m_file);
+    for (size_t i = 0; i < m_header.m_extensions.size(); ++i)
+    {
+        if (m_header.m_extensions[i]->m_ecode == NiftiBlockPayload::ECODE)
+        {
+            m_blockPayload->getExtensionBytes(m_header.m_extensions[i]->m_bytes);
+            break;
+        }
+    }
+    m_file.seek(0);
+    m_header.write(m_file, m_header.version(), m_header.isSwapped());
 }
 
 void NiftiIO::close()
 {
+    if (m_blockPayload != NULL && m_blockPayload->isWriting())
+    {
+        finishBlockPayload();
+    }
+    m_blockPayload.grabNew(NULL);
     m_file.close();
     m_dims.clear();
 }
 
+NiftiIO::~NiftiIO()
+{
+    try
+    {
+        close();
+    } catch (exception& e) {//a compressed file that can't be finished is unusable, but destructors shouldn't throw
+        CaretLogSevere("failed to finish writing nifti file '" + m_file.getFilename() + "': " + e.what());
+    }
+}
+
+void NiftiIO::readPayload(char* dataOut, const int64_t& position, const int64_t& count, int64_t* numRead)
+{
+    if (m_blockPayload != NULL)
+    {
+        m_blockPayload->read(m_file, position, dataOut, count);//throws on any problem, and never reads short
+        if (numRead != NULL) *numRead = count;
+    } else {
+        m_file.seek(position + m_header.getDataOffset());
+        m_file.read(dataOut, count, numRead);
+    }
+}
+
+void NiftiIO::writePayload(const char* dataIn, const int64_t& position, const int64_t& count)
+{
+    if (m_blockPayload != NULL)
+    {
+        m_blockPayload->write(m_file, position, dataIn, count);
+    } else {
+        m_file.seek(position + m_header.getDataOffset());
+        m_file.write(dataIn, count);
+    }
+}
+
 int NiftiIO::getNumComponents() const
 {
     return m_header.getNumComponents();
 }
 
+void NiftiIO::readRawData(void* dataOut, const int& fullDims, const vector<int64_t>& indexSelect)
+{
+    CaretAssert(fullDims >= 0 && fullDims <= (int)m_dims.size());
+    CaretAssert((size_t)fullDims + indexSelect.size() == m_dims.size());
+    int64_t numElems = getNumComponents();
+    int curDim;
+    for (curDim = 0; curDim < fullDims; ++curDim)
+    {
+        numElems *= m_dims[curDim];
+    }
+    int64_t numDimSkip = numElems, numSkip = 0;
+    for (; curDim < (int)m_dims.size(); ++curDim)
+    {
+        CaretAssert(indexSelect[curDim - fullDims] >= 0 && indexSelect[curDim - fullDims] < m_dims[curDim]);
+        numSkip += indexSelect[curDim - fullDims] * numDimSkip;
+        numDimSkip *= m_dims[curDim];
+    }
+    const int elemSize = numBytesPerElem();
+    CaretMutexLocker locked(&m_mutex);//no scratch needed, but don't seek while another thread is reading
+    int64_t numRead = 0;
+    readPayload((char*)dataOut, numSkip * elemSize, numElems * elemSize, &numRead);
+    if (numRead != numElems * elemSize)
+    {
+        throw DataFileException("error while reading from nifti file '" + m_file.getFilename() + "'");
+    }
+    if (m_header.isSwapped())
+    {
+        switch (elemSize)
+        {
+            case 1:
+                break;
+            case 2:
+                ByteSwapping::swapArray((int16_t*)dataOut, numElems);
+                break;
+            case 4:
+                ByteSwapping::swapArray((int32_t*)dataOut, numElems);
+                break;
+            case 8:
+                ByteSwapping::swapArray((int64_t*)dataOut, numElems);
+                break;
+            default://long double, which ByteSwapping handles as its own type
+                ByteSwapping::swapArray((long double*)dataOut, numElems);
+                break;
+        }
+    }
+}
+
+void NiftiIO::convertReadHalf(float* out, uint16_t* in, const int64_t& count)
+{
+    if (m_header.isSwapped()) ByteSwapping::swapArray(in, count);
+    NiftiHalfFloat::toFloat(in, out, count, m_halfFormat);
+}
+
+void NiftiIO::convertWriteHalf(uint16_t* out, const float* in, const int64_t& count)
+{
+    NiftiHalfFloat::fromFloat(in, out, count, m_halfFormat);
+    if (!m_warnedSaturation)
+    {
+        int64_t numSaturated = NiftiHalfFloat::countSaturated(in, out, count, m_halfFormat);
+        if (numSaturated > 0)
+        {
+            CaretLogWarning(AString::number(numSaturated) + " values written to file '" + m_file.getFilename() +
+                            "' are too large for its 16-bit float datatype (float16 only goes up to 65504) and became infinity, use a wider datatype to keep them");
+            m_warnedSaturation = true;
+        }
+    }
+    if (m_header.isSwapped()) ByteSwapping::swapArray(out, count);
+}
+
 int NiftiIO::numBytesPerElem()
 {
     switch (m_header.getDataType())
@@ -26,6 +26,8 @@
 #include "CaretBinaryFile.h"
 #include "CaretMutex.h"
 #include "DataFileException.h"
+#include "NiftiBlockPayload.h"
+#include "NiftiHalfFloat.h"
 #include "NiftiHeader.h"
 
 #include <QString>
@@ -44,16 +46,36 @@ namespace caret
         std::vector<int64_t> m_dims;
         std::vector<char> m_scratch;//scratch memory for byteswapping, type conversion, etc
         CaretMutex m_mutex;//protect multithreaded calls from each other
+        CaretPointer<NiftiBlockPayload> m_blockPayload;//only for block compressed files
+        NiftiHalfFloat::Format m_halfFormat;//UINT16 in the header, but really 16-bit floats
+        bool m_warnedSaturation;//only warn once per file about values that became infinity
         int numBytesPerElem();//for resizing scratch
+        //positions are relative to vox_offset, these handle block compressed files
+        void readPayload(char* dataOut, const int64_t& position, const int64_t& count, int64_t* numRead);
+        void writePayload(const char* dataIn, const int64_t& position, const int64_t& count);
+        void finishBlockPayload();
         template<typename TO, typename FROM>
         void convertRead(TO* out, FROM* in, const int64_t& count);//for reading from file
         template<typename TO, typename FROM>
         void convertWrite(TO* out, const FROM* in, const int64_t& count);//for writing to file
         template<typename TO, typename FROM>
         static TO clamp(const FROM& in);//deal with integer cast being undefined when converting from outside range
+        void convertReadHalf(float* out, uint16_t* in, const int64_t& count);
+        template<typename TO>
+        void convertReadHalf(TO* out, uint16_t* in, const int64_t& count);
+        void convertWriteHalf(uint16_t* out, const float* in, const int64_t& count);
+        template<typename FROM>
+        void convertWriteHalf(uint16_t* out, const FROM* in, const int64_t& count);
     public:
+        NiftiIO() : m_halfFormat(NiftiHalfFloat::NONE), m_warnedSaturation(false) { }
+        ~NiftiIO();
         void openRead(const QString& filename);
-        void writeNew(const QString& filename, const NiftiHeader& header, const int& version = 1, const bool& withRead = false, const bool& swapEndian = false);
+        ///compressBlockElements greater than zero writes the workbench-specific block compressed layout, see NiftiBlockPayload
+        void writeNew(const QString& filename, const NiftiHeader& header, const int& version = 1, const bool& withRead = false, const bool& swapEndian = false,
+                      const int64_t& compressBlockElements = -1);
+        bool isBlockCompressed() const { return m_blockPayload != NULL; }
+        ///readRawData gives the 16-bit patterns of these, not integers
+        NiftiHalfFloat::Format getHalfFormat() const { return m_halfFormat; }
         QString getFilename() const { return m_file.getFilename(); }
         void overrideDimensions(const std::vector<int64_t>& newDims) { m_dims = newDims; }//HACK: deal with reading/writing CIFTI-1's broken headers
         void close();
@@ -66,6 +88,9 @@ namespace caret
         void readData(T* dataOut, const int& fullDims, const std::vector<int64_t>& indexSelect, const bool& tolerateShortRead = false);
         template<typename T>
         void writeData(const T* dataIn, const int& fullDims, const std::vector<int64_t>& indexSelect);
+        //reads in the file's datatype without applying scaling, only byteswapping, dataOut needs getNumBytesPerElement() times the number of elements
+        void readRawData(void* dataOut, const int& fullDims, const std::vector<int64_t>& indexSelect);
+        int getNumBytesPerElement() { return numBytesPerElem(); }
     };
     
     template<typename T>
@@ -90,9 +115,8 @@ namespace caret
         //we can't guarantee that the output memory is enough to use as scratch space, as we might be doing a narrowing conversion
         //we are doing FILE ACCESS, so cpu performance isn't really something to worry about
         m_scratch.resize(numElems * numBytesPerElem());
-        m_file.seek(numSkip * numBytesPerElem() + m_header.getDataOffset());
         int64_t numRead = 0;
-        m_file.read(m_scratch.data(), m_scratch.size(), &numRead);
+        readPayload(m_scratch.data(), numSkip * numBytesPerElem(), m_scratch.size(), &numRead);
         if ((numRead != (int64_t)m_scratch.size() && !tolerateShortRead) || numRead < 0)//for now, assume read giving -1 is always a problem
         {
             throw DataFileException("error while reading from nifti file '" + m_file.getFilename() + "'");
@@ -107,7 +131,12 @@ namespace caret
                 convertRead(dataOut, (int8_t*)m_scratch.data(), numElems);
                 break;
             case NIFTI_TYPE_UINT16:
-                convertRead(dataOut, (uint16_t*)m_scratch.data(), numElems);
+                if (m_halfFormat != NiftiHalfFloat::NONE)
+                {
+                    convertReadHalf(dataOut, (uint16_t*)m_scratch.data(), numElems);
+                } else {
+                    convertRead(dataOut, (uint16_t*)m_scratch.data(), numElems);
+                }
                 break;
             case NIFTI_TYPE_INT16:
                 convertRead(dataOut, (int16_t*)m_scratch.data(), numElems);
@@ -163,7 +192,6 @@ namespace caret
         CaretMutexLocker locked(&m_mutex);//protect starting with resizing until we are done writing, because we use an internal variable for scratch space
         //we are doing FILE ACCESS, so cpu performance isn't really something to worry about
         m_scratch.resize(numElems * numBytesPerElem());
-        m_file.seek(numSkip * numBytesPerElem() + m_header.getDataOffset());
         switch (m_header.getDataType())
         {
             case NIFTI_TYPE_UINT8:
@@ -174,7 +202,12 @@ namespace caret
                 convertWrite((int8_t*)m_scratch.data(), dataIn, numElems);
                 break;
             case NIFTI_TYPE_UINT16:
-                convertWrite((uint16_t*)m_scratch.data(), dataIn, numElems);
+                if (m_halfFormat != NiftiHalfFloat::NONE)
+                {
+                    convertWriteHalf((uint16_t*)m_scratch.data(), dataIn, numElems);
+                } else {
+                    convertWrite((uint16_t*)m_scratch.data(), dataIn, numElems);
+                }
                 break;
             case NIFTI_TYPE_INT16:
                 convertWrite((int16_t*)m_scratch.data(), dataIn, numElems);
@@ -207,7 +240,7 @@ namespace caret
                 CaretAssert(0);
                 throw DataFileException("internal error, tell the developers what you just tried to do");
         }
-        m_file.write(m_scratch.data(), m_scratch.size());
+        writePayload(m_scratch.data(), numSkip * numBytesPerElem(), m_scratch.size());
     }
     
     template<typename TO, typename FROM>
@@ -285,6 +318,33 @@ namespace caret
         if (m_header.isSwapped()) ByteSwapping::swapArray(out, count);
     }
     
+    template<typename TO>
+    void NiftiIO::convertReadHalf(TO* out, uint16_t* in, const int64_t& count)
+    {//float output is the common case, and doesn't need this extra buffer
+        std::vector<float> decoded(count);
+        convertReadHalf(decoded.data(), in, count);
+        for (int64_t i = 0; i < count; ++i)
+        {
+            if (std::numeric_limits<TO>::is_integer)
+            {
+                out[i] = clamp<TO, double>(floor(0.5 + decoded[i]));
+            } else {
+                out[i] = (TO)decoded[i];
+            }
+        }
+    }
+    
+    template<typename FROM>
+    void NiftiIO::convertWriteHalf(uint16_t* out, const FROM* in, const int64_t& count)
+    {
+        std::vector<float> toEncode(count);
+        for (int64_t i = 0; i < count; ++i)
+        {
+            toEncode[i] = (float)in[i];
+        }
+        convertWriteHalf(out, toEncode.data(), count);
+    }
+    
     template<typename TO, typename FROM>
     TO NiftiIO::clamp(const FROM& in)
     {
@@ -0,0 +1,78 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "OperationCiftiMatrixPyramid.h"
+#include "OperationException.h"
+
+#include "CiftiFile.h"
+#include "CiftiMatrixPyramid.h"
+
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+AString OperationCiftiMatrixPyramid::getCommandSwitch()
+{
+    return "-cifti-matrix-pyramid";
+}
+
+AString OperationCiftiMatrixPyramid::getShortDescription()
+{
+    return "PRECOMPUTE LEVELS OF DETAIL FOR CHARTING A LARGE CIFTI MATRIX";
+}
+
+OperationParameters* OperationCiftiMatrixPyramid::getParameters()
+{
+    OperationParameters* ret = new OperationParameters();
+    
+    ret->addCiftiParameter(1, "cifti", "the cifti matrix file");
+    
+    OptionalParameter* maxCellsOpt = ret->createOptionalParameter(2, "-max-stored-cells", "limit the size of the stored levels");
+    maxCellsOpt->addIntegerParameter(1, "cells", "maximum number of pooled cells in the stored levels, default " +
+                                     AString::number(CiftiMatrixPyramid::DEFAULT_MAXIMUM_STORED_CELLS));
+    
+    ret->setHelpText(
+        AString("Reads the matrix once and saves averages over blocks of 2x2, 4x4, 8x8, etc cells to a file next to the input, ") +
+        "named by appending '" + CiftiMatrixPyramid::getCacheFileName("") + "' to the input filename.  " +
+        "When wb_view charts a matrix too large to draw every cell, it uses these levels of detail instead of reading the whole matrix when the file is loaded.  " +
+        "The saved file is ignored if the cifti file is modified afterwards, in which case this command should be run again.\n\n" +
+        "Only the coarser levels that fit within the limit of stored cells are saved, finer levels are read from the cifti file " +
+        "for the part of the matrix that is in view."
+    );
+    return ret;
+}
+
+void OperationCiftiMatrixPyramid::useParameters(OperationParameters* myParams, ProgressObject* myProgObj)
+{
+    LevelProgress myProgress(myProgObj);
+    const CiftiFile* myCifti = myParams->getCifti(1);
+    int64_t maxCells = CiftiMatrixPyramid::DEFAULT_MAXIMUM_STORED_CELLS;
+    OptionalParameter* maxCellsOpt = myParams->getOptionalParameter(2);
+    if (maxCellsOpt->m_present)
+    {
+        maxCells = maxCellsOpt->getInteger(1);
+        if (maxCells < 1) throw OperationException("maximum stored cells must be positive");
+    }
+    if (myCifti->getCiftiXML().getNumberOfDimensions() != 2) throw OperationException("input cifti file must be a 2D matrix");
+    CiftiMatrixPyramid myPyramid;
+    myPyramid.build(myCifti, vector<int32_t>(), maxCells);
+    myPyramid.writeCacheFile(myCifti->getFileName());
+}
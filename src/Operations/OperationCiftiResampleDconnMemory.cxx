@@ -23,14 +23,326 @@
 
 #include "AffineFile.h"
 #include "AlgorithmCiftiResample.h"
+#include "AlgorithmCiftiSeparate.h"
+#include "CaretAssert.h"
+#include "CaretLogger.h"
+#include "CaretOMP.h"
 #include "CiftiFile.h"
+#include "FloatMatrix.h"
 #include "MetricFile.h"
 #include "SurfaceFile.h"
+#include "SurfaceResamplingHelper.h"
+#include "Vector3D.h"
+#include "VolumeSpace.h"
 #include "WarpfieldFile.h"
 
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <utility>
+#include <vector>
+
 using namespace caret;
 using namespace std;
 
+namespace
+{
+    struct SphereSet
+    {
+        const SurfaceFile* curSphere, *newSphere;
+        const MetricFile* curAreas, *newAreas;
+        SphereSet() : curSphere(NULL), newSphere(NULL), curAreas(NULL), newAreas(NULL) { }
+        SphereSet(const SurfaceFile* curSphereIn, const SurfaceFile* newSphereIn, const MetricFile* curAreasIn, const MetricFile* newAreasIn) :
+            curSphere(curSphereIn), newSphere(newSphereIn), curAreas(curAreasIn), newAreas(newAreasIn) { }
+    };
+    
+    struct SparseResampleMatrix
+    {//compressed rows, output index i is the weighted sum of the input indices in m_weights[m_start[i]] up to m_weights[m_start[i + 1]]
+        vector<int64_t> m_start;
+        vector<pair<int64_t, float> > m_weights;
+        
+        void setRows(const vector<vector<pair<int64_t, float> > >& rows)
+        {
+            int64_t numRows = (int64_t)rows.size(), total = 0;
+            m_start.resize(numRows + 1);
+            for (int64_t i = 0; i < numRows; ++i)
+            {
+                m_start[i] = total;
+                total += (int64_t)rows[i].size();
+            }
+            m_start[numRows] = total;
+            m_weights.resize(total);
+            for (int64_t i = 0; i < numRows; ++i)
+            {
+                copy(rows[i].begin(), rows[i].end(), m_weights.begin() + m_start[i]);
+            }
+        }
+        
+        void apply(const float* input, float* output) const
+        {
+            int64_t numRows = (int64_t)m_start.size() - 1;
+            for (int64_t i = 0; i < numRows; ++i)
+            {
+                double accum = 0.0;
+                for (int64_t j = m_start[i]; j < m_start[i + 1]; ++j)
+                {
+                    accum += input[m_weights[j].first] * m_weights[j].second;
+                }
+                output[i] = accum;
+            }
+        }
+        
+        int64_t getBytes() const
+        {
+            return (int64_t)(m_start.capacity() * sizeof(int64_t) + m_weights.capacity() * sizeof(pair<int64_t, float>));
+        }
+    };
+    
+    //same weights as AlgorithmCiftiResample uses without dilation, expressed as a matrix from input brainordinates to output brainordinates
+    void buildResampleMatrix(const CiftiFile* myCiftiIn, const CiftiFile* myCiftiOut, const int& direction, const SurfaceResamplingMethodEnum::Enum& mySurfMethod,
+                             const VolumeFile::InterpType& myVolMethod, const FloatMatrix& affine, const VolumeFile* warpfield,
+                             const map<StructureEnum::Enum, SphereSet>& spheres, SparseResampleMatrix& matrixOut)
+    {
+        const CiftiBrainModelsMap& inModels = myCiftiIn->getCiftiXML().getBrainModelsMap(direction), &outModels = myCiftiOut->getCiftiXML().getBrainModelsMap(direction);
+        vector<vector<pair<int64_t, float> > > rows(outModels.getLength());
+        vector<StructureEnum::Enum> surfList = outModels.getSurfaceStructureList(), volList = outModels.getVolumeStructureList();
+        for (int i = 0; i < (int)surfList.size(); ++i)
+        {
+            vector<CiftiBrainModelsMap::SurfaceMap> inMap = inModels.getSurfaceMap(surfList[i]), outMap = outModels.getSurfaceMap(surfList[i]);
+            vector<int64_t> nodeToIndex(inModels.getSurfaceNumberOfNodes(surfList[i]), -1);
+            for (int64_t j = 0; j < (int64_t)inMap.size(); ++j)
+            {
+                nodeToIndex[inMap[j].m_surfaceNode] = inMap[j].m_ciftiIndex;
+            }
+            map<StructureEnum::Enum, SphereSet>::const_iterator iter = spheres.find(surfList[i]);
+            if (iter == spheres.end() || iter->second.curSphere == NULL)
+            {//copy, checkForErrors already made sure the number of vertices matches
+                for (int64_t j = 0; j < (int64_t)outMap.size(); ++j)
+                {
+                    int64_t inIndex = nodeToIndex[outMap[j].m_surfaceNode];
+                    if (inIndex >= 0) rows[outMap[j].m_ciftiIndex].push_back(make_pair(inIndex, 1.0f));
+                }
+                continue;
+            }
+            const SphereSet& mySpheres = iter->second;
+            const float* curAreasPtr = NULL, *newAreasPtr = NULL;
+            if (mySpheres.curAreas != NULL && mySpheres.newAreas != NULL)
+            {
+                curAreasPtr = mySpheres.curAreas->getValuePointerForColumn(0);
+                newAreasPtr = mySpheres.newAreas->getValuePointerForColumn(0);
+            }
+            vector<float> inRoi(mySpheres.curSphere->getNumberOfNodes(), 0.0f);
+            for (int64_t j = 0; j < (int64_t)inMap.size(); ++j)
+            {
+                inRoi[inMap[j].m_surfaceNode] = 1.0f;
+            }
+            SurfaceResamplingHelper myHelper(mySurfMethod, mySpheres.curSphere, mySpheres.newSphere, curAreasPtr, newAreasPtr, inRoi.data());
+            vector<pair<int, float> > nodeWeights;
+            for (int64_t j = 0; j < (int64_t)outMap.size(); ++j)
+            {
+                myHelper.getWeights(outMap[j].m_surfaceNode, nodeWeights);
+                vector<pair<int64_t, float> >& thisRow = rows[outMap[j].m_ciftiIndex];
+                for (int k = 0; k < (int)nodeWeights.size(); ++k)
+                {
+                    int64_t inIndex = nodeToIndex[nodeWeights[k].first];
+                    if (inIndex >= 0) thisRow.push_back(make_pair(inIndex, nodeWeights[k].second));
+                }
+            }
+        }
+        FloatMatrix targetToSource = affine;//same as AlgorithmVolumeAffineResample
+        targetToSource.resize(4, 4);
+        targetToSource[3][0] = 0.0f;
+        targetToSource[3][1] = 0.0f;
+        targetToSource[3][2] = 0.0f;
+        targetToSource[3][3] = 1.0f;
+        targetToSource = targetToSource.inverse();
+        Vector3D xvec, yvec, zvec, offset;
+        xvec[0] = targetToSource[0][0]; xvec[1] = targetToSource[1][0]; xvec[2] = targetToSource[2][0];
+        yvec[0] = targetToSource[0][1]; yvec[1] = targetToSource[1][1]; yvec[2] = targetToSource[2][1];
+        zvec[0] = targetToSource[0][2]; zvec[1] = targetToSource[1][2]; zvec[2] = targetToSource[2][2];
+        offset[0] = targetToSource[0][3]; offset[1] = targetToSource[1][3]; offset[2] = targetToSource[2][3];
+        for (int i = 0; i < (int)volList.size(); ++i)
+        {
+            vector<CiftiBrainModelsMap::VolumeMap> inMap = inModels.getVolumeStructureMap(volList[i]), outMap = outModels.getVolumeStructureMap(volList[i]);
+            int64_t inDims[3], inOffset[3], outDims[3], outOffset[3];
+            vector<vector<float> > inSform, outSform;
+            AlgorithmCiftiSeparate::getCroppedVolSpace(myCiftiIn, direction, volList[i], inDims, inSform, inOffset);
+            AlgorithmCiftiSeparate::getCroppedVolSpace(myCiftiOut, direction, volList[i], outDims, outSform, outOffset);
+            VolumeSpace inSpace(inDims, inSform), outSpace(outDims, outSform);
+            vector<int64_t> voxelToIndex(inDims[0] * inDims[1] * inDims[2], -1);
+            for (int64_t j = 0; j < (int64_t)inMap.size(); ++j)
+            {
+                voxelToIndex[inSpace.getIndex(inMap[j].m_ijk[0] - inOffset[0], inMap[j].m_ijk[1] - inOffset[1], inMap[j].m_ijk[2] - inOffset[2])] = inMap[j].m_ciftiIndex;
+            }
+            VolumeFile::InterpType thisMethod = myVolMethod;
+            if (inDims[0] == 1 || inDims[1] == 1 || inDims[2] == 1) thisMethod = VolumeFile::ENCLOSING_VOXEL;//VolumeFile::interpolateValue does this for single slices
+            int64_t outMapSize = (int64_t)outMap.size();
+#pragma omp CARET_PARFOR schedule(dynamic)
+            for (int64_t j = 0; j < outMapSize; ++j)
+            {
+                Vector3D outCoord, inCoord;
+                outSpace.indexToSpace(outMap[j].m_ijk[0] - outOffset[0], outMap[j].m_ijk[1] - outOffset[1], outMap[j].m_ijk[2] - outOffset[2], outCoord);
+                if (warpfield != NULL)
+                {
+                    Vector3D displacement;
+                    bool validDisplacement = false;
+                    displacement[0] = warpfield->interpolateValue(outCoord, VolumeFile::TRILINEAR, &validDisplacement, 0);
+                    if (!validDisplacement) continue;//invalid interpolation gives 0, which is an empty row
+                    displacement[1] = warpfield->interpolateValue(outCoord, VolumeFile::TRILINEAR, NULL, 1);
+                    displacement[2] = warpfield->interpolateValue(outCoord, VolumeFile::TRILINEAR, NULL, 2);
+                    inCoord = outCoord + displacement;
+                } else {
+                    inCoord = xvec * outCoord[0] + yvec * outCoord[1] + zvec * outCoord[2] + offset;
+                }
+                vector<pair<int64_t, float> >& thisRow = rows[outMap[j].m_ciftiIndex];//each output index is a different row, so no locking needed
+                if (thisMethod == VolumeFile::ENCLOSING_VOXEL)
+                {
+                    int64_t inIJK[3];
+                    inSpace.enclosingVoxel(inCoord, inIJK);
+                    if (!inSpace.indexValid(inIJK)) continue;
+                    int64_t inIndex = voxelToIndex[inSpace.getIndex(inIJK[0], inIJK[1], inIJK[2])];
+                    if (inIndex >= 0) thisRow.push_back(make_pair(inIndex, 1.0f));
+                } else {
+                    CaretAssert(thisMethod == VolumeFile::TRILINEAR);
+                    float inIndexFloat[3];
+                    inSpace.spaceToIndex(inCoord, inIndexFloat);
+                    int64_t low[3] = { (int64_t)floor(inIndexFloat[0]), (int64_t)floor(inIndexFloat[1]), (int64_t)floor(inIndexFloat[2]) };
+                    if (!inSpace.indexValid(low[0], low[1], low[2]) || !inSpace.indexValid(low[0] + 1, low[1] + 1, low[2] + 1)) continue;
+                    float highWeight[3] = { inIndexFloat[0] - low[0], inIndexFloat[1] - low[1], inIndexFloat[2] - low[2] };
+                    for (int corner = 0; corner < 8; ++corner)
+                    {
+                        float weight = 1.0f;
+                        int64_t cornerIJK[3];
+                        for (int axis = 0; axis < 3; ++axis)
+                        {
+                            bool high = ((corner >> axis) & 1) != 0;
+                            cornerIJK[axis] = low[axis] + (high ? 1 : 0);
+                            weight *= (high ? highWeight[axis] : 1.0f - highWeight[axis]);
+                        }
+                        if (weight == 0.0f) continue;
+                        int64_t inIndex = voxelToIndex[inSpace.getIndex(cornerIJK[0], cornerIJK[1], cornerIJK[2])];
+                        if (inIndex >= 0) thisRow.push_back(make_pair(inIndex, weight));
+                    }
+                }
+            }
+        }
+        matrixOut.setRows(rows);
+    }
+    
+    //output = colMatrix * input * rowMatrix^T, computed in blocks of output rows so that only the input rows a block uses are in memory
+    void resampleDconnStreaming(const CiftiFile* myCiftiIn, const CiftiFile* myTemplate, const int& templateDir, CiftiFile* myCiftiOut,
+                                const SurfaceResamplingMethodEnum::Enum& mySurfMethod, const VolumeFile::InterpType& myVolMethod,
+                                const FloatMatrix& affine, const VolumeFile* warpfield, const map<StructureEnum::Enum, SphereSet>& spheres, const float& memLimitGB)
+    {
+        const CiftiXML& myInputXML = myCiftiIn->getCiftiXML();
+        CiftiXML myOutXML = myInputXML;
+        myOutXML.setMap(CiftiXML::ALONG_COLUMN, *(myTemplate->getCiftiXML().getMap(templateDir)));
+        myOutXML.setMap(CiftiXML::ALONG_ROW, *(myTemplate->getCiftiXML().getMap(templateDir)));
+        myCiftiOut->setCiftiXML(myOutXML);
+        SparseResampleMatrix colMatrix, rowMatrix;
+        buildResampleMatrix(myCiftiIn, myCiftiOut, CiftiXML::ALONG_COLUMN, mySurfMethod, myVolMethod, affine, warpfield, spheres, colMatrix);
+        const SparseResampleMatrix* rowMatrixPtr = &colMatrix;
+        if (!(*(myInputXML.getMap(CiftiXML::ALONG_ROW)) == *(myInputXML.getMap(CiftiXML::ALONG_COLUMN))))
+        {//symmetric dconns use the same weights for both dimensions
+            buildResampleMatrix(myCiftiIn, myCiftiOut, CiftiXML::ALONG_ROW, mySurfMethod, myVolMethod, affine, warpfield, spheres, rowMatrix);
+            rowMatrixPtr = &rowMatrix;
+        }
+        int64_t inRows = myInputXML.getDimensionLength(CiftiXML::ALONG_COLUMN), inRowLength = myInputXML.getDimensionLength(CiftiXML::ALONG_ROW);
+        int64_t outRows = myOutXML.getDimensionLength(CiftiXML::ALONG_COLUMN), outRowLength = myOutXML.getDimensionLength(CiftiXML::ALONG_ROW);
+        int64_t numThreads = 1;
+#ifdef CARET_OMP
+        numThreads = omp_get_max_threads();
+#endif
+        //the weights, the per-thread combined rows, and inputSlot stay allocated the whole time, blocks get what is left
+        int64_t fixedBytes = colMatrix.getBytes() + numThreads * inRowLength * (int64_t)sizeof(float) + inRows * (int64_t)sizeof(int64_t);
+        if (rowMatrixPtr == &rowMatrix) fixedBytes += rowMatrix.getBytes();
+        int64_t limitBytes = (int64_t)(memLimitGB * 1024 * 1024 * 1024) - fixedBytes;
+        if (limitBytes < 0)
+        {
+            CaretLogWarning("resampling weights and per-thread buffers alone need " + AString::number(fixedBytes / (1024.0 * 1024.0 * 1024.0)) +
+                            " GB, exceeding -mem-limit, using blocks of one row");
+            limitBytes = 0;
+        }
+        const int64_t inputRowBytes = inRowLength * (int64_t)sizeof(float) + 2 * (int64_t)sizeof(int64_t);//the row, plus its blockInputs and readOrder entries
+        const int64_t outputRowBytes = outRowLength * (int64_t)sizeof(float);
+        vector<int64_t> inputSlot(inRows, -1), blockInputs, readOrder;//inputSlot is where an input row is stored in the current block
+        vector<float> inputData, outputData;
+        for (int64_t blockStart = 0; blockStart < outRows;)
+        {
+            int64_t blockEnd = blockStart;
+            while (blockEnd < outRows)
+            {
+                size_t oldSize = blockInputs.size();
+                for (int64_t j = colMatrix.m_start[blockEnd]; j < colMatrix.m_start[blockEnd + 1]; ++j)
+                {
+                    int64_t inRow = colMatrix.m_weights[j].first;
+                    if (inputSlot[inRow] < 0)
+                    {
+                        inputSlot[inRow] = (int64_t)blockInputs.size();
+                        blockInputs.push_back(inRow);
+                    }
+                }
+                if (blockEnd > blockStart && (int64_t)blockInputs.size() * inputRowBytes + (blockEnd + 1 - blockStart) * outputRowBytes > limitBytes)
+                {//doesn't fit, leave this row for the next block - a block always gets at least one row, no matter the limit
+                    for (size_t k = oldSize; k < blockInputs.size(); ++k)
+                    {
+                        inputSlot[blockInputs[k]] = -1;
+                    }
+                    blockInputs.resize(oldSize);
+                    break;
+                }
+                ++blockEnd;
+            }
+            inputData.resize(blockInputs.size() * inRowLength);
+            readOrder = blockInputs;
+            sort(readOrder.begin(), readOrder.end());//read sequentially from the file
+            for (size_t k = 0; k < readOrder.size(); ++k)
+            {
+                myCiftiIn->getRow(inputData.data() + inputSlot[readOrder[k]] * inRowLength, readOrder[k]);
+            }
+            int64_t blockRows = blockEnd - blockStart;
+            outputData.resize(blockRows * outRowLength);
+#pragma omp CARET_PAR
+            {
+                vector<float> combined(inRowLength);
+#pragma omp CARET_FOR schedule(dynamic)
+                for (int64_t i = 0; i < blockRows; ++i)
+                {
+                    float* outRow = outputData.data() + i * outRowLength;
+                    int64_t start = colMatrix.m_start[blockStart + i], end = colMatrix.m_start[blockStart + i + 1];
+                    if (start == end)
+                    {
+                        fill(outRow, outRow + outRowLength, 0.0f);
+                        continue;
+                    }
+                    for (int64_t j = start; j < end; ++j)
+                    {
+                        const float* inRow = inputData.data() + inputSlot[colMatrix.m_weights[j].first] * inRowLength;
+                        const float weight = colMatrix.m_weights[j].second;
+                        if (j == start)
+                        {
+                            for (int64_t k = 0; k < inRowLength; ++k) combined[k] = weight * inRow[k];
+                        } else {
+                            for (int64_t k = 0; k < inRowLength; ++k) combined[k] += weight * inRow[k];
+                        }
+                    }
+                    rowMatrixPtr->apply(combined.data(), outRow);
+                }
+            }
+            for (int64_t i = 0; i < blockRows; ++i)
+            {
+                myCiftiOut->setRow(outputData.data() + i * outRowLength, blockStart + i);
+            }
+            for (size_t k = 0; k < blockInputs.size(); ++k)
+            {
+                inputSlot[blockInputs[k]] = -1;
+            }
+            blockInputs.clear();
+            blockStart = blockEnd;
+        }
+    }
+}
+
 AString OperationCiftiResampleDconnMemory::getCommandSwitch()
 {
     return "-cifti-resample-dconn-memory";
@@ -114,10 +426,18 @@ OperationParameters* OperationCiftiResampleDconnMemory::getParameters()
     cerebAreaMetricsOpt->addMetricParameter(1, "current-area", "a metric file with vertex areas for the current mesh");
     cerebAreaMetricsOpt->addMetricParameter(2, "new-area", "a metric file with vertex areas for the new mesh");
     
+    OptionalParameter* memLimitOpt = ret->createOptionalParameter(16, "-mem-limit", "compute linear resampling in blocks that fit within a memory limit");
+    memLimitOpt->addDoubleParameter(1, "limit-GB", "memory limit in gigabytes");
+    
     AString myHelpText =
-        AString("This command does the same thing as running -cifti-resample twice, but uses memory up to approximately 2x the size that the intermediate file would be.  ") +
+        AString("This command does the same thing as running -cifti-resample twice.  ") +
+        "It uses memory up to approximately 2x the size that the intermediate file would be.  " +
         "This is because the intermediate dconn is kept in memory, rather than written to disk, " +
         "and the components before and after resampling/dilation have to be in memory at the same time during the relevant computation.  " +
+        "When -mem-limit is specified and the resampling is linear (no dilation, no -surface-largest, not label data, and a <volume-method> of TRILINEAR or ENCLOSING_VOXEL), " +
+        "the resampling weights for each dimension are instead computed once, and the output is computed in blocks of rows that fit within the limit, " +
+        "reading only the input rows each block needs, so neither the whole input nor the intermediate matrix is ever in memory.  " +
+        "The limit includes the resampling weights and a scratch row per thread, but not the memory used by the input and output files themselves.  " +
         "The <template-direction> argument should usually be COLUMN, as dtseries, dscalar, and dlabel all have brainordinates on that direction.  " +
         "If spheres are not specified for a surface structure which exists in the cifti files, its data is copied without resampling or dilation.  " +
         "Dilation is done with the 'nearest' method, and is done on <new-sphere> for surface data.  " +
@@ -396,6 +716,31 @@ void OperationCiftiResampleDconnMemory::useParameters(OperationParameters* myPar
     {
         throw OperationException(message);
     }
+    float memLimitGB = -1.0f;
+    OptionalParameter* memLimitOpt = myParams->getOptionalParameter(16);
+    if (memLimitOpt->m_present)
+    {
+        memLimitGB = (float)memLimitOpt->getDouble(1);
+        if (memLimitGB < 0.0f)
+        {
+            throw OperationException("memory limit cannot be negative");
+        }
+    }
+    if (memLimitOpt->m_present && !isLabelData && !surfLargest && voldilatemm <= 0.0f && surfdilatemm <= 0.0f && myVolMethod != VolumeFile::CUBIC)
+    {//cubic is linear too, but the spline prefilter makes every output voxel depend on the whole volume component
+        map<StructureEnum::Enum, SphereSet> spheres;
+        spheres[StructureEnum::CORTEX_LEFT] = SphereSet(curLeftSphere, newLeftSphere, curLeftAreas, newLeftAreas);
+        spheres[StructureEnum::CORTEX_RIGHT] = SphereSet(curRightSphere, newRightSphere, curRightAreas, newRightAreas);
+        spheres[StructureEnum::CEREBELLUM] = SphereSet(curCerebSphere, newCerebSphere, curCerebAreas, newCerebAreas);
+        const VolumeFile* warpfield = NULL;
+        if (warpfieldOpt->m_present) warpfield = myWarpfield.getWarpfield();
+        resampleDconnStreaming(myCiftiIn, myTemplate, templateDir, myCiftiOut, mySurfMethod, myVolMethod, myAffine.getMatrix(), warpfield, spheres, memLimitGB);
+        return;
+    }
+    if (memLimitOpt->m_present)
+    {
+        CaretLogWarning("-mem-limit only applies to linear resampling, ignoring it");
+    }
     CiftiFile tempCifti;
     //TSC: resampling along column first causes it to hit peak memory usage earlier
     if (warpfieldOpt->m_present)
@@ -0,0 +1,126 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "OperationLabelProbabilityList.h"
+#include "OperationException.h"
+
+#include "LabelFile.h"
+#include "LabelProbabilityAccumulator.h"
+#include "MetricFile.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+AString OperationLabelProbabilityList::getCommandSwitch()
+{
+    return "-label-probability-list";
+}
+
+AString OperationLabelProbabilityList::getShortDescription()
+{
+    return "FIND FREQUENCY OF SURFACE LABELS OVER MANY FILES";
+}
+
+OperationParameters* OperationLabelProbabilityList::getParameters()
+{
+    OperationParameters* ret = new OperationParameters();
+    
+    ret->addStringParameter(1, "label-list", "text file containing label filenames, one per line");
+    
+    ret->addMetricOutputParameter(2, "probability-metric-out", "the relative frequencies of each label at each vertex");
+    
+    ret->createOptionalParameter(3, "-exclude-unlabeled", "don't make a probability map of the unlabeled key");
+    
+    ret->setHelpText(
+        AString("Like -label-probability, but reads the label files named in a text file one at a time, so that the maps of many subjects ") +
+        "do not need to be merged into one file or held in memory together.  " +
+        "All maps in all files are used, and labels are matched by name, so the files do not need to use the same keys.  " +
+        "The output has one map for each label name, in order of first appearance, " +
+        "where the value is how many of the input maps had that label at that vertex, divided by the total number of input maps."
+    );
+    return ret;
+}
+
+void OperationLabelProbabilityList::useParameters(OperationParameters* myParams, ProgressObject* myProgObj)
+{
+    LevelProgress myProgress(myProgObj);
+    AString listFileName = myParams->getString(1);
+    MetricFile* outputMetric = myParams->getOutputMetric(2);
+    bool excludeUnlabeled = myParams->getOptionalParameter(3)->m_present;
+    ifstream listFile(listFileName.toLocal8Bit().constData());
+    if (!listFile.good())
+    {
+        throw OperationException("error reading label list file '" + listFileName + "'");
+    }
+    CaretPointer<LabelProbabilityAccumulator> myAccum;
+    int numNodes = -1;
+    StructureEnum::Enum myStructure = StructureEnum::INVALID;
+    string line;
+    while (getline(listFile, line))
+    {
+        AString labelFileName = AString(line.c_str()).trimmed();
+        if (labelFileName.isEmpty()) continue;
+        LabelFile thisLabel;//only one file in memory at a time
+        thisLabel.readFile(labelFileName);
+        if (myAccum == NULL)
+        {
+            numNodes = thisLabel.getNumberOfNodes();
+            myStructure = thisLabel.getStructure();
+            myAccum.grabNew(new LabelProbabilityAccumulator(numNodes, excludeUnlabeled));
+        } else {
+            if (thisLabel.getNumberOfNodes() != numNodes)
+            {
+                throw OperationException("label file '" + labelFileName + "' has a different number of vertices than the first file");
+            }
+            if (thisLabel.getStructure() != myStructure)
+            {
+                myStructure = StructureEnum::INVALID;//don't claim a structure the inputs disagree on
+            }
+        }
+        int tableHandle = myAccum->addLabelTable(thisLabel.getLabelTable());
+        int numMaps = thisLabel.getNumberOfMaps();
+        for (int m = 0; m < numMaps; ++m)
+        {
+            myAccum->addMap(tableHandle, thisLabel.getLabelKeyPointerForColumn(m));
+        }
+    }
+    if (myAccum == NULL || myAccum->getNumberOfMaps() == 0)
+    {
+        throw OperationException("label list file '" + listFileName + "' doesn't name any label files with maps");
+    }
+    int numOutMaps = myAccum->getNumberOfLabels();
+    if (numOutMaps == 0)
+    {
+        throw OperationException("input label files contain no labels to compute probabilities of");
+    }
+    vector<float> scratch(numNodes);
+    outputMetric->setNumberOfNodesAndColumns(numNodes, numOutMaps);
+    outputMetric->setStructure(myStructure);
+    for (int m = 0; m < numOutMaps; ++m)
+    {
+        outputMetric->setMapName(m, myAccum->getLabelName(m));
+        myAccum->getProbabilities(m, scratch.data());
+        outputMetric->setValuesForColumn(m, scratch.data());
+    }
+}
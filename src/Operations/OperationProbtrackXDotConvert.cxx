@@ -20,13 +20,25 @@
 
 #include "OperationProbtrackXDotConvert.h"
 #include "OperationException.h"
+#include "CaretBinaryFile.h"
+#include "CaretHeap.h"
 #include "CaretLogger.h"
+#include "CaretOMP.h"
+#include "CaretSparseFile.h"
 #include "CiftiFile.h"
+#include "DataFileException.h"
 #include "MetricFile.h"
 #include "StructureEnum.h"
 #include "VolumeFile.h"
 
+#include <QByteArray>
+#include <QDir>
+#include <QTemporaryFile>
+
 #include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
 #include <fstream>
 #include <map>
 #include <vector>
@@ -34,16 +46,157 @@
 using namespace caret;
 using namespace std;
 
-//specifically for the purpose of sorting the input .dot file to the order required, in case it isn't initially ordered correctly
-struct SparseValue
+namespace
 {
-    int32_t index[2];//save some memory
-    float value;
-    bool operator<(const SparseValue& rhs) const
+    //specifically for the purpose of sorting the input .dot file to the order required, in case it isn't initially ordered correctly
+    //indexes are output indexes (after any voxel reordering), [0] is the position within the row, [1] is the row
+    struct SparseValue
+    {
+        int32_t index[2];//save some memory
+        float value;
+        bool operator<(const SparseValue& rhs) const
+        {
+            return (index[1] < rhs.index[1]);//NOTE: this specifically avoids minor ordering by the other index to make the sort faster (less swapping because more "equals" cases)
+        }
+    };
+
+    bool lessWithinRow(const SparseValue& left, const SparseValue& right)
+    {
+        return left.index[0] < right.index[0];
+    }
+
+    const int64_t CHUNK_BYTES = 16 * 1024 * 1024;//text is read in batches of one chunk per thread
+    const int64_t MIN_CHUNK_BYTES = 64 * 1024;
+    const int64_t MAX_MERGE_BUFFER = 1024 * 1024;//values per sorted run to read back from disk at a time
+
+    struct DotParseSettings
+    {
+        int32_t rowSize, colSize;
+        bool transpose, halfMatrix;
+        const vector<int64_t>* rowReorder;//NULL if not reordering
+        const vector<int64_t>* colReorder;
+    };
+
+    //a piece of the text that ends on a line boundary, and what parsing it found
+    struct DotChunk
+    {
+        const char* m_begin;
+        const char* m_end;
+        vector<SparseValue> m_values;
+        int64_t m_numZeros;
+        bool m_hasData, m_afterZero;//m_afterZero only considers zero lines inside this chunk
+        bool m_stopped;//found something that isn't a number where one was expected, like reading with operator>>, the rest of the file is ignored
+        AString m_error;//only the first error, so that errors get reported in file order
+    };
+
+    //QByteArray conversions always use the C locale, unlike strtof after QCoreApplication calls setlocale
+    bool nextToken(const char*& pos, const char* end, QByteArray& tokenOut)
+    {
+        while (pos < end && isspace((unsigned char)*pos)) ++pos;
+        const char* start = pos;
+        while (pos < end && !isspace((unsigned char)*pos)) ++pos;
+        if (pos == start) return false;
+        tokenOut = QByteArray::fromRawData(start, pos - start);
+        return true;
+    }
+
+    void parseDotChunk(DotChunk& chunk, const DotParseSettings& settings)
     {
-        return (index[1] < rhs.index[1]);//NOTE: this specifically avoids minor ordering by the other index to make the sort faster (less swapping because more "equals" cases)
+        chunk.m_values.clear();
+        chunk.m_numZeros = 0;
+        chunk.m_hasData = false;
+        chunk.m_afterZero = false;
+        chunk.m_stopped = false;
+        chunk.m_error = "";
+        const char* pos = chunk.m_begin;
+        QByteArray tokens[3];
+        while (nextToken(pos, chunk.m_end, tokens[0]))
+        {
+            bool ok[3] = { false, false, false };
+            if (nextToken(pos, chunk.m_end, tokens[1]) && nextToken(pos, chunk.m_end, tokens[2]))
+            {
+                SparseValue tempValue;
+                if (settings.transpose)
+                {
+                    tempValue.index[1] = tokens[0].toInt(ok);
+                    tempValue.index[0] = tokens[1].toInt(ok + 1);
+                } else {
+                    tempValue.index[0] = tokens[0].toInt(ok);
+                    tempValue.index[1] = tokens[1].toInt(ok + 1);
+                }
+                tempValue.value = tokens[2].toFloat(ok + 2);
+                if (ok[0] && ok[1] && ok[2])
+                {
+                    if (tempValue.value == 0.0f)
+                    {
+                        if (tempValue.index[0] != settings.rowSize || tempValue.index[1] != settings.colSize)
+                        {
+                            chunk.m_error = "dimensions line in .dot file doesn't agree with provided row/column spaces";
+                            return;
+                        }
+                        ++chunk.m_numZeros;//ignore, we expect one line (last in file) to have this
+                    } else {
+                        if (tempValue.index[0] < 1 || tempValue.index[0] > settings.rowSize ||
+                            tempValue.index[1] < 1 || tempValue.index[1] > settings.colSize)
+                        {
+                            chunk.m_error = "found invalid index pair in dot file: " + AString::number(tempValue.index[0]) + ", " + AString::number(tempValue.index[1]) +
+                                (settings.transpose ? ", perhaps you need to remove -transpose" : ", perhaps you need to use -transpose");
+                            return;
+                        }
+                        if (chunk.m_numZeros != 0) chunk.m_afterZero = true;
+                        chunk.m_hasData = true;
+                        tempValue.index[0] -= 1;//fix for 1-indexing
+                        tempValue.index[1] -= 1;
+                        int64_t numOut = 1;
+                        SparseValue outValues[2] = { tempValue, tempValue };
+                        if (settings.halfMatrix && tempValue.index[0] != tempValue.index[1])
+                        {//mirror in input index space, before reordering
+                            outValues[1].index[0] = tempValue.index[1];
+                            outValues[1].index[1] = tempValue.index[0];
+                            numOut = 2;
+                        }
+                        for (int64_t i = 0; i < numOut; ++i)
+                        {
+                            if (settings.rowReorder != NULL) outValues[i].index[0] = (*settings.rowReorder)[outValues[i].index[0]];
+                            if (settings.colReorder != NULL) outValues[i].index[1] = (*settings.colReorder)[outValues[i].index[1]];
+                            chunk.m_values.push_back(outValues[i]);
+                        }
+                    }
+                    continue;
+                }
+            }
+            chunk.m_stopped = true;
+            return;
+        }
     }
-};
+
+    //a sorted piece of the input, either entirely in memory, or spilled to the temporary file and read back a block at a time
+    struct SortedRun
+    {
+        vector<SparseValue> m_buffer;
+        int64_t m_bufferPos;
+        int64_t m_filePos, m_fileEnd;//in values
+        SortedRun() { m_bufferPos = 0; m_filePos = 0; m_fileEnd = 0; }
+        bool atEnd() const { return m_bufferPos == (int64_t)m_buffer.size() && m_filePos == m_fileEnd; }
+        const SparseValue& current() const { return m_buffer[m_bufferPos]; }
+        void advance(QFile& spillFile, const int64_t& blockValues)
+        {
+            ++m_bufferPos;
+            if (m_bufferPos == (int64_t)m_buffer.size() && m_filePos < m_fileEnd)
+            {
+                int64_t toRead = min(blockValues, m_fileEnd - m_filePos);
+                m_buffer.resize(toRead);
+                if (!spillFile.seek(m_filePos * sizeof(SparseValue)) ||
+                    spillFile.read((char*)m_buffer.data(), toRead * sizeof(SparseValue)) != (qint64)(toRead * sizeof(SparseValue)))
+                {
+                    throw OperationException("failed to read sorting data back from temporary file '" + spillFile.fileName() + "'");
+                }
+                m_filePos += toRead;
+                m_bufferPos = 0;
+            }
+        }
+    };
+}
 
 AString OperationProbtrackXDotConvert::getCommandSwitch()
 {
@@ -87,8 +240,17 @@ OperationParameters* OperationProbtrackXDotConvert::getParameters()
     
     ret->createOptionalParameter(8, "-make-symmetric", "transform half-square input into full matrix output");
     
+    OptionalParameter* memLimitOpt = ret->createOptionalParameter(11, "-mem-limit", "restrict memory usage");
+    memLimitOpt->addDoubleParameter(1, "limit-GB", "memory limit in gigabytes");
+    
+    OptionalParameter* sparseOpt = ret->createOptionalParameter(12, "-wbsparse-out", "also write the matrix as a sparse file");
+    sparseOpt->addStringParameter(1, "sparse-out", "output filename, should end in .wbsparse");
+    
     AString myText = AString("NOTE: exactly one -row option and one -col option must be used.\n\n") +
         "If the input file does not have its indexes sorted in the correct ordering, this command may take longer than expected.  " +
+        "The text is parsed in parallel, and the entire matrix is held in memory while sorting unless -mem-limit is specified, " +
+        "in which case sorted pieces are written to a temporary file and merged while writing the output.  " +
+        "The sparse file written by -wbsparse-out stores values rounded to integers, as fdt_matrix values are streamline counts.  " +
         "Specifying -transpose will transpose the input matrix before trying to put its values into the cifti file, which is currently needed for at least matrix2 " +
         "in order to display it as intended.  " +
         "How the cifti file is displayed is based on which -row option is specified: if -row-voxels is specified, then it will display data on volume slices.  " +
@@ -116,6 +278,17 @@ void OperationProbtrackXDotConvert::useParameters(OperationParameters* myParams,
     OptionalParameter* colCiftiOpt = myParams->getOptionalParameter(10);
     bool transpose = myParams->getOptionalParameter(7)->m_present;
     bool halfMatrix = myParams->getOptionalParameter(8)->m_present;
+    float memLimitGB = -1.0f;
+    OptionalParameter* memLimitOpt = myParams->getOptionalParameter(11);
+    if (memLimitOpt->m_present)
+    {
+        memLimitGB = (float)memLimitOpt->getDouble(1);
+        if (memLimitGB < 0.0f)
+        {
+            throw OperationException("memory limit cannot be negative");
+        }
+    }
+    OptionalParameter* sparseOpt = myParams->getOptionalParameter(12);
     int numRowOpts = 0, numColOpts = 0;
     if (rowVoxelOpt->m_present) ++numRowOpts;
     if (rowSurfaceOpt->m_present) ++numRowOpts;
@@ -181,13 +354,13 @@ void OperationProbtrackXDotConvert::useParameters(OperationParameters* myParams,
         }
         myXML.copyMapping(CiftiXMLOld::ALONG_COLUMN, colCiftiOpt->getCifti(1)->getCiftiXMLOld(), myDir);
     }
-    fstream dotFile(dotFileName.toLatin1().constData(), fstream::in);
-    if (!dotFile.good())
+    CaretBinaryFile dotFile;
+    try
     {
+        dotFile.open(dotFileName);
+    } catch (DataFileException&) {
         throw OperationException("error opening text file '" + dotFileName + "'");
     }
-    SparseValue tempValue;
-    vector<SparseValue> dotFileContents;
     int32_t rowSize = myXML.getNumberOfColumns(), colSize = myXML.getNumberOfRows();
     if (halfMatrix && rowSize != colSize)
     {
@@ -197,70 +370,150 @@ void OperationProbtrackXDotConvert::useParameters(OperationParameters* myParams,
     {
         CaretLogInfo("-transpose is not needed with -make-symmetric");
     }
+    DotParseSettings mySettings;
+    mySettings.rowSize = rowSize;
+    mySettings.colSize = colSize;
+    mySettings.transpose = transpose;
+    mySettings.halfMatrix = halfMatrix;
+    mySettings.rowReorder = (rowVoxelOpt->m_present ? &rowReorderMap : NULL);
+    mySettings.colReorder = (colVoxelOpt->m_present ? &colReorderMap : NULL);
+    vector<int64_t> rowInverse, colInverse;//to report indexes as given in the dot file, and check the file's own order
+    if (rowVoxelOpt->m_present)
+    {
+        rowInverse.resize(rowReorderMap.size());
+        for (int64_t i = 0; i < (int64_t)rowReorderMap.size(); ++i) rowInverse[rowReorderMap[i]] = i;
+    }
+    if (colVoxelOpt->m_present)
+    {
+        colInverse.resize(colReorderMap.size());
+        for (int64_t i = 0; i < (int64_t)colReorderMap.size(); ++i) colInverse[colReorderMap[i]] = i;
+    }
+    int numChunks = 1;
+#ifdef CARET_OMP
+    numChunks = omp_get_max_threads();
+#endif
+    int64_t chunkBytes = CHUNK_BYTES;
+    int64_t bufferLimit = -1;//number of values to collect before sorting them and writing them to disk, -1 for no limit
+    if (memLimitGB >= 0.0f)
+    {
+        int64_t targetBytes = (int64_t)(memLimitGB * 1024 * 1024 * 1024);
+        //text plus parsed chunks can take several times the text size, so keep the text batch to a small fraction of the limit
+        chunkBytes = max(MIN_CHUNK_BYTES, min(chunkBytes, targetBytes / 16 / numChunks));
+        targetBytes -= chunkBytes * numChunks * 5;
+        bufferLimit = max(MAX_MERGE_BUFFER, targetBytes / (int64_t)sizeof(SparseValue));
+    }
     int64_t numZeros = 0;
-    bool afterZero = false;
-    if (transpose)
+    bool afterZero = false, sorted = true, bufferSorted = true;
+    int32_t lastRow = -1, lastBufferRow = -1;
+    vector<SparseValue> dotFileContents;
+    vector<SortedRun> sortedRuns;
+    AString tempPath = QDir::tempPath();
+    if (!tempPath.endsWith('/')) tempPath += '/';
+    QTemporaryFile spillFile(tempPath + "wb_dot_sort.XXXXXX");
+    int64_t spillValues = 0;
+    vector<DotChunk> myChunks(numChunks);
+    vector<char> textBuffer(chunkBytes * numChunks);
+    int64_t carried = 0;//bytes of an incomplete line left over from the previous batch
+    bool done = false;
+    while (!done)
     {
-        while (dotFile >> tempValue.index[1] >> tempValue.index[0] >> tempValue.value)//this is the only line that is different for transpose
+        int64_t numRead = 0;
+        dotFile.read(textBuffer.data() + carried, textBuffer.size() - carried, &numRead);
+        int64_t dataEnd = carried + numRead;
+        done = (dataEnd < (int64_t)textBuffer.size());
+        int64_t parseEnd = dataEnd;
+        if (!done)
         {
-            if (tempValue.value == 0.0f)
+            while (parseEnd > 0 && textBuffer[parseEnd - 1] != '\n') --parseEnd;
+            if (parseEnd == 0)
+            {//a single line longer than the whole batch, get more room and try again
+                carried = dataEnd;
+                textBuffer.resize(textBuffer.size() * 2);
+                continue;
+            }
+        }
+        const char* batchStart = textBuffer.data();
+        const char* batchEnd = batchStart + parseEnd;
+        const char* chunkStart = batchStart;
+        for (int i = 0; i < numChunks; ++i)
+        {//split on line boundaries, last chunk takes the remainder
+            const char* chunkEnd = batchEnd;
+            if (i < numChunks - 1)
             {
-                if (tempValue.index[0] != rowSize || tempValue.index[1] != colSize)
-                {
-                    throw OperationException("dimensions line in .dot file doesn't agree with provided row/column spaces");
-                }
-                ++numZeros;//ignore, we expect one line (last in file) to have this
-            } else {
-                if (tempValue.index[0] < 1 || tempValue.index[0] > rowSize ||
-                    tempValue.index[1] < 1 || tempValue.index[1] > colSize)
-                {
-                    throw OperationException("found invalid index pair in dot file: " + AString::number(tempValue.index[0]) + ", " + AString::number(tempValue.index[1]) +
-                        ", perhaps you need to remove -transpose");
-                }
-                if (numZeros != 0) afterZero = true;
-                tempValue.index[0] -= 1;//fix for 1-indexing
-                tempValue.index[1] -= 1;
-                dotFileContents.push_back(tempValue);
-                if (halfMatrix && tempValue.index[0] != tempValue.index[1])
-                {
-                    int32_t tempIndex = tempValue.index[0];
-                    tempValue.index[0] = tempValue.index[1];
-                    tempValue.index[1] = tempIndex;
-                    dotFileContents.push_back(tempValue);
-                }
+                chunkEnd = min(batchEnd, max(chunkStart, batchStart + parseEnd * (i + 1) / numChunks));
+                while (chunkEnd > batchStart && chunkEnd < batchEnd && chunkEnd[-1] != '\n') ++chunkEnd;
             }
+            myChunks[i].m_begin = chunkStart;
+            myChunks[i].m_end = chunkEnd;
+            chunkStart = chunkEnd;
         }
-    } else {
-        while (dotFile >> tempValue.index[0] >> tempValue.index[1] >> tempValue.value)
+#pragma omp CARET_PARFOR schedule(dynamic)
+        for (int i = 0; i < numChunks; ++i)
         {
-            if (tempValue.value == 0.0f)
+            parseDotChunk(myChunks[i], mySettings);
+        }
+        for (int i = 0; i < numChunks; ++i)
+        {//combine in file order, so warnings and errors are the same as reading it serially
+            const DotChunk& thisChunk = myChunks[i];
+            if (!thisChunk.m_error.isEmpty()) throw OperationException(thisChunk.m_error);
+            if (thisChunk.m_stopped)
             {
-                if (tempValue.index[0] != rowSize || tempValue.index[1] != colSize)
+                CaretLogWarning("stopped reading dot file at text that isn't two integers and a number, ignoring the rest of the file");
+                done = true;
+            }
+            if (thisChunk.m_afterZero || (thisChunk.m_hasData && numZeros != 0)) afterZero = true;
+            numZeros += thisChunk.m_numZeros;
+            int64_t numValues = (int64_t)thisChunk.m_values.size();
+            for (int64_t j = 0; j < numValues; ++j)
+            {
+                const SparseValue& thisValue = thisChunk.m_values[j];
+                int32_t inputRow = thisValue.index[1];//-col-voxels reordering alone means sorting, but the file isn't out of order
+                if (colVoxelOpt->m_present) inputRow = (int32_t)colInverse[inputRow];
+                if (inputRow < lastRow)
                 {
-                    throw OperationException("dimensions line in .dot file doesn't agree with provided row/column spaces");
+                    if (sorted && !halfMatrix)
+                    {
+                        CaretLogInfo("dot file indexes are not correctly sorted, sorting them may take a minute or so...");
+                    }
+                    sorted = false;
                 }
-                ++numZeros;
-            } else {
-                if (tempValue.index[0] < 1 || tempValue.index[0] > rowSize ||
-                    tempValue.index[1] < 1 || tempValue.index[1] > colSize)
+                if (thisValue.index[1] < lastBufferRow) bufferSorted = false;
+                lastRow = inputRow;
+                lastBufferRow = thisValue.index[1];
+                dotFileContents.push_back(thisValue);
+            }
+            if (bufferLimit > 0 && (int64_t)dotFileContents.size() >= bufferLimit)
+            {//sort what we have, and write it to the temporary file as one run
+                if (spillValues == 0)
                 {
-                    throw OperationException("found invalid index pair in dot file: " + AString::number(tempValue.index[0]) + ", " + AString::number(tempValue.index[1]) +
-                        ", perhaps you need to use -transpose");
+                    if (!spillFile.open())
+                    {
+                        throw OperationException("failed to open temporary file for sorting in '" + tempPath + "'");
+                    }
+                    CaretLogInfo("dot file exceeds memory limit, sorting it in pieces using temporary file '" + spillFile.fileName() + "'");
                 }
-                if (numZeros != 0) afterZero = true;
-                tempValue.index[0] -= 1;//fix for 1-indexing
-                tempValue.index[1] -= 1;
-                dotFileContents.push_back(tempValue);
-                if (halfMatrix && tempValue.index[0] != tempValue.index[1])
+                if (!bufferSorted) sort(dotFileContents.begin(), dotFileContents.end());
+                int64_t runValues = (int64_t)dotFileContents.size();
+                if (spillFile.write((const char*)dotFileContents.data(), runValues * sizeof(SparseValue)) != (qint64)(runValues * sizeof(SparseValue)))
                 {
-                    int32_t tempIndex = tempValue.index[0];
-                    tempValue.index[0] = tempValue.index[1];
-                    tempValue.index[1] = tempIndex;
-                    dotFileContents.push_back(tempValue);
+                    throw OperationException("failed to write to temporary file '" + spillFile.fileName() + "', check free disk space");
                 }
+                sortedRuns.push_back(SortedRun());
+                sortedRuns.back().m_filePos = spillValues;
+                sortedRuns.back().m_fileEnd = spillValues + runValues;
+                spillValues += runValues;
+                dotFileContents.clear();
+                bufferSorted = true;
+                lastBufferRow = -1;
             }
+            if (thisChunk.m_stopped) break;
         }
+        carried = dataEnd - parseEnd;
+        if (carried > 0) memmove(textBuffer.data(), textBuffer.data() + parseEnd, carried);
     }
+    textBuffer = vector<char>();
+    myChunks = vector<DotChunk>();
+    dotFile.close();
     if (numZeros != 1)
     {
         CaretLogWarning("found (and ignored) " + AString::number(numZeros) + " lines with zero for value, expected 1");
@@ -269,107 +522,105 @@ void OperationProbtrackXDotConvert::useParameters(OperationParameters* myParams,
     {
         CaretLogWarning("found data lines after dimensionality line (which should be the last line of the file)");
     }
-    bool sorted = true;
-    int64_t numValues = (int64_t)dotFileContents.size();
-    for (int64_t i = 1; i < numValues; ++i)
-    {
-        if (dotFileContents[i - 1].index[1] > dotFileContents[i].index[1])
-        {
-            sorted = false;
-            if (!halfMatrix)
-            {
-                CaretLogInfo("dot file indexes are not correctly sorted, sorting them may take a minute or so...");
-            }
-            break;
-        }
-    }
-    if (!sorted) sort(dotFileContents.begin(), dotFileContents.end());
+    if (!bufferSorted) sort(dotFileContents.begin(), dotFileContents.end());
     if (!sorted && !halfMatrix)
     {
         CaretLogInfo("sorting finished");
     }
+    sortedRuns.push_back(SortedRun());//whatever is still in memory is the last run
+    sortedRuns.back().m_buffer.swap(dotFileContents);
+    int numRuns = (int)sortedRuns.size();
+    int64_t mergeBlock = MAX_MERGE_BUFFER;
+    if (bufferLimit > 0) mergeBlock = max((int64_t)1024, min(mergeBlock, bufferLimit / numRuns));
+    CaretMinHeap<int, int32_t> runHeap;//which run has the lowest next row
+    for (int i = 0; i < numRuns; ++i)
+    {
+        if (i < numRuns - 1)
+        {//prime the spilled runs, the last one is already in memory
+            sortedRuns[i].m_bufferPos = -1;
+            sortedRuns[i].advance(spillFile, mergeBlock);
+        }
+        if (!sortedRuns[i].atEnd()) runHeap.push(i, sortedRuns[i].current().index[1]);
+    }
     myCiftiOut->setCiftiXML(myXML);
-    int64_t cur = 0, end = (int64_t)dotFileContents.size();
+    CaretPointer<CaretSparseFileWriter> sparseOut;
+    if (sparseOpt->m_present)
+    {
+        sparseOut.grabNew(new CaretSparseFileWriter(sparseOpt->getString(1), myCiftiOut->getCiftiXML(), false));
+    }
     vector<float> scratchRow(myXML.getNumberOfColumns(), 0.0f);
     vector<bool> checkDuplicate(myXML.getNumberOfColumns(), false);
-    int64_t whichRow = 0;//set all rows, in case initial allocation doesn't give a zeroed matrix
-    while (whichRow < myXML.getNumberOfRows())
+    vector<SparseValue> rowValues;
+    vector<int64_t> sparseIndices, sparseValues;
+    int64_t numRows = myXML.getNumberOfRows();
+    for (int64_t whichRow = 0; whichRow < numRows; ++whichRow)//set all rows, in case initial allocation doesn't give a zeroed matrix
     {
-        int64_t next = cur;
-        while (next < end && dotFileContents[next].index[1] == whichRow) ++next;
-        if (rowVoxelOpt->m_present)
+        rowValues.clear();
+        while (!runHeap.isEmpty())
         {
-            for (int64_t i = cur; i < next; ++i)
+            int32_t nextRow;
+            runHeap.top(&nextRow);
+            if (nextRow != whichRow) break;
+            int whichRun = runHeap.pop();
+            SortedRun& thisRun = sortedRuns[whichRun];
+            while (!thisRun.atEnd() && thisRun.current().index[1] == whichRow)
             {
-                int64_t outIndex = rowReorderMap[dotFileContents[i].index[0]];
-                if (checkDuplicate[outIndex])
-                {
-                    AString elemString;
-                    if (transpose)
-                    {
-                        elemString = AString::number(dotFileContents[i].index[1] + 1) + ", " + AString::number(dotFileContents[i].index[0] + 1);
-                    } else {
-                        elemString = AString::number(dotFileContents[i].index[0] + 1) + ", " + AString::number(dotFileContents[i].index[1] + 1);
-                    }
-                    if (halfMatrix)
-                    {
-                        throw OperationException("element specified more than once: " + elemString + ", perhaps you should not use -make-symmetric");
-                    } else {
-                        throw OperationException("duplicate element found: " + elemString);
-                    }
-                }
-                scratchRow[outIndex] = dotFileContents[i].value;
-                checkDuplicate[outIndex] = true;
+                rowValues.push_back(thisRun.current());
+                thisRun.advance(spillFile, mergeBlock);
             }
-        } else {
-            for (int64_t i = cur; i < next; ++i)
+            if (!thisRun.atEnd()) runHeap.push(whichRun, thisRun.current().index[1]);
+        }
+        int64_t numRowValues = (int64_t)rowValues.size();
+        for (int64_t i = 0; i < numRowValues; ++i)
+        {
+            int64_t outIndex = rowValues[i].index[0];
+            if (checkDuplicate[outIndex])
             {
-                int64_t outIndex = dotFileContents[i].index[0];
-                if (checkDuplicate[outIndex])
+                int64_t inputIndex[2] = { outIndex, whichRow };
+                if (rowVoxelOpt->m_present) inputIndex[0] = rowInverse[outIndex];
+                if (colVoxelOpt->m_present) inputIndex[1] = colInverse[whichRow];
+                AString elemString;
+                if (transpose)
                 {
-                    AString elemString;
-                    if (transpose)
-                    {
-                        elemString = AString::number(dotFileContents[i].index[1] + 1) + ", " + AString::number(dotFileContents[i].index[0] + 1);
-                    } else {
-                        elemString = AString::number(dotFileContents[i].index[0] + 1) + ", " + AString::number(dotFileContents[i].index[1] + 1);
-                    }
-                    if (halfMatrix)
-                    {
-                        throw OperationException("element specified more than once: " + elemString + ", perhaps you should not use -make-symmetric");
-                    } else {
-                        throw OperationException("duplicate element found: " + elemString);
-                    }
+                    elemString = AString::number(inputIndex[1] + 1) + ", " + AString::number(inputIndex[0] + 1);
+                } else {
+                    elemString = AString::number(inputIndex[0] + 1) + ", " + AString::number(inputIndex[1] + 1);
+                }
+                if (halfMatrix)
+                {
+                    throw OperationException("element specified more than once: " + elemString + ", perhaps you should not use -make-symmetric");
+                } else {
+                    throw OperationException("duplicate element found: " + elemString);
                 }
-                scratchRow[outIndex] = dotFileContents[i].value;
-                checkDuplicate[outIndex] = true;
             }
+            scratchRow[outIndex] = rowValues[i].value;
+            checkDuplicate[outIndex] = true;
         }
-        if (colVoxelOpt->m_present)
+        myCiftiOut->setRow(scratchRow.data(), whichRow);
+        if (sparseOut != NULL)
         {
-            myCiftiOut->setRow(scratchRow.data(), colReorderMap[whichRow]);
-        } else {
-            myCiftiOut->setRow(scratchRow.data(), whichRow);
-        }
-        if (rowVoxelOpt->m_present)
-        {
-            for (int64_t i = cur; i < next; ++i)
+            sort(rowValues.begin(), rowValues.end(), lessWithinRow);
+            sparseIndices.clear();
+            sparseValues.clear();
+            for (int64_t i = 0; i < numRowValues; ++i)
             {
-                int64_t outIndex = rowReorderMap[dotFileContents[i].index[0]];
-                scratchRow[outIndex] = 0.0f;
-                checkDuplicate[outIndex] = false;
-            }
-        } else {
-            for (int64_t i = cur; i < next; ++i)
-            {
-                int64_t outIndex = dotFileContents[i].index[0];
-                scratchRow[outIndex] = 0.0f;
-                checkDuplicate[outIndex] = false;
+                int64_t count = (int64_t)floor(rowValues[i].value + 0.5f);
+                if (count != 0)
+                {
+                    sparseIndices.push_back(rowValues[i].index[0]);
+                    sparseValues.push_back(count);
+                }
             }
+            sparseOut->writeRowSparse(whichRow, sparseIndices, sparseValues);
+        }
+        for (int64_t i = 0; i < numRowValues; ++i)
+        {
+            int64_t outIndex = rowValues[i].index[0];
+            scratchRow[outIndex] = 0.0f;
+            checkDuplicate[outIndex] = false;
         }
-        cur = next;
-        ++whichRow;
     }
+    if (sparseOut != NULL) sparseOut->finish();
 }
 
 void OperationProbtrackXDotConvert::addVoxelMapping(const VolumeFile* myLabelVol, const AString& textFileName, CiftiXMLOld& myXML, vector<int64_t>& reorderMapping, const int& direction)
@@ -30,8 +30,13 @@
 #include <GL/osmesa.h>
 #endif // HAVE_OSMESA
 
-#include <QImage>
 #include <QColor>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QRegExp>
+#include <QStringList>
+#include <QTextStream>
 
 
 #include "Brain.h"
@@ -56,6 +61,7 @@
 #include "SceneClass.h"
 #include "SceneClassArray.h"
 #include "SceneFile.h"
+#include "ScenePathName.h"
 #include "ScenePrimitiveArray.h"
 #include "SessionManager.h"
 #include "TileTabsConfiguration.h"
@@ -117,6 +123,9 @@ OperationShowScene::getParameters()
     mapYokeOpt->addStringParameter(1, "Map Yoking Roman Numeral", "Roman numeral identifying the map yoking group (I, II, III, IV, V, VI, VII, VIII, IX, X)");
     mapYokeOpt->addIntegerParameter(2, "Map Index", "Map index for yoking group.  Indices start at 1 (one)");
     
+    OptionalParameter* batchOpt = ret->createOptionalParameter(9, "-batch", "render additional scenes listed in a text file");
+    batchOpt->addStringParameter(1, "batch-file", "text file with one render per line");
+    
     AString helpText("Render content of browser windows displayed in a scene "
                      "into image file(s).  The image file name should be "
                      "similar to \"capture.png\".  If there is only one image "
@@ -154,6 +163,21 @@ OperationShowScene::getParameters()
                  "      of the graphics region, the width and height specified\n"
                  "      on the command line is used for the size of the \n"
                  "      output image.\n"
+                 "\n"
+                 "The -batch option renders more images in the same run, after the\n"
+                 "image for the scene given on the command line.  Each line of the\n"
+                 "batch file contains a scene name or number, an image file name,\n"
+                 "and optionally any number of pairs of a data file used by the\n"
+                 "scene followed by the file that replaces it for that image, all\n"
+                 "separated by whitespace.  Lines starting with '#' are ignored.\n"
+                 "For example, to render the same scene for another subject:\n"
+                 "\n"
+                 "    1 subj2.png subj1/thickness.dscalar.nii subj2/thickness.dscalar.nii\n"
+                 "\n"
+                 "Relative file names are relative to the current directory.  Data\n"
+                 "files that are unchanged from the previous image (for example,\n"
+                 "template surfaces) stay loaded and are not read again, so renders\n"
+                 "that share files should be adjacent in the batch file.\n"
                  );
     
     
@@ -223,10 +247,108 @@ OperationShowScene::useParameters(OperationParameters* myParams,
     }
     
     /*
-     * Read the scene file and load the scene
+     * The scene on the command line is always rendered first,
+     * followed by any renders listed in the batch file.
+     */
+    std::vector<BatchRender> batchRenders(1);
+    batchRenders[0].m_sceneNameOrNumber = sceneNameOrNumber;
+    batchRenders[0].m_imageFileName     = imageFileName;
+    OptionalParameter* batchOpt = myParams->getOptionalParameter(9);
+    if (batchOpt->m_present) {
+        readBatchFile(batchOpt->getString(1),
+                      batchRenders);
+    }
+    
+    /*
+     * Read the scene file
      */
     SceneFile sceneFile;
     sceneFile.readFile(sceneFileName);
+    
+    /*
+     * Verify all scenes exist before anything is rendered
+     */
+    for (std::vector<BatchRender>::const_iterator iter = batchRenders.begin();
+         iter != batchRenders.end();
+         iter++) {
+        findScene(sceneFile, iter->m_sceneNameOrNumber);
+    }
+
+    /*
+     * Enable voxel coloring since it is defaulted off for commands
+     */
+    VolumeFile::setVoxelColoringEnabled(true);
+    
+    /*
+     * Scenes only draw a few maps of each volume, so keep integer
+     * volumes small like wb_view does
+     */
+    VolumeFile::setNativeStorageEnabled(true);
+    VolumeFile::setOnDiskEnabled(true);
+    
+    /*
+     * The session is restored once per render.  Data files that
+     * are not modified remain loaded by the Brain between scene
+     * restorations so files shared by consecutive renders (template
+     * surfaces, atlases) are only read once.
+     */
+    bool missingWindowMessageHasBeenDisplayed = false;
+    for (std::vector<BatchRender>::const_iterator iter = batchRenders.begin();
+         iter != batchRenders.end();
+         iter++) {
+        const BatchRender& batchRender = *iter;
+        
+        if (batchRender.m_substitutions.empty()) {
+            renderScene(findScene(sceneFile, batchRender.m_sceneNameOrNumber),
+                        batchRender.m_imageFileName,
+                        userImageWidth,
+                        userImageHeight,
+                        useWindowSizeForImageSizeFlag,
+                        useWindowSizeParam->m_optionSwitch,
+                        doNotUseSceneColorsFlag,
+                        mapYokingGroup,
+                        mapYokingMapIndex,
+                        missingWindowMessageHasBeenDisplayed);
+        }
+        else {
+            /*
+             * Substitutions modify the scene so use a fresh copy of the scene file
+             */
+            SceneFile substitutedSceneFile;
+            substitutedSceneFile.readFile(sceneFileName);
+            Scene* scene = findScene(substitutedSceneFile, batchRender.m_sceneNameOrNumber);
+            substituteFileNames(scene,
+                                batchRender.m_substitutions);
+            renderScene(scene,
+                        batchRender.m_imageFileName,
+                        userImageWidth,
+                        userImageHeight,
+                        useWindowSizeForImageSizeFlag,
+                        useWindowSizeParam->m_optionSwitch,
+                        doNotUseSceneColorsFlag,
+                        mapYokingGroup,
+                        mapYokingMapIndex,
+                        missingWindowMessageHasBeenDisplayed);
+        }
+    }
+}
+
+/**
+ * Find a scene in a scene file.
+ *
+ * @param sceneFile
+ *     The scene file.
+ * @param sceneNameOrNumber
+ *     Name or number (starting at one) of the scene.
+ * @return
+ *     The scene.
+ * @throws OperationException
+ *     If the scene is not found.
+ */
+Scene*
+OperationShowScene::findScene(SceneFile& sceneFile,
+                              const AString& sceneNameOrNumber)
+{
     Scene* scene = sceneFile.getSceneWithName(sceneNameOrNumber);
     if (scene == NULL) {
         bool valid = false;
@@ -238,19 +360,163 @@ OperationShowScene::useParameters(OperationParameters* myParams,
                 scene = sceneFile.getSceneAtIndex(sceneIndex);
             }
             else {
-                throw OperationException("Scene index is invalid");
+                throw OperationException("Scene index is invalid: "
+                                         + sceneNameOrNumber);
             }
         }
         else {
-            throw OperationException("Scene name is invalid");
+            throw OperationException("Scene name is invalid: "
+                                     + sceneNameOrNumber);
         }
     }
+    
+    return scene;
+}
 
-    /*
-     * Enable voxel coloring since it is defaulted off for commands
-     */
-    VolumeFile::setVoxelColoringEnabled(true);
+/**
+ * Read the batch file.  Each line contains the name or number of a scene,
+ * the name of the output image, and optionally pairs of a data file name
+ * in the scene followed by the file that replaces it.  Empty lines and
+ * lines starting with '#' are ignored.
+ *
+ * @param batchFileName
+ *     Name of the batch file.
+ * @param batchRendersOut
+ *     Renders read from the file are appended to this.
+ * @throws OperationException
+ *     If the file cannot be read or a line is invalid.
+ */
+void
+OperationShowScene::readBatchFile(const AString& batchFileName,
+                                  std::vector<BatchRender>& batchRendersOut)
+{
+    QFile file(batchFileName);
+    if ( ! file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        throw OperationException("Unable to open batch file "
+                                 + batchFileName
+                                 + ": "
+                                 + file.errorString());
+    }
+    
+    QTextStream stream(&file);
+    int32_t lineNumber = 0;
+    while ( ! stream.atEnd()) {
+        const AString line = stream.readLine().trimmed();
+        lineNumber++;
+        if (line.isEmpty()
+            || line.startsWith("#")) {
+            continue;
+        }
+        
+        const QStringList items = line.split(QRegExp("\\s+"),
+                                             QString::SkipEmptyParts);
+        if ((items.size() < 2)
+            || ((items.size() % 2) != 0)) {
+            throw OperationException("Batch file "
+                                     + batchFileName
+                                     + " line "
+                                     + AString::number(lineNumber)
+                                     + " must contain a scene name or number, an image file name, "
+                                       "and pairs of scene data file and replacement file names");
+        }
+        
+        BatchRender batchRender;
+        batchRender.m_sceneNameOrNumber = items[0];
+        batchRender.m_imageFileName     = FileInformation(items[1]).getAbsoluteFilePath();
+        for (int32_t i = 2; i < items.size(); i += 2) {
+            batchRender.m_substitutions.push_back(std::make_pair(FileInformation(items[i]).getAbsoluteFilePath(),
+                                                                 FileInformation(items[i + 1]).getAbsoluteFilePath()));
+        }
+        batchRendersOut.push_back(batchRender);
+    }
+}
+
+/**
+ * Replace data file names in a scene.
+ *
+ * @param scene
+ *     The scene.
+ * @param substitutions
+ *     Pairs of file name in the scene and the file name that replaces it.
+ * @throws OperationException
+ *     If a file to replace is not in the scene.
+ */
+void
+OperationShowScene::substituteFileNames(Scene* scene,
+                                        const std::vector<std::pair<AString, AString> >& substitutions)
+{
+    std::vector<bool> substitutionUsed(substitutions.size(), false);
     
+    const std::vector<SceneObject*> sceneObjects = scene->getDescendants();
+    for (std::vector<SceneObject*>::const_iterator iter = sceneObjects.begin();
+         iter != sceneObjects.end();
+         iter++) {
+        SceneObject* sceneObject = *iter;
+        if (sceneObject->getDataType() == SceneObjectDataTypeEnum::SCENE_PATH_NAME) {
+            /*
+             * Will be NULL for 'path name arrays' but their elements are
+             * also descendants
+             */
+            ScenePathName* scenePathName = dynamic_cast<ScenePathName*>(sceneObject);
+            if (scenePathName != NULL) {
+                const AString pathName = QDir::cleanPath(scenePathName->stringValue());
+                for (int32_t i = 0; i < static_cast<int32_t>(substitutions.size()); i++) {
+                    if (pathName == QDir::cleanPath(substitutions[i].first)) {
+                        scenePathName->setValue(substitutions[i].second);
+                        substitutionUsed[i] = true;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    
+    for (int32_t i = 0; i < static_cast<int32_t>(substitutions.size()); i++) {
+        if ( ! substitutionUsed[i]) {
+            throw OperationException("File "
+                                     + substitutions[i].first
+                                     + " is not used by scene "
+                                     + scene->getName());
+        }
+    }
+}
+
+/**
+ * Restore a scene and render its browser windows into image file(s).
+ *
+ * @param scene
+ *     The scene.
+ * @param imageFileName
+ *     Name of output image file.
+ * @param userImageWidth
+ *     Width of image from command line.
+ * @param userImageHeight
+ *     Height of image from command line.
+ * @param useWindowSizeForImageSizeFlag
+ *     If true, use the window size from the scene for the image size.
+ * @param windowSizeSwitch
+ *     Switch of the option for using the window size.
+ * @param doNotUseSceneColorsFlag
+ *     If true, do not use the foreground and background colors from the scene.
+ * @param mapYokingGroup
+ *     Map yoking group whose selected map is overridden.
+ * @param mapYokingMapIndex
+ *     Map index for the map yoking group.
+ * @param missingWindowMessageHasBeenDisplayed
+ *     Status of warning about missing window size, so it is displayed only once.
+ */
+void
+OperationShowScene::renderScene(const Scene* scene,
+                                const AString& imageFileName,
+                                const int32_t userImageWidth,
+                                const int32_t userImageHeight,
+                                const bool useWindowSizeForImageSizeFlag,
+                                const AString& windowSizeSwitch,
+                                const bool doNotUseSceneColorsFlag,
+                                const MapYokingGroupEnum::Enum mapYokingGroup,
+                                const int32_t mapYokingMapIndex,
+                                bool& missingWindowMessageHasBeenDisplayed)
+{
     SceneAttributes sceneAttributes(SceneTypeEnum::SCENE_TYPE_FULL);
     
     if (doNotUseSceneColorsFlag) {
@@ -283,8 +549,6 @@ OperationShowScene::useParameters(OperationParameters* myParams,
     
     const GapsAndMargins* gapsAndMargins = brain->getGapsAndMargins();
     
-    bool missingWindowMessageHasBeenDisplayed = false;
-    
     /*
      * Apply map yoking
      */
@@ -333,7 +597,7 @@ OperationShowScene::useParameters(OperationParameters* myParams,
                     if ((imageWidth <= 0)
                         || (imageHeight <= 0)) {
                         const QString msg("Option "
-                                          + useWindowSizeParam->m_optionSwitch
+                                          + windowSizeSwitch
                                           + " is used but window size not found in scene and width="
                                           + QString::number(imageWidth)
                                           + " height="
@@ -345,7 +609,7 @@ OperationShowScene::useParameters(OperationParameters* myParams,
                     
                     if ( ! missingWindowMessageHasBeenDisplayed) {
                         const QString msg("Option \""
-                                          + useWindowSizeParam->m_optionSwitch
+                                          + windowSizeSwitch
                                           + "\" is used but window size not found in scene.\n"
                                           "   Scene was created prior to implementation of this option.\n"
                                           "   Image size will be width="
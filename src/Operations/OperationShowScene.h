@@ -22,11 +22,17 @@
 /*LICENSE_END*/
 
 
+#include <utility>
+#include <vector>
+
 #include "AbstractOperation.h"
+#include "MapYokingGroupEnum.h"
 
 namespace caret {
 
     class BrainOpenGLFixedPipeline;
+    class Scene;
+    class SceneFile;
     
     class OperationShowScene : public AbstractOperation {
 
@@ -43,6 +49,35 @@ namespace caret {
         static bool isShowSceneCommandAvailable();
         
     private:
+        /// one image to render, with data files to replace in the scene
+        struct BatchRender {
+            AString m_sceneNameOrNumber;
+            
+            AString m_imageFileName;
+            
+            std::vector<std::pair<AString, AString> > m_substitutions;
+        };
+        
+        static Scene* findScene(SceneFile& sceneFile,
+                                const AString& sceneNameOrNumber);
+        
+        static void readBatchFile(const AString& batchFileName,
+                                  std::vector<BatchRender>& batchRendersOut);
+        
+        static void substituteFileNames(Scene* scene,
+                                        const std::vector<std::pair<AString, AString> >& substitutions);
+        
+        static void renderScene(const Scene* scene,
+                                const AString& imageFileName,
+                                const int32_t userImageWidth,
+                                const int32_t userImageHeight,
+                                const bool useWindowSizeForImageSizeFlag,
+                                const AString& windowSizeSwitch,
+                                const bool doNotUseSceneColorsFlag,
+                                const MapYokingGroupEnum::Enum mapYokingGroup,
+                                const int32_t mapYokingMapIndex,
+                                bool& missingWindowMessageHasBeenDisplayed);
+        
         static BrainOpenGLFixedPipeline* createBrainOpenGL();
         
         static void writeImage(const AString& imageFileName,
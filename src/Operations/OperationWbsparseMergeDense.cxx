@@ -161,7 +161,8 @@ void OperationWbsparseMergeDense::useParameters(OperationParameters* myParams, P
             for (int64_t i = 0; i < outColSize; ++i)
             {
                 int64_t curOffset = 0;
-                vector<int64_t> outIndices, outValues, inIndices, inValues;
+                vector<int64_t> outIndices, outValues;
+                CaretSparseRowView inRow;//points into the mapped input file, no copying
                 int loaded = -1;
                 for (int j = 0; j < numOutModels; ++j)//we could just do the entire row for each file, but doing it by structure could allow structure selection in the future
                 {
@@ -205,16 +206,17 @@ void OperationWbsparseMergeDense::useParameters(OperationParameters* myParams, P
                     {
                         if (loaded != sourceWbsparse[j])
                         {
-                            wbsparseList[sourceWbsparse[j]]->getRowSparse(i, inIndices, inValues);
+                            wbsparseList[sourceWbsparse[j]]->getRowView(i, inRow);
                             loaded = sourceWbsparse[j];
                         }
-                        int64_t numSparse = (int64_t)inIndices.size();
+                        int64_t numSparse = inRow.getNumberOfNonzero();
                         for (int64_t k = 0; k < numSparse; ++k)
                         {
-                            if (inIndices[k] >= startIndex && inIndices[k] < endIndex)
+                            int64_t inIndex = inRow.getIndex(k);
+                            if (inIndex >= startIndex && inIndex < endIndex)
                             {
-                                outIndices.push_back(inIndices[k] + curOffset);
-                                outValues.push_back(inValues[k]);
+                                outIndices.push_back(inIndex + curOffset);
+                                outValues.push_back(inRow.getValue(k));
                             }
                         }
                         curOffset += endIndex - startIndex;
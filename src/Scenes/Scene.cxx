@@ -23,10 +23,17 @@
 #include "Scene.h"
 #undef __SCENE_DECLARE__
 
+#include <memory>
+
 #include "CaretAssert.h"
+#include "CaretLogger.h"
 #include "SceneAttributes.h"
 #include "SceneClass.h"
 #include "SceneInfo.h"
+#include "SceneSaxReader.h"
+#include "SceneXmlElements.h"
+#include "SceneXmlIndex.h"
+#include "XmlSaxParser.h"
 
 using namespace caret;
 
@@ -236,11 +243,14 @@ Scene::Scene(const SceneTypeEnum::Enum sceneType)
     m_sceneAttributes = new SceneAttributes(sceneType);
     m_hasFilesWithRemotePaths = false;
     m_sceneInfo = new SceneInfo();
+    m_lazySceneIndex = -1;
 }
 
 Scene::Scene(const Scene& rhs)
 :CaretObjectTracksModification()
 {
+    rhs.loadAllContent();
+    m_lazySceneIndex = -1;
     m_sceneAttributes = new SceneAttributes(*(rhs.m_sceneAttributes));
     m_hasFilesWithRemotePaths = rhs.m_hasFilesWithRemotePaths;
     m_sceneInfo = new SceneInfo(*(rhs.m_sceneInfo));
@@ -272,6 +282,8 @@ Scene::~Scene()
 std::vector<SceneObject*>
 Scene::getDescendants() const
 {
+    loadAllContent();
+    
     std::vector<SceneObject*> descendants;
     
     const int32_t numberOfSceneClasses = this->getNumberOfClasses();
@@ -335,6 +347,9 @@ const SceneClass*
 Scene::getClassAtIndex(const int32_t indx) const
 {
     CaretAssertVectorIndex(m_sceneClasses, indx);
+    if (m_sceneClasses[indx] == NULL) {
+        loadLazyClass(indx);
+    }
     m_sceneClasses[indx]->setRestored(true);
     return m_sceneClasses[indx];
 }
@@ -350,6 +365,18 @@ Scene::getClassWithName(const AString& sceneClassName) const
 {
     const int32_t numberOfSceneClasses = this->getNumberOfClasses();
     for (int32_t i = 0; i < numberOfSceneClasses; i++) {
+        if (m_sceneClasses[i] == NULL) {
+            /*
+             * Only parse the class when it is the one requested
+             */
+            CaretAssert(m_lazyXmlIndex != NULL);
+            const SceneXmlIndex::SceneEntry& sceneEntry = m_lazyXmlIndex->getScene(m_lazySceneIndex);
+            CaretAssertVectorIndex(sceneEntry.m_classes, i);
+            if (sceneEntry.m_classes[i].m_name != sceneClassName) {
+                continue;
+            }
+            loadLazyClass(i);
+        }
         if (m_sceneClasses[i]->getName() == sceneClassName) {
             m_sceneClasses[i]->setRestored(true);
             return m_sceneClasses[i];
@@ -427,6 +454,7 @@ Scene::setDescription(const AString& sceneDescription)
 bool
 Scene::hasFilesWithRemotePaths() const
 {
+    loadAllContent();
     return m_hasFilesWithRemotePaths;
 }
 
@@ -524,4 +552,109 @@ Scene::clearModified()
     m_sceneInfo->clearModified();
 }
 
+/**
+ * Leave the classes of this scene in the scene file until they are used.
+ * Each class is parsed the first time it is accessed.
+ *
+ * @param xmlIndex
+ *    Index of the scene file containing this scene.
+ * @param sceneIndex
+ *    Index of this scene in the scene file index.
+ */
+void
+Scene::setLazyContent(const CaretPointer<const SceneXmlIndex>& xmlIndex,
+                      const int32_t sceneIndex)
+{
+    CaretAssert(xmlIndex != NULL);
+    CaretAssert(m_sceneClasses.empty());
+    
+    m_lazyXmlIndex  = xmlIndex;
+    m_lazySceneIndex = sceneIndex;
+    m_sceneClasses.resize(xmlIndex->getScene(sceneIndex).m_classes.size(),
+                          NULL);
+}
 
+/**
+ * Parse any of the classes, and the scene info's image, that are still
+ * only in the scene file.  Needed before the scene file is overwritten.
+ */
+void
+Scene::loadAllContent() const
+{
+    m_sceneInfo->loadAllContent();
+    
+    if (m_lazyXmlIndex == NULL) {
+        return;
+    }
+    
+    const int32_t numberOfSceneClasses = this->getNumberOfClasses();
+    for (int32_t i = 0; i < numberOfSceneClasses; i++) {
+        if (m_sceneClasses[i] == NULL) {
+            loadLazyClass(i);
+        }
+    }
+    
+    m_lazyXmlIndex = CaretPointer<const SceneXmlIndex>();
+}
+
+/**
+ * Parse a class that is still only in the scene file.  If the
+ * class cannot be read, an error is logged and the class is empty.
+ *
+ * @param indx
+ *    Index of the class.
+ */
+void
+Scene::loadLazyClass(const int32_t indx) const
+{
+    CaretAssert(m_lazyXmlIndex != NULL);
+    CaretAssertVectorIndex(m_sceneClasses, indx);
+    CaretAssert(m_sceneClasses[indx] == NULL);
+    
+    const SceneXmlIndex::SceneEntry& sceneEntry = m_lazyXmlIndex->getScene(m_lazySceneIndex);
+    CaretAssertVectorIndex(sceneEntry.m_classes, indx);
+    const SceneXmlIndex::ClassEntry& classEntry = sceneEntry.m_classes[indx];
+    
+    SceneClass* sceneClass = NULL;
+    try {
+        QByteArray sceneBytes;
+        m_lazyXmlIndex->readRange(classEntry.m_range,
+                                  sceneBytes);
+        sceneBytes.prepend(sceneEntry.m_startTag);
+        sceneBytes.append("</" + SceneXmlElements::SCENE_TAG.toUtf8() + ">");
+        
+        /*
+         * The scene reader puts the class into a scene, so read into
+         * a temporary scene and take the class from it
+         */
+        Scene tempScene(m_sceneAttributes->getSceneType());
+        SceneSaxReader saxReader(m_lazyXmlIndex->getFileName(),
+                                 &tempScene);
+        std::unique_ptr<XmlSaxParser> parser(XmlSaxParser::createXmlParser());
+        parser->parseString(QString::fromUtf8(sceneBytes),
+                            &saxReader);
+        
+        if (tempScene.m_sceneClasses.size() == 1) {
+            sceneClass = tempScene.m_sceneClasses[0];
+            tempScene.m_sceneClasses.clear();
+        }
+        if (tempScene.m_hasFilesWithRemotePaths) {
+            m_hasFilesWithRemotePaths = true;
+        }
+    }
+    catch (const XmlSaxParserException& e) {
+        CaretLogSevere("Unable to read class "
+                       + classEntry.m_name
+                       + " of scene "
+                       + getName()
+                       + ": "
+                       + e.whatString());
+    }
+    
+    if (sceneClass == NULL) {
+        sceneClass = new SceneClass(classEntry.m_name,
+                                    classEntry.m_className,
+                                    0);
+    }
+    m_sceneClasses[indx] = sceneClass;
+}
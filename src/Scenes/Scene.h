@@ -23,6 +23,7 @@
 
 
 #include "CaretObjectTracksModification.h"
+#include "CaretPointer.h"
 #include "SceneTypeEnum.h"
 
 namespace caret {
@@ -30,6 +31,7 @@ namespace caret {
     class SceneClass;
     class SceneInfo;
     class SceneObject;
+    class SceneXmlIndex;
     
     class Scene : public CaretObjectTracksModification {
         
@@ -85,6 +87,11 @@ namespace caret {
         
         virtual void clearModified() override;
         
+        void setLazyContent(const CaretPointer<const SceneXmlIndex>& xmlIndex,
+                            const int32_t sceneIndex);
+        
+        void loadAllContent() const;
+        
         // ADD_NEW_METHODS_HERE
 
         static void setSceneBeingCreated(Scene* scene);
@@ -92,18 +99,25 @@ namespace caret {
         static void setSceneBeingCreatedHasFilesWithRemotePaths();
         
     private:
+        void loadLazyClass(const int32_t indx) const;
 
         /** Attributes of the scene*/
         SceneAttributes* m_sceneAttributes;
 
-        /** Classes contained in the scene*/
-        std::vector<SceneClass*> m_sceneClasses;
+        /** Classes contained in the scene, NULL for a class that is still only in the scene file */
+        mutable std::vector<SceneClass*> m_sceneClasses;
 
         /** Info about scene */
         SceneInfo* m_sceneInfo;
         
         /** True if it found a ScenePathName with a remote file */
-        bool m_hasFilesWithRemotePaths;
+        mutable bool m_hasFilesWithRemotePaths;
+        
+        /** Index of the scene file while some classes have not been parsed */
+        mutable CaretPointer<const SceneXmlIndex> m_lazyXmlIndex;
+        
+        /** Index of this scene in the scene file index */
+        int32_t m_lazySceneIndex;
         
         /** When a scene is being created, this will be set */
         static Scene* s_sceneBeingCreated;
@@ -23,10 +23,15 @@
 #include "SceneInfo.h"
 #undef __SCENE_INFO_DECLARE__
 
+#include <memory>
+
 #include "CaretAssert.h"
 #include "CaretLogger.h"
+#include "SceneInfoSaxReader.h"
 #include "SceneXmlElements.h"
+#include "SceneXmlIndex.h"
 #include "XmlAttributes.h"
+#include "XmlSaxParser.h"
 #include "XmlWriter.h"
 using namespace caret;
 
@@ -44,7 +49,7 @@ using namespace caret;
 SceneInfo::SceneInfo()
 : CaretObjectTracksModification()
 {
-    
+    m_lazySceneInfoIndex = -1;
 }
 
 SceneInfo::SceneInfo(const SceneInfo& rhs) : CaretObjectTracksModification()
@@ -54,6 +59,8 @@ SceneInfo::SceneInfo(const SceneInfo& rhs) : CaretObjectTracksModification()
     m_balsaSceneID = rhs.m_balsaSceneID;
     m_imageFormat = rhs.m_imageFormat;
     m_imageBytes = rhs.m_imageBytes;
+    m_lazyXmlIndex = rhs.m_lazyXmlIndex;
+    m_lazySceneInfoIndex = rhs.m_lazySceneInfoIndex;
 }
 
 /**
@@ -121,6 +128,7 @@ void
 SceneInfo::setImageBytes(const QByteArray& imageBytes,
                                   const AString& imageFormat)
 {
+    m_lazyXmlIndex = CaretPointer<const SceneXmlIndex>();
     if ((imageBytes != m_imageBytes)
         || (imageFormat != m_imageFormat)) {
         m_imageBytes  = imageBytes;
@@ -140,6 +148,7 @@ void
 SceneInfo::getImageBytes(QByteArray& imageBytesOut,
                                   AString& imageFormatOut) const
 {
+    loadAllContent();
     imageBytesOut = m_imageBytes;
     imageFormatOut         = m_imageFormat;
 }
@@ -153,6 +162,7 @@ SceneInfo::getImageBytes(QByteArray& imageBytesOut,
 bool
 SceneInfo::hasImage() const
 {
+    loadAllContent();
     if (m_imageBytes.isEmpty()) {
         return false;
     }
@@ -196,6 +206,8 @@ void
 SceneInfo::writeSceneInfo(XmlWriter& xmlWriter,
                           const int32_t sceneInfoIndex) const
 {
+    loadAllContent();
+    
     XmlAttributes attributes;
     attributes.addAttribute(SceneXmlElements::SCENE_INFO_INDEX_ATTRIBUTE,
                             sceneInfoIndex);
@@ -277,6 +289,7 @@ SceneInfo::setImageFromText(const AString& text,
                                const AString& encoding,
                                const AString& imageFormat)
 {
+    m_lazyXmlIndex = CaretPointer<const SceneXmlIndex>();
     m_imageBytes.clear();
     m_imageFormat = "";
     
@@ -293,7 +306,60 @@ SceneInfo::setImageFromText(const AString& text,
     }
 }
 
+/**
+ * Leave the thumbnail image in the scene file until it is used.
+ *
+ * @param xmlIndex
+ *    Index of the scene file containing this scene info.
+ * @param sceneInfoIndex
+ *    Index of this scene info in the scene file index.
+ */
+void
+SceneInfo::setLazyImage(const CaretPointer<const SceneXmlIndex>& xmlIndex,
+                        const int32_t sceneInfoIndex)
+{
+    CaretAssert(xmlIndex != NULL);
+    m_lazyXmlIndex = xmlIndex;
+    m_lazySceneInfoIndex = sceneInfoIndex;
+    m_imageBytes.clear();
+    m_imageFormat = "";
+}
 
-
-
-
+/**
+ * Parse the thumbnail image if it is still only in the scene file.
+ * If it cannot be read, an error is logged and there is no image.
+ */
+void
+SceneInfo::loadAllContent() const
+{
+    if (m_lazyXmlIndex == NULL) {
+        return;
+    }
+    
+    const CaretPointer<const SceneXmlIndex> xmlIndex = m_lazyXmlIndex;
+    m_lazyXmlIndex = CaretPointer<const SceneXmlIndex>();
+    
+    const SceneXmlIndex::SceneInfoEntry& sceneInfoEntry = xmlIndex->getSceneInfo(m_lazySceneInfoIndex);
+    try {
+        QByteArray sceneInfoBytes;
+        xmlIndex->readRange(sceneInfoEntry.m_imageRange,
+                            sceneInfoBytes);
+        sceneInfoBytes.prepend(sceneInfoEntry.m_startTag);
+        sceneInfoBytes.append("</" + SceneXmlElements::SCENE_INFO_TAG.toUtf8() + ">");
+        
+        SceneInfo tempSceneInfo;
+        SceneInfoSaxReader saxReader(xmlIndex->getFileName(),
+                                     &tempSceneInfo);
+        std::unique_ptr<XmlSaxParser> parser(XmlSaxParser::createXmlParser());
+        parser->parseString(QString::fromUtf8(sceneInfoBytes),
+                            &saxReader);
+        m_imageBytes  = tempSceneInfo.m_imageBytes;
+        m_imageFormat = tempSceneInfo.m_imageFormat;
+    }
+    catch (const XmlSaxParserException& e) {
+        CaretLogSevere("Unable to read thumbnail image of scene "
+                       + m_sceneName
+                       + ": "
+                       + e.whatString());
+    }
+}
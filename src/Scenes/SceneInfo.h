@@ -23,10 +23,12 @@
 
 #include <stdint.h>
 #include "CaretObjectTracksModification.h"
+#include "CaretPointer.h"
 
 
 
 namespace caret {
+    class SceneXmlIndex;
     class XmlWriter;
     
     class SceneInfo : public CaretObjectTracksModification {
@@ -70,6 +72,11 @@ namespace caret {
                                  const QByteArray& imageBytes,
                                  const AString& imageFormat) const;
         
+        void setLazyImage(const CaretPointer<const SceneXmlIndex>& xmlIndex,
+                          const int32_t sceneInfoIndex);
+        
+        void loadAllContent() const;
+        
     private:
         SceneInfo& operator=(const SceneInfo&);
         
@@ -83,10 +90,16 @@ namespace caret {
         AString m_balsaSceneID;
         
         /** thumbnail image bytes */
-        QByteArray m_imageBytes;
+        mutable QByteArray m_imageBytes;
         
         /** format of thumbnail image (eg: jpg, ppm, etc.) */
-        AString m_imageFormat;
+        mutable AString m_imageFormat;
+        
+        /** Index of the scene file while the image has not been parsed */
+        mutable CaretPointer<const SceneXmlIndex> m_lazyXmlIndex;
+        
+        /** Index of this scene info in the scene file index */
+        int32_t m_lazySceneInfoIndex;
         
         // ADD_NEW_MEMBERS_HERE
 
@@ -106,6 +106,11 @@ namespace caret {
          */
         static const AString OBJECT_VERSION_ATTRIBUTE = "Version";
     
+        /**
+         * XML Tag for Scene Info Directory element, same as SceneFile::XML_TAG_SCENE_INFO_DIRECTORY_TAG.
+         */
+        static const AString SCENE_INFO_DIRECTORY_TAG = "SceneInfoDirectory";
+    
         /**
          * XML Tag for Scene Info element.
          */
@@ -0,0 +1,613 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "SceneXmlIndex.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <QFile>
+#include <QFileInfo>
+
+#include "CaretAssert.h"
+#include "SceneXmlElements.h"
+#include "XmlSaxParserException.h"
+#include "XmlUtilities.h"
+
+using namespace caret;
+
+namespace
+{
+    bool isXmlSpace(const char c)
+    {
+        return (c == ' ' || c == '\t' || c == '\n' || c == '\r');
+    }
+
+    bool bytesStartWith(const char* data, const int64_t dataSize, const int64_t pos, const char* text)
+    {
+        const int64_t textLength = strlen(text);
+        return (pos + textLength <= dataSize && memcmp(data + pos, text, textLength) == 0);
+    }
+
+    ///position of text at or after pos, or -1
+    int64_t findBytes(const char* data, const int64_t dataSize, const int64_t pos, const char* text)
+    {
+        const char* textEnd = text + strlen(text);
+        const char* found = std::search(data + pos, data + dataSize, text, textEnd);
+        if (found == data + dataSize) return -1;
+        return found - data;
+    }
+}
+
+/**
+ * \class caret::SceneXmlIndex
+ * \brief Byte offsets of the parts of a scene file.
+ * \ingroup Scenes
+ *
+ * Scanning the markup of a scene file is much faster than parsing it,
+ * since the scene classes and the base64 thumbnail images are skipped
+ * without being decoded.  The offsets allow each scene's top level classes,
+ * and each scene info's image, to be parsed only when they are used.
+ *
+ * Only files written the way SceneFile writes them are indexed (UTF-8,
+ * no DTD, a scene info for every scene), anything else should be
+ * read by parsing the whole file.
+ */
+
+/**
+ * Constructor.
+ */
+SceneXmlIndex::SceneXmlIndex()
+{
+    m_fileSize = 0;
+}
+
+/**
+ * Destructor.
+ */
+SceneXmlIndex::~SceneXmlIndex()
+{
+}
+
+/**
+ * Index the given scene file.
+ *
+ * @param filename
+ *    Name of the scene file, must be a local file.
+ * @return
+ *    True if the file was indexed, false if it must be read by parsing the whole file.
+ */
+bool
+SceneXmlIndex::indexFile(const AString& filename)
+{
+    m_scenes.clear();
+    m_sceneInfos.clear();
+    m_filename = filename;
+
+    QFile file(filename);
+    if ( ! file.open(QFile::ReadOnly)) {
+        return false;
+    }
+    m_fileSize = file.size();
+    m_fileLastModified = QFileInfo(filename).lastModified();
+
+    bool validFlag = false;
+    uchar* mappedData = ((m_fileSize > 0)
+                         ? file.map(0, m_fileSize)
+                         : NULL);
+    if (mappedData != NULL) {
+        validFlag = indexBytes(reinterpret_cast<const char*>(mappedData),
+                               m_fileSize);
+        file.unmap(mappedData);
+    }
+    else {
+        const QByteArray allBytes = file.readAll();
+        if (allBytes.size() == m_fileSize) {
+            validFlag = indexBytes(allBytes.constData(),
+                                   allBytes.size());
+        }
+    }
+
+    if ( ! validFlag) {
+        m_scenes.clear();
+        m_sceneInfos.clear();
+    }
+    return validFlag;
+}
+
+/**
+ * Find the scenes, their top level classes, and the scene infos in the
+ * bytes of a scene file.
+ *
+ * @param data
+ *    Content of the file.
+ * @param dataSize
+ *    Number of bytes in the file.
+ * @return
+ *    True if the content could be indexed.
+ */
+bool
+SceneXmlIndex::indexBytes(const char* data,
+                          const int64_t dataSize)
+{
+    const QByteArray sceneTag            = SceneXmlElements::SCENE_TAG.toUtf8();
+    const QByteArray sceneNameTag        = SceneXmlElements::SCENE_NAME_TAG.toUtf8();
+    const QByteArray sceneDescriptionTag = SceneXmlElements::SCENE_DESCRIPTION_TAG.toUtf8();
+    const QByteArray objectTag           = SceneXmlElements::OBJECT_TAG.toUtf8();
+    const QByteArray infoDirectoryTag    = SceneXmlElements::SCENE_INFO_DIRECTORY_TAG.toUtf8();
+    const QByteArray sceneInfoTag        = SceneXmlElements::SCENE_INFO_TAG.toUtf8();
+    const QByteArray imageTag            = SceneXmlElements::SCENE_INFO_IMAGE_TAG.toUtf8();
+
+    int64_t pos = 0;
+    if (bytesStartWith(data, dataSize, 0, "\xEF\xBB\xBF")) {
+        pos = 3;
+    }
+
+    int32_t depth = 0;
+    bool rootFoundFlag = false;
+    bool rootClosedFlag = false;
+    bool infoDirectoryFoundFlag = false;
+    bool inInfoDirectoryFlag = false;
+    int64_t sceneIndex = -1;
+    int64_t classIndex = -1;
+    int64_t sceneInfoIndex = -1;
+    bool inImageFlag = false;
+
+    while (pos < dataSize) {
+        const char* nextTag = static_cast<const char*>(memchr(data + pos, '<', dataSize - pos));
+        if (nextTag == NULL) {
+            break;
+        }
+        pos = nextTag - data;
+
+        if (bytesStartWith(data, dataSize, pos, "<!--")) {
+            const int64_t endPos = findBytes(data, dataSize, pos + 4, "-->");
+            if (endPos < 0) return false;
+            pos = endPos + 3;
+            continue;
+        }
+        if (bytesStartWith(data, dataSize, pos, "<![CDATA[")) {
+            const int64_t endPos = findBytes(data, dataSize, pos + 9, "]]>");
+            if (endPos < 0) return false;
+            pos = endPos + 3;
+            continue;
+        }
+        if (bytesStartWith(data, dataSize, pos, "<?")) {
+            const int64_t endPos = findBytes(data, dataSize, pos + 2, "?>");
+            if (endPos < 0) return false;
+            if (bytesStartWith(data, dataSize, pos, "<?xml")) {
+                /*
+                 * Byte offsets are only meaningful for parsing as UTF-8
+                 */
+                AString encoding;
+                if (getAttributeValue(data + pos, endPos - pos, "encoding", encoding)) {
+                    if (encoding.toLower() != "utf-8") return false;
+                }
+            }
+            pos = endPos + 2;
+            continue;
+        }
+        if (bytesStartWith(data, dataSize, pos, "<!")) {
+            return false;//DTD may declare entities that parts of the file use
+        }
+
+        int32_t elementDepth = -1;
+        int64_t elementEnd = -1;
+        if (bytesStartWith(data, dataSize, pos, "</")) {
+            const char* tagEnd = static_cast<const char*>(memchr(data + pos, '>', dataSize - pos));
+            if (tagEnd == NULL) return false;
+            --depth;
+            if (depth < 0) return false;
+            elementDepth = depth;
+            elementEnd = (tagEnd - data) + 1;
+        }
+        else {
+            /*
+             * Start tag, '>' may be inside of attribute values
+             */
+            int64_t i = pos + 1;
+            char quote = 0;
+            for (; i < dataSize; ++i) {
+                const char c = data[i];
+                if (quote != 0) {
+                    if (c == quote) quote = 0;
+                }
+                else if (c == '"' || c == '\'') {
+                    quote = c;
+                }
+                else if (c == '>') {
+                    break;
+                }
+            }
+            if (i >= dataSize) return false;
+            const int64_t tagLength = i + 1 - pos;
+            const bool selfClosingFlag = (data[i - 1] == '/');
+            int64_t nameEnd = pos + 1;
+            while (nameEnd < i && ! isXmlSpace(data[nameEnd]) && data[nameEnd] != '/') ++nameEnd;
+            const QByteArray name = QByteArray::fromRawData(data + pos + 1, nameEnd - pos - 1);
+
+            if (depth == 0) {
+                if (rootFoundFlag) return false;
+                rootFoundFlag = true;
+            }
+            else if (depth == 1) {
+                if (name == sceneTag) {
+                    SceneEntry scene;
+                    scene.m_range.m_offset = pos;
+                    scene.m_startTag = QByteArray(data + pos, tagLength);
+                    getAttributeValue(data + pos, tagLength, SceneXmlElements::SCENE_TYPE_ATTRIBUTE, scene.m_sceneTypeName);
+                    m_scenes.push_back(scene);
+                    sceneIndex = m_scenes.size() - 1;
+                }
+                else if (name == infoDirectoryTag) {
+                    infoDirectoryFoundFlag = true;
+                    inInfoDirectoryFlag = true;
+                }
+            }
+            else if (depth == 2) {
+                if (sceneIndex >= 0) {
+                    if (name == objectTag) {
+                        ClassEntry classEntry;
+                        classEntry.m_range.m_offset = pos;
+                        getAttributeValue(data + pos, tagLength, SceneXmlElements::OBJECT_NAME_ATTRIBUTE, classEntry.m_name);
+                        getAttributeValue(data + pos, tagLength, SceneXmlElements::OBJECT_CLASS_ATTRIBUTE, classEntry.m_className);
+                        m_scenes[sceneIndex].m_classes.push_back(classEntry);
+                        classIndex = m_scenes[sceneIndex].m_classes.size() - 1;
+                    }
+                    else if ((name != sceneNameTag)
+                             && (name != sceneDescriptionTag)) {
+                        return false;//scene reader rejects these, let it report the error
+                    }
+                }
+                else if (inInfoDirectoryFlag
+                         && (name == sceneInfoTag)) {
+                    SceneInfoEntry sceneInfo;
+                    sceneInfo.m_range.m_offset = pos;
+                    sceneInfo.m_startTag = QByteArray(data + pos, tagLength);
+                    AString indexText;
+                    if ( ! getAttributeValue(data + pos, tagLength, SceneXmlElements::SCENE_INFO_INDEX_ATTRIBUTE, indexText)) {
+                        return false;
+                    }
+                    bool validFlag = false;
+                    sceneInfo.m_sceneIndex = indexText.trimmed().toInt(&validFlag);
+                    if ( ! validFlag) return false;
+                    m_sceneInfos.push_back(sceneInfo);
+                    sceneInfoIndex = m_sceneInfos.size() - 1;
+                }
+            }
+            else if (depth == 3) {
+                if ((sceneInfoIndex >= 0)
+                    && (name == imageTag)) {
+                    if (m_sceneInfos[sceneInfoIndex].m_imageRange.m_length > 0) {
+                        return false;//more than one image
+                    }
+                    m_sceneInfos[sceneInfoIndex].m_imageRange.m_offset = pos;
+                    inImageFlag = true;
+                }
+            }
+
+            if (selfClosingFlag) {
+                elementDepth = depth;
+                elementEnd = pos + tagLength;
+            }
+            else {
+                ++depth;
+                pos += tagLength;
+                continue;
+            }
+        }
+
+        /*
+         * An element ended
+         */
+        CaretAssert(elementDepth >= 0);
+        if (elementDepth == 3) {
+            if (inImageFlag) {
+                SceneInfoEntry& sceneInfo = m_sceneInfos[sceneInfoIndex];
+                sceneInfo.m_imageRange.m_length = elementEnd - sceneInfo.m_imageRange.m_offset;
+                inImageFlag = false;
+            }
+        }
+        else if (elementDepth == 2) {
+            if (classIndex >= 0) {
+                ClassEntry& classEntry = m_scenes[sceneIndex].m_classes[classIndex];
+                classEntry.m_range.m_length = elementEnd - classEntry.m_range.m_offset;
+                classIndex = -1;
+            }
+            else if (sceneInfoIndex >= 0) {
+                SceneInfoEntry& sceneInfo = m_sceneInfos[sceneInfoIndex];
+                sceneInfo.m_range.m_length = elementEnd - sceneInfo.m_range.m_offset;
+                sceneInfoIndex = -1;
+            }
+        }
+        else if (elementDepth == 1) {
+            if (sceneIndex >= 0) {
+                SceneEntry& scene = m_scenes[sceneIndex];
+                scene.m_range.m_length = elementEnd - scene.m_range.m_offset;
+                sceneIndex = -1;
+            }
+            inInfoDirectoryFlag = false;
+        }
+        else if (elementDepth == 0) {
+            rootClosedFlag = true;
+        }
+        pos = elementEnd;
+    }
+
+    if (( ! rootFoundFlag)
+        || ( ! rootClosedFlag)
+        || ( ! infoDirectoryFoundFlag)
+        || (depth != 0)) {
+        return false;
+    }
+
+    /*
+     * Older files have the scene names only in the scenes, so every scene
+     * needs exactly one scene info
+     */
+    const int32_t numberOfScenes = m_scenes.size();
+    std::vector<bool> sceneHasInfo(numberOfScenes, false);
+    for (std::vector<SceneInfoEntry>::const_iterator iter = m_sceneInfos.begin();
+         iter != m_sceneInfos.end();
+         iter++) {
+        const int32_t infoSceneIndex = iter->m_sceneIndex;
+        if ((infoSceneIndex < 0)
+            || (infoSceneIndex >= numberOfScenes)
+            || sceneHasInfo[infoSceneIndex]) {
+            return false;
+        }
+        sceneHasInfo[infoSceneIndex] = true;
+    }
+    if (std::find(sceneHasInfo.begin(), sceneHasInfo.end(), false) != sceneHasInfo.end()) {
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Get the value of an attribute from the bytes of a start tag.
+ *
+ * @param tag
+ *    The start tag, beginning with '<'.
+ * @param tagLength
+ *    Number of bytes in the tag.
+ * @param attributeName
+ *    Name of the attribute.
+ * @param valueOut
+ *    Output with the decoded value of the attribute.
+ * @return
+ *    True if the attribute was found.
+ */
+bool
+SceneXmlIndex::getAttributeValue(const char* tag,
+                                 const int64_t tagLength,
+                                 const AString& attributeName,
+                                 AString& valueOut)
+{
+    const QByteArray attributeNameBytes = attributeName.toUtf8();
+    int64_t i = 1;
+    while (i < tagLength && ! isXmlSpace(tag[i]) && tag[i] != '>' && tag[i] != '/') ++i;
+    while (i < tagLength) {
+        while (i < tagLength && isXmlSpace(tag[i])) ++i;
+        const int64_t nameStart = i;
+        while (i < tagLength && tag[i] != '=' && ! isXmlSpace(tag[i]) && tag[i] != '>' && tag[i] != '/') ++i;
+        const int64_t nameEnd = i;
+        while (i < tagLength && isXmlSpace(tag[i])) ++i;
+        if (i >= tagLength || tag[i] != '=') {
+            ++i;
+            continue;
+        }
+        ++i;
+        while (i < tagLength && isXmlSpace(tag[i])) ++i;
+        if (i >= tagLength) break;
+        const char quote = tag[i];
+        if (quote != '"' && quote != '\'') return false;
+        ++i;
+        const int64_t valueStart = i;
+        while (i < tagLength && tag[i] != quote) ++i;
+        if (i >= tagLength) return false;
+        if (QByteArray::fromRawData(tag + nameStart, nameEnd - nameStart) == attributeNameBytes) {
+            valueOut = XmlUtilities::decodeXmlSpecialCharacters(QString::fromUtf8(tag + valueStart, static_cast<int>(i - valueStart)));
+            return true;
+        }
+        ++i;
+    }
+    return false;
+}
+
+/**
+ * @return The scene at the given index.
+ * @param sceneIndex
+ *    Index of the scene.
+ */
+const SceneXmlIndex::SceneEntry&
+SceneXmlIndex::getScene(const int32_t sceneIndex) const
+{
+    CaretAssertVectorIndex(m_scenes, sceneIndex);
+    return m_scenes[sceneIndex];
+}
+
+/**
+ * @return The scene info at the given index, in the order of the file.
+ * @param sceneInfoIndex
+ *    Index of the scene info.
+ */
+const SceneXmlIndex::SceneInfoEntry&
+SceneXmlIndex::getSceneInfo(const int32_t sceneInfoIndex) const
+{
+    CaretAssertVectorIndex(m_sceneInfos, sceneInfoIndex);
+    return m_sceneInfos[sceneInfoIndex];
+}
+
+/**
+ * Throw an exception if the file is not the same file that was indexed.
+ */
+void
+SceneXmlIndex::checkFileUnchanged() const
+{
+    QFileInfo fileInfo(m_filename);
+    if (( ! fileInfo.exists())
+        || (fileInfo.size() != m_fileSize)
+        || (fileInfo.lastModified() != m_fileLastModified)) {
+        throw XmlSaxParserException("Scene file "
+                                    + m_filename
+                                    + " was changed after it was read, it must be read again.");
+    }
+}
+
+/**
+ * Read some of the bytes of the file.
+ *
+ * @param range
+ *    Range of bytes.
+ * @param bytesOut
+ *    Output with the bytes.
+ * @throw XmlSaxParserException
+ *    If the file was changed since it was indexed or cannot be read.
+ */
+void
+SceneXmlIndex::readRange(const ByteRange& range,
+                         QByteArray& bytesOut) const
+{
+    readRanges(std::vector<ByteRange>(1, range),
+               bytesOut);
+}
+
+/**
+ * Read several ranges of bytes of the file, one after another.
+ *
+ * @param ranges
+ *    Ranges of bytes, ranges with no bytes are skipped.
+ * @param bytesOut
+ *    Output with the bytes of all of the ranges.
+ * @throw XmlSaxParserException
+ *    If the file was changed since it was indexed or cannot be read.
+ */
+void
+SceneXmlIndex::readRanges(const std::vector<ByteRange>& ranges,
+                          QByteArray& bytesOut) const
+{
+    checkFileUnchanged();
+    QFile file(m_filename);
+    if ( ! file.open(QFile::ReadOnly)) {
+        throw XmlSaxParserException("Unable to open file " + m_filename);
+    }
+
+    int64_t totalLength = 0;
+    for (std::vector<ByteRange>::const_iterator iter = ranges.begin();
+         iter != ranges.end();
+         iter++) {
+        totalLength += std::max(iter->m_length, int64_t(0));
+    }
+    bytesOut.clear();
+    bytesOut.reserve(totalLength);
+
+    for (std::vector<ByteRange>::const_iterator iter = ranges.begin();
+         iter != ranges.end();
+         iter++) {
+        if (iter->m_length <= 0) {
+            continue;
+        }
+        if ( ! file.seek(iter->m_offset)) {
+            throw XmlSaxParserException("Unable to seek in file " + m_filename);
+        }
+        const QByteArray bytes = file.read(iter->m_length);
+        if (bytes.size() != iter->m_length) {
+            throw XmlSaxParserException("Unable to read from file " + m_filename);
+        }
+        bytesOut.append(bytes);
+    }
+}
+
+/**
+ * Read the file without the scenes and scene infos, for reading the
+ * metadata and the other parts of the scene info directory.
+ *
+ * @param bytesOut
+ *    Output with the bytes.
+ * @throw XmlSaxParserException
+ *    If the file was changed since it was indexed or cannot be read.
+ */
+void
+SceneXmlIndex::readFileWithoutScenes(QByteArray& bytesOut) const
+{
+    std::vector<ByteRange> skipRanges;
+    for (std::vector<SceneEntry>::const_iterator iter = m_scenes.begin();
+         iter != m_scenes.end();
+         iter++) {
+        skipRanges.push_back(iter->m_range);
+    }
+    for (std::vector<SceneInfoEntry>::const_iterator iter = m_sceneInfos.begin();
+         iter != m_sceneInfos.end();
+         iter++) {
+        skipRanges.push_back(iter->m_range);
+    }
+    std::sort(skipRanges.begin(),
+              skipRanges.end(),
+              [](const ByteRange& a, const ByteRange& b) { return a.m_offset < b.m_offset; });
+
+    std::vector<ByteRange> keepRanges;
+    ByteRange keepRange;
+    for (std::vector<ByteRange>::const_iterator iter = skipRanges.begin();
+         iter != skipRanges.end();
+         iter++) {
+        keepRange.m_length = iter->m_offset - keepRange.m_offset;
+        keepRanges.push_back(keepRange);
+        keepRange.m_offset = iter->m_offset + iter->m_length;
+    }
+    keepRange.m_length = m_fileSize - keepRange.m_offset;
+    keepRanges.push_back(keepRange);
+
+    readRanges(keepRanges,
+               bytesOut);
+}
+
+/**
+ * Read a scene info without its image.
+ *
+ * @param sceneInfoIndex
+ *    Index of the scene info.
+ * @param bytesOut
+ *    Output with the bytes.
+ * @throw XmlSaxParserException
+ *    If the file was changed since it was indexed or cannot be read.
+ */
+void
+SceneXmlIndex::readSceneInfoWithoutImage(const int32_t sceneInfoIndex,
+                                         QByteArray& bytesOut) const
+{
+    const SceneInfoEntry& sceneInfo = getSceneInfo(sceneInfoIndex);
+    if (sceneInfo.m_imageRange.m_length <= 0) {
+        readRange(sceneInfo.m_range,
+                  bytesOut);
+        return;
+    }
+
+    std::vector<ByteRange> keepRanges(2);
+    keepRanges[0].m_offset = sceneInfo.m_range.m_offset;
+    keepRanges[0].m_length = sceneInfo.m_imageRange.m_offset - keepRanges[0].m_offset;
+    keepRanges[1].m_offset = sceneInfo.m_imageRange.m_offset + sceneInfo.m_imageRange.m_length;
+    keepRanges[1].m_length = sceneInfo.m_range.m_offset + sceneInfo.m_range.m_length - keepRanges[1].m_offset;
+
+    readRanges(keepRanges,
+               bytesOut);
+}
@@ -0,0 +1,128 @@
+#ifndef __SCENE_XML_INDEX_H__
+#define __SCENE_XML_INDEX_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <stdint.h>
+#include <vector>
+
+#include <QByteArray>
+#include <QDateTime>
+
+#include "AString.h"
+
+namespace caret {
+
+    /**
+     * Byte offsets of the scenes, their top level classes, and the scene infos
+     * in a scene file, so that each of them can be parsed when it is needed
+     */
+    class SceneXmlIndex {
+
+    public:
+        struct ByteRange {
+            int64_t m_offset;
+            int64_t m_length;
+            ByteRange() : m_offset(0), m_length(0) { }
+        };
+
+        struct ClassEntry {
+            AString m_name;
+            AString m_className;
+            ByteRange m_range;
+        };
+
+        struct SceneEntry {
+            ByteRange m_range;
+            QByteArray m_startTag;
+            AString m_sceneTypeName;
+            std::vector<ClassEntry> m_classes;
+        };
+
+        struct SceneInfoEntry {
+            int32_t m_sceneIndex;
+            ByteRange m_range;
+            QByteArray m_startTag;
+            ByteRange m_imageRange;//zero length when there is no image
+            SceneInfoEntry() : m_sceneIndex(-1) { }
+        };
+
+        SceneXmlIndex();
+
+        virtual ~SceneXmlIndex();
+
+        bool indexFile(const AString& filename);
+
+        /** @return Name of the indexed file */
+        const AString& getFileName() const { return m_filename; }
+
+        /** @return Number of scenes in the file */
+        int32_t getNumberOfScenes() const { return m_scenes.size(); }
+
+        const SceneEntry& getScene(const int32_t sceneIndex) const;
+
+        /** @return Number of scene infos in the file */
+        int32_t getNumberOfSceneInfos() const { return m_sceneInfos.size(); }
+
+        const SceneInfoEntry& getSceneInfo(const int32_t sceneInfoIndex) const;
+
+        void readRange(const ByteRange& range,
+                       QByteArray& bytesOut) const;
+
+        void readFileWithoutScenes(QByteArray& bytesOut) const;
+
+        void readSceneInfoWithoutImage(const int32_t sceneInfoIndex,
+                                       QByteArray& bytesOut) const;
+
+    private:
+        SceneXmlIndex(const SceneXmlIndex&);
+
+        SceneXmlIndex& operator=(const SceneXmlIndex&);
+
+        bool indexBytes(const char* data,
+                        const int64_t dataSize);
+
+        void checkFileUnchanged() const;
+
+        void readRanges(const std::vector<ByteRange>& ranges,
+                        QByteArray& bytesOut) const;
+
+        static bool getAttributeValue(const char* tag,
+                                      const int64_t tagLength,
+                                      const AString& attributeName,
+                                      AString& valueOut);
+
+        AString m_filename;
+
+        int64_t m_fileSize;
+
+        QDateTime m_fileLastModified;
+
+        std::vector<SceneEntry> m_scenes;
+
+        std::vector<SceneInfoEntry> m_sceneInfos;
+
+        // ADD_NEW_MEMBERS_HERE
+
+    };
+
+} // namespace
+#endif  //__SCENE_XML_INDEX_H__
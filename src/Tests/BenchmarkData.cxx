@@ -0,0 +1,92 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "BenchmarkData.h"
+
+#include "AlgorithmSurfaceCreateSphere.h"
+#include "CiftiFile.h"
+#include "StructureEnum.h"
+#include "SurfaceFile.h"
+#include "VolumeFile.h"
+
+#include <random>
+
+using namespace caret;
+using namespace std;
+
+void BenchmarkData::fillRandom(vector<float>& dataOut, const int64_t& count, const uint32_t& seed, const float& minimum, const float& maximum)
+{
+    mt19937 myGen(seed);
+    uniform_real_distribution<float> myDist(minimum, maximum);
+    dataOut.resize(count);
+    for (int64_t i = 0; i < count; ++i)
+    {
+        dataOut[i] = myDist(myGen);
+    }
+}
+
+void BenchmarkData::makeSphere(const int& numVertices, SurfaceFile* sphereOut)
+{
+    AlgorithmSurfaceCreateSphere(NULL, numVertices, sphereOut);
+    sphereOut->setStructure(StructureEnum::CORTEX_LEFT);
+}
+
+void BenchmarkData::makeDenseTimeseries(const int64_t& verticesPerHemisphere, const int64_t& numTimepoints, CiftiFile* ciftiOut)
+{
+    CiftiBrainModelsMap myDenseMap;
+    myDenseMap.addSurfaceModel(verticesPerHemisphere, StructureEnum::CORTEX_LEFT);
+    myDenseMap.addSurfaceModel(verticesPerHemisphere, StructureEnum::CORTEX_RIGHT);
+    CiftiXML myXML;
+    myXML.setNumberOfDimensions(2);
+    myXML.setMap(CiftiXML::ALONG_COLUMN, myDenseMap);
+    myXML.setMap(CiftiXML::ALONG_ROW, CiftiSeriesMap(numTimepoints, 0.0f, 0.72f));
+    ciftiOut->setCiftiXML(myXML);
+    vector<float> rowData;
+    const int64_t numRows = myDenseMap.getLength();
+    for (int64_t i = 0; i < numRows; ++i)
+    {
+        fillRandom(rowData, numTimepoints, (uint32_t)i, -1.0f, 1.0f);
+        ciftiOut->setRow(rowData.data(), i);
+    }
+}
+
+void BenchmarkData::makeVolume4D(const int64_t& dimension, const int64_t& numFrames, VolumeFile* volumeOut)
+{
+    vector<int64_t> myDims(4, dimension);
+    myDims[3] = numFrames;
+    vector<vector<float> > mySform(3, vector<float>(4, 0.0f));
+    for (int i = 0; i < 3; ++i)
+    {
+        mySform[i][i] = 2.0f;
+        mySform[i][3] = -dimension;//center the volume on the origin
+    }
+    volumeOut->reinitialize(myDims, mySform);
+    const int64_t frameSize = dimension * dimension * dimension;
+    vector<float> frame;
+    for (int64_t f = 0; f < numFrames; ++f)
+    {
+        fillRandom(frame, frameSize, (uint32_t)f);
+        for (int64_t i = 0; i < frameSize; ++i)
+        {
+            frame[i] += 100.0f * (i % dimension) / dimension;//a gradient, so the data compresses like images do rather than like noise
+        }
+        volumeOut->setFrame(frame.data(), f);
+    }
+}
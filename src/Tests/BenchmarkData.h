@@ -0,0 +1,51 @@
+#ifndef __BENCHMARK_DATA_H__
+#define __BENCHMARK_DATA_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <stdint.h>
+#include <vector>
+
+namespace caret {
+
+    class CiftiFile;
+    class SurfaceFile;
+    class VolumeFile;
+
+    ///synthetic inputs for benchmarks, generated from a fixed seed so that runs on different builds see the same data
+    class BenchmarkData
+    {
+        BenchmarkData();
+    public:
+        static void fillRandom(std::vector<float>& dataOut, const int64_t& count, const uint32_t& seed, const float& minimum = 0.0f, const float& maximum = 1.0f);
+
+        ///divided icosahedron with radius 100, as made by -surface-create-sphere
+        static void makeSphere(const int& numVertices, SurfaceFile* sphereOut);
+
+        ///in-memory dense timeseries with left and right cortex of the given number of vertices each, rows are brainordinates
+        static void makeDenseTimeseries(const int64_t& verticesPerHemisphere, const int64_t& numTimepoints, CiftiFile* ciftiOut);
+
+        ///cube of 2mm voxels, random values added to a gradient
+        static void makeVolume4D(const int64_t& dimension, const int64_t& numFrames, VolumeFile* volumeOut);
+    };
+
+}
+#endif //__BENCHMARK_DATA_H__
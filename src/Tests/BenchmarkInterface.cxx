@@ -0,0 +1,92 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "BenchmarkInterface.h"
+
+#include "CaretException.h"
+#include "ElapsedTimer.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryFile>
+
+#include <algorithm>
+#include <iostream>
+
+using namespace caret;
+using namespace std;
+
+double BenchmarkInterface::s_minimumSeconds = 1.0;
+int64_t BenchmarkInterface::s_problemScale = 1;
+
+void BenchmarkInterface::measure(const AString& caseName, const AString& unitName, const double& unitsPerRun, const function<void()>& runFunction)
+{
+    const int64_t MIN_RUNS = 3;
+    runFunction();//warm caches and lazy initialization
+    ElapsedTimer totalTimer, runTimer;
+    totalTimer.start();
+    Result thisResult;
+    thisResult.m_benchmark = getIdentifier();
+    thisResult.m_case = caseName;
+    thisResult.m_unit = unitName;
+    thisResult.m_unitsPerRun = unitsPerRun;
+    thisResult.m_runs = 0;
+    thisResult.m_bestSeconds = -1.0;
+    double totalSeconds = 0.0;
+    while (thisResult.m_runs < MIN_RUNS || totalTimer.getElapsedTimeSeconds() < s_minimumSeconds)
+    {
+        runTimer.start();
+        runFunction();
+        double elapsed = runTimer.getElapsedTimeSeconds();
+        totalSeconds += elapsed;
+        if (thisResult.m_bestSeconds < 0.0 || elapsed < thisResult.m_bestSeconds) thisResult.m_bestSeconds = elapsed;
+        ++thisResult.m_runs;
+    }
+    thisResult.m_bestSeconds = max(thisResult.m_bestSeconds, 1e-9);//timer resolution, don't divide by zero
+    thisResult.m_meanSeconds = totalSeconds / thisResult.m_runs;
+    m_results.push_back(thisResult);
+    cout << getIdentifier() << " " << caseName << ": " << thisResult.m_bestSeconds * 1000.0 << " ms best, " << thisResult.m_meanSeconds * 1000.0 << " ms mean of "
+         << thisResult.m_runs << " runs, " << thisResult.getThroughput() << " " << unitName << "/s" << endl;
+}
+
+void BenchmarkInterface::measureWithScratchFile(const AString& extension, const function<void(const AString&, const bool&)>& fileCases)
+{
+    QTemporaryFile reserved(getScratchDirectory() + "/wb_benchmark_XXXXXX" + extension);
+    if (!reserved.open())
+    {
+        throw CaretException("unable to create a scratch file in '" + getScratchDirectory() + "'");
+    }
+    reserved.close();//the name stays reserved until reserved is destroyed, which also removes the file
+    const AString fileName = reserved.fileName(), gzFileName = fileName + ".gz";//unique because fileName is
+    fileCases(fileName, false);
+    QFile(fileName).resize(0);//free the space, but keep the name
+    try
+    {
+        fileCases(gzFileName, true);
+    } catch (CaretException& e) {
+        cout << "skipping gzip, " << e.whatString() << endl;
+    }
+    QFile::remove(gzFileName);
+}
+
+AString BenchmarkInterface::getScratchDirectory()
+{
+    return QDir::tempPath();
+}
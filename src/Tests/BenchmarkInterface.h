@@ -0,0 +1,71 @@
+#ifndef __BENCHMARK_INTERFACE_H__
+#define __BENCHMARK_INTERFACE_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "TestInterface.h"
+
+#include <functional>
+#include <stdint.h>
+#include <vector>
+
+namespace caret {
+
+   ///timing harness for the benchmark driver, execute() calls measure() once per case
+   class BenchmarkInterface : public TestInterface
+   {
+   public:
+      struct Result
+      {
+         AString m_benchmark, m_case, m_unit;
+         int64_t m_runs;
+         double m_bestSeconds, m_meanSeconds, m_unitsPerRun;
+         double getThroughput() const { return m_unitsPerRun / m_bestSeconds; }//units per second, of the fastest run
+      };
+   private:
+      std::vector<Result> m_results;
+      static double s_minimumSeconds;
+      static int64_t s_problemScale;
+   protected:
+      BenchmarkInterface(const AString& identifier) : TestInterface(identifier) { }
+
+      ///runs the function once untimed, then repeatedly until the minimum time is used, with at least 3 timed runs
+      ///unitsPerRun is the amount of work per run (bytes, vertices, etc), for reporting throughput
+      void measure(const AString& caseName, const AString& unitName, const double& unitsPerRun, const std::function<void()>& runFunction);
+
+      ///calls fileCases with a unique file name in the scratch directory ending in extension (like ".dtseries.nii"), then with that name plus ".gz"
+      ///(the gzip flag), skipping the gzip cases if they throw, and removes both files afterwards - concurrent runs never share a file
+      void measureWithScratchFile(const AString& extension, const std::function<void(const AString& fileName, const bool& gzip)>& fileCases);
+   public:
+      const std::vector<Result>& getResults() const { return m_results; }
+
+      ///minimum time to spend on each case, in seconds
+      static void setMinimumSeconds(const double& seconds) { s_minimumSeconds = seconds; }
+
+      ///multiplier on the size of the synthetic data, 1 is sized to run all benchmarks in a few minutes
+      static void setProblemScale(const int64_t& scale) { s_problemScale = scale; }
+      static int64_t getProblemScale() { return s_problemScale; }
+
+      ///directory for temporary files written by I/O benchmarks
+      static AString getScratchDirectory();
+   };
+
+}
+#endif //__BENCHMARK_INTERFACE_H__
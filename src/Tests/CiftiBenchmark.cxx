@@ -0,0 +1,83 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CiftiBenchmark.h"
+
+#include "BenchmarkData.h"
+#include "CiftiFile.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+CiftiBenchmark::CiftiBenchmark(const AString& identifier) : BenchmarkInterface(identifier)
+{
+}
+
+namespace
+{
+    void readAllRows(const CiftiFile& myCifti)
+    {
+        const int64_t numRows = myCifti.getNumberOfRows();
+        vector<float> scratch(myCifti.getNumberOfColumns());
+        for (int64_t i = 0; i < numRows; ++i)
+        {
+            myCifti.getRow(scratch.data(), i);
+        }
+    }
+    
+    void readColumns(const CiftiFile& myCifti, const int64_t& numColumns)
+    {
+        const int64_t stride = max(int64_t(1), myCifti.getNumberOfColumns() / numColumns);
+        vector<float> scratch(myCifti.getNumberOfRows());
+        for (int64_t i = 0; i < numColumns; ++i)
+        {
+            myCifti.getColumn(scratch.data(), (i * stride) % myCifti.getNumberOfColumns());
+        }
+    }
+}
+
+void CiftiBenchmark::execute()
+{
+    const int64_t VERTICES = 10242, TIMEPOINTS = 600 * getProblemScale(), DISK_COLUMNS = 8;
+    CiftiFile memCifti;
+    BenchmarkData::makeDenseTimeseries(VERTICES, TIMEPOINTS, &memCifti);
+    const double matrixBytes = 4.0 * memCifti.getNumberOfRows() * memCifti.getNumberOfColumns();
+    const double columnBytes = 4.0 * memCifti.getNumberOfRows();
+    measure("memory row read", "bytes", matrixBytes, [&]() { readAllRows(memCifti); });
+    measure("memory column read", "bytes", matrixBytes, [&]() { readColumns(memCifti, memCifti.getNumberOfColumns()); });
+    measureWithScratchFile(".dtseries.nii", [&](const AString& fileName, const bool& gzip)
+    {
+        if (gzip)
+        {
+            measure("gzip write", "bytes", matrixBytes, [&]() { memCifti.writeFile(fileName); });
+            CiftiFile gzCifti(fileName);
+            measure("gzip row read", "bytes", matrixBytes, [&]() { readAllRows(gzCifti); });
+            return;
+        }
+        measure("write", "bytes", matrixBytes, [&]() { memCifti.writeFile(fileName); });
+        CiftiFile diskCifti(fileName);
+        measure("on-disk row read", "bytes", matrixBytes, [&]() { readAllRows(diskCifti); });
+        measure("on-disk column read", "bytes", columnBytes * DISK_COLUMNS, [&]() { readColumns(diskCifti, DISK_COLUMNS); });
+        measure("open and load into memory", "bytes", matrixBytes, [&]() { CiftiFile loadCifti(fileName); loadCifti.convertToInMemory(); });
+    });
+}
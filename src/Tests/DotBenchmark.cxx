@@ -0,0 +1,62 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "DotBenchmark.h"
+
+#include "BenchmarkData.h"
+#include "dot_wrapper.h"
+
+#include <iostream>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+DotBenchmark::DotBenchmark(const AString& identifier) : BenchmarkInterface(identifier)
+{
+}
+
+void DotBenchmark::execute()
+{
+    const int ROWSIZE = 1200, NUMROWS = 2048 * (int)getProblemScale();//timeseries-length rows, like correlating a seed against a dtseries
+    vector<float> seed, rows;
+    BenchmarkData::fillRandom(seed, ROWSIZE, 1);
+    BenchmarkData::fillRandom(rows, (int64_t)ROWSIZE * NUMROWS, 2);
+    vector<double> results(NUMROWS);
+    vector<DotSIMDEnum::Enum> allImpls = DotSIMDEnum::getAllEnums();
+    for (int i = 0; i < (int)allImpls.size(); ++i)
+    {
+        if (allImpls[i] == DOT_AUTO) continue;//same as one of the others
+        dot_flags impl_in_use = dot_set_impl(allImpls[i]);
+        if (impl_in_use != allImpls[i])
+        {
+            cout << "skipping " << DotSIMDEnum::toName(allImpls[i]) << ", not supported" << endl;
+            continue;
+        }
+        measure(DotSIMDEnum::toName(allImpls[i]), "flops", 2.0 * ROWSIZE * NUMROWS, [&]()
+                {
+                    for (int j = 0; j < NUMROWS; ++j)
+                    {
+                        results[j] = dsdot(seed.data(), rows.data() + (int64_t)j * ROWSIZE, ROWSIZE);
+                    }
+                });
+    }
+    dot_set_impl(DOT_AUTO);
+}
@@ -0,0 +1,59 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "MathExpressionBenchmark.h"
+
+#include "BenchmarkData.h"
+#include "CaretMathExpression.h"
+
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+MathExpressionBenchmark::MathExpressionBenchmark(const AString& identifier) : BenchmarkInterface(identifier)
+{
+}
+
+void MathExpressionBenchmark::execute()
+{
+    const int64_t NUM_ELEMENTS = 1000000 * getProblemScale();
+    const AString EXPRESSION = "(x - mean) / stdev * (x > 0.1) + exp(-y ^ 2 / 2) * sin(3 * PI * y)";
+    measure("parse", "expressions", 1.0, [&]() { CaretMathExpression myExpr(EXPRESSION); });
+    CaretMathExpression myExpr(EXPRESSION);
+    vector<AString> varNames = myExpr.getVarNames();
+    vector<vector<float> > varData(varNames.size());
+    for (int i = 0; i < (int)varNames.size(); ++i)
+    {
+        BenchmarkData::fillRandom(varData[i], NUM_ELEMENTS, (uint32_t)i, 0.5f, 1.5f);//positive so stdev makes sense
+    }
+    vector<float> values(varNames.size()), result(NUM_ELEMENTS);
+    measure("evaluate", "elements", NUM_ELEMENTS, [&]()
+            {
+                for (int64_t i = 0; i < NUM_ELEMENTS; ++i)
+                {
+                    for (int j = 0; j < (int)varNames.size(); ++j)
+                    {
+                        values[j] = varData[j][i];
+                    }
+                    result[i] = myExpr.evaluate(values);
+                }
+            });
+}
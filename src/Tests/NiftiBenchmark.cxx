@@ -0,0 +1,66 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "NiftiBenchmark.h"
+
+#include "BenchmarkData.h"
+#include "NiftiIO.h"
+#include "VolumeFile.h"
+
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+NiftiBenchmark::NiftiBenchmark(const AString& identifier) : BenchmarkInterface(identifier)
+{
+}
+
+namespace
+{
+    void readAllFrames(const AString& fileName)
+    {
+        NiftiIO myIO;
+        myIO.openRead(fileName);
+        const vector<int64_t>& myDims = myIO.getDimensions();
+        vector<float> frame(myDims[0] * myDims[1] * myDims[2] * myIO.getNumComponents());
+        vector<int64_t> indexSelect(myDims.size() - 3, 0);
+        for (int64_t f = 0; f < myDims[3]; ++f)
+        {
+            indexSelect[0] = f;
+            myIO.readData(frame.data(), 3, indexSelect);
+        }
+    }
+}
+
+void NiftiBenchmark::execute()
+{
+    const int64_t DIMENSION = 91, FRAMES = 50 * getProblemScale();
+    VolumeFile myVol;
+    BenchmarkData::makeVolume4D(DIMENSION, FRAMES, &myVol);
+    const double volumeBytes = 4.0 * DIMENSION * DIMENSION * DIMENSION * FRAMES;
+    measureWithScratchFile(".nii", [&](const AString& fileName, const bool& gzip)
+    {
+        const AString prefix = (gzip ? "gzip " : "");
+        measure(prefix + "write", "bytes", volumeBytes, [&]() { myVol.writeFile(fileName); });
+        measure(prefix + "frame read", "bytes", volumeBytes, [&]() { readAllFrames(fileName); });
+        measure(prefix + "volume file read", "bytes", volumeBytes, [&]() { VolumeFile readVol; readVol.readFile(fileName); });
+    });
+}
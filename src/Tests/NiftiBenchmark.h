@@ -0,0 +1,36 @@
+#ifndef __NIFTI_BENCHMARK_H__
+#define __NIFTI_BENCHMARK_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "BenchmarkInterface.h"
+
+namespace caret {
+
+    ///reading 4D volumes with NiftiIO, uncompressed and gzipped, by frame and whole file
+    class NiftiBenchmark : public BenchmarkInterface
+    {
+    public:
+        NiftiBenchmark(const AString& identifier);
+        virtual void execute();
+    };
+
+}
+#endif //__NIFTI_BENCHMARK_H__
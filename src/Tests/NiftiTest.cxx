@@ -20,9 +20,15 @@
 
 #include "NiftiTest.h"
 
+#include "CiftiFile.h"
 #include "MultiDimIterator.h"
 #include "NiftiIO.h"
 
+#include <QDir>
+#include <QTemporaryFile>
+
+#include <cmath>
+#include <random>
 #include <vector>
 
 using namespace std;
@@ -159,3 +165,243 @@ void NiftiHeaderTest::writeNifti2Header(AString filename, NiftiHeader &header)
     myFile.open(filename, CaretBinaryFile::WRITE_TRUNCATE);
     header.write(myFile, 2);
 }
+
+//Tests for the block compressed payload
+
+namespace
+{
+    //smooth enough to compress, with noise so that blocks aren't identical
+    void makeTestData(vector<float>& dataOut, const int64_t& count, const uint32_t& seed)
+    {
+        mt19937 myGen(seed);
+        uniform_real_distribution<float> myDist(-1.0f, 1.0f);
+        dataOut.resize(count);
+        for (int64_t i = 0; i < count; ++i)
+        {
+            dataOut[i] = myDist(myGen) + 0.01f * (i % 997);
+        }
+    }
+}
+
+NiftiBlockCompressTest::NiftiBlockCompressTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void NiftiBlockCompressTest::execute()
+{
+    QTemporaryFile reserved(QDir::tempPath() + "/wb_test_XXXXXX.nii");
+    if (!reserved.open())
+    {
+        setFailed("unable to create a temporary file in '" + QDir::tempPath() + "'");
+        return;
+    }
+    reserved.close();//the name stays reserved until reserved is destroyed, which also removes the file
+    const AString fileName = reserved.fileName();
+    bool wasEnabled = CiftiFile::isCompressedWritingEnabled();
+    CiftiFile::setCompressedWritingEnabled(true);
+    try
+    {
+        testCompressedCifti(fileName);
+    } catch (CaretException& e) {
+        setFailed("caught exception testing compressed cifti: " + e.whatString());
+    }
+    CiftiFile::setCompressedWritingEnabled(wasEnabled);
+    if (failed()) return;
+    try
+    {
+        testCompressedVolume(fileName);
+    } catch (CaretException& e) {
+        setFailed("caught exception testing compressed volume: " + e.whatString());
+    }
+}
+
+void NiftiBlockCompressTest::testCompressedCifti(const AString& fileName)
+{
+    //CiftiFile puts 262 rows of this length in each block, so the third block is only partly filled
+    const int64_t rowLength = 1000, numRows = 600;
+    CiftiXML myXML;
+    myXML.setNumberOfDimensions(2);
+    myXML.setMap(CiftiXML::ALONG_COLUMN, CiftiSeriesMap(numRows));
+    myXML.setMap(CiftiXML::ALONG_ROW, CiftiSeriesMap(rowLength));
+    vector<float> data;
+    makeTestData(data, rowLength * numRows, 1);
+    {
+        CiftiFile writer;
+        writer.setCiftiXML(myXML);
+        for (int64_t i = 0; i < numRows; ++i)
+        {
+            writer.setRow(data.data() + i * rowLength, i);
+        }
+        writer.writeFile(fileName);
+    }
+    {
+        NiftiIO checkLayout;
+        checkLayout.openRead(fileName);
+        if (!checkLayout.isBlockCompressed())
+        {
+            setFailed("cifti file was not written block compressed");
+            return;
+        }
+    }
+    CiftiFile reader(fileName);
+    if (reader.getNumberOfRows() != numRows || reader.getNumberOfColumns() != rowLength)
+    {
+        setFailed("compressed cifti file has the wrong dimensions");
+        return;
+    }
+    vector<float> row(rowLength);
+    for (int64_t i = numRows - 1; i >= 0; --i)//backwards, so that blocks are decoded again after the last one
+    {
+        reader.getRow(row.data(), i);
+        for (int64_t j = 0; j < rowLength; ++j)
+        {
+            if (row[j] != data[i * rowLength + j])
+            {
+                setFailed("compressed cifti row " + AString::number(i) + " doesn't match the data that was written");
+                return;
+            }
+        }
+    }
+    vector<float> column(numRows);
+    reader.getColumn(column.data(), rowLength - 1);
+    for (int64_t i = 0; i < numRows; ++i)
+    {
+        if (column[i] != data[i * rowLength + rowLength - 1])
+        {
+            setFailed("compressed cifti column doesn't match the data that was written");
+            return;
+        }
+    }
+    std::cout << "Compressed cifti round trip was successful." << std::endl;
+}
+
+void NiftiBlockCompressTest::testCompressedVolume(const AString& fileName)
+{
+    //frames of 1001 elements in blocks of 256, so frames straddle blocks and the last block has 187 elements
+    const int64_t blockElements = 256;
+    vector<int64_t> dims(4);
+    dims[0] = 13; dims[1] = 11; dims[2] = 7; dims[3] = 3;
+    const int64_t frameSize = dims[0] * dims[1] * dims[2];
+    vector<float> data;
+    makeTestData(data, frameSize * dims[3], 2);
+    NiftiHeader myHeader;
+    myHeader.setDimensions(dims);
+    myHeader.setDataType(NIFTI_TYPE_FLOAT32);
+    {
+        NiftiIO writer;
+        writer.writeNew(fileName, myHeader, 1, false, false, blockElements);
+        for (int64_t f = 0; f < dims[3]; ++f)
+        {
+            writer.writeData(data.data() + f * frameSize, 3, vector<int64_t>(1, f));
+        }
+        writer.close();
+    }
+    NiftiIO reader;
+    reader.openRead(fileName);
+    if (!reader.isBlockCompressed())
+    {
+        setFailed("volume file was not written block compressed");
+        return;
+    }
+    if (reader.getDimensions() != dims)
+    {
+        setFailed("compressed volume file has the wrong dimensions");
+        return;
+    }
+    vector<float> frame(frameSize);
+    for (int64_t f = dims[3] - 1; f >= 0; --f)
+    {
+        reader.readData(frame.data(), 3, vector<int64_t>(1, f));
+        for (int64_t i = 0; i < frameSize; ++i)
+        {
+            if (frame[i] != data[f * frameSize + i])
+            {
+                setFailed("compressed volume frame " + AString::number(f) + " doesn't match the data that was written");
+                return;
+            }
+        }
+    }
+    vector<float> allFrames(data.size());
+    reader.readData(allFrames.data(), 4, vector<int64_t>());
+    if (allFrames != data)
+    {
+        setFailed("compressed volume doesn't match the data that was written when read all at once");
+        return;
+    }
+    std::cout << "Compressed volume round trip was successful." << std::endl;
+}
+
+//Tests for 16-bit float storage
+
+NiftiHalfFloatTest::NiftiHalfFloatTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void NiftiHalfFloatTest::execute()
+{
+    QTemporaryFile reserved(QDir::tempPath() + "/wb_test_XXXXXX.nii");
+    if (!reserved.open())
+    {
+        setFailed("unable to create a temporary file in '" + QDir::tempPath() + "'");
+        return;
+    }
+    reserved.close();//the name stays reserved until reserved is destroyed, which also removes the file
+    try
+    {
+        testFormat(reserved.fileName(), NiftiHalfFloat::FLOAT16, 1.0f / 2048);
+        if (failed()) return;
+        testFormat(reserved.fileName(), NiftiHalfFloat::BFLOAT16, 1.0f / 256);
+    } catch (CaretException& e) {
+        setFailed("caught exception testing 16-bit floats: " + e.whatString());
+    }
+}
+
+void NiftiHalfFloatTest::testFormat(const AString& fileName, const NiftiHalfFloat::Format& format, const float& relativeError)
+{
+    const AString formatName = (format == NiftiHalfFloat::BFLOAT16 ? "bfloat16" : "float16");
+    //the last three are beyond the largest float16, 65504, so they should come back as infinity in that format (and warn when written)
+    const float values[] = { 0.0f, 1.0f, -2.25f, 0.1f, 3.14159f, -1000.5f, 1e-3f, 65504.0f, 65519.0f, 65520.0f, 70000.0f, -1e6f };
+    const int numValues = sizeof(values) / sizeof(values[0]);
+    const float FLOAT16_MAX = 65504.0f;
+    vector<float> data(values, values + numValues);
+    vector<int64_t> dims(3, 1);
+    dims[0] = numValues;
+    NiftiHeader myHeader;
+    myHeader.setDimensions(dims);
+    NiftiHalfFloat::setHeaderFormat(myHeader, format);
+    {
+        NiftiIO writer;
+        writer.writeNew(fileName, myHeader);
+        writer.writeData(data.data(), 3, vector<int64_t>());
+        writer.close();
+    }
+    NiftiIO reader;
+    reader.openRead(fileName);
+    if (reader.getHalfFormat() != format)
+    {
+        setFailed(formatName + " file was read back with the wrong 16-bit float format");
+        return;
+    }
+    vector<float> result(numValues);
+    reader.readData(result.data(), 3, vector<int64_t>());
+    for (int i = 0; i < numValues; ++i)
+    {
+        //rounding to nearest can go a little past the largest value before it becomes infinity
+        bool saturates = (format == NiftiHalfFloat::FLOAT16 && abs(values[i]) >= FLOAT16_MAX + 16.0f);
+        if (saturates)
+        {
+            if (!std::isinf(result[i]) || (result[i] > 0.0f) != (values[i] > 0.0f))
+            {
+                setFailed(formatName + " value " + AString::number(values[i]) + " was read back as " + AString::number(result[i]) + ", expected infinity with the same sign");
+                return;
+            }
+        } else {
+            if (!(abs(result[i] - values[i]) <= abs(values[i]) * relativeError))
+            {
+                setFailed(formatName + " value " + AString::number(values[i]) + " was read back as " + AString::number(result[i]));
+                return;
+            }
+        }
+    }
+    std::cout << "Reading and writing of " << formatName << " was successful." << std::endl;
+}
@@ -22,6 +22,7 @@
 #define NIFTITEST_H
 
 #include "TestInterface.h"
+#include "NiftiHalfFloat.h"
 #include "NiftiHeader.h"
 
 namespace caret {
@@ -44,6 +45,23 @@ public:
     void writeNifti2Header(AString filename, NiftiHeader &header);
 };
 
+class NiftiBlockCompressTest : public TestInterface
+{
+    void testCompressedCifti(const AString& fileName);
+    void testCompressedVolume(const AString& fileName);
+public:
+    NiftiBlockCompressTest(const AString& identifier);
+    virtual void execute();
+};
+
+class NiftiHalfFloatTest : public TestInterface
+{
+    void testFormat(const AString& fileName, const NiftiHalfFloat::Format& format, const float& relativeError);
+public:
+    NiftiHalfFloatTest(const AString& identifier);
+    virtual void execute();
+};
+
 
 }
 
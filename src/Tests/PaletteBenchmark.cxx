@@ -0,0 +1,69 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "PaletteBenchmark.h"
+
+#include "BenchmarkData.h"
+#include "FastStatistics.h"
+#include "NodeAndVoxelColoring.h"
+#include "Palette.h"
+#include "PaletteColorMapping.h"
+#include "PaletteFile.h"
+
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+PaletteBenchmark::PaletteBenchmark(const AString& identifier) : BenchmarkInterface(identifier)
+{
+}
+
+void PaletteBenchmark::execute()
+{
+    const int64_t NUM_SCALARS = 91282 * getProblemScale();//grayordinates in a standard dense file
+    vector<float> scalars;
+    BenchmarkData::fillRandom(scalars, NUM_SCALARS, 1, -5.0f, 5.0f);
+    PaletteFile myPaletteFile;
+    const Palette* myPalette = myPaletteFile.getPaletteByName(Palette::ROY_BIG_BL_PALETTE_NAME);
+    if (myPalette == NULL)
+    {
+        setFailed("default palette " + Palette::ROY_BIG_BL_PALETTE_NAME + " not found");
+        return;
+    }
+    measure("statistics", "scalars", NUM_SCALARS, [&]() { FastStatistics myStats(scalars.data(), NUM_SCALARS); });
+    FastStatistics myStats(scalars.data(), NUM_SCALARS);
+    PaletteColorMapping myMapping;
+    vector<float> rgbaFloat(NUM_SCALARS * 4);
+    vector<uint8_t> rgbaByte(NUM_SCALARS * 4);
+    measure("color float", "scalars", NUM_SCALARS, [&]()
+            {
+                NodeAndVoxelColoring::colorScalarsWithPalette(&myStats, &myMapping, myPalette, scalars.data(), scalars.data(), NUM_SCALARS, rgbaFloat.data());
+            });
+    measure("color byte", "scalars", NUM_SCALARS, [&]()
+            {
+                NodeAndVoxelColoring::colorScalarsWithPalette(&myStats, &myMapping, myPalette, scalars.data(), scalars.data(), NUM_SCALARS, rgbaByte.data());
+            });
+    myMapping.setThresholdType(PaletteThresholdTypeEnum::THRESHOLD_TYPE_NORMAL);
+    measure("color byte thresholded", "scalars", NUM_SCALARS, [&]()
+            {
+                NodeAndVoxelColoring::colorScalarsWithPalette(&myStats, &myMapping, myPalette, scalars.data(), scalars.data(), NUM_SCALARS, rgbaByte.data());
+            });
+}
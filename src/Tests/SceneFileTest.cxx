@@ -0,0 +1,170 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "SceneFileTest.h"
+
+#include "Scene.h"
+#include "SceneClass.h"
+#include "SceneFile.h"
+#include "SceneFileSaxReader.h"
+#include "SceneInfo.h"
+#include "SceneWriterXml.h"
+#include "SceneXmlIndex.h"
+#include "XmlSaxParser.h"
+#include "XmlWriter.h"
+
+#include <QDir>
+#include <QTemporaryFile>
+#include <QTextStream>
+
+#include <memory>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    //the scene's xml, as it would be written into a scene file, which covers all of its classes
+    AString sceneToXml(const Scene& scene, const int32_t sceneIndex, const AString& fileName)
+    {
+        QString text;
+        {
+            QTextStream stream(&text);
+            XmlWriter xmlWriter(stream);
+            SceneWriterXml sceneWriter(xmlWriter, fileName);
+            sceneWriter.writeScene(scene, sceneIndex);
+            stream.flush();
+        }
+        return text;
+    }
+}
+
+SceneFileTest::SceneFileTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void SceneFileTest::makeSceneFile(SceneFile& sceneFileOut)
+{
+    const int32_t NUM_SCENES = 4;
+    for (int32_t i = 0; i < NUM_SCENES; ++i)
+    {
+        Scene* scene = new Scene(SceneTypeEnum::SCENE_TYPE_FULL);
+        scene->setName("scene " + AString::number(i + 1));
+        scene->setDescription("description with markup characters < & > in scene " + AString::number(i + 1));
+        scene->getSceneInfo()->setBalsaSceneID("id" + AString::number(i));
+        if (i % 2 == 0)
+        {//thumbnails are left in the file by the indexed reading until they are used
+            scene->getSceneInfo()->setImageBytes(QByteArray("not really an image ") + QByteArray::number(i), "png");
+        }
+        for (int32_t c = 0; c <= i; ++c)
+        {//a different number of classes in each scene
+            SceneClass* topClass = new SceneClass("class" + AString::number(c), "TestClass", 1);
+            topClass->addInteger("scene", i);
+            topClass->addFloat("value", 0.5f * c - 1.25f);
+            topClass->addString("text", "<scene>" + AString::number(i) + "</scene>");
+            topClass->addPathName("path", "data/file" + AString::number(c) + ".nii");
+            const float values[] = { 1.0f, -2.5f, 3.25f };
+            topClass->addFloatArray("array", values, 3);
+            SceneClass* child = new SceneClass("child", "TestChildClass", 2);
+            child->addBoolean("flag", (c % 2) == 0);
+            const AString strings[] = { "a", "b & c", "</object>" };
+            child->addStringArray("strings", strings, 3);
+            topClass->addClass(child);
+            scene->addClass(topClass);
+        }
+        sceneFileOut.addScene(scene);
+    }
+}
+
+void SceneFileTest::compareScenes(const Scene& indexed, const Scene& parsed, const int32_t sceneIndex, const AString& fileName)
+{
+    const AString sceneName = "scene " + AString::number(sceneIndex + 1);
+    indexed.loadAllContent();
+    if (indexed.getName() != parsed.getName() || indexed.getDescription() != parsed.getDescription() ||
+        indexed.getBalsaSceneID() != parsed.getBalsaSceneID())
+    {
+        setFailed(sceneName + " has different scene info when read through the index");
+        return;
+    }
+    QByteArray indexedImage, parsedImage;
+    AString indexedFormat, parsedFormat;
+    indexed.getSceneInfo()->getImageBytes(indexedImage, indexedFormat);
+    parsed.getSceneInfo()->getImageBytes(parsedImage, parsedFormat);
+    if (indexedImage != parsedImage || indexedFormat != parsedFormat)
+    {
+        setFailed(sceneName + " has a different thumbnail when read through the index");
+        return;
+    }
+    if (indexed.getNumberOfClasses() != parsed.getNumberOfClasses())
+    {
+        setFailed(sceneName + " has " + AString::number(indexed.getNumberOfClasses()) + " classes when read through the index, but " +
+                  AString::number(parsed.getNumberOfClasses()) + " when parsed");
+        return;
+    }
+    if (sceneToXml(indexed, sceneIndex, fileName) != sceneToXml(parsed, sceneIndex, fileName))
+    {
+        setFailed(sceneName + " has different classes when read through the index");
+    }
+}
+
+void SceneFileTest::execute()
+{
+    QTemporaryFile reserved(QDir::tempPath() + "/wb_test_XXXXXX.scene");
+    if (!reserved.open())
+    {
+        setFailed("unable to create a temporary file in '" + QDir::tempPath() + "'");
+        return;
+    }
+    reserved.close();//the name stays reserved until reserved is destroyed, which also removes the file
+    const AString fileName = reserved.fileName();
+    try
+    {
+        {
+            SceneFile written;
+            makeSceneFile(written);
+            written.writeFile(fileName);
+        }
+        SceneXmlIndex checkIndex;
+        if (!checkIndex.indexFile(fileName))
+        {
+            setFailed("scene file written by workbench can't be indexed, so readFile would not use the index");
+            return;
+        }
+        SceneFile indexed;
+        indexed.readFile(fileName);//uses the index
+        SceneFile parsed;//the full parse that readFile falls back to
+        parsed.setFileName(fileName);
+        SceneFileSaxReader saxReader(&parsed, fileName);
+        unique_ptr<XmlSaxParser> parser(XmlSaxParser::createXmlParser());
+        parser->parseFile(fileName, &saxReader);
+        if (indexed.getNumberOfScenes() != parsed.getNumberOfScenes() || parsed.getNumberOfScenes() != 4)
+        {
+            setFailed("scene file has " + AString::number(indexed.getNumberOfScenes()) + " scenes when read through the index, and " +
+                      AString::number(parsed.getNumberOfScenes()) + " when parsed, expected 4");
+            return;
+        }
+        for (int32_t i = 0; i < parsed.getNumberOfScenes(); ++i)
+        {
+            compareScenes(*indexed.getSceneAtIndex(i), *parsed.getSceneAtIndex(i), i, fileName);
+        }
+    } catch (CaretException& e) {
+        setFailed("caught exception: " + e.whatString());
+    }
+    if (!failed()) std::cout << "Scene file reading through the index matches the full parse." << std::endl;
+}
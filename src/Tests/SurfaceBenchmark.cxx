@@ -0,0 +1,93 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "SurfaceBenchmark.h"
+
+#include "BenchmarkData.h"
+#include "CaretPointer.h"
+#include "GeodesicHelper.h"
+#include "MetricFile.h"
+#include "MetricSmoothingObject.h"
+#include "SurfaceFile.h"
+#include "SurfaceResamplingHelper.h"
+
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+SurfaceBenchmark::SurfaceBenchmark(const AString& identifier) : BenchmarkInterface(identifier)
+{
+}
+
+void SurfaceBenchmark::execute()
+{
+    const int LARGE_VERTICES = 40962, SMALL_VERTICES = 10242, GEO_SEARCHES = 100, SMOOTH_COLUMNS = 10 * (int)getProblemScale();
+    const float GEO_DIST = 10.0f, SMOOTH_KERNEL = 2.0f;//mm, sphere has radius 100
+    SurfaceFile largeSphere, smallSphere;
+    BenchmarkData::makeSphere(LARGE_VERTICES, &largeSphere);
+    BenchmarkData::makeSphere(SMALL_VERTICES, &smallSphere);
+    const int numLarge = largeSphere.getNumberOfNodes(), numSmall = smallSphere.getNumberOfNodes();
+    
+    CaretPointer<GeodesicHelper> myGeoHelp = largeSphere.getGeodesicHelper();
+    vector<int32_t> geoNodes;
+    vector<float> geoDists;
+    measure("geodesic search", "searches", GEO_SEARCHES, [&]()
+            {
+                for (int i = 0; i < GEO_SEARCHES; ++i)
+                {
+                    myGeoHelp->getNodesToGeoDist((int32_t)(((int64_t)i * numLarge) / GEO_SEARCHES), GEO_DIST, geoNodes, geoDists);
+                }
+            });
+    
+    MetricFile myMetric, smoothOut;
+    myMetric.setNumberOfNodesAndColumns(numLarge, SMOOTH_COLUMNS);
+    myMetric.setStructure(StructureEnum::CORTEX_LEFT);
+    vector<float> columnData;
+    for (int i = 0; i < SMOOTH_COLUMNS; ++i)
+    {
+        BenchmarkData::fillRandom(columnData, numLarge, (uint32_t)i);
+        myMetric.setValuesForColumn(i, columnData.data());
+    }
+    measure("smoothing weights", "vertices", numLarge, [&]() { MetricSmoothingObject mySmooth(&largeSphere, SMOOTH_KERNEL); });
+    MetricSmoothingObject mySmooth(&largeSphere, SMOOTH_KERNEL);
+    measure("smoothing", "vertex-maps", (double)numLarge * SMOOTH_COLUMNS, [&]() { mySmooth.smoothMetric(&myMetric, &smoothOut); });
+    
+    vector<float> largeAreas, smallAreas;
+    largeSphere.computeNodeAreas(largeAreas);
+    smallSphere.computeNodeAreas(smallAreas);
+    measure("barycentric weights", "vertices", numSmall, [&]()
+            {
+                SurfaceResamplingHelper myHelp(SurfaceResamplingMethodEnum::BARYCENTRIC, &largeSphere, &smallSphere);
+            });
+    measure("adaptive barycentric weights", "vertices", numSmall, [&]()
+            {
+                SurfaceResamplingHelper myHelp(SurfaceResamplingMethodEnum::ADAP_BARY_AREA, &largeSphere, &smallSphere, largeAreas.data(), smallAreas.data());
+            });
+    SurfaceResamplingHelper myResample(SurfaceResamplingMethodEnum::ADAP_BARY_AREA, &largeSphere, &smallSphere, largeAreas.data(), smallAreas.data());
+    vector<float> resampled(numSmall);
+    measure("resample", "vertex-maps", (double)numSmall * SMOOTH_COLUMNS, [&]()
+            {
+                for (int i = 0; i < SMOOTH_COLUMNS; ++i)
+                {
+                    myResample.resampleNormal(myMetric.getValuePointerForColumn(i), resampled.data());
+                }
+            });
+}
@@ -0,0 +1,214 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "TfceTest.h"
+
+#include "SurfaceFile.h"
+#include "TfceHelper.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    //the old way: at every distinct value, find the clusters above it from scratch, and integrate each cluster's area over the step
+    //elements that aren't used get zero output, and don't connect anything
+    void referenceTfce(const vector<vector<int> >& neighbors, const vector<float>& areas, const vector<bool>& used,
+                       const vector<float>& data, const float& param_e, const float& param_h, vector<double>& outData)
+    {
+        int numElems = (int)data.size();
+        outData.assign(numElems, 0.0);
+        double integrated_h = param_h + 1.0;
+        for (int sign = 1; sign >= -1; sign -= 2)
+        {
+            vector<float> thresholds;
+            for (int i = 0; i < numElems; ++i)
+            {
+                if (used[i] && sign * data[i] > 0.0f) thresholds.push_back(sign * data[i]);
+            }
+            sort(thresholds.begin(), thresholds.end());
+            thresholds.erase(unique(thresholds.begin(), thresholds.end()), thresholds.end());
+            double prevThresh = 0.0;
+            vector<int> marked(numElems, -1);
+            for (int t = 0; t < (int)thresholds.size(); ++t)
+            {//between the previous threshold and this one, the clusters are the same as at this one
+                float thresh = thresholds[t];
+                double slice = (pow((double)thresh, integrated_h) - pow(prevThresh, integrated_h)) / integrated_h;
+                for (int seed = 0; seed < numElems; ++seed)
+                {
+                    if (!used[seed] || sign * data[seed] < thresh || marked[seed] == t) continue;
+                    vector<int> members(1, seed), stack(1, seed);
+                    marked[seed] = t;
+                    double clusterArea = 0.0;
+                    while (!stack.empty())
+                    {
+                        int elem = stack.back();
+                        stack.pop_back();
+                        clusterArea += areas[elem];
+                        for (int j = 0; j < (int)neighbors[elem].size(); ++j)
+                        {
+                            int neigh = neighbors[elem][j];
+                            if (used[neigh] && sign * data[neigh] >= thresh && marked[neigh] != t)
+                            {
+                                marked[neigh] = t;
+                                members.push_back(neigh);
+                                stack.push_back(neigh);
+                            }
+                        }
+                    }
+                    double contribution = pow(clusterArea, (double)param_e) * slice;
+                    for (int j = 0; j < (int)members.size(); ++j)
+                    {
+                        outData[members[j]] += sign * contribution;
+                    }
+                }
+                prevThresh = thresh;
+            }
+        }
+    }
+    
+    float randomValue()
+    {//multiples of 0.25 in [-3, 3], so there are many ties and zeros
+        return ((rand() % 25) - 12) * 0.25f;
+    }
+}
+
+TfceTest::TfceTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void TfceTest::compareOutput(const AString& what, const vector<float>& result, const vector<double>& expected)
+{
+    for (int i = 0; i < (int)expected.size(); ++i)
+    {
+        double diff = fabs(result[i] - expected[i]);
+        if (diff > 1e-4 * max(1.0, fabs(expected[i])))
+        {
+            setFailed(what + " TFCE differs from threshold steps at element " + AString::number(i) + ", got " + AString::number(result[i]) +
+                      ", expected " + AString::number(expected[i]));
+            return;
+        }
+    }
+}
+
+void TfceTest::execute()
+{
+    const float PARAM_E = 0.5f, PARAM_H = 2.0f;
+    const int TEST_MAPS = 5;
+    {//surface: a triangulated grid, with some vertices left out
+        const int GRID = 20, numNodes = GRID * GRID;
+        SurfaceFile mySurf;
+        mySurf.setNumberOfNodesAndTriangles(numNodes, (GRID - 1) * (GRID - 1) * 2);
+        vector<vector<int> > neighbors(numNodes);
+        int triangle = 0;
+        for (int y = 0; y < GRID; ++y)
+        {
+            for (int x = 0; x < GRID; ++x)
+            {
+                mySurf.setCoordinate(y * GRID + x, x, y, 0.0f);
+                if (x == GRID - 1 || y == GRID - 1) continue;
+                int corners[4] = { y * GRID + x, y * GRID + x + 1, (y + 1) * GRID + x + 1, (y + 1) * GRID + x };
+                mySurf.setTriangle(triangle++, corners[0], corners[1], corners[2]);
+                mySurf.setTriangle(triangle++, corners[0], corners[2], corners[3]);
+                int edges[5][2] = { { 0, 1 }, { 1, 2 }, { 2, 0 }, { 2, 3 }, { 3, 0 } };
+                for (int e = 0; e < 5; ++e)
+                {
+                    neighbors[corners[edges[e][0]]].push_back(corners[edges[e][1]]);
+                    neighbors[corners[edges[e][1]]].push_back(corners[edges[e][0]]);
+                }
+            }
+        }
+        vector<float> areas(numNodes);
+        vector<bool> used(numNodes);
+        vector<int64_t> nodeToData(numNodes);
+        for (int i = 0; i < numNodes; ++i)
+        {
+            areas[i] = 0.5f + (rand() % 100) / 100.0f;
+            used[i] = (rand() % 10 != 0);
+            nodeToData[i] = (used[i] ? i : -1);
+        }
+        TfceHelper myHelper(numNodes);
+        myHelper.addSurface(&mySurf, areas.data(), nodeToData);
+        TfceHelper::Workspace myScratch;
+        for (int m = 0; m < TEST_MAPS; ++m)
+        {
+            vector<float> data(numNodes), result(numNodes);
+            for (int i = 0; i < numNodes; ++i) data[i] = randomValue();
+            vector<double> expected;
+            referenceTfce(neighbors, areas, used, data, PARAM_E, PARAM_H, expected);
+            myHelper.compute(data.data(), result.data(), PARAM_E, PARAM_H, myScratch);
+            compareOutput("surface", result, expected);
+        }
+    }
+    {//volume: a random subset of a small box, stored in shuffled order
+        const int DIM = 6, boxSize = DIM * DIM * DIM;
+        vector<int> boxToData(boxSize, -1);
+        vector<int64_t> voxelIJK, dataIndices;
+        for (int v = 0; v < boxSize; ++v)
+        {
+            if (rand() % 4 == 0) continue;
+            boxToData[v] = (int)dataIndices.size();
+            dataIndices.push_back((int64_t)dataIndices.size());
+            voxelIJK.push_back(v % DIM);
+            voxelIJK.push_back((v / DIM) % DIM);
+            voxelIJK.push_back(v / (DIM * DIM));
+        }
+        int numVoxels = (int)dataIndices.size();
+        for (int i = numVoxels - 1; i > 0; --i)
+        {
+            int swapWith = rand() % (i + 1);
+            swap(dataIndices[i], dataIndices[swapWith]);
+        }
+        const float VOXEL_VOLUME = 2.0f;
+        vector<vector<int> > neighbors(numVoxels);
+        vector<float> areas(numVoxels, VOXEL_VOLUME);
+        vector<bool> used(numVoxels, true);
+        for (int v = 0; v < numVoxels; ++v)
+        {
+            int64_t ijk[3] = { voxelIJK[v * 3], voxelIJK[v * 3 + 1], voxelIJK[v * 3 + 2] };
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                for (int step = -1; step <= 1; step += 2)
+                {
+                    int64_t neighIJK[3] = { ijk[0], ijk[1], ijk[2] };
+                    neighIJK[axis] += step;
+                    if (neighIJK[axis] < 0 || neighIJK[axis] >= DIM) continue;
+                    int neighData = boxToData[neighIJK[0] + DIM * (neighIJK[1] + DIM * neighIJK[2])];
+                    if (neighData >= 0) neighbors[dataIndices[v]].push_back(dataIndices[neighData]);
+                }
+            }
+        }
+        TfceHelper myHelper(numVoxels);
+        myHelper.addVoxels(voxelIJK, dataIndices, VOXEL_VOLUME);
+        TfceHelper::Workspace myScratch;
+        for (int m = 0; m < TEST_MAPS; ++m)
+        {
+            vector<float> data(numVoxels), result(numVoxels);
+            for (int i = 0; i < numVoxels; ++i) data[i] = randomValue();
+            vector<double> expected;
+            referenceTfce(neighbors, areas, used, data, PARAM_E, PARAM_H, expected);
+            myHelper.compute(data.data(), result.data(), PARAM_E, PARAM_H, myScratch);
+            compareOutput("volume", result, expected);
+        }
+    }
+}
@@ -0,0 +1,194 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2026  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+//program for running benchmarks, results can be saved as JSON to compare builds
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+
+#include "BenchmarkInterface.h"
+#include "SessionManager.h"
+#include "CaretCommandLine.h"
+#include "CaretException.h"
+#include "CaretOMP.h"
+
+//benchmarks
+#include "CiftiBenchmark.h"
+#include "DotBenchmark.h"
+#include "MathExpressionBenchmark.h"
+#include "NiftiBenchmark.h"
+#include "PaletteBenchmark.h"
+#include "SurfaceBenchmark.h"
+
+using namespace std;
+using namespace caret;
+
+void freeBenchmarkList(vector<BenchmarkInterface*>& mylist)
+{
+    for (int i = 0; i < (int)mylist.size(); ++i)
+    {
+        delete mylist[i];
+    }
+}
+
+void printUsage(vector<BenchmarkInterface*>& mylist)
+{
+    cout << "usage: benchmark_driver [-json <file>] [-min-time <seconds>] [-scale <factor>] <benchmark>..." << endl;
+    cout << "   -json: also write the results to a JSON file" << endl;
+    cout << "   -min-time: minimum time to spend on each case, default 1 second" << endl;
+    cout << "   -scale: multiply the size of the synthetic data, default 1" << endl;
+    cout << "benchmarks, or 'all':" << endl;
+    for (int i = 0; i < (int)mylist.size(); ++i)
+    {
+        cout << mylist[i]->getIdentifier() << endl;
+    }
+}
+
+QJsonObject resultToJson(const BenchmarkInterface::Result& myResult)
+{
+    QJsonObject ret;
+    ret["benchmark"] = myResult.m_benchmark;
+    ret["case"] = myResult.m_case;
+    ret["unit"] = myResult.m_unit;
+    ret["runs"] = (double)myResult.m_runs;
+    ret["best_seconds"] = myResult.m_bestSeconds;
+    ret["mean_seconds"] = myResult.m_meanSeconds;
+    ret["units_per_run"] = myResult.m_unitsPerRun;
+    ret["throughput"] = myResult.getThroughput();
+    return ret;
+}
+
+int main(int argc, char** argv)
+{
+    {
+        QCoreApplication myApp(argc, argv);
+        caret_global_commandLine_init(argc, argv);
+        SessionManager::createSessionManager(ApplicationTypeEnum::APPLICATION_TYPE_COMMAND_LINE);
+        vector<BenchmarkInterface*> mybenchmarks;
+        mybenchmarks.push_back(new CiftiBenchmark("ciftiio"));
+        mybenchmarks.push_back(new DotBenchmark("dotsimd"));
+        mybenchmarks.push_back(new MathExpressionBenchmark("mathexpression"));
+        mybenchmarks.push_back(new NiftiBenchmark("niftiio"));
+        mybenchmarks.push_back(new PaletteBenchmark("palette"));
+        mybenchmarks.push_back(new SurfaceBenchmark("surface"));
+        AString jsonFileName;
+        vector<AString> selected;
+        for (int i = 1; i < argc; ++i)
+        {
+            AString thisArg(argv[i]);
+            if ((thisArg == "-json" || thisArg == "-min-time" || thisArg == "-scale") && i + 1 >= argc)
+            {
+                cout << "option " << thisArg << " requires an argument" << endl;
+                freeBenchmarkList(mybenchmarks);
+                return 1;
+            }
+            if (thisArg == "-json")
+            {
+                jsonFileName = argv[++i];
+            } else if (thisArg == "-min-time") {
+                BenchmarkInterface::setMinimumSeconds(atof(argv[++i]));
+            } else if (thisArg == "-scale") {
+                BenchmarkInterface::setProblemScale(max(1, atoi(argv[++i])));
+            } else {
+                selected.push_back(thisArg);
+            }
+        }
+        if (selected.empty())
+        {
+            cout << "No benchmark specified" << endl;
+            printUsage(mybenchmarks);
+            freeBenchmarkList(mybenchmarks);
+            return 1;
+        }
+        int failCount = 0;
+        QJsonArray jsonResults;
+        for (int j = 0; j < (int)mybenchmarks.size(); ++j)
+        {
+            bool run = false;
+            for (int i = 0; i < (int)selected.size(); ++i)
+            {
+                if (mybenchmarks[j]->getIdentifier() == selected[i] || "all" == selected[i]) run = true;
+            }
+            if (!run) continue;
+            try
+            {
+                mybenchmarks[j]->execute();
+            } catch (CaretException& e) {
+                ++failCount;
+                cout << "Benchmark " << mybenchmarks[j]->getIdentifier() << " failed, exception: " << e.whatString() << endl;
+            }
+            if (mybenchmarks[j]->failed())
+            {
+                ++failCount;
+                cout << "Benchmark " << mybenchmarks[j]->getIdentifier() << " failed: " << mybenchmarks[j]->getFailMessage() << endl;
+            }
+            const vector<BenchmarkInterface::Result>& myResults = mybenchmarks[j]->getResults();
+            for (int i = 0; i < (int)myResults.size(); ++i)
+            {
+                jsonResults.append(resultToJson(myResults[i]));
+            }
+        }
+        if (!jsonFileName.isEmpty())
+        {
+            QJsonObject machine;//enough to tell which results are comparable
+            machine["host"] = QSysInfo::machineHostName();
+            machine["cpu_architecture"] = QSysInfo::currentCpuArchitecture();
+            machine["os"] = QSysInfo::prettyProductName();
+#ifdef CARET_OMP
+            machine["threads"] = omp_get_max_threads();
+#else
+            machine["threads"] = 1;
+#endif
+            QJsonObject root;
+            root["date"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+            root["machine"] = machine;
+            root["scale"] = (double)BenchmarkInterface::getProblemScale();
+            root["results"] = jsonResults;
+            QFile jsonFile(jsonFileName);
+            if (!jsonFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+            {
+                cout << "failed to open " << jsonFileName << " for writing" << endl;
+                ++failCount;
+            } else {
+                jsonFile.write(QJsonDocument(root).toJson());
+                jsonFile.close();
+            }
+        }
+        freeBenchmarkList(mybenchmarks);
+        if (failCount != 0)
+        {
+            cout << "Total of " << failCount << " benchmarks failed!" << endl;
+            return 1;
+        }
+        SessionManager::deleteSessionManager();
+        myApp.processEvents();
+    }
+    return 0;
+}
@@ -44,7 +44,9 @@
 #include "PointerTest.h"
 #include "ProgressTest.h"
 #include "QuatTest.h"
+#include "SceneFileTest.h"
 #include "StatisticsTest.h"
+#include "TfceTest.h"
 #include "TimerTest.h"
 #include "TopologyHelperTest.h"
 #include "VolumeFileTest.h"
@@ -78,10 +80,14 @@ int main(int argc, char** argv)
         mytests.push_back(new MathExpressionTest("mathexpression"));
         mytests.push_back(new NiftiFileTest("niftifile"));
         mytests.push_back(new NiftiHeaderTest("niftiheader"));
+        mytests.push_back(new NiftiBlockCompressTest("niftiblockcompress"));
+        mytests.push_back(new NiftiHalfFloatTest("niftihalffloat"));
         mytests.push_back(new PointerTest("pointer"));
         mytests.push_back(new ProgressTest("progress"));
         mytests.push_back(new QuatTest("quaternion"));
+        mytests.push_back(new SceneFileTest("scenefile"));
         mytests.push_back(new StatisticsTest("statistics"));
+        mytests.push_back(new TfceTest("tfce"));
         mytests.push_back(new TimerTest("timer"));
         mytests.push_back(new TopologyHelperTest("topohelp"));
         mytests.push_back(new VolumeFileTest("volumefile"));